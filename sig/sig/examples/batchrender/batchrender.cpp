@@ -0,0 +1,108 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <string.h>
+# include <sig/gs_model.h>
+# include <sig/gs_timer.h>
+# include <sig/sn_model.h>
+# include <sigogl/gl_tools.h>
+# include <sigogl/ws_offscreen.h>
+
+// Renders images of models without opening windows, so that batches of models can be
+// rendered on machines without a display. Each job is a model and an optional image file;
+// jobs are given in the command line or in job files with one job per line.
+
+struct Job { GsString model, image; };
+
+static void usage ()
+{
+	gsout << "Usage: batchrender [options] [model...]\n"
+			 " Renders each model with WsOffscreen and saves an image with the model name.\n"
+			 " -w <width>, -h <height>: image size, 256x256 by default\n"
+			 " -s <samples>: multisampling samples, 4 by default\n"
+			 " -e <ext>: image format, png (default), bmp or tga\n"
+			 " -o <folder>: existing folder for the images, otherwise the folder of each model\n"
+			 " -j <file>: renders the jobs in file, each line with a model and an optional\n"
+			 "            image file; empty lines and lines starting with # are skipped\n"
+			 " -sw: uses a software renderer (mesa's llvmpipe)\n";
+}
+
+static bool read_jobs ( const char* file, GsArray<Job>& jobs )
+{
+	FILE* fp = fopen ( file, "rt" );
+	if ( !fp ) return false;
+	char line[1024], model[1024], image[1024];
+	while ( fgets(line,sizeof(line),fp) )
+	{	int n = sscanf ( line, "%1023s %1023s", model, image );
+		if ( n<1 || model[0]=='#' ) continue;
+		Job& j = jobs.push();
+		j.model = model;
+		j.image = n>1? image:"";
+	}
+	fclose ( fp );
+	return true;
+}
+
+int main ( int argc, char** argv )
+{
+	int w=256, h=256, samples=4;
+	bool software=false;
+	GsString ext("png"), folder;
+	GsArray<Job> jobs;
+
+	for ( int i=1; i<argc; i++ )
+	{	GsString s ( argv[i] );
+		bool hasarg = i+1<argc;
+		if ( s=="-w" && hasarg ) w=atoi(argv[++i]);
+		else if ( s=="-h" && hasarg ) h=atoi(argv[++i]);
+		else if ( s=="-s" && hasarg ) samples=atoi(argv[++i]);
+		else if ( s=="-e" && hasarg ) ext=argv[++i];
+		else if ( s=="-o" && hasarg ) { folder=argv[++i]; validate_path(folder); }
+		else if ( s=="-j" && hasarg ) { if ( !read_jobs(argv[++i],jobs) ) { gsout << "Could not read " << argv[i] << "!\n"; return 1; } }
+		else if ( s=="-sw" ) software=true;
+		else if ( s[0]=='-' ) { usage(); return 1; }
+		else { Job& j=jobs.push(); j.model=argv[i]; j.image=""; }
+	}
+	if ( jobs.empty() || w<1 || h<1 ) { usage(); return 1; }
+
+	WsOffscreen off ( w, h, samples, software );
+	if ( !off.valid() ) { gsout << "Could not create an OpenGL context!\n"; return 1; }
+	off.background ( GsColor::white );
+
+	GsTimer timer(0);
+	int failed=0;
+	for ( int i=0; i<jobs.size(); i++ )
+	{	Job& j = jobs[i];
+		if ( j.image.len()==0 )
+		{	j.image = j.model;
+			remove_extension ( j.image );
+			if ( folder.len() ) remove_path ( j.image );
+			j.image.insert ( 0, folder );
+			j.image << '.' << ext;
+		}
+
+		timer.start();
+		SnModel* snm = new SnModel;
+		off.root ( snm ); // the previous model is deleted
+		bool ok = snm->model()->load ( j.model );
+		if ( ok )
+		{	off.view_all ();
+			ok = off.render ( j.image );
+		}
+		timer.stop();
+
+		if ( i==0 && ok ) gsout << "OpenGL " << gl_version() << ", GLSL " << glsl_version() << gsnl;
+		gsout << j.model << " -> " << j.image;
+		if ( ok ) gsout << " (" << (1000.0*timer.dt()) << "ms)\n";
+		else { gsout << ": failed!\n"; failed++; }
+	}
+	off.root ( 0 );
+
+	gsout << (jobs.size()-failed) << " of " << jobs.size() << " images rendered.\n";
+	return failed? 1:0;
+}
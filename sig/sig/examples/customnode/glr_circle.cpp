@@ -96,7 +96,7 @@ void GlrCircle::render ( SnShape* s, GlContext* ctx )
 		ctx->line_width ( c.linewidth );
 		ctx->use_program ( Prog->id ); // ctx tests if the program is being changed
 
-		glUniformMatrix4fv ( Prog->uniloc[0], 1, GLTRANSPMAT, ctx->projection()->e );
+		ctx->uniform_projection ( Prog );
 		glUniformMatrix4fv ( Prog->uniloc[1], 1, GLTRANSPMAT, ctx->modelview()->e );
 		glUniform4fv ( Prog->uniloc[2], 1, s->color().vec4() );
 
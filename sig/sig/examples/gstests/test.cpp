@@ -28,6 +28,23 @@ void test_arraylist ();
 void test_graph ();
 void test_grid ();
 void test_list ();
+void test_coldet ();
+void test_skinning ();
+void test_weld ();
+void test_adjacency ();
+void test_raycast ();
+void test_input ();
+void test_modelbin ();
+void test_objload ();
+void test_fk ();
+void test_animator ();
+void test_blend ();
+void test_keyframes ();
+void test_motionpack ();
+void test_motionbin ();
+void test_visgraph ();
+void test_frustum ();
+void test_profiler ();
 
 struct FuncDesc { void (*func) (); const char* name; } FD[] =
 {	{ test_random,	"random" },
@@ -46,6 +63,23 @@ struct FuncDesc { void (*func) (); const char* name; } FD[] =
 	{ test_slotmap, "slotmap" },
 	{ test_structures, "structures" },
 	{ test_arraylist, "arraylist" },
+	{ test_coldet,	"coldet" },
+	{ test_skinning, "skinning" },
+	{ test_weld,	"weld" },
+	{ test_adjacency, "adjacency" },
+	{ test_raycast, "raycast" },
+	{ test_input,	"input" },
+	{ test_modelbin, "modelbin" },
+	{ test_objload, "objload" },
+	{ test_fk,		"fk" },
+	{ test_animator, "animator" },
+	{ test_blend,	"blend" },
+	{ test_keyframes, "keyframes" },
+	{ test_motionpack, "motionpack" },
+	{ test_motionbin, "motionbin" },
+	{ test_visgraph, "visgraph" },
+	{ test_frustum, "frustum" },
+	{ test_profiler, "profiler" },
 	{ 0, 0 } };
 
 int main ( int argc, char** argv )
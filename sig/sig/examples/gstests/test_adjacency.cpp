@@ -0,0 +1,152 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_timer.h>
+
+// makes a grid of nxn quads with shared vertices:
+static void make_grid ( GsModel& m, int n )
+ {
+   m.init ();
+   for ( int i=0; i<=n; i++ )
+	for ( int j=0; j<=n; j++ ) m.V.push().set ( float(i), float(j), 0 );
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { int v=i*(n+1)+j;
+	   m.F.push().set ( v, v+n+1, v+n+2 );
+	   m.F.push().set ( v, v+n+2, v+1 );
+	 }
+   m.detect_mode ();
+ }
+
+// the construction of edges per vertex used before GsModelAdjacency:
+static int fcompare ( const GsModel::Face *f1, const GsModel::Face *f2 ) { return f1->b-f2->b; }
+static GsArray<GsModel::Face>* old_edges_per_vertex ( const GsModel& m )
+ {
+   int i, j, k;
+   GsArray<GsModel::Face>* va = new GsArray<GsModel::Face>[m.V.size()];
+   for ( i=0; i<m.V.size(); i++ ) va[i].capacity(8);
+   for ( i=0; i<m.F.size(); i++ )
+	{ const GsModel::Face& f=m.F[i];
+	  va[f.a].uniqinsort ( GsModel::Face(i,f.b,f.c), fcompare );
+	  va[f.b].uniqinsort ( GsModel::Face(i,f.c,f.a), fcompare );
+	  va[f.c].uniqinsort ( GsModel::Face(i,f.a,f.b), fcompare );
+	}
+   for ( i=0; i<m.V.size(); i++ )
+	{ GsArray<GsModel::Face>& ea = va[i];
+	  int max = ea.size()-1;
+	  for ( j=1; j<max; j++ )
+	   { for ( k=j; k<=max; k++ ) { if ( ea[j-1].c==ea[k].b ) break; }
+		 if ( k<=max ) { GsModel::Face tmp; GS_SWAP(ea[j],ea[k]); }
+	   }
+	}
+   return va;
+ }
+
+// checks twins, fans and rings, and returns the number of boundary vertices:
+static int check ( GsModel& m, int& errors )
+ {
+   const GsModelAdjacency& adj = m.adjacency();
+   int c, v, nb=0;
+   GsArray<int> ring;
+   for ( c=0; c<adj.corners(); c++ )
+	{ int t = adj.twin(c);
+	  if ( t>=0 && ( adj.twin(t)!=c || adj.vertex(t)!=adj.dest(c) || adj.dest(t)!=adj.vertex(c) ) ) errors++;
+	}
+   for ( v=0; v<adj.vertices(); v++ )
+	{ const int* st = adj.star(v);
+	  int d = adj.degree(v);
+	  for ( int i=0; i+1<d; i++ ) if ( adj.swing(st[i])!=st[i+1] ) errors++;
+	  ring.size(0);
+	  adj.one_ring ( v, ring );
+	  if ( adj.boundary(v) ) nb++;
+	  if ( ring.size()!=d+(adj.boundary(v)?1:0) ) errors++;
+	}
+   return nb;
+ }
+
+void test_adjacency ()
+ {
+   GsModel m;
+   GsTimer timer(0);
+   int errors=0;
+
+   gsout << "Grid:\n";
+   make_grid ( m, 4 );
+   int nb = check ( m, errors );
+   gsout << "V=" << m.V.size() << " F=" << m.F.size() << " E=" << m.adjacency().count_edges()
+		 << " (expected " << 3*16+2*4 << ") boundary vertices=" << nb << " (expected 16)\n";
+   GsArray<int> ring;
+   m.adjacency().one_ring ( 12, ring );
+   gsout << "One-ring of center vertex 12: " << ring << gsnl;
+   ring.size(0);
+   m.adjacency().one_ring ( 0, ring );
+   gsout << "One-ring of corner vertex 0: " << ring << gsnl;
+
+   gsout << "\nSphere: ";
+   m.make_sphere ( GsPnt::null, 1.0f, 40, false );
+   m.merge_redundant_vertices ( 0.00001f );
+   nb = check ( m, errors );
+   int e = m.adjacency().count_edges();
+   gsout << "F=" << m.F.size() << " V=" << m.V.size() << " E=" << e << " V-E+F=" << (m.V.size()-e+m.F.size())
+		 << " boundary vertices=" << nb << " mean degree=" << m.count_mean_vertex_degree() << gsnl;
+
+   gsout << "\nGrids:\n";
+   for ( int n=64; n<=1024; n*=2 )
+	{ make_grid ( m, n );
+
+	  timer.start ();
+	  GsArray<GsModel::Face>* va = old_edges_per_vertex ( m );
+	  timer.stop ();
+	  double t0 = timer.dt();
+	  delete[] va;
+
+	  timer.start ();
+	  m.adjacency ();
+	  timer.stop ();
+	  double t1 = timer.dt();
+
+	  timer.start ();
+	  m.adjacency (); // only compares the stamps
+	  timer.stop ();
+	  double t2 = timer.dt();
+
+	  nb = check ( m, errors );
+	  gsout << "F=" << m.F.size() << " E=" << m.adjacency().count_edges() << " boundary vertices=" << nb
+			<< " | edges per vertex " << (1000.0*t0) << "ms, adjacency " << (1000.0*t1) << "ms, cached " << (1000.0*t2) << "ms\n";
+	}
+
+   gsout << "\nInvalidation: ";
+   const GsModelAdjacency& adj = m.adjacency ();
+   int fi = m.F.size()/2+1; // a face in the middle of the grid
+   int t = adj.twin(3*fi);
+   GsModel::Face f = m.F[fi];
+   m.F[fi].set ( f.a, f.c, f.b ); // inverting one face disconnects it
+   m.changed ();
+   m.adjacency ();
+   gsout << "twin " << t << " -> " << adj.twin(3*fi) << ", ";
+   m.F[fi] = f;
+   m.changed ();
+   m.adjacency ();
+   gsout << "restored twin " << adj.twin(3*fi) << gsnl;
+
+   gsout << "\nSmooth of last grid: ";
+   m.free_adjacency ();
+   timer.start ();
+   m.smooth ();
+   timer.stop ();
+   gsout << (1000.0*timer.dt()) << "ms, N=" << m.N.size() << gsnl;
+
+   gsout << "\nCopy: ";
+   m.adjacency ();
+   { GsModel c ( m ); // the cached structure is not shared with the copy
+	 gsout << "E=" << c.adjacency().count_edges() << gspc;
+   }
+   gsout << "E=" << m.adjacency().count_edges() << gsnl;
+
+   gsout << "\nErrors: " << errors << gsnl;
+ }
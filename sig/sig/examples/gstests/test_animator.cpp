@@ -0,0 +1,148 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_parallel.h>
+# include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_motion.h>
+# include <sigkin/kn_ct_motion.h>
+# include <sigkin/kn_ct_scheduler.h>
+# include <sigkin/kn_animator.h>
+
+// a root with a few chains of rotational joints, the root also translates:
+static KnSkeleton* make_skeleton ()
+ {
+   KnSkeleton* sk = new KnSkeleton;
+   KnJoint* root = sk->add_joint ( KnJoint::TypeQuat, 0, "root" );
+   root->quat()->thaw ();
+   root->pos()->thaw ();
+   GsString name;
+   for ( int c=0; c<5; c++ )
+	{ KnJoint* p = root;
+	  for ( int k=0; k<12; k++ )
+	   { name.setf ( "c%dj%d", c, k );
+		 p = sk->add_joint ( KnJoint::TypeQuat, p, name );
+		 p->offset ( GsVec(0.2f*float(c),1.0f,0) );
+		 p->quat()->thaw ();
+	   }
+	}
+   sk->make_channels ();
+   return sk;
+ }
+
+static KnMotion* make_motion ( KnSkeleton* sk, int frames, float dt )
+ {
+   GsArray<KnPosture*> postures;
+   GsArray<float> keytimes;
+   for ( int f=0; f<frames; f++ )
+	{ KnPosture* p = postures.push() = new KnPosture ( sk );
+	  p->get_random ();
+	  keytimes.push() = dt*float(f);
+	}
+   KnMotion* m = new KnMotion;
+   m->makeasref ( postures, keytimes );
+   return m;
+ }
+
+// each character blends two shared motions with a scheduler, with its own timing:
+static void add_character ( KnAnimator* a, KnMotion* m1, KnMotion* m2, int i )
+ {
+   KnSkeleton* sk = make_skeleton ();
+   KnCtScheduler* sch = new KnCtScheduler;
+   sch->init ( sk );
+   KnCtMotion* c1 = new KnCtMotion;
+   c1->init ( m1 );
+   c1->loop ( true );
+   KnCtMotion* c2 = new KnCtMotion;
+   c2->init ( m2 );
+   c2->loop ( true );
+   sch->schedule ( c1, 0, 0, 0, KnCtScheduler::Static );
+   sch->schedule ( c2, 0.1*double(i%10), 0.5f, 0, KnCtScheduler::Static );
+   sch->start ();
+   a->add ( sk, sch );
+ }
+
+static float maxdiff ( KnAnimator* a, KnAnimator* b )
+ {
+   float d=0;
+   for ( int i=0; i<a->characters(); i++ )
+	{ const GsArray<GsMat>& ma = a->global_matrices(i);
+	  const GsArray<GsMat>& mb = b->global_matrices(i);
+	  for ( int j=0; j<ma.size(); j++ )
+	   for ( int k=0; k<16; k++ ) d = GS_MAX ( d, GS_DIST(ma[j][k],mb[j][k]) );
+	}
+   return d;
+ }
+
+static void count_task ( int i, int thread, void* udata )
+ {
+   int* sum = (int*)udata;
+   volatile float x=0;
+   for ( int k=0; k<(i%7)*1000; k++ ) x += sqrtf(float(k)); // uneven costs
+   sum[i] = i+1;
+ }
+
+void test_animator ()
+ {
+   const int CHARS=200, FRAMES=200;
+   int i, f;
+
+   // thread pool with uneven tasks:
+   for ( int nt=1; nt<=4; nt++ )
+	{ GsThreadPool pool ( nt );
+	  GsArray<int> sum ( 1000 );
+	  int errors=0;
+	  for ( int run=0; run<20; run++ )
+	   { sum.setall ( 0 );
+		 pool.run ( sum.size(), count_task, sum.pt(), 1+run%3 );
+		 for ( i=0; i<sum.size(); i++ ) if ( sum[i]!=i+1 ) errors++;
+	   }
+	  gsout << "GsThreadPool with " << nt << " thread(s): " << errors << " errors\n";
+	}
+
+   KnSkeleton* model = make_skeleton ();
+   model->ref ();
+   KnMotion* m1 = make_motion ( model, 30, 0.1f ); m1->ref();
+   KnMotion* m2 = make_motion ( model, 20, 0.15f ); m2->ref();
+
+   KnAnimator* serial = new KnAnimator ( 1 );
+   KnAnimator* parallel = new KnAnimator ( 0 );
+   serial->ref ();
+   parallel->ref ();
+   for ( i=0; i<CHARS; i++ ) add_character ( serial, m1, m2, i );
+   for ( i=0; i<CHARS; i++ ) add_character ( parallel, m1, m2, i );
+   gsout << CHARS << " characters with " << model->joints().size() << " joints, "
+		 << parallel->threads() << " thread(s)\n";
+
+   GsTimer timer(0);
+   double ts=0, tp=0;
+   float d=0;
+   for ( f=0; f<FRAMES; f++ )
+	{ double t = 0.02*double(f);
+	  timer.start (); serial->evaluate ( t ); timer.stop (); ts += timer.dt();
+	  timer.start (); parallel->evaluate ( t ); timer.stop (); tp += timer.dt();
+	  d = GS_MAX ( d, maxdiff(serial,parallel) );
+	}
+   gsout << "Serial: " << 1000.0*ts/FRAMES << "ms per frame\n";
+   gsout << "Parallel: " << 1000.0*tp/FRAMES << "ms per frame, speedup " << ts/tp << gsnl;
+   gsout << "Max difference: " << d << gsnl;
+
+   // different thread counts must give the same result:
+   for ( int nt=2; nt<=4; nt++ )
+	{ parallel->threads ( nt );
+	  parallel->evaluate ( 1.2345 );
+	  serial->evaluate ( 1.2345 );
+	  gsout << nt << " threads max difference: " << maxdiff(serial,parallel) << gsnl;
+	}
+
+   serial->unref ();
+   parallel->unref ();
+   m1->unref ();
+   m2->unref ();
+   model->unref ();
+ }
@@ -0,0 +1,144 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+# include <sig/gs_quat.h>
+# include <sigkin/kn_channels.h>
+# include <sigkin/kn_channel_layout.h>
+
+// a character-like channel array: root translation, many quaternions and a few other types:
+static void make_channels ( KnChannels& ch, int quats )
+ {
+   GsString name;
+   ch.add ( "root", KnChannel::XPos );
+   ch.add ( "root", KnChannel::YPos );
+   ch.add ( "root", KnChannel::ZPos );
+   for ( int i=0; i<quats; i++ )
+	{ name.setf ( "j%d", i );
+	  ch.add ( (const char*)name, KnChannel::Quat );
+	  if ( i%10==5 ) ch.add ( (const char*)name, KnChannel::XRot );
+	}
+   ch.add ( "shoulder", KnChannel::Swing );
+   ch.add ( "shoulder", KnChannel::Twist );
+   ch.add ( "hand", KnChannel::IKGoal );
+   ch.add ( "foot", KnChannel::IKPos );
+ }
+
+static void random_values ( const KnChannels& ch, float* v )
+ {
+   GsRandom<float> r ( -1.0f, 1.0f );
+   for ( int i=0; i<ch.size(); i++ )
+	{ int n = ch(i).size();
+	  if ( ch(i).type()==KnChannel::Quat || ch(i).type()==KnChannel::IKGoal )
+	   { float* q = ch(i).type()==KnChannel::Quat? v : v+3;
+		 for ( int k=0; k<q-v; k++ ) v[k] = r.get();
+		 GsQuat Q ( GsVec(r.get(),r.get(),r.get()), gs2pi*r.get() );
+		 float s = i%3==0? -1.0f:1.0f; // also test quaternions with negative w
+		 q[0]=s*Q.w; q[1]=s*Q.x; q[2]=s*Q.y; q[3]=s*Q.z;
+	   }
+	  else
+	   { for ( int k=0; k<n; k++ ) v[k] = gspi*r.get();
+	   }
+	  v += n;
+	}
+ }
+
+// the per-channel interpolation used before the channel layout:
+static void channel_interp ( const KnChannels& ch, const float* fp1, const float* fp2, float t, float* fp )
+ {
+   for ( int i=0; i<ch.size(); i++ )
+	{ float q1[7]; // gslerp may change the 1st quaternion
+	  for ( int k=0; k<ch(i).size(); k++ ) q1[k]=fp1[k];
+	  int dp = ch(i).interp ( q1, fp2, t, fp );
+	  fp1 += dp; fp2 += dp; fp += dp;
+	}
+ }
+
+static void channel_interp ( const KnChannels& ch, GsArray<float*>& buffer, const GsArray<float>& w, float* fp )
+ {
+   GsArray<float*> b ( buffer );
+   for ( int i=0; i<ch.size(); i++ )
+	{ int dp = ch(i).interp ( b, w, fp );
+	  for ( int j=0; j<b.size(); j++ ) b[j]+=dp;
+	  fp += dp;
+	}
+ }
+
+static float maxdiff ( const float* a, const float* b, int n )
+ {
+   float d=0;
+   for ( int i=0; i<n; i++ ) d = GS_MAX ( d, GS_DIST(a[i],b[i]) );
+   return d;
+ }
+
+void test_blend ()
+ {
+   const int QUATS=60, POSTURES=4, RUNS=20000;
+   int i, j;
+
+   KnChannels ch;
+   make_channels ( ch, QUATS );
+   const KnChannelLayout& layout = ch.layout();
+   int n = ch.floats();
+   gsout << ch.size() << " channels, " << n << " floats: " << layout.linears() << " linear, "
+		 << layout.angles() << " angles, " << layout.quats() << " quaternions\n";
+
+   GsArray<float> v1(n), v2(n), a(n), b(n);
+   random_values ( ch, v1.pt() );
+   random_values ( ch, v2.pt() );
+
+   // two postures:
+   float d=0;
+   for ( i=0; i<=20; i++ )
+	{ float t = float(i)/20.0f;
+	  channel_interp ( ch, v1.pt(), v2.pt(), t, a.pt() );
+	  layout.interp ( v1.pt(), v2.pt(), t, b.pt() );
+	  d = GS_MAX ( d, maxdiff(a.pt(),b.pt(),n) );
+	}
+   gsout << "Interpolation max difference: " << d << gsnl;
+
+   // interpolation into connected buffers, connecting every other channel:
+   KnChannels chb ( ch );
+   for ( i=0; i<chb.size(); i+=2 ) chb[i].connect ( a.pt()+chb.floatpos(i) );
+   a = v2; b = v2;
+   for ( i=0; i<chb.size(); i+=2 ) { int k=chb.floatpos(i); chb[i].interp ( v1.pt()+k, b.pt()+k, 0.3f, b.pt()+k ); }
+   chb.layout().interp ( v1.pt(), 0.3f, chb );
+   gsout << "Connected interpolation max difference: " << maxdiff(a.pt(),b.pt(),n) << gsnl;
+
+   // weighted interpolation:
+   GsArray<float> values ( n*POSTURES );
+   GsArray<float*> buffer ( POSTURES );
+   GsArray<float> w ( POSTURES );
+   for ( j=0; j<POSTURES; j++ )
+	{ buffer[j] = values.pt()+n*j;
+	  random_values ( ch, buffer[j] );
+	  w[j] = float(j+1)/10.0f; // sums 1 with 4 postures
+	}
+   channel_interp ( ch, buffer, w, a.pt() );
+   layout.interp ( buffer, w, b.pt() );
+   gsout << "Weighted interpolation max difference: " << maxdiff(a.pt(),b.pt(),n) << gsnl;
+
+   // benchmark:
+   GsTimer timer(0);
+   double tc, tl;
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) channel_interp ( ch, v1.pt(), v2.pt(), float(i%100)/100.0f, a.pt() );
+   timer.stop (); tc = timer.dt();
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) layout.interp ( v1.pt(), v2.pt(), float(i%100)/100.0f, b.pt() );
+   timer.stop (); tl = timer.dt();
+   gsout << "Interpolation per channel: " << 1.0E6*tc/RUNS << "us, layout: " << 1.0E6*tl/RUNS << "us, speedup " << tc/tl << gsnl;
+
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) channel_interp ( ch, buffer, w, a.pt() );
+   timer.stop (); tc = timer.dt();
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) layout.interp ( buffer, w, b.pt() );
+   timer.stop (); tl = timer.dt();
+   gsout << "Weighted per channel: " << 1.0E6*tc/RUNS << "us, layout: " << 1.0E6*tl/RUNS << "us, speedup " << tc/tl << gsnl;
+ }
@@ -0,0 +1,84 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+# include <sig/cd_manager.h>
+
+static void pairs ( CdManager& cd )
+ {
+   const GsArray<int>& p = cd.colliding_pairs();
+   gsout << (p.size()/2) << " pairs: ";
+   for ( int i=0; i<p.size(); i+=2 ) gsout << p[i] << '-' << p[i+1] << gspc;
+   gsout << gsnl;
+ }
+
+void test_coldet ()
+ {
+   int i, j;
+   CdManager cd;
+   GsModel box;
+   GsMat m;
+   box.make_box ( GsBox(GsPnt(-1,-1,-1),GsPnt(1,1,1)) );
+
+   gsout << "Two boxes approaching each other:\n";
+   int b1 = cd.insert_object ( box );
+   int b2 = cd.insert_object ( box );
+   for ( float x=3.0f; x>=1.5f; x-=0.25f )
+	{ m.translation ( x, 0, 0 );
+	  cd.update_transformation ( b2, m );
+	  gsout << "dist " << (x-2.0f) << ": collide=" << cd.collide()
+			<< " toler(0.3)=" << cd.collide_tolerance(0.3f) << gsnl;
+	}
+
+   gsout << "\nRotated by 45 degrees around z, touching only when corners meet:\n";
+   for ( float x=3.0f; x>=2.0f; x-=0.2f )
+	{ m.rotz ( GS_TORAD(45.0f) );
+	  m.setrans ( x, 0, 0 );
+	  cd.update_transformation ( b2, m );
+	  gsout << "x " << x << ": collide=" << cd.collide() << gsnl;
+	}
+
+   gsout << "\nDeactivating the pair: ";
+   cd.deactivate_pair ( b1, b2 );
+   gsout << "deactivated=" << cd.pair_deactivated(b1,b2) << " collide=" << cd.collide() << gsnl;
+   cd.activate_pair ( b1, b2 );
+   gsout << "Reactivating the pair: collide=" << cd.collide() << gsnl;
+   cd.remove_object ( b2 );
+   gsout << "Removed 2nd box: valid=" << cd.id_valid(b2) << " collide=" << cd.collide() << gsnl;
+
+   gsout << "\nChain of 60 capsules with adjacent pairs deactivated:\n";
+   const int N=60;
+   GsModel cap;
+   cap.make_capsule ( GsPnt(0,0,0), GsPnt(0,1,0), 0.2f, 0.2f, 24, true );
+   cd.init ();
+   int ids[N];
+   for ( i=0; i<N; i++ ) ids[i] = cd.insert_object ( cap );
+   for ( i=1; i<N; i++ ) cd.deactivate_pair ( ids[i-1], ids[i] );
+   gsout << "Triangles per capsule: " << cap.F.size()
+		 << ", deactivated pairs: " << cd.count_deactivated_pairs() << gsnl;
+
+   GsTimer timer(0);
+   GsMat r;
+   int frames=1000, collisions=0;
+   timer.start ();
+   for ( j=0; j<frames; j++ )
+	{ m.identity ();
+	  for ( i=0; i<N; i++ ) // a planar chain folding over itself as j increases
+	   { r.rotz ( GS_TORAD(0.02f*float(j)) );
+		 r.setrans ( 0, 1.0f, 0 );
+		 m = m*r;
+		 cd.update_transformation ( ids[i], m );
+	   }
+	  if ( cd.collide_all() ) collisions++;
+	}
+   timer.stop ();
+   gsout << "Frames with collisions: " << collisions << "/" << frames << gsnl;
+   pairs ( cd );
+   gsout << "Mean time per frame: " << (1000.0*timer.dt()/double(frames)) << "ms\n";
+ }
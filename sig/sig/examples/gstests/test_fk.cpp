@@ -0,0 +1,124 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+# include <sigkin/kn_skeleton.h>
+
+// a root with several chains, each chain with a side branch at every few joints:
+static void make_skeleton ( KnSkeleton* sk, int chains, int len )
+ {
+   KnJoint* root = sk->add_joint ( KnJoint::TypeQuat, 0, "root" );
+   root->quat()->thaw ();
+   GsString name;
+   for ( int c=0; c<chains; c++ )
+	{ KnJoint* p = root;
+	  for ( int k=0; k<len; k++ )
+	   { name.setf ( "c%dj%d", c, k );
+		 KnJoint* j = sk->add_joint ( KnJoint::TypeQuat, p, name );
+		 j->offset ( GsVec(0,1.0f,0.1f*float(c)) );
+		 j->quat()->thaw ();
+		 if ( k%4==3 )
+		  { name.append ( "b" );
+			KnJoint* b = sk->add_joint ( KnJoint::TypeQuat, j, name );
+			b->offset ( GsVec(0.5f,0,0) );
+			b->quat()->thaw ();
+		  }
+		 p = j;
+	   }
+	}
+ }
+
+static void random_rot ( KnJoint* j, GsRandom<float>& r )
+ {
+   j->quat()->value ( GsQuat ( GsVec(r.get(),r.get(),r.get()), r.get() ) );
+ }
+
+// reference recursive evaluation of all global matrices:
+static void reference ( KnJoint* j, const GsMat& pmat, GsArray<GsMat>& G )
+ {
+   G[j->index()].mult ( pmat, j->lmat() );
+   for ( int i=0; i<j->children(); i++ ) reference ( j->child(i), G[j->index()], G );
+ }
+
+static float maxdiff ( KnSkeleton* sk )
+ {
+   GsArray<GsMat> G ( sk->joints().size() );
+   reference ( sk->root(), GsMat::id, G );
+   float d=0;
+   for ( int i=0; i<G.size(); i++ )
+	for ( int k=0; k<16; k++ ) d = GS_MAX ( d, GS_DIST(G[i][k],sk->joints()[i]->gmat()[k]) );
+   return d;
+ }
+
+void test_fk ()
+ {
+   const int CHAINS=8, LEN=24, FRAMES=20000;
+   int f, i;
+
+   KnSkeleton* sk = new KnSkeleton;
+   sk->ref ();
+   make_skeleton ( sk, CHAINS, LEN );
+   const GsArray<KnJoint*>& J = sk->joints();
+   gsout << "Skeleton with " << J.size() << " joints\n";
+
+   GsRandom<float> r ( -1.0f, 1.0f );
+   for ( i=0; i<J.size(); i++ ) random_rot ( J[i], r );
+   sk->update_global_matrices ();
+   gsout << "Full update max difference: " << maxdiff(sk) << gsnl;
+
+   // changes at single joints must propagate to their subtrees only:
+   float d=0;
+   for ( f=0; f<100; f++ )
+	{ random_rot ( J[gs_random(0,J.size()-1)], r );
+	  if ( f%3==0 ) J[gs_random(0,J.size()-1)]->offset ( GsVec(r.get(),1.0f,r.get()) );
+	  sk->update_global_matrices ();
+	  d = GS_MAX ( d, maxdiff(sk) );
+	}
+   gsout << "Partial updates max difference: " << d << gsnl;
+
+   // local updates followed by a full update:
+   d=0;
+   KnJoint* c0 = sk->joint ( "c0j0" );
+   for ( f=0; f<100; f++ )
+	{ KnJoint* j = J[gs_random(0,J.size()-1)];
+	  random_rot ( j, r );
+	  random_rot ( c0, r );
+	  switch ( f%3 )
+	   { case 0: j->update_gmat_up(); break;
+		 case 1: c0->update_branch_gmat(); break;
+		 default: j->update_gmat_local();
+	   }
+	  sk->update_global_matrices ();
+	  d = GS_MAX ( d, maxdiff(sk) );
+	}
+   gsout << "Local updates max difference: " << d << gsnl;
+
+   // timings:
+   GsTimer timer(0);
+   GsArray<KnJoint*> changed;
+   for ( i=J.size()/16; i<J.size(); i+=J.size()/8 ) changed.push()=J[i];
+
+   timer.start ();
+   for ( f=0; f<FRAMES; f++ )
+	{ for ( i=0; i<J.size(); i++ ) J[i]->set_lmat_changed();
+	  sk->update_global_matrices ();
+	}
+   timer.stop ();
+   gsout << "All joints changed: " << 1.0E6*timer.dt()/FRAMES << "us per update\n";
+
+   timer.start ();
+   for ( f=0; f<FRAMES; f++ )
+	{ for ( i=0; i<changed.size(); i++ ) changed[i]->set_lmat_changed();
+	  sk->update_global_matrices ();
+	}
+   timer.stop ();
+   gsout << changed.size() << " joints changed: " << 1.0E6*timer.dt()/FRAMES << "us per update\n";
+   gsout << "Final max difference: " << maxdiff(sk) << gsnl;
+
+   sk->unref ();
+ }
@@ -0,0 +1,131 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_frustum.h>
+# include <sig/gs_camera.h>
+# include <sig/gs_random.h>
+# include <sig/sn_group.h>
+# include <sig/sn_model.h>
+# include <sig/sn_transform.h>
+# include <sig/sa_action.h>
+
+// point in the clip volume of m, tested in homogeneous coordinates:
+static bool clip_inside ( const GsMat& m, const GsPnt& p )
+ {
+   float c[4];
+   for ( int i=0; i<4; i++ ) c[i] = m.e[4*i]*p.x + m.e[4*i+1]*p.y + m.e[4*i+2]*p.z + m.e[4*i+3];
+   return c[3]>0 && GS_ABS(c[0])<=c[3] && GS_ABS(c[1])<=c[3] && GS_ABS(c[2])<=c[3];
+ }
+
+static GsPnt corner ( const GsBox& b, int i )
+ {
+   return GsPnt ( i&1? b.b.x:b.a.x, i&2? b.b.y:b.a.y, i&4? b.b.z:b.a.z );
+ }
+
+// skips groups as renderers do, keeping the matrix reaching the given shape:
+class CullAction : public SaAction
+ { public :
+   GsMat proj, shapemat;
+   SnShape* shape;
+   int culled;
+   CullAction ( const GsMat& m, SnShape* s ) { proj=m; shape=s; culled=0; }
+   virtual bool group_apply ( SnGroup* g ) override
+	{ if ( g->can_cull() )
+	   { GsMat m; m.mult ( proj, get_top_matrix() );
+		 if ( GsFrustum(m).test(g->culling_box())==GsFrustum::Outside ) { culled++; return true; }
+	   }
+	  return SaAction::group_apply ( g );
+	}
+   virtual bool shape_apply ( SnShape* s ) override
+	{ if ( s==shape ) shapemat=get_top_matrix();
+	  return true;
+	}
+ };
+
+void test_frustum ()
+ {
+   GsCamera cam;
+   cam.eye.set ( 0, 2, 10 );
+   cam.center.set ( 0, 0, 0 );
+   cam.aspect = 1.5f;
+   cam.zfar = 100.0f;
+   GsMat m;
+   cam.getmat ( m );
+   GsFrustum f ( m );
+
+   // random boxes, checking results with sampled points:
+   GsRandom<float> r;
+   int count[3] = { 0, 0, 0 }, errors=0;
+   for ( int i=0; i<5000; i++ )
+	{ GsPnt c ( 60.0f*r.get()-30.0f, 60.0f*r.get()-30.0f, 60.0f*r.get()-30.0f );
+	  GsBox b ( c, 0.1f+3.0f*r.get() );
+	  GsFrustum::Result res = f.test ( b );
+	  count[res]++;
+	  if ( res==GsFrustum::Inside )
+	   { for ( int k=0; k<8; k++ ) if ( !clip_inside(m,corner(b,k)) ) { errors++; break; }
+	   }
+	  else if ( res==GsFrustum::Outside )
+	   { for ( int k=0; k<200; k++ )
+		  { GsPnt p ( b.a.x+b.dx()*r.get(), b.a.y+b.dy()*r.get(), b.a.z+b.dz()*r.get() );
+			if ( clip_inside(m,p) ) { errors++; break; }
+		  }
+	   }
+	}
+   gsout << "Boxes outside: " << count[GsFrustum::Outside] << ", intersecting: " << count[GsFrustum::Intersecting]
+		 << ", inside: " << count[GsFrustum::Inside] << ", errors: " << errors << gsnl;
+   gsout << "Center " << (f.contains(cam.center)?"inside":"outside") << ", eye " << (f.contains(cam.eye)?"inside":"outside") << gsnl;
+
+   // planes in local coordinates of a transformation:
+   GsMat t, mt;
+   t.translation ( GsVec(0,0,-200) );
+   mt.mult ( m, t );
+   GsFrustum ft ( mt );
+   GsBox unit ( GsPnt::null, 1.0f );
+   gsout << "Unit box: " << (f.test(unit)==GsFrustum::Inside?"inside":"not inside")
+		 << ", translated beyond zfar: " << (ft.test(unit)==GsFrustum::Outside?"outside":"not outside") << gsnl;
+
+   // culling boxes of groups:
+   SnGroup* root = new SnGroup;
+   root->ref();
+   SnGroup* g = root->add_group ( new SnTransform, true );
+   g->culling ( true );
+   ((SnTransform*)g->get(0))->get().translation ( GsVec(0,0,-200) );
+   SnModel* sm = new SnModel;
+   sm->model()->make_box ( unit );
+   g->add ( sm );
+   GsFrustum::Result r1 = f.test ( g->culling_box() );
+   sm->model()->translate ( GsVec(0,0,200) );
+   GsFrustum::Result r2 = f.test ( g->culling_box() ); // not touched, still cached
+   g->touch_culling_box ();
+   GsFrustum::Result r3 = f.test ( g->culling_box() );
+   gsout << "Group box: " << g->culling_box() << ", tests " << int(r1) << int(r2) << int(r3)
+		 << " (expected " << int(GsFrustum::Outside) << int(GsFrustum::Outside) << int(GsFrustum::Inside) << ")" << gsnl;
+   gsout << "Shape cached box: " << sm->cached_bounding_box() << gsnl;
+   root->unref();
+
+   // a culled group must not change the matrix reaching its siblings, which only
+   // separators guarantee, so that non-separators are not culled:
+   for ( int sep=0; sep<2; sep++ )
+	{ root = new SnGroup;
+	  root->ref();
+	  g = root->add_group ( new SnTransform, sep==1 );
+	  ((SnTransform*)g->get(0))->get().translation ( GsVec(0,0,-200) );
+	  sm = new SnModel;
+	  sm->model()->make_box ( unit );
+	  g->add ( sm );
+	  SnModel* sibling = new SnModel;
+	  sibling->model()->make_box ( unit );
+	  root->add ( sibling );
+	  CullAction a1 ( m, sibling ), a2 ( m, sibling );
+	  a1.apply ( root );
+	  g->culling ( true );
+	  a2.apply ( root );
+	  gsout << (sep?"Separator":"Non-separator") << " culled: " << a2.culled << ", sibling matrix "
+			<< (a1.shapemat==a2.shapemat?"unchanged":"changed") << gsnl;
+	  root->unref();
+	}
+ }
@@ -8,7 +8,11 @@
 # include <sig/gs_vec2.h>
 # include <sig/gs_color.h>
 # include <sig/gs_graph.h>
+# include <sig/gs_graph_snapshot.h>
 # include <sig/gs_string.h>
+# include <sig/gs_random.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_parallel.h>
 
 class MyNode;
 
@@ -77,7 +81,142 @@ static void run ()
    for ( it.last(); it.inrange(); it.prior() ) gsout<<it->s<<gsnl;
  }
 
+// grid graph with costs not smaller than the distance between nodes, with node positions by id:
+struct Grid
+{	MyGraph g;
+	GsArray<MyNode*> nodes;
+	GsArray<GsVec2> pos;
+	GsArray<int> queries;
+	GsArray<float> costs;
+	GsArray<GsGraphSearch*> searches;
+};
+
+static float griddist ( const GsGraphNode* n1, const GsGraphNode* n2, void* udata )
+ {
+   const GsArray<GsVec2>& pos = ((Grid*)udata)->pos;
+   return dist ( pos[n1->id()], pos[n2->id()] );
+ }
+
+static void make_grid ( Grid& grid, int n, float blocked )
+ {
+   GsRandom<float> r;
+   grid.nodes.size ( n*n );
+   grid.pos.size ( n*n );
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { MyNode* node = grid.nodes[i*n+j] = grid.g.insert ( new MyNode );
+	   grid.pos[node->id()].set ( float(i), float(j) );
+	   if ( r.get()<blocked ) node->blocked ( true );
+	 }
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { if ( i+1<n ) grid.g.link ( grid.nodes[i*n+j], grid.nodes[(i+1)*n+j], 1.0f+r.get() );
+	   if ( j+1<n ) grid.g.link ( grid.nodes[i*n+j], grid.nodes[i*n+j+1], 1.0f+r.get() );
+	 }
+ }
+
+static void query ( int i, int thread, void* udata )
+ {
+   Grid& grid = *(Grid*)udata;
+   GsArray<MyNode*> path;
+   float cost;
+   MyNode* n1 = grid.nodes[grid.queries[2*i]];
+   MyNode* n2 = grid.nodes[grid.queries[2*i+1]];
+   grid.g.search_path ( *grid.searches[thread], n1, n2, path, cost, griddist, &grid );
+   grid.costs[i] = cost;
+ }
+
+static void search ()
+ {
+   const int N=200, Q=400;
+   Grid grid;
+   make_grid ( grid, N, 0.2f );
+   GsRandom<int> r ( 0, N*N-1 );
+   grid.queries.size ( 2*Q );
+   for ( int i=0; i<grid.queries.size(); i++ ) grid.queries[i]=r.get();
+
+   // uniform-cost, A* and weighted A* searches:
+   GsGraphSearch s;
+   GsArray<MyNode*> path;
+   GsArray<float> costs ( Q );
+   GsTimer timer(0);
+   double time[3]={0,0,0}, expanded[3]={0,0,0}, ratio=1;
+   int found=0, errors=0;
+   for ( int i=0; i<Q; i++ )
+	{ MyNode* n1 = grid.nodes[grid.queries[2*i]];
+	  MyNode* n2 = grid.nodes[grid.queries[2*i+1]];
+	  float c0, c1, c2;
+	  timer.start(); bool f = grid.g.search_path ( s, n1, n2, path, c0 ); timer.stop();
+	  time[0]+=timer.dt(); expanded[0]+=s.expanded();
+	  timer.start(); grid.g.search_path ( s, n1, n2, path, c1, griddist, &grid ); timer.stop();
+	  time[1]+=timer.dt(); expanded[1]+=s.expanded();
+	  if ( f && (path[0]!=n1 || path.top()!=n2) ) errors++;
+	  timer.start(); grid.g.search_path ( s, n1, n2, path, c2, griddist, &grid, 1.5f ); timer.stop();
+	  time[2]+=timer.dt(); expanded[2]+=s.expanded();
+	  costs[i] = c1;
+	  if ( !f ) continue;
+	  found++;
+	  if ( GS_DIST(c0,c1)>1E-3f*c0 || c2<c0-1E-3f*c0 || c2>1.5f*c0+1E-3f*c0 ) errors++;
+	  ratio = GS_MAX ( ratio, c2/c0 );
+	}
+   gsout << "Searches in a " << N << "x" << N << " grid: " << found << " of " << Q << " found, errors: " << errors << gsnl;
+   const char* name[3] = { "uniform-cost", "A*", "weighted A* (1.5)" };
+   for ( int k=0; k<3; k++ )
+	gsout << name[k] << ": " << (1.0E3*time[k]/Q) << "ms, " << int(expanded[k]/Q) << " nodes expanded per search\n";
+   gsout << "Weighted A* max cost ratio: " << ratio << gsnl;
+
+   // the same searches in parallel, each thread with its own search object:
+   GsThreadPool pool ( 4 );
+   for ( int t=0; t<pool.threads(); t++ ) grid.searches.push() = new GsGraphSearch;
+   grid.costs.size ( Q );
+   timer.start(); pool.run ( Q, query, &grid ); timer.stop();
+   int diffs=0;
+   for ( int i=0; i<Q; i++ ) if ( grid.costs[i]!=costs[i] ) diffs++;
+   gsout << "Parallel A* with " << pool.threads() << " threads: " << (1.0E3*timer.dt()/Q) << "ms per search, differences: " << diffs << gsnl;
+   while ( grid.searches.size() ) delete grid.searches.pop();
+
+   // the same searches in a snapshot of the graph:
+   timer.start();
+   GsGraphSnapshot snap ( grid.g );
+   timer.stop();
+   gsout << "Snapshot: " << snap.nodes() << " nodes, " << snap.links() << " links, " << snap.bytes()
+		 << " bytes, built in " << (1.0E3*timer.dt()) << "ms\n";
+   GsArray<int> ipath;
+   diffs=0;
+   timer.start();
+   for ( int i=0; i<Q; i++ )
+	{ float c;
+	  int i1 = snap.index(grid.nodes[grid.queries[2*i]]), i2 = snap.index(grid.nodes[grid.queries[2*i+1]]);
+	  bool f = snap.search_path ( s, i1, i2, ipath, c, griddist, &grid );
+	  if ( c!=costs[i] || (f && (ipath[0]!=i1 || ipath.top()!=i2)) ) diffs++;
+	}
+   timer.stop();
+   gsout << "Snapshot A*: " << (1.0E3*timer.dt()/Q) << "ms per search, differences: " << diffs << gsnl;
+
+   // local searches reaching the same costs:
+   int depth, reached=0, limited=0;
+   float d;
+   diffs=0;
+   for ( int i=0; i<Q; i++ )
+	{ int i1 = snap.index(grid.nodes[grid.queries[2*i]]), i2 = snap.index(grid.nodes[grid.queries[2*i+1]]);
+	  if ( snap.local_search(s,i2,i1,0,0,depth,d) ) { reached++; if ( GS_DIST(d,costs[i])>1E-3f*d ) diffs++; }
+	  if ( !snap.local_search(s,i2,i1,0,20.0f,depth,d) ) limited++;
+	}
+   gsout << "Snapshot local searches reaching the goal: " << reached << ", differences: " << diffs
+		 << ", stopped by max distance 20: " << limited << gsnl;
+
+   // connected components:
+   GsArray<int> comps, cnodes, snapcomps, snapnodes;
+   GsArray<MyNode*> nodes;
+   timer.start(); grid.g.get_disconnected_components ( comps, nodes ); timer.stop();
+   double tc = timer.dt();
+   timer.start(); snap.get_disconnected_components ( snapcomps, snapnodes ); timer.stop();
+   gsout << "Components: " << comps.size()/2 << " in " << (1.0E3*tc) << "ms, snapshot: " << snapcomps.size()/2
+		 << " in " << (1.0E3*timer.dt()) << "ms, snapshot nodes: " << snapnodes.size() << gsnl;
+ }
+
 void test_graph ()
  {
    run ();
+   search ();
  }
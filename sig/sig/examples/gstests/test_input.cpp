@@ -0,0 +1,119 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include <sig/gs_input.h>
+# include <sig/gs_string.h>
+# include <sig/gs_random.h>
+# include <sig/gs_timer.h>
+
+// writes a file with tokens of all types, large enough to cross several buffer blocks:
+static void make_file ( const char* fname, int lines )
+ {
+   GsRandom<float> r;
+   FILE* f = fopen ( fname, "w" );
+   for ( int i=0; i<lines; i++ )
+	{ fprintf ( f, "v %g %.9g %d # comment %d\n", r.get()*1000-500, r.get()*2-1, int(r.get()*100000)-50000, i );
+	  if ( i%97==0 ) fprintf ( f, "\"quoted text\\n\" name_%d +.5 -3e-2 1.2.3 x.y %%!\n", i );
+	  if ( i%131==0 ) fprintf ( f, "%s\n", "aVeryLongNameThatIsLongerThanTheMaximumTokenSizeAndThereforeGetsSplitByTheTokenizerIntoTwoTokensSoThatThisCaseIsAlsoTestedHere_abc" );
+	}
+   fprintf ( f, "last 1.5" ); // no new line at the end
+   fclose ( f );
+ }
+
+// reads all tokens, mixing get(), getf(), geti() and readchar() calls:
+static void read_tokens ( GsInput& in, GsString& out )
+ {
+   int n=0;
+   GsString s;
+   while ( true )
+	{ if ( n%5==3 ) { s.setf("<%d>",in.readchar()); out<<s; }
+	  if ( n%7==2 ) { s.setf("<%.9g>",in.getf()); out<<s; }
+	  if ( n%11==4 ) { s.setf("<%d>",in.geti()); out<<s; }
+	  bool end = in.end();
+	  GsInput::TokenType t = in.get();
+	  s.setf ( "%d %d [%s] %d\n", end?1:0, (int)t, (const char*)in.ltoken(), in.curline() );
+	  out << s;
+	  if ( t==GsInput::End ) break;
+	  n++;
+	}
+ }
+
+void test_input ()
+ {
+   const char* fname = "test_input.txt";
+   GsTimer timer(0);
+   int i;
+
+   // the same tokens have to be read from files and from strings:
+   make_file ( fname, 20000 );
+   GsInput in;
+   in.commentchar ( '#' );
+   in.open ( fname );
+   GsString file, buf, t1, t2;
+   in.readall ( file );
+   in.open ( fname );
+   read_tokens ( in, t1 );
+   in.init ( file );
+   read_tokens ( in, t2 );
+   gsout << "Tokens from file and string: " << (t1==t2 && t1.len()>0?"equal":"different") << gsnl;
+
+   // the file position is synchronized when the file pointer is requested:
+   float x, y; int z;
+   sscanf ( file, "v %f %f %d", &x, &y, &z );
+   in.open ( fname );
+   in.get(); in.getf();
+   float a=0;
+   bool ok = fscanf(in.filept(),"%f",&a)==1 && a==y && in.geti()==z && in.get()==GsInput::String && in.ltoken()=="quoted text\n";
+   gsout << "Reading from the file pointer: " << (ok?"ok":"failed") << gsnl;
+
+   // conversions:
+   GsRandom<double> r;
+   int diff=0;
+   for ( i=0; i<100000; i++ )
+	{ char st[64];
+	  sprintf ( st, i%2? "%.*g":"%.*e", 1+i%20, (r.get()-0.5)*pow(10.0,80*r.get()-40) );
+	  if ( gs_atof(st)!=(float)atof(st) ) diff++;
+	  sprintf ( st, "%d", int((r.get()-0.5)*4e9) );
+	  if ( gs_atoi(st)!=atoi(st) ) diff++;
+	}
+   gsout << "Conversion differences: " << diff << gsnl;
+
+   // a sign followed by a point starts a number, as accepted by scanf:
+   GsString tk;
+   in.init ( "-.5 +.5e1 -. +x .5 -" );
+   while ( in.get()!=GsInput::End ) { tk << int(in.ltype()) << '[' << in.ltoken() << "] "; }
+   gsout << "Signed points: " << tk << gsnl;
+
+   // reading speed:
+   make_file ( fname, 400000 );
+   double s1=0, s2=0;
+   timer.start ();
+   FILE* f = fopen ( fname, "r" );
+   char st[256];
+   while ( fscanf(f,"%255s",st)==1 )
+	{ if ( st[0]=='v' && fscanf(f,"%f %f %d",&x,&y,&z)==3 ) { s1+=x; s1+=y; s1+=z; }
+	  if ( !fgets(st,256,f) ) break;
+	}
+   fclose ( f );
+   timer.stop ();
+   double t0 = timer.dt();
+   timer.start ();
+   in.open ( fname );
+   while ( in.get()!=GsInput::End )
+	{ if ( in.ltoken()=="v" ) { s2+=in.getf(); s2+=in.getf(); s2+=in.geti(); }
+	  in.skipline();
+	}
+   timer.stop ();
+   gsout << "Lines with 3 numbers: fscanf " << (1000.0*t0) << "ms, GsInput " << (1000.0*timer.dt()) << "ms, "
+		 << (s1==s2?"same":"different") << " sums\n";
+
+   in.close ();
+   remove ( fname );
+ }
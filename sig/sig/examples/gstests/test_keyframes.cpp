@@ -0,0 +1,98 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+# include <sigkin/kn_motion.h>
+
+// a motion with one XPos channel where the value of each frame is its index:
+static KnMotion* make_motion ( int frames, bool uniform )
+ {
+   KnChannels* ch = new KnChannels;
+   ch->add ( "root", KnChannel::XPos );
+   GsArray<KnPosture*> postures ( frames );
+   GsArray<float> keytimes ( frames );
+   float kt=0;
+   for ( int f=0; f<frames; f++ )
+	{ postures[f] = new KnPosture ( ch );
+	  postures[f]->values[0] = float(f);
+	  keytimes[f] = kt;
+	  kt += uniform? 1.0f/120.0f : gs_random(0.001f,0.02f);
+	}
+   KnMotion* m = new KnMotion;
+   m->makeasref ( postures, keytimes );
+   if ( uniform ) m->set_freq ( 1.0f/120.0f );
+   return m;
+ }
+
+// the linear search previously used by KnMotion::apply():
+static int linear_search ( KnMotion* m, float t, int lastf )
+ {
+   int f, fini=0, fsize=m->frames();
+   if ( lastf>0 && lastf<fsize && t>m->keytime(lastf) ) fini=lastf+1;
+   for ( f=fini; f<fsize; f++ ) if ( t<m->keytime(f) ) break;
+   return f-1;
+ }
+
+static void test_motion ( KnMotion* m, const char* name )
+ {
+   const int RUNS=2000;
+   int i, f, errors=0;
+   float kt0=m->keytime(0), ktn=m->last_keytime();
+   GsRandom<float> r ( kt0-0.1f, ktn+0.1f );
+
+   // random access with random hints, and exact keytimes:
+   for ( i=0; i<RUNS; i++ )
+	{ float t = r.get();
+	  if ( m->search_frame(t,gs_random(-1,(int)m->frames()))!=linear_search(m,t,0) ) errors++;
+	  f = gs_random(0,(int)m->frames()-1);
+	  if ( m->search_frame(m->keytime(f),f-1)!=linear_search(m,m->keytime(f),0) ) errors++;
+	}
+   gsout << name << ": " << m->frames() << " frames, " << errors << " search errors\n";
+
+   // backward playback applied to a posture:
+   KnChannels* ch = new KnChannels;
+   ch->add ( "root", KnChannel::XPos );
+   KnPosture target ( ch );
+   m->connect ( &target );
+   float d=0;
+   for ( i=0; i<RUNS; i++ )
+	{ float t = ktn - (ktn-kt0)*float(i)/float(RUNS);
+	  m->apply ( t );
+	  f = linear_search ( m, t, 0 );
+	  float v = float(f) + (t-m->keytime(f))/(m->keytime(f+1)-m->keytime(f));
+	  d = GS_MAX ( d, GS_DIST(v,target.values[0]) );
+	}
+   gsout << "Backward playback max difference: " << d << gsnl;
+
+   // timings of backward playback:
+   GsTimer timer(0);
+   double tl, tb;
+   int lastf=0, sum=0;
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) sum += lastf = linear_search ( m, ktn-(ktn-kt0)*float(i)/float(RUNS), lastf );
+   timer.stop (); tl = timer.dt();
+   lastf = 0;
+   timer.start ();
+   for ( i=0; i<RUNS; i++ ) sum -= lastf = m->search_frame ( ktn-(ktn-kt0)*float(i)/float(RUNS), lastf );
+   timer.stop (); tb = timer.dt();
+   gsout << "Backward search linear: " << 1.0E6*tl/RUNS << "us, search_frame: " << 1.0E6*tb/RUNS
+		 << "us" << (sum? " (different results)":"") << gsnl;
+ }
+
+void test_keyframes ()
+ {
+   KnMotion* m = make_motion ( 100000, true );
+   m->ref ();
+   test_motion ( m, "Uniform motion" );
+   m->unref ();
+
+   m = make_motion ( 100000, false );
+   m->ref ();
+   test_motion ( m, "Non-uniform motion" );
+   m->unref ();
+ }
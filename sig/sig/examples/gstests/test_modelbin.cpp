@@ -0,0 +1,172 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <string.h>
+# include <stdio.h>
+# include <sig/gs_model_bvh.h>
+# include <sig/gs_primitive.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+
+// makes a wavy grid of nxn quads with normals, texture coordinates and two material groups:
+static void make_grid ( GsModel& m, int n )
+ {
+   m.init ();
+   for ( int i=0; i<=n; i++ )
+	for ( int j=0; j<=n; j++ )
+	 { float x=10.0f*float(i)/n, y=10.0f*float(j)/n;
+	   m.V.push().set ( x, y, 0.5f*sinf(2*x)*cosf(1.5f*y) );
+	   m.N.push().set ( 0, 0, 1 );
+	   m.T.push().set ( x/10.0f, y/10.0f );
+	 }
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { int v=i*(n+1)+j;
+	   m.F.push().set ( v, v+n+1, v+n+2 );
+	   m.F.push().set ( v, v+n+2, v+1 );
+	 }
+   m.Fn = m.F;
+   m.Ft = m.F;
+   m.M.size ( 2 );
+   m.M[0].init(); m.M[0].diffuse = GsColor::red;
+   m.M[1].init(); m.M[1].diffuse = GsColor::blue;
+   m.G.size ( 2 );
+   m.G[0].init ( 0, m.F.size()/2 );
+   m.G[1].init ( m.F.size()/2, m.F.size()-m.F.size()/2 );
+   m.G[0].mtlname = gs_string_new ( "red" );
+   m.G[1].mtlname = gs_string_new ( "blue" );
+   m.G[1].dmap = new GsModel::Texture;
+   m.G[1].dmap->fname.set ( "grid.png" );
+   m.textured = true;
+   m.culling = false;
+   m.name = "grid";
+   m.detect_mode ();
+ }
+
+template <typename X>
+static bool same ( const GsArray<X>& a, const GsArray<X>& b )
+ {
+   return a.size()==b.size() && memcmp ( (const void*)a.pt(), (const void*)b.pt(), sizeof(X)*a.size() )==0;
+ }
+
+static int compare ( const GsModel& a, const GsModel& b )
+ {
+   int diff=0;
+   if ( !same(a.V,b.V) ) diff++;
+   if ( !same(a.N,b.N) ) diff++;
+   if ( !same(a.T,b.T) ) diff++;
+   if ( !same(a.F,b.F) ) diff++;
+   if ( !same(a.Fn,b.Fn) ) diff++;
+   if ( !same(a.Ft,b.Ft) ) diff++;
+   if ( !same(a.M,b.M) ) diff++;
+   if ( a.G.size()!=b.G.size() ) return diff+1;
+   for ( int i=0; i<a.G.size(); i++ )
+	{ const GsModel::Group &ga=a.G[i], &gb=b.G[i];
+	  if ( ga.fi!=gb.fi || ga.fn!=gb.fn ) diff++;
+	  if ( (ga.mtlname==0)!=(gb.mtlname==0) || (ga.mtlname && strcmp(ga.mtlname,gb.mtlname)) ) diff++;
+	  if ( (ga.dmap==0)!=(gb.dmap==0) || (ga.dmap && strcmp(ga.dmap->fname.pt,gb.dmap->fname.pt)) ) diff++;
+	}
+   if ( a.name!=b.name || a.culling!=b.culling || a.textured!=b.textured ) diff++;
+   if ( a.geomode()!=b.geomode() || a.mtlmode()!=b.mtlmode() ) diff++;
+   if ( (a.primitive==0)!=(b.primitive==0) ) diff++;
+   if ( a.primitive && memcmp((const void*)a.primitive,(const void*)b.primitive,sizeof(GsPrimitive)) ) diff++;
+   return diff;
+ }
+
+// writes an int at position pos of the section s, using the offsets in the file header:
+static void corrupt ( const char* file, int s, long pos, int value )
+ {
+   FILE* fp = fopen ( file, "r+b" );
+   if ( !fp ) return;
+   uint64_t offset=0;
+   fseek ( fp, 24+16*s, SEEK_SET ); // magic, version, byte order, name and flags precede the sections
+   if ( fread(&offset,sizeof(offset),1,fp)==1 )
+	{ fseek ( fp, long(offset)+pos, SEEK_SET );
+	  fwrite ( &value, sizeof(int), 1, fp );
+	}
+   fclose ( fp );
+ }
+
+void test_modelbin ()
+ {
+   GsModel m, m1, m2;
+   GsTimer timer(0);
+   GsRandom<float> r;
+
+   // round trip of a model with all arrays, groups and textures:
+   make_grid ( m, 20 );
+   bool ok = m.save("test_modelbin.mb") && m1.load("test_modelbin.mb");
+   gsout << "Grid round trip: " << (ok?"ok":"failed") << ", differences: " << compare(m,m1) << gsnl;
+
+   // primitives, and detection by signature of a binary file saved with .m extension:
+   GsPrimitive p;
+   p.ra = 1.5f;
+   m.make_primitive ( p );
+   ok = m.save_bin("test_modelbin.m") && m1.load("test_modelbin.m");
+   gsout << "Primitive round trip with .m name: " << (ok?"ok":"failed") << ", differences: " << compare(m,m1) << gsnl;
+
+   // truncated and text files are rejected:
+   FILE* fp = fopen ( "test_modelbin.m", "r+b" );
+   if ( fp ) { fseek ( fp, 8, SEEK_SET ); fputc ( 99, fp ); fclose ( fp ); }
+   gsout << "Wrong version rejected: " << (m1.load_bin("test_modelbin.m")?"no":"yes") << gsnl;
+   m.save ( "test_modelbin.m" );
+   gsout << "Text file detected as binary: " << (GsModel::binary_file("test_modelbin.m")?"yes":"no") << gsnl;
+
+   // groups referencing missing faces are rejected, and a corrupted hierarchy is rebuilt:
+   make_grid ( m, 20 );
+   m.save_bin ( "test_modelbin.mb", true );
+   corrupt ( "test_modelbin.mb", 7, 4, m.F.size()+1 ); // fn of the first group
+   gsout << "Group out of range rejected: " << (m1.load_bin("test_modelbin.mb")?"no":"yes") << gsnl;
+   m.save_bin ( "test_modelbin.mb", true );
+   corrupt ( "test_modelbin.mb", 11, 0, -1 ); // first face index of the hierarchy
+   ok = m1.load_bin ( "test_modelbin.mb" );
+   int pickdiff=0;
+   for ( int i=0; i<200; i++ )
+	{ GsPnt p ( 10.0f*r.get(), 10.0f*r.get(), 2.0f );
+	  GsLine ray ( p, p+GsVec(2.0f*r.get()-1.0f,2.0f*r.get()-1.0f,-1.0f) );
+	  if ( m.pick_face(ray)!=m1.pick_face(ray) ) pickdiff++;
+	}
+   gsout << "Corrupted bvh: " << (ok?"loaded":"rejected") << ", picks: " << pickdiff << gsnl;
+
+   // load times and reuse of the stored hierarchy (text files round the coordinates, so
+   // the binary model is compared with the original one):
+   for ( int n=100; n<=800; n*=2 )
+	{ make_grid ( m, n );
+	  m.save ( "test_modelbin.m" );
+	  m.save_bin ( "test_modelbin.mb", true );
+
+	  timer.start ();
+	  m1.load ( "test_modelbin.m" );
+	  timer.stop ();
+	  double t0 = timer.dt();
+	  timer.start ();
+	  m2.load ( "test_modelbin.mb" );
+	  timer.stop ();
+	  double t1 = timer.dt();
+
+	  timer.start ();
+	  const GsModelBvh& bvh = m2.bvh();
+	  timer.stop ();
+	  double tb = timer.dt();
+	  m1.bvh ();
+
+	  int pickdiff=0;
+	  for ( int i=0; i<200; i++ )
+	   { GsPnt p ( 10.0f*r.get(), 10.0f*r.get(), 2.0f );
+		 GsLine ray ( p, p+GsVec(2.0f*r.get()-1.0f,2.0f*r.get()-1.0f,-1.0f) );
+		 if ( m1.pick_face(ray)!=m2.pick_face(ray) ) pickdiff++;
+	   }
+
+	  gsout << "F=" << m.F.size() << ": load .m " << (1000.0*t0) << "ms, .mb " << (1000.0*t1) << "ms"
+			<< " | stored bvh: " << bvh.nodes() << " nodes, " << (1000.0*tb) << "ms"
+			<< " | differences: " << compare(m,m2) << ", picks: " << pickdiff << gsnl;
+	}
+
+   remove ( "test_modelbin.m" );
+   remove ( "test_modelbin.mb" );
+ }
@@ -0,0 +1,117 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <stdio.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_quat.h>
+# include <sigkin/kn_motion.h>
+
+static KnMotion* make_motion ( int joints, int frames )
+ {
+   KnChannels* ch = new KnChannels;
+   ch->add ( "root", KnChannel::XPos );
+   ch->add ( "root", KnChannel::ZPos );
+   GsString name;
+   for ( int j=0; j<joints; j++ )
+	{ name.setf ( "joint%d", j );
+	  ch->add ( (const char*)name, KnChannel::Quat );
+	  if ( j%4==3 ) ch->add ( (const char*)name, KnChannel::YRot );
+	}
+   GsArray<KnPosture*> postures ( frames );
+   GsArray<float> keytimes ( frames );
+   for ( int f=0; f<frames; f++ )
+	{ KnPosture* p = postures[f] = new KnPosture ( ch );
+	  float t = float(f)/30.0f;
+	  keytimes[f] = t;
+	  float* v = p->values.pt();
+	  *v++ = 20.0f*sinf(t);
+	  *v++ = 10.0f*t;
+	  for ( int j=0; j<joints; j++ )
+	   { GsQuat q ( GsVec(float(j%2),1.0f,float(j%3)), 0.6f*sinf(0.7f*t+float(j)) );
+		 *v++=q.w; *v++=q.x; *v++=q.y; *v++=q.z;
+		 if ( j%4==3 ) *v++ = cosf(t);
+	   }
+	}
+   KnMotion* m = new KnMotion;
+   m->makeasref ( postures, keytimes );
+   m->name ( "walk" );
+   m->ref ();
+   return m;
+ }
+
+// max difference in the keytimes and values of two motions, or -1 if their sizes differ:
+static float compare ( KnMotion* m1, KnMotion* m2 )
+ {
+   if ( m1->frames()!=m2->frames() || m1->postfloats()!=m2->postfloats() ) return -1;
+   if ( m1->channels()->size()!=m2->channels()->size() ) return -1;
+   float d=0;
+   for ( int f=0; f<(int)m1->frames(); f++ )
+	{ d = GS_MAX ( d, GS_DIST(m1->keytime(f),m2->keytime(f)) );
+	  for ( int k=0; k<m1->postfloats(); k++ )
+		d = GS_MAX ( d, GS_DIST(m1->posture(f)->values[k],m2->posture(f)->values[k]) );
+	}
+   return d;
+ }
+
+void test_motionbin ()
+ {
+   GsTimer timer(0);
+   GsString cache;
+   KnMotion::cache_file ( "test_motionbin.sm", cache );
+   remove ( cache );
+
+   KnMotion* m = make_motion ( 40, 1200 );
+   m->save ( "test_motionbin.sm" );
+
+   // first load parses the text file and generates the cache:
+   KnMotion m1, m2;
+   timer.start(); bool ok = m1.load("test_motionbin.sm"); timer.stop();
+   double t0 = timer.dt();
+   gsout << "Text load: " << (ok?"ok":"failed") << ", " << (1000.0*t0) << "ms, cache generated: "
+		 << (KnMotion::binary_file(cache)?"yes":"no") << gsnl;
+
+   // second load uses the cache:
+   timer.start(); ok = m2.load("test_motionbin.sm"); timer.stop();
+   double t1 = timer.dt();
+   gsout << "Cached load: " << (ok?"ok":"failed") << ", " << (1000.0*t1) << "ms (" << (t0/t1) << "x)"
+		 << ", name: " << m2.name() << ", filename: " << m2.filename()
+		 << ", differences: " << compare(&m1,&m2) << gsnl;
+
+   // a change in the source invalidates the cache, which is regenerated:
+   KnMotion* ms = make_motion ( 40, 600 );
+   ms->save ( "test_motionbin.sm" );
+   ok = m2.load_bin ( cache, "test_motionbin.sm" );
+   gsout << "Outdated cache rejected: " << (ok?"no":"yes");
+   m2.load ( "test_motionbin.sm" );
+   gsout << ", reloaded frames: " << m2.frames() << ", cache valid: "
+		 << (m1.load_bin(cache,"test_motionbin.sm")?"yes":"no") << ", frames: " << m1.frames() << gsnl;
+
+   // without cache the text file is parsed:
+   KnMotion::use_cache ( false );
+   timer.start(); m1.load("test_motionbin.sm"); timer.stop();
+   KnMotion::use_cache ( true );
+   gsout << "Load without cache: " << (1000.0*timer.dt()) << "ms, differences: " << compare(&m1,&m2) << gsnl;
+
+   // packed motions are saved decompressed:
+   KnMotionPack::Params params;
+   m->pack_frames ( params );
+   ok = m->save_bin("test_motionbin.kmb") && m2.load("test_motionbin.kmb");
+   m->unpack_frames ();
+   gsout << "Packed round trip: " << (ok?"ok":"failed") << ", packed: " << m2.packed()
+		 << ", differences: " << compare(m,&m2) << gsnl;
+
+   // corrupted files are rejected:
+   FILE* fp = fopen ( "test_motionbin.kmb", "r+b" );
+   if ( fp ) { fseek ( fp, 8, SEEK_SET ); fputc ( 99, fp ); fclose ( fp ); }
+   gsout << "Wrong version rejected: " << (m2.load("test_motionbin.kmb")?"no":"yes") << gsnl;
+
+   m->unref(); ms->unref();
+   remove ( "test_motionbin.sm" );
+   remove ( "test_motionbin.kmb" );
+   remove ( cache );
+ }
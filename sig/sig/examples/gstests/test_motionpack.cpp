@@ -0,0 +1,127 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_quat.h>
+# include <sigkin/kn_motion.h>
+
+// channels similar to the ones of a mocap skeleton:
+static KnChannels* make_channels ( int joints )
+ {
+   KnChannels* ch = new KnChannels;
+   ch->add ( "root", KnChannel::XPos );
+   ch->add ( "root", KnChannel::YPos );
+   ch->add ( "root", KnChannel::ZPos );
+   GsString name;
+   for ( int j=0; j<joints; j++ )
+	{ name.setf ( "j%d", j );
+	  ch->add ( (const char*)name, KnChannel::Quat );
+	  if ( j%8==7 ) ch->add ( (const char*)name, KnChannel::XRot );
+	}
+   return ch;
+ }
+
+// smooth curves with different frequencies, every 5th joint does not move:
+static KnMotion* make_clip ( int joints, int frames, float seed )
+ {
+   KnChannels* ch = make_channels ( joints );
+   GsArray<KnPosture*> postures ( frames );
+   GsArray<float> keytimes ( frames );
+   for ( int f=0; f<frames; f++ )
+	{ KnPosture* p = postures[f] = new KnPosture ( ch );
+	  float t = float(f)/120.0f;
+	  keytimes[f] = t;
+	  float* v = p->values.pt();
+	  *v++ = 100.0f*sinf(0.3f*t+seed);
+	  *v++ = 90.0f+2.0f*sinf(4.0f*t);
+	  *v++ = 50.0f*t;
+	  for ( int j=0; j<joints; j++ )
+	   { float a = j%5==0? 0.2f : 0.8f*sinf ( (0.5f+0.02f*float(j))*t+seed );
+		 GsQuat q ( GsVec(1.0f,float(j%3),0.5f), a );
+		 *v++=q.w; *v++=q.x; *v++=q.y; *v++=q.z;
+		 if ( j%8==7 ) *v++ = 1.5f*sinf(2.0f*t+seed);
+	   }
+	  keytimes[f] = t;
+	}
+   KnMotion* m = new KnMotion;
+   m->makeasref ( postures, keytimes );
+   m->set_freq ( 1.0f/120.0f );
+   m->ref ();
+   return m;
+ }
+
+// max difference between two motions sampled at several times:
+static float maxdiff ( KnMotion* m1, KnMotion* m2, int samples, double* t1=0, double* t2=0 )
+ {
+   KnPosture p1 ( make_channels(m1->channels()->size()) ), p2 ( p1 );
+   KnChannels* ch = new KnChannels ( *m1->channels() );
+   ch->connect ( &p1 );
+   KnChannels* ch2 = new KnChannels ( *m2->channels() );
+   ch2->connect ( &p2 );
+   ch->ref(); ch2->ref();
+   GsTimer timer(0);
+   float d=0, dur=m1->duration();
+   int lf1=0, lf2=0;
+   if ( t1 ) *t1 = *t2 = 0;
+   for ( int i=0; i<samples; i++ )
+	{ float t = dur*float(i)/float(samples);
+	  timer.start(); KnMotion::apply ( m1, ch, lf1, t, KnMotion::Linear, 0 ); timer.stop();
+	  if ( t1 ) *t1 += timer.dt();
+	  timer.start(); KnMotion::apply ( m2, ch2, lf2, t, KnMotion::Linear, 0 ); timer.stop();
+	  if ( t2 ) *t2 += timer.dt();
+	  for ( int k=0; k<p1.values.size(); k++ ) d = GS_MAX ( d, GS_DIST(p1.values[k],p2.values[k]) );
+	}
+   ch->unref(); ch2->unref();
+   return d;
+ }
+
+void test_motionpack ()
+ {
+   const int JOINTS=60, FRAMES=2400, CLIPS=3;
+   double tu, tp;
+
+   // quantization:
+   float q[4], qd[4];
+   gsuint16 w[3];
+   float qerr=0;
+   for ( int i=0; i<10000; i++ )
+	{ GsQuat Q ( GsVec(gs_random(-1.0f,1.0f),gs_random(-1.0f,1.0f),gs_random(-1.0f,1.0f)), gs_random(-gspi,gspi) );
+	  float s = GS_MAX(GS_MAX(fabsf(Q.w),fabsf(Q.x)),GS_MAX(fabsf(Q.y),fabsf(Q.z)));
+	  if ( Q.w==-s || Q.x==-s || Q.y==-s || Q.z==-s ) Q = Q*-1.0f; // largest component is encoded positive
+	  q[0]=Q.w; q[1]=Q.x; q[2]=Q.y; q[3]=Q.z;
+	  KnMotionPack::encode ( q, w );
+	  KnMotionPack::decode ( w, qd );
+	  float e = 0;
+	  for ( int k=0; k<4; k++ ) e += (q[k]-qd[k])*(q[k]-qd[k]);
+	  qerr = GS_MAX ( qerr, 4.0f*asinf(sqrtf(e)/2.0f) );
+	}
+   gsout << "Smallest-three quantization max error: " << qerr << " radians\n";
+
+   for ( int c=0; c<CLIPS; c++ )
+	{ KnMotion* m = make_clip ( JOINTS, FRAMES, float(c) );
+	  KnMotion* mp = new KnMotion; mp->ref(); *mp = *m;
+	  KnMotion* mr = new KnMotion; mr->ref(); *mr = *m;
+
+	  KnMotionPack::Params params;
+	  mp->pack_frames ( params );
+	  params.reduce = true;
+	  params.lintol = 0.01f;
+	  params.angtol = 0.005f;
+	  mr->pack_frames ( params );
+
+	  gsout << "Clip " << c << " packed: "; mp->frames_pack()->stats().output(gsout); gsout << gsnl;
+	  gsout << "Clip " << c << " reduced: "; mr->frames_pack()->stats().output(gsout); gsout << gsnl;
+	  gsout << "Sampled max difference packed: " << maxdiff(m,mp,5000,&tu,&tp);
+	  gsout << ", reduced: " << maxdiff(m,mr,5000) << gsnl;
+	  gsout << "Apply time: " << 1.0E6*tu/5000 << "us, packed: " << 1.0E6*tp/5000 << "us\n";
+
+	  mr->unpack_frames ();
+	  gsout << "Unpacked max difference: " << maxdiff(m,mr,5000) << ", packed: " << mr->packed() << gsnl;
+	  m->unref(); mp->unref(); mr->unref();
+	}
+ }
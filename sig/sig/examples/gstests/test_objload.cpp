@@ -0,0 +1,295 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <string.h>
+# include <math.h>
+# include <sig/gs_model.h>
+# include <sig/gs_strings.h>
+# include <sig/gs_dirs.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_parallel.h>
+
+//================ the previous GsInput-based importer ================
+
+# define GETID(n,A) in>>n; if (n>0) n--; else if (n<0) n+=A.size()
+
+static void old_get_face ( GsInput& in, GsModel& m, int& vc, int& vt, int& vn )
+{
+	vc = vt = vn = -1;
+	GETID(vc,m.V);
+	if ( in.check()==GsInput::Delimiter )
+	{	in.get();
+		if ( in.check()==GsInput::Number ) { GETID(vt,m.T); }
+		if ( in.check()==GsInput::Delimiter ) { in.get(); GETID(vn,m.N); }
+	}
+}
+
+static GsColor old_read_color ( GsInput& in )
+{
+	float r, g, b;
+	in >> r >> g >> b;
+	return GsColor(r,g,b);
+}
+
+static void old_read_materials ( GsModel& model, GsArray<GsModel::Texture*>& Td, GsStrings& mnames,
+								 const GsString& file, const GsStrings& paths )
+{
+	GsString fullf;
+	GsInput in;
+	in.lowercase(false);
+	for ( int i=0; i<=paths.size(); i++ )
+	{	fullf = i<paths.size()? paths[i] : "";
+		fullf << file;
+		in.init ( fopen(fullf,"rt") );
+		if ( in.valid() ) break;
+	}
+	if ( !in.valid() ) return;
+	in.commentchar ('#');
+	GsArray<GsMaterial>& M = model.M;
+	while ( !in.end() )
+	{	in.get();
+		if ( in.ltoken()=="newmtl" ) { M.push().init(); Td.push()=0; in.get(); mnames.push(in.ltoken()); }
+		else if ( in.ltoken()=="Ka" ) M.top().ambient = old_read_color ( in );
+		else if ( in.ltoken()=="Kd" ) M.top().diffuse = old_read_color ( in );
+		else if ( in.ltoken()=="Ks" ) M.top().specular = old_read_color ( in );
+		else if ( in.ltoken()=="Ke" ) M.top().emission = old_read_color ( in );
+		else if ( in.ltoken()=="Ns" ) in >> M.top().shininess;
+		else if ( in.ltoken()=="d" || in.ltoken()=="Tr" )
+		{	int a = int(in.getf()*255.0f);
+			M.top().diffuse.a = (gsbyte)(GS_BOUND(a,0,255));
+		}
+		else if ( in.ltoken()=="illum" ) { if ( in.geti()==1 ) M.top().specular = GsColor::black; }
+		else if ( in.ltoken()=="map_Kd" || in.ltoken()=="map_Ka" )
+		{	GsString txfile;
+			in.readline(txfile);
+			txfile.trim();
+			GsModel::Texture* tx = new GsModel::Texture;
+			tx->id=-2;
+			tx->fname.set ( txfile );
+			Td.top() = tx;
+			model.textured = 1;
+		}
+		else in.skipline();
+	}
+}
+
+static bool old_process_line ( GsInput& in, GsModel& m, GsArray<int>& Fm, GsStrings& paths, GsStrings& mnames,
+							   int& curmtl, GsArray<int>& va, GsArray<int>& ta, GsArray<int>& na,
+							   GsArray<GsModel::Texture*>& Td )
+{
+	in.get();
+	if ( in.ltoken().len()==0 ) return true;
+	if ( in.ltoken()=="v" ) { m.V.push(); in >> m.V.top(); }
+	else if ( in.ltoken()=="vn" ) { m.N.push(); in >> m.N.top(); }
+	else if ( in.ltoken()=="vt" ) { m.T.push(); in >> m.T.top(); }
+	else if ( in.ltoken()=="f" )
+	{	va.size(0); ta.size(0); na.size(0);
+		while ( true )
+		{	if ( in.get()==GsInput::End ) break;
+			in.unget();
+			old_get_face ( in, m, va.push(), ta.push(), na.push() );
+		}
+		if ( va.size()<3 ) return false;
+		for ( int i=2; i<va.size(); i++ )
+		{	m.F.push().set ( va[0], va[i-1], va[i] );
+			Fm.push() = curmtl;
+			if ( ta[0]>=0 && ta[1]>=0 && ta[i]>=0 ) m.Ft.push().set ( ta[0], ta[i-1], ta[i] );
+			if ( na[0]>=0 && na[1]>=0 && na[i]>=0 ) m.Fn.push().set ( na[0], na[i-1], na[i] );
+		}
+	}
+	else if ( in.ltoken()=="s" ) in.get();
+	else if ( in.ltoken()=="o" ) { in.get(); m.name = in.ltoken(); }
+	else if ( in.ltoken()=="usemtl" || in.ltoken()=="g" )
+	{	in.get ();
+		if ( in.ltype()!=GsInput::End ) { int i = mnames.lsearch ( in.ltoken() ); if ( i>=0 ) curmtl=i; }
+	}
+	else if ( in.ltoken()=="mtllib" )
+	{	GsString token, file;
+		while ( in.check()==GsInput::String )
+		{	in.readline(token);
+			token.trim();
+			extract_filename ( token, file );
+			paths.push ( token );
+			old_read_materials ( m, Td, mnames, file, paths );
+		}
+	}
+	return true;
+}
+
+static bool old_load_obj ( GsModel& m, const char* file )
+{
+	GsInput in ( fopen(file,"r") );
+	if ( !in.valid() ) return false;
+	in.commentchar ( '#' );
+	in.lowercase ( false );
+	GsString path=file, fname;
+	extract_filename(path,fname);
+	GsStrings paths;
+	paths.push ( path );
+	int curmtl = -1;
+	m.init ();
+	m.name = fname;
+	remove_extension ( m.name );
+	GsString line;
+	GsStrings mtlnames;
+	GsArray<int> Fm, v(0,8), t(0,8), n(0,8);
+	GsArray<GsModel::Texture*> Td;
+	GsInput lineinp;
+	lineinp.commentchar('#');
+	while ( in.readline(line)>=0 )
+	{	lineinp.init ( line );
+		if ( !old_process_line(lineinp,m,Fm,paths,mtlnames,curmtl,v,t,n,Td) ) return false;
+	}
+	m.define_groups ( Fm, &mtlnames );
+	for ( int i=0; i<m.G.size(); i++) m.G[i].dmap = Td[i];
+	m.order_transparent_materials ();
+	m.validate();
+	m.compress ();
+	return true;
+}
+
+//============================= comparison ================================
+
+template <typename X>
+static bool same ( const GsArray<X>& a, const GsArray<X>& b )
+{
+	return a.size()==b.size() && ( a.size()==0 || memcmp(a.pt(),b.pt(),sizeof(X)*a.size())==0 );
+}
+
+static int compare ( const GsModel& a, const GsModel& b )
+{
+	int diff=0;
+	if ( !same(a.V,b.V) ) diff++;
+	if ( !same(a.N,b.N) ) diff++;
+	if ( !same(a.T,b.T) ) diff++;
+	if ( !same(a.F,b.F) ) diff++;
+	if ( !same(a.Fn,b.Fn) ) diff++;
+	if ( !same(a.Ft,b.Ft) ) diff++;
+	if ( !same(a.M,b.M) ) diff++;
+	if ( a.name!=b.name || a.textured!=b.textured || a.G.size()!=b.G.size() ) diff++;
+	for ( int i=0; i<a.G.size() && i<b.G.size(); i++ )
+	{	const GsModel::Group &ga=a.G[i], &gb=b.G[i];
+		if ( ga.fi!=gb.fi || ga.fn!=gb.fn ) diff++;
+		if ( gs_compare(ga.mtlname?ga.mtlname:"",gb.mtlname?gb.mtlname:"")!=0 ) diff++;
+		if ( (ga.dmap==0)!=(gb.dmap==0) || ( ga.dmap && gs_compare(ga.dmap->fname.pt,gb.dmap->fname.pt)!=0 ) ) diff++;
+	}
+	return diff;
+}
+
+//============================= test files ================================
+
+static const char* Mtl =
+	"# materials\n"
+	"newmtl red\n Ka 0.1 0.1 0.1\n Kd 1 0 0\n Ks .5 .5 .5\n Ns 32\n illum 2\n"
+	"newmtl Glass_1 # comment\n Kd 0.2 0.3 0.4\n d 0.5\n illum 1\n"
+	"newmtl wood\n Kd 0.6 0.4 0.2\n map_Kd wood.png \n Tr 0.9\n Ke 1 1e-2 -.5\n";
+
+// faces with materials need all texture and normal indices, as required by GsModel::define_groups():
+static const char* Obj1 =
+	"# test file\n"
+	"mtllib test_objload.mtl\n"
+	"o Test_Object\n"
+	"v 0 0 0\nv 1.0 0 0\r\nv 1 1 0 1\n  v 0 1 0\nV -1.5e0 2.5E-1 +3\n"
+	"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1 0\n"
+	"vn 0 0 1\nvn 0 0 -1\n"
+	"usemtl red\n"
+	"f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1 5/1/2\n"
+	"g Glass_1\ns 1\n"
+	"f -4/-4/-2 -3/-3/-2 -2/-2/-2 -1/-1/-2\n"
+	"usemtl unknown\n"
+	"f 1/1/1 2/2/1 3/3/1 # comment\n"
+	"USEMTL WOOD\n"
+	"f 2/1/1 3/2/1 4/3/1\n"
+	"l 1 2\nusemap off\n"
+	"f 3/1/2 2/2/2 1/3/2\n";
+
+// unusual numbers and face definitions:
+static const char* Obj2 =
+	"v 0 0 0\nv 1.2.3 4 5\nv 123456789012345678901 1e30 0.1234567890123456789\nv -0 1e-40 2.5e+2\n"
+	"v .5 -.5 1e\nv -.5 +.5 -.25e1\nv 7 # 8 9\nv 1e5e 2 3\nv 0.000001 -1.17549435e-38 3.4028234e38\nv x 1-2 +-3\n"
+	"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1 0\n"
+	"vn 0 0 1\nvn 0 0 -1\n"
+	"f 1 2 3\nf 1/1 2/2 3/3 4/4\nf 1//1 3//1 4//1\n"
+	"f 5/1/1 6/2 7/3/2 8/4/1 9/1/1\n"
+	"f 2/ 3/2/ 4/3/1\nf 1 5 9 -1 -2 +3 0\nf a/b c d\n"
+	"f 3 2 1\n";
+
+// numbers with a sign followed by a point, which the .m format has always accepted:
+static const char* M1 =
+	"GsModel\nvertices 3\n-.5 +.5 0\n+.25 -.75 .5\n0 -0.5 +1\nfaces 1\n0 1 2\n";
+
+static void write_file ( const char* fname, const char* s )
+{
+	FILE* f = fopen ( fname, "wb" );
+	fputs ( s, f );
+	fclose ( f );
+}
+
+// writes a wavy grid of nxn quads with texture coordinates and normals, as triangles:
+static void write_grid ( const char* fname, int n )
+{
+	FILE* f = fopen ( fname, "wb" );
+	fprintf ( f, "# %d triangles\no grid\n", 2*n*n );
+	for ( int i=0; i<=n; i++ )
+	 for ( int j=0; j<=n; j++ )
+	  { float x=float(i)/n, y=float(j)/n;
+		fprintf ( f, "v %f %f %f\n", x, y, 0.1f*sinf(10*x)*cosf(8*y) );
+		fprintf ( f, "vt %f %f\n", x, y );
+		fprintf ( f, "vn %f %f %f\n", -cosf(10*x)*cosf(8*y), 0.8f*sinf(10*x)*sinf(8*y), 1.0f );
+	  }
+	for ( int i=0; i<n; i++ )
+	 for ( int j=0; j<n; j++ )
+	  { int v=i*(n+1)+j+1;
+		fprintf ( f, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", v, v, v, v+n+1, v+n+1, v+n+1, v+n+2, v+n+2, v+n+2 );
+		fprintf ( f, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", v, v, v, v+n+2, v+n+2, v+n+2, v+1, v+1, v+1 );
+	  }
+	fclose ( f );
+}
+
+void test_objload ()
+{
+	GsModel m1, m2;
+	GsTimer timer(0);
+
+	write_file ( "test_objload.mtl", Mtl );
+	const char* objs[2] = { Obj1, Obj2 };
+	for ( int i=0; i<2; i++ )
+	{	write_file ( "test_objload.obj", objs[i] );
+		bool ok1 = old_load_obj ( m1, "test_objload.obj" );
+		bool ok2 = m2.load_obj ( "test_objload.obj" );
+		gsout << "Test file " << (i+1) << ": loaded " << ok1 << gspc << ok2 << ", V=" << m2.V.size() << " F=" << m2.F.size()
+			  << " M=" << m2.M.size() << " G=" << m2.G.size() << " name=" << m2.name << ", differences " << compare(m1,m2) << gsnl;
+	}
+	remove ( "test_objload.obj" );
+	remove ( "test_objload.mtl" );
+
+	write_file ( "test_objload.m", M1 );
+	bool ok = m2.load ( "test_objload.m" );
+	gsout << "Signed points in .m: loaded " << ok << ", V[0]=" << (m2.V.size()? m2.V[0]:GsPnt::null)
+		  << " V[1]=" << (m2.V.size()>1? m2.V[1]:GsPnt::null) << " F=" << m2.F.size() << gsnl;
+	remove ( "test_objload.m" );
+
+	gsout << "\nGrids:\n";
+	int nts[3] = { 1, 4, gs_hardware_threads() };
+	for ( int n=100; n<=800; n*=2 )
+	{	write_grid ( "test_objload.obj", n );
+		timer.start ();
+		old_load_obj ( m1, "test_objload.obj" );
+		timer.stop ();
+		gsout << "F=" << m1.F.size() << ": GsInput " << (1000.0*timer.dt()) << "ms";
+		for ( int t=0; t<3; t++ )
+		{	if ( t==2 && nts[t]<=4 ) break;
+			timer.start ();
+			m2.load_obj ( "test_objload.obj", nts[t] );
+			timer.stop ();
+			gsout << " | " << nts[t] << " thread(s) " << (1000.0*timer.dt()) << "ms, differences " << compare(m1,m2);
+		}
+		gsout << gsnl;
+	}
+	remove ( "test_objload.obj" );
+}
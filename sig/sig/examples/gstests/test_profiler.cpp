@@ -0,0 +1,63 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <sig/gs_profiler.h>
+# include <sig/gs_parallel.h>
+
+static void work ( int i0, int i1, void* udata )
+ {
+   GsProfileScope scope ( "work" );
+   gs_sleep ( 2 );
+ }
+
+void test_profiler ()
+ {
+   GsProfiler::enable ( true, 4 );
+
+   // 6 frames in a buffer of 4, with nested scopes, counters and gpu times:
+   for ( int i=0; i<6; i++ )
+	{ GsProfiler::next_frame ();
+	  int f = GsProfiler::frame_number();
+	  { GsProfileScope s1 ( "update" );
+		{ GsProfileScope s2 ( "skin" ); gs_sleep(1); }
+		{ GsProfileScope s2 ( "skin" ); gs_sleep(1); }
+		gs_parallel_for ( 2, 2, work, 0 );
+	  }
+	  GsProfiler::count ( GsProfiler::DrawCalls, 10+i );
+	  GsProfiler::count ( GsProfiler::Triangles, 1000 );
+	  GsProfiler::count ( GsProfiler::ProgramSwitches );
+	  GsProfiler::gpu_time ( f, "model", 0.5 );
+	  GsProfiler::gpu_time ( f, "model", 0.25 );
+	  GsProfiler::gpu_time ( f-4, "late", 1.0 ); // may arrive late, is lost if the frame left the buffer
+	}
+   GsProfiler::next_frame ();
+
+   int n = GsProfiler::frames();
+   gsout << "Frames: " << n << ", first: " << GsProfiler::frame(0).number << ", last: " << GsProfiler::frame(n-1).number << gsnl;
+   const GsProfiler::Frame& f = GsProfiler::frame(n-1);
+   gsout << "Draw calls: " << int(f.counters[GsProfiler::DrawCalls]) << ", scopes: " << f.scopes.size()
+		 << ", gpu times: " << f.gpu.size() << " (" << float(f.gpu_ms()) << "ms)\n";
+   int errors=0;
+   for ( int i=0; i<f.scopes.size(); i++ )
+	{ const GsProfiler::Scope& s = f.scopes[i];
+	  if ( s.end<s.start || s.start<f.start || s.end>f.end ) errors++;
+	  if ( s.name==GsString("skin") && s.depth!=1 ) errors++;
+	}
+   gsout << "Scope errors: " << errors << gsnl;
+
+   GsString s;
+   GsProfiler::summary ( n-1, s );
+   gsout << s;
+
+   bool ok = GsProfiler::export_trace ( "test_profiler.json" );
+   gsout << "Trace " << (ok?"saved":"not saved") << " in test_profiler.json\n";
+   remove ( "test_profiler.json" );
+
+   GsProfiler::enable ( false );
+   gsout << "Disabled, frame number: " << GsProfiler::frame_number() << gsnl;
+ }
@@ -0,0 +1,128 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_model_bvh.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+# include <sig/gs_parallel.h>
+
+// makes a wavy height field of nxn quads in [0,10]x[0,10]; the triangles are large enough
+// for the absolute epsilon of GsLine::intersects_triangle(), used in the comparisons:
+static void make_terrain ( GsModel& m, int n )
+ {
+   m.init ();
+   for ( int i=0; i<=n; i++ )
+	for ( int j=0; j<=n; j++ )
+	 { float x=10.0f*float(i)/n, y=10.0f*float(j)/n;
+	   m.V.push().set ( x, y, 0.5f*sinf(2*x)*cosf(1.5f*y) );
+	 }
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { int v=i*(n+1)+j;
+	   m.F.push().set ( v, v+n+1, v+n+2 );
+	   m.F.push().set ( v, v+n+2, v+1 );
+	 }
+   m.detect_mode ();
+ }
+
+// the previous implementation of GsModel::pick_face():
+static int brute_pick ( const GsModel& m, const GsLine& line )
+ {
+   float t, u, v, closestt=0;
+   int closestf=-1;
+   for ( int i=0; i<m.F.size(); i++ )
+	{ const GsModel::Face& f = m.F[i];
+	  if ( line.intersects_triangle ( m.V[f.a], m.V[f.b], m.V[f.c], t, u, v ) )
+	   { if ( closestf<0 || t<closestt ) { closestf=i; closestt=t; } }
+	}
+   return closestf;
+ }
+
+void test_raycast ()
+ {
+   const int NRAYS=200, NBATCH=200000;
+   GsModel m;
+   GsTimer timer(0);
+   GsRandom<float> r;
+   int i;
+
+   for ( int n=50; n<=400; n*=2 )
+	{ make_terrain ( m, n );
+	  GsArray<GsLine> rays(NRAYS);
+	  for ( i=0; i<NRAYS; i++ ) // rays from above with random slopes
+	   { GsPnt p ( 10.0f*r.get(), 10.0f*r.get(), 2.0f );
+		 rays[i].set ( p, p+GsVec(2.0f*r.get()-1.0f,2.0f*r.get()-1.0f,-1.0f) );
+	   }
+
+	  timer.start ();
+	  const GsModelBvh& bvh = m.bvh();
+	  timer.stop ();
+	  double tb = timer.dt();
+
+	  GsArray<int> f1(NRAYS), f2(NRAYS);
+	  timer.start ();
+	  for ( i=0; i<NRAYS; i++ ) f1[i]=brute_pick ( m, rays[i] );
+	  timer.stop ();
+	  double t0 = timer.dt();
+	  timer.start ();
+	  for ( i=0; i<NRAYS; i++ ) f2[i]=m.pick_face ( rays[i] );
+	  timer.stop ();
+	  double t1 = timer.dt();
+
+	  int diff=0, misses=0;
+	  for ( i=0; i<NRAYS; i++ ) { if ( f1[i]!=f2[i] ) diff++; if ( f1[i]<0 ) misses++; }
+	  gsout << "F=" << m.F.size() << ": build " << (1000.0*tb) << "ms, " << bvh.nodes() << " nodes"
+			<< " | per pick: brute force " << (1000.0*t0/NRAYS) << "ms, bvh " << (1000.0*t1/NRAYS) << "ms"
+			<< " | differences " << diff << ", misses " << misses << gsnl;
+	}
+
+   gsout << "\nBatches of " << NBATCH << " rays:\n";
+   GsArray<GsLine> rays(NBATCH);
+   for ( i=0; i<NBATCH; i++ ) // random segments, half of them crossing the terrain
+	{ GsPnt p ( 10.0f*r.get(), 10.0f*r.get(), i%2? 3.0f:0.6f );
+	  rays[i].set ( p, p+GsVec(2.0f*r.get()-1.0f,2.0f*r.get()-1.0f,-2.0f) );
+	}
+   GsModelBvh& bvh = (GsModelBvh&)m.bvh();
+   GsArray<GsModelBvh::Hit> hits;
+   GsArray<gsbyte> anyhits;
+   int nts[3] = { 1, 2, gs_hardware_threads() };
+   for ( int t=0; t<3; t++ )
+	{ if ( t==2 && nts[t]<=2 ) break;
+	  bvh.threads ( nts[t] );
+	  timer.start ();
+	  bvh.closest_hits ( rays, hits, 0, 1.0f );
+	  timer.stop ();
+	  double t0 = timer.dt();
+	  timer.start ();
+	  bvh.any_hits ( rays, anyhits, 0, 1.0f );
+	  timer.stop ();
+	  double t1 = timer.dt();
+	  int nh=0, na=0, diff=0;
+	  for ( i=0; i<NBATCH; i++ )
+	   { if ( hits[i].f>=0 ) nh++;
+		 if ( anyhits[i] ) na++;
+		 if ( (hits[i].f>=0) != (anyhits[i]==1) ) diff++;
+	   }
+	  gsout << nts[t] << " thread(s): closest hits " << (1000.0*t0) << "ms, any hits " << (1000.0*t1) << "ms"
+			<< " | hits " << nh << gspc << na << ", differences " << diff << gsnl;
+	}
+
+   gsout << "\nInvalidation: ";
+   GsLine ray ( GsPnt(5.03f,5.07f,2.0f), GsPnt(5.03f,5.07f,0) );
+   int f = m.pick_face ( ray );
+   const GsModel::Face& face = m.F[f];
+   m.V[face.a].x += 1.0f; m.V[face.b].x += 1.0f; m.V[face.c].x += 1.0f; // moves the face away from the ray
+   m.changed (); // V was changed directly
+   gsout << "face " << f << " -> " << m.pick_face(ray) << ", brute force " << brute_pick(m,ray) << gsnl;
+
+   gsout << "Copy: ";
+   { GsModel c ( m ); // the cached hierarchy is not shared with the copy
+	 gsout << "face " << c.pick_face(ray);
+   }
+   gsout << ", original " << m.pick_face(ray) << gsnl;
+ }
@@ -0,0 +1,113 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_quat.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_parallel.h>
+# include <sig/gs_skinning.h>
+
+// the per-vertex layout used before GsSkinning, with one allocated array of weights per vertex:
+struct Weight { int j; float w; GsVec v; GsVec n; GsQuat q; };
+struct SkinVtx { int n; Weight* w; };
+
+static void pose ( GsArray<GsMat>& G, float ang )
+ {
+   GsMat r, t;
+   t.translation ( 0, 1.0f, 0 );
+   G[0].rotz ( ang );
+   for ( int k=1; k<G.size(); k++ ) { r.rotz(ang); G[k] = G[k-1]*t*r; }
+ }
+
+static float maxdiff ( const GsArray<GsVec>& a, const GsArray<GsVec>& b )
+ {
+   float d=0;
+   for ( int i=0; i<a.size(); i++ ) d = GS_MAX ( d, dist(a[i],b[i]) );
+   return d;
+ }
+
+void test_skinning ()
+ {
+   const int NV=100000, NJ=32, FRAMES=100;
+   int i, k, f;
+
+   // a cylinder along a chain of joints, with 1 to 4 influences per vertex:
+   GsArray<GsPnt> BV(NV);
+   GsArray<GsVec> BN(NV);
+   GsArray<GsMat> IB(NJ), G(NJ);
+   for ( k=0; k<NJ; k++ ) IB[k].translation ( 0, -float(k), 0 ); // joint k is at (0,k,0) in the bind pose
+   GsArray<SkinVtx> SV(NV);
+   GsSkinning sk;
+   sk.begin ();
+   for ( i=0; i<NV; i++ )
+	{ float h = float(NJ-1)*float(i)/float(NV);
+	  float a = float(i%97)*gs2pi/97.0f;
+	  BN[i].set ( cosf(a), 0, sinf(a) );
+	  BV[i].set ( 0.3f*BN[i].x, h, 0.3f*BN[i].z );
+	  int n = 1+i%4;
+	  SV[i].n = n;
+	  SV[i].w = new Weight[n];
+	  float sum=0;
+	  for ( k=0; k<n; k++ ) sum += float(n-k);
+	  for ( k=0; k<n; k++ )
+	   { Weight& w = SV[i].w[k];
+		 w.j = GS_BOUND ( int(h)+k-1, 0, NJ-1 );
+		 w.w = float(n-k)/sum;
+		 w.v = IB[w.j]*BV[i];
+		 w.n = BN[i];
+		 sk.add ( i, w.j, w.w, w.v, w.n );
+	   }
+	}
+   sk.end ();
+   gsout << "Skin with " << sk.vertices() << " vertices, " << sk.influences() << " influences, " << NJ << " joints\n";
+
+   GsArray<GsVec> V1(NV), N1(NV), V2(NV), N2(NV);
+   GsTimer timer(0);
+
+   // per-vertex loop:
+   timer.start ();
+   for ( f=0; f<FRAMES; f++ )
+	{ pose ( G, 0.05f*float(f%20) );
+	  for ( i=0; i<NV; i++ )
+	   { Weight* w = SV[i].w;
+		 GsPnt wv;
+		 GsVec wn;
+		 for ( k=0; k<SV[i].n; k++ )
+		  { const GsMat& m = G[w[k].j];
+			wv += (m*w[k].v) * w[k].w;
+			GsVec r ( m.e11*w[k].n.x + m.e12*w[k].n.y + m.e13*w[k].n.z,
+					  m.e21*w[k].n.x + m.e22*w[k].n.y + m.e23*w[k].n.z,
+					  m.e31*w[k].n.x + m.e32*w[k].n.y + m.e33*w[k].n.z );
+			wn += r * w[k].w;
+		  }
+		 wn.normalize();
+		 V1[i] = wv;
+		 N1[i] = wn;
+	   }
+	}
+   timer.stop ();
+   double t0 = timer.dt();
+   gsout << "Per-vertex loop: " << (1000.0*t0/FRAMES) << "ms per frame\n";
+
+   // packed kernel with 1, 2, and all hardware threads:
+   int nts[3] = { 1, 2, gs_hardware_threads() };
+   for ( int t=0; t<3; t++ )
+	{ int nt = nts[t];
+	  if ( t==2 && nt<=2 ) break;
+	  sk.threads ( nt );
+	  timer.start ();
+	  for ( f=0; f<FRAMES; f++ )
+	   { pose ( G, 0.05f*float(f%20) );
+		 sk.apply ( G.pt(), V2.pt(), N2.pt() );
+	   }
+	  timer.stop ();
+	  gsout << "GsSkinning with " << nt << " thread(s): " << (1000.0*timer.dt()/FRAMES) << "ms per frame, "
+			<< "speedup " << (t0/timer.dt()) << ", max differences " << maxdiff(V1,V2) << gspc << maxdiff(N1,N2) << gsnl;
+	}
+
+   for ( i=0; i<NV; i++ ) delete[] SV[i].w;
+ }
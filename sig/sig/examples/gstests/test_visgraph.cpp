@@ -0,0 +1,119 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sig/gs_vis_graph.h>
+# include <sig/gs_geo2.h>
+# include <sig/gs_random.h>
+# include <sig/gs_timer.h>
+
+// visibility test of the previous build, testing all polygon edges:
+static bool ref_free ( const GsVisGraph& vg, int np, GsVisGraphNode* n1, GsVisGraphNode* n2, int p1, int v1, int p2, int v2 )
+ {
+   const GsPnt2& a = n1->p;
+   const GsPnt2& b = n2->p;
+   for ( int pi=0; pi<np; pi++ )
+	for ( int vi=0, vis=vg.psize(pi); vi<vis; vi++ )
+	 { int vip = (vi+1)%vis;
+	   if ( pi==p1 && (vi==v1||vip==v1) ) continue;
+	   if ( pi==p2 && (vi==v2||vip==v2) ) continue;
+	   const GsPnt2& c = vg.node(pi,vi)->p;
+	   const GsPnt2& d = vg.node(pi,vip)->p;
+	   if ( gs_segments_intersect(a.x,a.y,b.x,b.y, c.x,c.y,d.x,d.y) ) return false;
+	 }
+   return true;
+ }
+
+static void ref_link ( GsArrayPt<GsArray<GsVisGraphNode*>>& adj, GsVisGraphNode* n1, GsVisGraphNode* n2 )
+ {
+   GsArray<GsVisGraphNode*>& a1 = *adj[n1->id()];
+   for ( int i=0; i<a1.size(); i++ ) if ( a1[i]==n2 ) return;
+   a1.push() = n2;
+   adj[n2->id()]->push() = n1;
+ }
+
+// the links of the previous build, in the order they were created:
+static void ref_build ( const GsVisGraph& vg, int np, GsArrayPt<GsArray<GsVisGraphNode*>>& adj )
+ {
+   double x, y;
+   for ( int pa=0; pa<np; pa++ )
+	for ( int va=0, vas=vg.psize(pa); va<vas; va++ )
+	 { int vam=(va+vas-1)%vas, vap=(va+1)%vas;
+	   GsVisGraphNode* na = vg.node(pa,va);
+	   const GsPnt2& a = na->p;
+	   const GsPnt2& am = vg.node(pa,vam)->p;
+	   const GsPnt2& ap = vg.node(pa,vap)->p;
+	   if ( ref_free(vg,np,na,vg.node(pa,vap),pa,va,pa,vap) ) ref_link ( adj, na, vg.node(pa,vap) );
+	   if ( ccw(am,a,ap)<=0 ) continue;
+	   for ( int pb=0; pb<np; pb++ )
+		for ( int vb=0, vbs=vg.psize(pb); vb<vbs; vb++ )
+		 { int vbm=(vb+vbs-1)%vbs, vbp=(vb+1)%vbs;
+		   if ( pb==pa && (va==vb||va==vbm||va==vbp) ) continue;
+		   const GsPnt2& b = vg.node(pb,vb)->p;
+		   const GsPnt2& bm = vg.node(pb,vbm)->p;
+		   const GsPnt2& bp = vg.node(pb,vbp)->p;
+		   if ( ccw(bm,b,bp)<=0 ) continue;
+		   if ( gs_segment_line_intersect ( am.x,am.y,ap.x,ap.y, a.x,a.y,b.x,b.y, x,y ) ) continue;
+		   if ( gs_segment_line_intersect ( bm.x,bm.y,bp.x,bp.y, a.x,a.y,b.x,b.y, x,y ) ) continue;
+		   if ( ref_free(vg,np,na,vg.node(pb,vb),pa,va,pb,vb) ) ref_link ( adj, na, vg.node(pb,vb) );
+		 }
+	 }
+ }
+
+static void make_obstacles ( GsPolygons& pols, int n, float size )
+ {
+   GsRandom<float> r;
+   for ( int i=0; i<n; i++ )
+	{ GsPolygon& p = pols.push();
+	  p.circle_approximation ( GsPnt2(size*r.get(),size*r.get()), 0.5f+1.5f*r.get(), 3+int(6*r.get()) );
+	  for ( int k=0; k<p.size(); k++ ) p[k] += GsVec2 ( 0.3f*r.get(), 0.3f*r.get() );
+	}
+ }
+
+void test_visgraph ()
+ {
+   GsTimer timer(0);
+   int sizes[3] = { 50, 120, 250 };
+   for ( int t=0; t<3; t++ )
+	{ GsPolygons* pols = new GsPolygons;
+	  pols->ref();
+	  make_obstacles ( *pols, sizes[t], 10.0f*sqrtf(float(sizes[t])) );
+	  float r = t==1? 0.2f : -1.0f;
+
+	  GsVisGraph vg;
+	  timer.start(); vg.build ( pols, r, 0.5f, 1 ); timer.stop();
+	  double t1 = timer.dt();
+	  timer.start(); vg.build ( pols, r, 0.5f ); timer.stop();
+	  double tn = timer.dt();
+
+	  int np = pols->size(), nodes = vg.num_nodes();
+	  GsArrayPt<GsArray<GsVisGraphNode*>> adj;
+	  for ( int i=0; i<nodes; i++ ) adj.push();
+	  timer.start(); ref_build ( vg, np, adj ); timer.stop();
+	  double tr = timer.dt();
+
+	  // compare the links of all nodes, including their order:
+	  int diffs=0, links=0;
+	  for ( int pi=0; pi<np; pi++ )
+	   for ( int vi=0; vi<vg.psize(pi); vi++ )
+		{ GsVisGraphNode* n = vg.node(pi,vi);
+		  const GsArray<GsVisGraphNode*>& a = *adj[n->id()];
+		  links += n->nlinks();
+		  if ( a.size()!=n->nlinks() ) { diffs++; continue; }
+		  for ( int k=0; k<a.size(); k++ ) if ( n->link(k)->node()!=a[k] ) { diffs++; break; }
+		}
+	  gsout << np << " obstacles, " << nodes << " vertices, " << links/2 << " edges: previous build "
+			<< (1.0E3*tr) << "ms, grid " << (1.0E3*t1) << "ms, parallel " << (1.0E3*tn)
+			<< "ms, nodes with different links: " << diffs << gsnl;
+
+	  GsPolygon path;
+	  float cost;
+	  bool found = vg.search_shortest_path ( GsPnt2(-1,-1), GsPnt2(1000,1000), path, &cost );
+	  gsout << "Path found: " << (found?"yes":"no") << ", vertices: " << path.size() << ", cost: " << cost << gsnl;
+	  pols->unref();
+	}
+ }
@@ -0,0 +1,83 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_timer.h>
+# include <sig/gs_random.h>
+
+// makes a "triangle soup" grid of nxn quads, each triangle with its own vertices, normals and texture coordinates:
+static void make_soup ( GsModel& m, int n, float jitter )
+ {
+   GsRandom<float> r ( -jitter, jitter );
+   m.init ();
+   for ( int i=0; i<n; i++ )
+	for ( int j=0; j<n; j++ )
+	 { int c[6][2] = { {i,j}, {i+1,j}, {i+1,j+1}, {i,j}, {i+1,j+1}, {i,j+1} };
+	   for ( int k=0; k<6; k++ )
+		{ m.V.push().set ( float(c[k][0])+r.get(), float(c[k][1])+r.get(), 0 );
+		  m.T.push().set ( float(c[k][0])/n, float(c[k][1])/n );
+		  m.N.push() = GsVec::k;
+		}
+	   for ( int k=0; k<6; k+=3 )
+		{ int v=m.V.size()-6+k;
+		  m.F.push().set ( v, v+1, v+2 );
+		  m.Fn.push().set ( v, v+1, v+2 );
+		  m.Ft.push().set ( v, v+1, v+2 );
+		}
+	 }
+   m.detect_mode ();
+ }
+
+// returns the max distance between the vertices of the faces of both models:
+static float maxdiff ( const GsModel& m1, const GsModel& m2 )
+ {
+   float d=0;
+   for ( int i=0; i<m1.F.size(); i++ )
+	{ for ( int k=0; k<3; k++ )
+	   { d = GS_MAX ( d, dist ( m1.V[(&m1.F[i].a)[k]], m2.V[(&m2.F[i].a)[k]] ) );
+		 d = GS_MAX ( d, dist ( m1.N[(&m1.Fn[i].a)[k]], m2.N[(&m2.Fn[i].a)[k]] ) );
+	   }
+	}
+   return d;
+ }
+
+void test_weld ()
+ {
+   GsModel m, orig;
+   GsTimer timer(0);
+
+   for ( int n=10; n<=400; n*=2 )
+	{ make_soup ( orig, n, 0.0001f );
+	  m = orig;
+	  timer.start ();
+	  m.weld ( 0.001f );
+	  timer.stop ();
+	  gsout << "Grid " << n << "x" << n << ": V " << orig.V.size() << "->" << m.V.size()
+			<< " N " << orig.N.size() << "->" << m.N.size()
+			<< " T " << orig.T.size() << "->" << m.T.size()
+			<< " (expected V " << (n+1)*(n+1) << ") in " << (1000.0*timer.dt()) << "ms"
+			<< ", max difference " << maxdiff(orig,m) << gsnl;
+	}
+
+   gsout << "\nSeparate calls on the last grid:\n";
+   m = orig;
+   timer.start ();
+   m.merge_redundant_vertices ( 0.001f );
+   m.remove_redundant_normals ( 0.001f );
+   timer.stop ();
+   gsout << "V " << m.V.size() << " N " << m.N.size() << " in " << (1000.0*timer.dt()) << "ms"
+		 << ", max difference " << maxdiff(orig,m) << gsnl;
+
+   gsout << "\nSmooth mode: ";
+   m.init ();
+   m.make_sphere ( GsPnt::null, 1.0f, 20, true );
+   int vs = m.V.size();
+   m.V.push() = m.V[0]; m.N.push() = m.N[0]; // a duplicated vertex with its normal
+   m.F[0].a = m.V.size()-1;
+   m.merge_redundant_vertices ();
+   gsout << "V " << vs << "+1->" << m.V.size() << " N " << m.N.size() << " face index " << m.F[0].a << gsnl;
+ }
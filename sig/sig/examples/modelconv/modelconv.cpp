@@ -0,0 +1,62 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_model.h>
+# include <sig/gs_timer.h>
+
+// Converts models between the formats supported by GsModel. The output format is chosen
+// by the output extension, or is the binary format if option -b is given, which allows
+// replacing .m files referenced by other files, like skeletons, by binary versions.
+
+static void usage ()
+{
+	gsout << "Usage: modelconv [-b] [-bvh] <input> [output]\n"
+			 " Loads a model in any format supported by GsModel::load() and saves it\n"
+			 " according to the output extension (.m, .mb or .iv).\n"
+			 " If no output is given, the input is saved with extension .mb.\n"
+			 " -b: saves in binary format whatever the output extension is\n"
+			 " -bvh: also saves the bounding volume hierarchy in binary files\n";
+}
+
+int main ( int argc, char** argv )
+{
+	bool bin=false, bvh=false;
+	const char *input=0, *output=0;
+
+	for ( int i=1; i<argc; i++ )
+	{	GsString s ( argv[i] );
+		if ( s=="-b" ) bin=true;
+		else if ( s=="-bvh" ) bvh=true;
+		else if ( !input ) input=argv[i];
+		else if ( !output ) output=argv[i];
+		else { usage(); return 1; }
+	}
+	if ( !input ) { usage(); return 1; }
+
+	GsString outf;
+	if ( output )
+	{	outf = output;
+	}
+	else
+	{	outf = input;
+		remove_extension ( outf );
+		outf << ".mb";
+	}
+	if ( has_extension(outf,"mb") ) bin=true;
+
+	GsModel m;
+	GsTimer timer(0);
+	timer.start();
+	if ( !m.load(input) ) { gsout << "Could not load " << input << "!\n"; return 1; }
+	timer.stop();
+	gsout << input << ": " << m.V.size() << " vertices, " << m.F.size() << " faces, loaded in " << (1000.0*timer.dt()) << "ms\n";
+
+	bool ok = bin? m.save_bin(outf,bvh) : m.save(outf);
+	if ( !ok ) { gsout << "Could not save " << outf << "!\n"; return 1; }
+	gsout << "Saved " << outf << (bin?" (binary)":"") << gsnl;
+	return 0;
+}
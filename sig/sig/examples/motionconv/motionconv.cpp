@@ -0,0 +1,82 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sigkin/kn_motion.h>
+# include <sig/gs_timer.h>
+
+// Generates the binary cache files of motions, as done by KnMotion::load(), so that
+// applications do not have to parse the text files the first time they are loaded.
+// With option -o a single motion is converted to the format of the output extension.
+
+static void usage ()
+{
+	gsout << "Usage: motionconv [-f] <motion1> [motion2 ...]\n"
+			 "       motionconv -o <output> <input>\n"
+			 " Loads .sm or .bvh motions and generates their binary cache files (.kmb\n"
+			 " added to the file name), which KnMotion::load() then uses while the\n"
+			 " motion file is not changed. Up to date cache files are not regenerated.\n"
+			 " -f: regenerates cache files even if they are up to date\n"
+			 " -o: saves the input motion in output according to its extension, which\n"
+			 "     is the binary format for .kmb and the .sm format otherwise\n";
+}
+
+static bool convert ( const char* input, const char* output )
+{
+	KnMotion m;
+	GsTimer timer(0);
+	timer.start();
+	if ( !m.load(input) ) { gsout << "Could not load " << input << "!\n"; return false; }
+	timer.stop();
+	gsout << input << ": " << m.channels()->size() << " channels, " << m.frames() << " frames, loaded in " << (1000.0*timer.dt()) << "ms\n";
+
+	bool bin = has_extension(output,"kmb");
+	bool ok = bin? m.save_bin(output) : m.save(output);
+	if ( !ok ) { gsout << "Could not save " << output << "!\n"; return false; }
+	gsout << "Saved " << output << (bin?" (binary)":"") << gsnl;
+	return true;
+}
+
+static bool cache ( const char* input, bool force )
+{
+	GsString cachef;
+	KnMotion::cache_file ( input, cachef );
+	KnMotion m;
+	if ( !force && m.load_bin(cachef,input) ) { gsout << cachef << ": up to date\n"; return true; }
+
+	GsTimer timer(0);
+	timer.start();
+	if ( !m.load(input) ) { gsout << "Could not load " << input << "!\n"; return false; }
+	timer.stop();
+	if ( !m.save_bin(cachef,input) ) { gsout << "Could not save " << cachef << "!\n"; return false; }
+	gsout << cachef << ": " << m.frames() << " frames, text loaded in " << (1000.0*timer.dt()) << "ms\n";
+	return true;
+}
+
+int main ( int argc, char** argv )
+{
+	bool force=false;
+	const char* output=0;
+	GsArray<const char*> inputs;
+
+	for ( int i=1; i<argc; i++ )
+	{	GsString s ( argv[i] );
+		if ( s=="-f" ) force=true;
+		else if ( s=="-o" && i+1<argc ) output=argv[++i];
+		else inputs.push() = argv[i];
+	}
+	if ( inputs.empty() || (output && inputs.size()!=1) ) { usage(); return 1; }
+
+	KnMotion::use_cache ( false ); // motions are loaded here from their text files
+	if ( output ) return convert(inputs[0],output)? 0:1;
+
+	int errors=0;
+	for ( int i=0; i<inputs.size(); i++ )
+	{	if ( !cache(inputs[i],force) ) errors++;
+	}
+	if ( inputs.size()>1 ) gsout << inputs.size() << " motions, " << errors << " errors\n";
+	return errors? 1:0;
+}
@@ -12,12 +12,23 @@
  * contains a collision detector implementation */
 
 # include <sig/gs_model.h>
+# include <sig/gs_slot_map.h>
 
 /* CdImplementation encapsulates a collision
-   detection algorithm to be connected to a CdManager class */
+   detection algorithm to be connected to a CdManager class.
+   The default implementation keeps one bounding volume hierarchy per
+   inserted model, with axis-aligned boxes in the local frame of the model,
+   which become oriented boxes once the object transformation is applied.
+   A sweep-and-prune broad phase over the transformed boxes selects candidate
+   pairs, and the hierarchies are then traversed with exact triangle tests. */
 class CdImplementation : public GsShareable
  { protected:
 	GsArray<int> _pairs; // will contain the pairs of detected collisions
+	class Object;
+	GsSlotMap<Object> _objects; // inserted objects, indexed by their ids
+	GsArray<int> _sap;	 // active object ids sorted by the minimum x of their world boxes
+	GsArray<int> _cand;	 // candidate pairs returned by the broad phase
+	GsArray<int> _stack; // pairs of nodes to visit during the traversal of two hierarchies
  
    public:
 	/*! Constructor */
@@ -79,6 +90,10 @@ class CdImplementation : public GsShareable
 		is found to be smaller than the given tolerance.
 		False is returned when all pairs respects the minimum clearance. */
 	virtual bool collide_tolerance ( float toler );
+
+   protected:
+	void _broad_phase ( float toler );
+	bool _collide_pair ( Object* o1, Object* o2, float toler );
  };
 
 #endif // CD_IMPLEMENTATION
@@ -251,6 +251,15 @@ void gs_string_renew ( char*& s, int size );
 	If toadd is null or empty, nothing is done. */
 void gs_string_append ( char*& s, const char* toadd );
 
+/*! Converts a string to a float, giving the same result as (float)atof(s).
+	Numbers with up to 19 significant digits and exponents up to 22 are converted
+	directly, and other cases are passed to atof(). */
+float gs_atof ( const char* s );
+
+/*! Converts a string to an integer, giving the same result as atoi(s) for
+	numbers in the integer range. */
+int gs_atoi ( const char* s );
+
 /*! GsCharPt is a class containing a single char pointer pointing to a
 	c-like string, which is maintained by the class with proper	constructors,
 	a destructor, and additional methods, all implemented inline. */
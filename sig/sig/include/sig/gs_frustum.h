@@ -0,0 +1,60 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_FRUSTUM_H
+# define GS_FRUSTUM_H
+
+/** \file gs_frustum.h
+ * View frustum planes
+ */
+
+# include <sig/gs_mat.h>
+# include <sig/gs_box.h>
+
+//================================ GsFrustum ============================================
+
+/*! GsFrustum keeps the six clipping planes of a projection matrix, for example
+	the full camera matrix given by GsCamera::getmat(m). The planes are extracted
+	directly from the lines of the matrix and are not normalized. If the matrix
+	also includes a modelview transformation m=p*c*t, the planes are in the local
+	coordinates of t and boxes can be tested without being transformed. */
+class GsFrustum
+{  public :
+	/*! Result of box tests */
+	enum Result { Outside, Intersecting, Inside };
+
+   private :
+	float _p[6][4]; // left, right, bottom, top, near, far: (a,b,c,d) with inside ax+by+cz+d>=0
+
+   public :
+	/*! Constructor with the frustum of the identity matrix, ie, the box [-1,1]^3 */
+	GsFrustum () { set(GsMat::id); }
+
+	/*! Constructor with the frustum of matrix m */
+	GsFrustum ( const GsMat& m ) { set(m); }
+
+	/*! Extracts the planes of matrix m */
+	void set ( const GsMat& m );
+
+	/*! Returns the coefficients (a,b,c,d) of plane i in {0,..,5}, in the order
+		left, right, bottom, top, near and far. Points p inside the frustum
+		satisfy a*p.x+b*p.y+c*p.z+d>=0 for all planes. */
+	const float* plane ( int i ) const { return _p[i]; }
+
+	/*! Returns true if p is inside the frustum or on its border */
+	bool contains ( const GsPnt& p ) const;
+
+	/*! Tests box b against the planes. Outside is returned if the box is entirely
+		on the outer side of one plane, what is conservative for boxes near the
+		frustum corners, and Inside if the box is on the inner side of all planes.
+		An empty box is considered Intersecting, so that it is never culled. */
+	Result test ( const GsBox& b ) const;
+};
+
+//================================ End of File =================================================
+
+# endif  // GS_FRUSTUM_H
@@ -14,6 +14,7 @@
 
 # include <sig/gs_array.h>
 # include <sig/gs_list.h>
+# include <sig/gs_heap.h>
 
 //================================ GsGraphLink ============================================
 
@@ -54,6 +55,7 @@ class GsGraphNode : public GsListNode
 {  private :
 	GsArray<GsGraphLink*> _links;
 	gsuint _index;
+	gsuint _id;
 	int _blocked; // used as boolean or as a ref counter
 	GsGraphBase* _graph;
 	friend class GsGraphBase;
@@ -76,6 +78,11 @@ class GsGraphNode : public GsListNode
 	/*! Returns the index of this node */
 	gsuint index () { return _index; }
 
+	/*! Returns the identifier of this node, which is unique in its graph and
+		smaller than GsGraphBase::max_id(). Unlike index(), it is not changed by
+		marking or indexing operations. */
+	gsuint id () const { return _id; }
+
 	int blocked () const { return _blocked; }
 	void blocked ( bool b ) { _blocked = b? 1:0; }
 	void blocked ( int b ) { _blocked = b; }
@@ -143,6 +150,42 @@ const GsArray<L*>& links() const { return (const GsArray<L*>&) GsGraphNode::link
 
 class GsGraphPathTree;
 
+//================================ GsGraphSearch ==============================================
+
+/*! GsGraphSearch keeps the buffers used by GsGraphBase::search_path() and by the searches
+	of GsGraphSnapshot, so that several searches can run at the same time in a graph that
+	is not being modified, each one with its own GsGraphSearch object. Buffers are indexed
+	by node ids, or snapshot indices, and are reused from one search to the next without
+	being cleared. */
+class GsGraphSearch
+{  public :
+	/*! Heuristic function estimating the cost of a path between two nodes */
+	typedef float (*DistFunc) ( const GsGraphNode*, const GsGraphNode*, void* udata );
+
+   private :
+	struct Entry { gsuint stamp; int parent; float cost; int depth; bool closed; GsGraphNode* node; };
+	GsArray<Entry> _entries;       // per node id, valid when stamp==_stamp
+	GsHeap<int,float> _open;       // entry indices
+	gsuint _stamp;
+	int _expanded;
+	friend class GsGraphBase;
+	friend class GsGraphSnapshot;
+
+   public :
+	/*! Constructor with empty buffers */
+	GsGraphSearch ();
+
+	/*! Returns the number of nodes expanded by the last search */
+	int expanded () const { return _expanded; }
+
+	/*! Frees the memory used by the buffers */
+	void compress ();
+
+   private :
+	void _begin ( int n );
+	Entry& _entry ( int i );
+};
+
 /*! GsGraphBase maintains a directed graph with nodes and links. Links around
 	a node do not have any order meaning.
 	Note also that the user should avoid redundant links, as no tests are done
@@ -155,6 +198,8 @@ class GsGraphBase
 	mutable gsuint _curmark;
 	mutable char _mark_status;
 	GsGraphPathTree* _pt;
+	GsGraphSearch* _search; // used by the search_path() version without search object
+	gsuint _nextid;
 	GsManagerBase* _lman; // link manager for a class deriving GsGraphLink
 	mutable gscenum _leave_indices_after_save;
 
@@ -183,6 +228,9 @@ class GsGraphBase
 	/*! Counts and returns the number of (directional) links in the graph */
 	int num_links () const;
 
+	/*! Returns a value greater than the ids of all nodes in the graph, see GsGraphNode::id() */
+	gsuint max_id () const { return _nextid; }
+
 	/*! Methods for marking nodes and links */
 	void begin_marking () const;
 	void end_marking () const;
@@ -250,18 +298,23 @@ class GsGraphBase
 		pairs of start and end positions in array nodes, for each component. */
 	void get_disconnected_components ( GsArray<int>& components, GsArray<GsGraphNode*>& nodes );
 
-	/*! The returned path contains pointers to existing nodes in the graph.
-		In the case the two nodes are in two different disconnected components
-		an empty path is returned. If n1==n2 a path with the single node n1
-		is returned. In all cases, returns the distance (cost) of the path.
-		In case no path is found, the optional parameters distfunc and udata
-		can be used to return the path to the closest processed node to the goal.
-//xxx ***GsGraph is under revision***
-		TodoNote: for improved efficiency (and to save 1 float in GsGraphNode), 
-		this implementation does not have the "relax" test - this is to be revised. */
+	/*! Searches the shortest path from n1 to n2 with A*, using distfunc as heuristic.
+		The returned path contains pointers to existing nodes in the graph and
+		parameter cost receives its cost. True is returned if a path is found.
+		If n1==n2 a path with the single node n1 is returned. When distfunc is null
+		the search is a uniform-cost search. When given, distfunc(n,n1,udata) has to
+		be an estimate that never exceeds the cost of the shortest path between n and n1,
+		and if no path is found, the path from the expanded node closest to n1 according
+		to distfunc to n2 is returned. A weight greater than 1 multiplies the heuristic,
+		leading to faster searches with paths at most weight times longer than the
+		shortest ones. Blocked nodes and links are not traversed. This method only
+		reads the graph, and all search buffers are in s. */
+	bool search_path ( GsGraphSearch& s, GsGraphNode* n1, GsGraphNode* n2, GsArray<GsGraphNode*>& path,
+						float& cost, GsGraphSearch::DistFunc distfunc=0, void* udata=0, float weight=1.0f ) const;
+
+	/*! Same as the method above, using a search object owned by the graph */
 	bool search_path ( GsGraphNode* n1, GsGraphNode* n2, GsArray<GsGraphNode*>& path, float& cost,
-						float (*distfunc) ( const GsGraphNode*, const GsGraphNode*, void* udata )=0,
-						void* udata=0 );
+						GsGraphSearch::DistFunc distfunc=0, void* udata=0, float weight=1.0f );
 
 	/*! Performs an A* search from startn, until finding endn. The search 
 		stops if either maxnodes or maxdist is reached. If these parameters
@@ -277,6 +330,9 @@ class GsGraphBase
 		local_search(). Default is false. */
 	void bidirectional_block_test ( bool b );
 
+	/*! Returns the state set with bidirectional_block_test(bool) */
+	bool bidirectional_block_test () const;
+
 	/*! If this is set to true, it will be the user responsibility to call
 		end_indexing() after the next graph save. It can be used to retrieve the indices
 		used during saving in order to reference additional data to be saved in derived classes. */
@@ -331,9 +387,12 @@ class GsGraph : public GsGraphBase
 	{	GsGraphBase::get_disconnected_components( components, (GsArray<GsGraphNode*>&)nodes ); }
 
 	bool search_path ( N* n1, N* n2, GsArray<N*>& path, float& cost,
-						float (*distfunc) ( const GsGraphNode*, const GsGraphNode*, void* udata )=0,
-						void* udata=0  )
-	{	return GsGraphBase::search_path((GsGraphNode*)n1,(GsGraphNode*)n2,(GsArray<GsGraphNode*>&)path,cost,distfunc,udata); }
+						GsGraphSearch::DistFunc distfunc=0, void* udata=0, float weight=1.0f )
+	{	return GsGraphBase::search_path((GsGraphNode*)n1,(GsGraphNode*)n2,(GsArray<GsGraphNode*>&)path,cost,distfunc,udata,weight); }
+
+	bool search_path ( GsGraphSearch& s, N* n1, N* n2, GsArray<N*>& path, float& cost,
+						GsGraphSearch::DistFunc distfunc=0, void* udata=0, float weight=1.0f ) const
+	{	return GsGraphBase::search_path(s,(GsGraphNode*)n1,(GsGraphNode*)n2,(GsArray<GsGraphNode*>&)path,cost,distfunc,udata,weight); }
 
 	GsArray<N*>& buffer () { return (GsArray<N*>&) GsGraphBase::buffer(); }
 
@@ -0,0 +1,108 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_GRAPH_SNAPSHOT_H
+# define GS_GRAPH_SNAPSHOT_H
+
+/** \file gs_graph_snapshot.h
+ * Compact read-only copy of a graph
+ */
+
+# include <sig/gs_graph.h>
+
+//================================ GsGraphSnapshot ============================================
+
+/*! GsGraphSnapshot is a read-only copy of the connectivity of a GsGraphBase in
+	compressed sparse row form: nodes are numbered from 0 to nodes()-1 and the links
+	of node i are the ones in range [first(i),first(i+1)), with their target nodes,
+	costs and blocked states stored in contiguous arrays. Queries traverse the arrays
+	instead of the nodes and links allocated by the graph, and as they do not change
+	the snapshot, several threads can share one snapshot, each one with its own
+	GsGraphSearch object. The snapshot does not change when the graph is modified and
+	has to be built again to reflect changes. */
+class GsGraphSnapshot
+{  private :
+	GsArray<int> _first;          // first link of each node, with nodes()+1 positions
+	GsArray<int> _target;         // target node of each link
+	GsArray<float> _cost;         // cost of each link
+	GsArray<char> _lblocked;      // blocked state of each link
+	GsArray<char> _nblocked;      // blocked state of each node
+	GsArray<GsGraphNode*> _nodes; // graph node of each index
+	GsArray<int> _index;          // index of each graph node id, or -1
+
+   public :
+	/*! Constructor for an empty snapshot */
+	GsGraphSnapshot () {}
+
+	/*! Constructor building the snapshot of g */
+	GsGraphSnapshot ( const GsGraphBase& g ) { build(g); }
+
+	/*! Makes the snapshot empty */
+	void init ();
+
+	/*! Builds the snapshot of g. Nodes are indexed in the order of the node list
+		of g. When the bidirectional block test of g is on, links with a blocked
+		opposite link are stored as blocked. */
+	void build ( const GsGraphBase& g );
+
+	/*! Returns the number of nodes */
+	int nodes () const { return _nodes.size(); }
+
+	/*! Returns the number of (directional) links */
+	int links () const { return _target.size(); }
+
+	/*! Returns the graph node of index i, which is only valid while the node is in the graph */
+	GsGraphNode* node ( int i ) const { return _nodes[i]; }
+
+	/*! Returns the index of graph node n, or -1 if n was not in the graph */
+	int index ( const GsGraphNode* n ) const { return n->id()<(gsuint)_index.size()? _index[n->id()]:-1; }
+
+	/*! Returns the index of the first link of node i. The links of node i are the
+		ones in range [first(i),first(i+1)), and i can be nodes() */
+	int first ( int i ) const { return _first[i]; }
+
+	/*! Returns the number of links of node i */
+	int nlinks ( int i ) const { return _first[i+1]-_first[i]; }
+
+	/*! Returns the target node of link l */
+	int target ( int l ) const { return _target[l]; }
+
+	/*! Returns the cost of link l */
+	float cost ( int l ) const { return _cost[l]; }
+
+	/*! Returns the blocked state of link l */
+	bool link_blocked ( int l ) const { return _lblocked[l]!=0; }
+
+	/*! Returns the blocked state of node i */
+	bool node_blocked ( int i ) const { return _nblocked[i]!=0; }
+
+	/*! Returns the memory used by the snapshot arrays in bytes */
+	gsuint bytes () const;
+
+	/*! Searches a path from node i1 to node i2 in the same way as GsGraphBase::search_path(),
+		returning in path the node indices from i1 to i2. The heuristic function, if given,
+		receives the graph nodes of the indices. */
+	bool search_path ( GsGraphSearch& s, int i1, int i2, GsArray<int>& path, float& cost,
+						GsGraphSearch::DistFunc distfunc=0, void* udata=0, float weight=1.0f ) const;
+
+	/*! Expands nodes from node start in increasing order of path cost, until finding
+		node end, and returns true if end is reached. The search stops and returns false
+		if the depth (number of links) of the next node to expand is greater than maxdepth,
+		or if its path cost is greater than maxdist; limits that are <=0 are not used.
+		Parameters depth and dist receive the values of the last node considered. */
+	bool local_search ( GsGraphSearch& s, int start, int end, int maxdepth, float maxdist,
+						int& depth, float& dist ) const;
+
+	/*! Organizes node indices by connected components in the same way as
+		GsGraphBase::get_disconnected_components(), following all links, including
+		the blocked ones. Each node appears once in array nodes. */
+	void get_disconnected_components ( GsArray<int>& components, GsArray<int>& nodes ) const;
+};
+
+//================================ End of File =================================================
+
+# endif  // GS_GRAPH_SNAPSHOT_H
@@ -116,6 +116,12 @@ class GsGridBase
 	/*! 3D version of get_intersection() */
 	void get_intersection ( GsPnt a, GsPnt b, GsArray<int>& cells ) const;
 
+	/*! Get the indices of all 2D cells traversed by segment (a,b), considering cells
+		enlarged by eps in all directions, so that cells only touched by the segment,
+		or very close to it, are also included when eps>0. Cells are visited row by row.
+		Indices are just pushed to array cells, which is not emptied before being used */
+	void get_segment_intersection ( GsPnt2 a, GsPnt2 b, GsArray<int>& cells, float eps=0 ) const;
+
 	/*! Returns the index of the cell containing a, or -1 if a is outside the grid */
 	int get_point_location ( GsPnt2 a ) const;
 
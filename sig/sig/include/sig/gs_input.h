@@ -23,7 +23,9 @@ template <typename X> class GsArray;
 
 	GsInput reads data from a string buffer or from a file. It can
 	be used to read data byte per byte, or by parsing tokens that are 
-	recognized as strings, delimiters, or numbers. */
+	recognized as strings, delimiters, or numbers.
+	Files are read in blocks to an internal buffer, and therefore the position
+	of the associated FILE pointer is only updated when filept() is called. */
 class GsInput
 {  public :
 
@@ -44,7 +46,7 @@ class GsInput
    private :
 	struct Data;
 	mutable Data* _data; // some internal data
-	union { FILE  *f; const char *s; } _cur; // the current input position
+	union { FILE  *f; const char *s; } _cur; // the input file or string
 	int		_curline;	 // keeps track of the current line
 	char	_comchar;	 // skip line when _comchar is found
 	gsbyte  _type;		 // the input Type
@@ -53,7 +55,11 @@ class GsInput
 	int		_maxtoksize; // max size allowed for parsed tokens
 	char*   _filename;   // stores file name if one was open for the input
 	void _init ( char c );
-	int	 _peekbyte () { int c=readchar(); unget(c); return c; }
+	bool _refill ();
+	void _sync () const;
+	void _unread ( int c );
+	int  _readchar ();
+	int  _peekbyte ();
 
    public : 
 
@@ -93,13 +99,15 @@ class GsInput
 		filename is cleared and the line number becomes 1. */
 	void close ();
 
-	/*! Puts GsInput into TypeInvalid mode but without closing the associated file.
+	/*! Puts GsInput into TypeInvalid mode but without closing the associated file,
+		which is positioned after the last character read from it.
 		If GsInput is not of File type, the effect is the same as close(). */
 	void abandon ();
 
 	/*! If the input is done from a file, return the associated FILE pointer,
-		otherwise returns 0 */
-	FILE* filept () const { return _type==TypeFile? _cur.f:0; }
+		otherwise returns 0. The file position is set to the current input position,
+		so that the file can be read directly before GsInput is used again. */
+	FILE* filept () const;
 
 	/*! Returns the file name used for opening a file input, or null if not available */
 	const char* filename () const { return _filename; }
@@ -0,0 +1,65 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_MAPPED_FILE_H
+# define GS_MAPPED_FILE_H
+
+/** \file gs_mapped_file.h
+ * read-only memory mapped file */
+
+# include <stddef.h>
+# include <sig/gs.h>
+
+/*! \class GsMappedFile gs_mapped_file.h
+	\brief Read-only memory mapped file
+
+	GsMappedFile gives access to the whole contents of a file as a contiguous block
+	of memory, mapped with mmap() or MapViewOfFile() according to the platform.
+	If the mapping is not available the file is read into an allocated buffer,
+	so that data() can always be used in the same way after a successful open(). */
+class GsMappedFile
+ { private :
+	const char* _data;
+	size_t _size;
+	char _mapped; // 1 if _data is mapped, 0 if allocated
+	void* _handle; // file mapping handle in windows
+
+   public :
+	/*! Constructor of a closed file */
+	GsMappedFile ();
+
+	/*! Destructor calls close() */
+   ~GsMappedFile ();
+
+	/*! Maps the given file, returning false if it could not be open.
+		Any previously open file is closed before. */
+	bool open ( const char* filename );
+
+	/*! Releases the mapping or the allocated buffer */
+	void close ();
+
+	/*! Returns true if a file is open */
+	bool valid () const { return _data!=0; }
+
+	/*! Returns the file contents, or null if no file is open.
+		Note that the data is not null-terminated. */
+	const char* data () const { return _data; }
+
+	/*! Returns the size of the file in bytes */
+	size_t size () const { return _size; }
+
+	/*! Returns true if the data is mapped, and false if it was read into a buffer */
+	bool mapped () const { return _mapped==1; }
+
+   private :
+	GsMappedFile ( const GsMappedFile& ) {}
+	void operator= ( const GsMappedFile& ) {}
+ };
+
+//============================= end of file ==========================
+
+# endif // GS_MAPPED_FILE_H
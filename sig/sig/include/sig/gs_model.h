@@ -16,6 +16,7 @@ class SnCylinder;
 class SnSphere;
 class GsImage;
 class GsPolygon;
+class GsModelBvh;
 
 # include <sig/gs_box.h>
 # include <sig/gs_vec.h>
@@ -26,6 +27,7 @@ class GsPolygon;
 # include <sig/gs_strings.h>
 # include <sig/gs_material.h>
 # include <sig/gs_primitive.h>
+# include <sig/gs_model_adjacency.h>
 
 # include <sig/gs_shareable.h>
 
@@ -116,12 +118,21 @@ class GsModel : public GsShareable
    private:
 	gscenum _geomode; // modes have to bet set with mode() so that basic checks can take place
 	gscenum _mtlmode; 
+	GsModelAdjacency* _adjacency; // cached adjacency of F, or null if not yet built
+	mutable GsModelBvh* _bvh; // cached hierarchy for ray queries, or null if not yet built
+	gsuint _adjstamp; // stamp of the model when _adjacency was built
+	mutable gsuint _bvhstamp; // stamp of the model when _bvh was built
+	gsuint _stamp; // modification stamp, see changed()
+	void _weld ( float prec, bool v, bool n, bool t );
 
    public :
 
 	/*! Constructor lets all internal arrays as empty and culling is set to true */
 	GsModel ();
 
+	/*! Copy constructor, see operator=(). Cached structures are not copied. */
+	GsModel ( const GsModel& m );
+
 	/*! Virtual Destructor */
 	virtual ~GsModel ();
 
@@ -148,6 +159,15 @@ class GsModel : public GsShareable
 	/*! Compress all internal array buffers. */
 	void compress ();
 
+	/*! Increments the modification stamp of the model, which is used to know when the
+		cached structures built from V and F are out of date. It is called by all methods
+		changing V or F, and by SnModel::model() and SnModel::model_changed(), and it has to
+		be called after V or F are changed directly, otherwise the cached structures are kept. */
+	void changed () { _stamp++; }
+
+	/*! Returns the modification stamp of the model, see changed() */
+	gsuint stamp () const { return _stamp; }
+
 	/*! Ensure data arrays have coherent sizes, and if not, will set the illegal ones to
 		have size 0 and will then update the mode by calling detect_mode(). */
 	void validate ();
@@ -178,12 +198,21 @@ class GsModel : public GsShareable
 	void order_transparent_materials ();
 
 	/*! Removes redundant normals, which are very close or equal to each other. 
-		Only applicable if Fn.size()>0 (Hybrid GeoMode). */
+		Only applicable if Fn.size()>0 (Hybrid GeoMode).
+		A hash grid is used and the expected time is linear in the number of normals. */
 	void remove_redundant_normals ( float prec=gstiny );
 
-	/*! Check and remove redundant vertices */
+	/*! Check and remove redundant vertices, which are closer than prec to a previous vertex.
+		Normals per vertex and materials per vertex are kept in correspondence with V.
+		A hash grid is used and the expected time is linear in the number of vertices. */
 	void merge_redundant_vertices ( float prec=gstiny );
 
+	/*! Merges redundant vertices, normals (if Fn is used) and texture coordinates (if Ft is used),
+		updating indices in F, Fn and Ft in a single pass over the faces.
+		This is the same as calling merge_redundant_vertices() and remove_redundant_normals(),
+		but also considering T and with less passes over the faces. */
+	void weld ( float prec=gstiny );
+
 	/*! Clear the N and Fn arrays, with compression (if last param is true), then adjust mode. */
 	void flat ( bool comp=true );
 
@@ -197,9 +226,18 @@ class GsModel : public GsShareable
 
 	/*! Returns 3F/2, which is the number of edges for "well connected" manifold meshes */
 	int numedges () const { return 3*F.size()/2; }
+
+	/*! Returns the adjacency structure of the faces in F, which is built the first time it is
+		requested and kept in the model. It is rebuilt in linear time when requested after the
+		model is marked as changed, see changed().
+		The returned reference remains valid until free_adjacency() or init() are called. */
+	const GsModelAdjacency& adjacency ();
+
+	/*! Frees the adjacency structure kept by the model, if any */
+	void free_adjacency ();
    
 	/*! Count and return the mean number of edges adjacent to a vertex in the model,
-		by counting the aerage number of faces adjacent to a vertex. */
+		using the adjacency structure to count each edge only once. */
 	float count_mean_vertex_degree ();
 
 	/*! Returns the number of common vertices between the two faces given by their indices. */
@@ -211,6 +249,7 @@ class GsModel : public GsShareable
 	/*! Allocates with operator new an array va of V.size() where va[i] is an array containing
 		information of the edges around V[i], such that: 
 		V[i],V[va[i].b] forms an edge around V[i], adjacent to face F[va[i].a] with 3rd vertex V[va[i].c].
+		The edges are ordered by adjacency, as given by the adjacency structure.
 		The returned pointer must be freed by the user with operator delete[]. */
 	GsArray<Face>* get_edges_per_vertex();
 
@@ -221,12 +260,25 @@ class GsModel : public GsShareable
 
 	/*! Makes E to be an array containing the indices of the model edges,
 		without any repetition; ie only one instance per edge.
-		The number of edges in the model will thus be E.size()/2 */
+		The number of edges in the model will thus be E.size()/2.
+		The edges are retrieved from the adjacency structure. */
 	void get_edges ( GsArray<int>& E );
 
+	/*! Returns the bounding volume hierarchy of the model for ray queries, which is built the
+		first time it is requested and kept in the model. It is rebuilt when requested after the
+		model is marked as changed, see changed(). Include gs_model_bvh.h to use the returned object.
+		The returned reference remains valid until free_bvh() or init() are called. */
+	const GsModelBvh& bvh () const;
+
+	/*! Frees the bounding volume hierarchy kept by the model, if any */
+	void free_bvh ();
+
 	/*! Returns the index of the face intersecting with the line, or -1 if
-		no face is found. In case several intersections are found, the closest
-		to line.p1 is returned */
+		no face is found. In case several intersections are found, the one with
+		the smallest parameter along the line from p1 to p2 is returned.
+		The query uses the hierarchy returned by bvh(), which tests triangles in the same
+		way as GsLine::intersects_triangle(), except that its parallelism threshold is
+		relative to the size of the triangle, so that small triangles can also be picked. */
 	int pick_face ( const GsLine& line ) const;
 
 	/*! Sequentially stores, for all faces, the 3 vertices of each face in the given array. */
@@ -292,6 +344,8 @@ class GsModel : public GsShareable
 
 	/*! Checks the extension to be "obj" or "3ds", calling the apropiate importer,
 		or otherwise it will load a GsModel in .m (or old .srm) format.
+		Files in the binary format of save_bin() are detected by their signature,
+		whatever their extension is.
 		The given filename is stored and can be accessed later on
 		with filename() */
 	bool load ( const char* filename );
@@ -300,9 +354,22 @@ class GsModel : public GsShareable
 		Method in.filename() is needed for shared materials to work. */
 	bool load ( GsInput& in );
 
+	/*! Loads a model saved with save_bin(). The file is memory mapped and its arrays are
+		copied without any parsing. If the file has a bounding volume hierarchy it is kept
+		in the model and returned by bvh() until the model is changed.
+		False is returned if the file could not be open or is not in the expected format,
+		which includes files saved in a different version or platform. */
+	bool load_bin ( const char* file );
+
+	/*! Returns true if the file starts with the signature of the binary format */
+	static bool binary_file ( const char* file );
+
 	/*! This method imports a model in .obj format. If the import
-		is succesfull, true is returned, otherwise false is returned. */
-	bool load_obj ( const char* file );
+		is succesfull, true is returned, otherwise false is returned.
+		The file is memory mapped and large files are parsed in blocks by nt threads,
+		where nt<=0 uses the available hardware threads and 1 parses in a single thread.
+		The result does not depend on the number of threads. */
+	bool load_obj ( const char* file, int nt=0 );
 
 	/*! This method imports a model in .3ds format. If the import
 		is succesfull, true is returned, otherwise false is returned. */
@@ -314,10 +381,18 @@ class GsModel : public GsShareable
 	bool load_iv ( const char* file );
 
 	/*! If the extension in file name is "iv" the model is exported in 
-		.iv format, otherwise save the model in the .m format.
+		.iv format, if it is "mb" the model is saved with save_bin(),
+		otherwise save the model in the .m format.
 		The given filename is stored with method filename() */
 	bool save ( const char* fname );
 
+	/*! Saves the model in a versioned binary format, with all arrays stored as in memory
+		and aligned to 16 bytes, so that load_bin() only needs to copy them. Files are not
+		portable between platforms of different byte order. If bvh is true the bounding
+		volume hierarchy is built if needed and also saved. Note that the material names of
+		the .m format are not supported: materials are always saved in the file. */
+	bool save_bin ( const char* fname, bool bvh=false ) const;
+
 	/*! Save GsModel in the .m format.  */
 	bool save ( GsOutput& o ) const;
 
@@ -0,0 +1,107 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_MODEL_ADJACENCY_H
+# define GS_MODEL_ADJACENCY_H
+
+/** \file gs_model_adjacency.h
+ * Corner table adjacency of triangle meshes.*/
+
+# include <sig/gs_array.h>
+
+/*! \class GsModelAdjacency gs_model_adjacency.h
+	\brief Corner table adjacency of a triangle mesh
+
+	GsModelAdjacency keeps the adjacency information of a triangle mesh in flat arrays.
+	Corner c=3f+k refers to the k-th vertex of face f, and is also used as the index of
+	the half-edge leaving that vertex in face f, so that next(c) and prev(c) are computed
+	from the index only. Each half-edge keeps its twin in the adjacent face, and the corners
+	around each vertex are stored contiguously, ordered by adjacency. The structure is built
+	in time linear in the number of faces, and is usually obtained with GsModel::adjacency(),
+	which keeps it cached in the model until the model is changed.
+	Edges shared by more than two faces, or by faces with inconsistent orientations,
+	are treated as boundary edges. */
+class GsModelAdjacency
+ { private :
+	GsArray<int> _cv;   // vertex of each corner, which is a copy of the face indices
+	GsArray<int> _twin; // twin of each half-edge, or -1 for boundary edges
+	GsArray<int> _vi;   // index in _vc of the first corner of each vertex, plus one entry
+	GsArray<int> _vc;   // corners around each vertex, ordered by adjacency
+	int _nv;
+
+   public :
+	/*! Constructor of an empty structure */
+	GsModelAdjacency ();
+
+	/*! Frees all data */
+	void init ();
+
+	/*! Builds the structure for nf faces, given as 3 vertex indices per face in fv,
+		over nv vertices. The face indices are copied and can be changed afterwards. */
+	void build ( const int* fv, int nf, int nv );
+
+	/*! Returns the number of vertices */
+	int vertices () const { return _nv; }
+
+	/*! Returns the number of faces */
+	int faces () const { return _cv.size()/3; }
+
+	/*! Returns the number of corners, which is also the number of half-edges */
+	int corners () const { return _cv.size(); }
+
+	/*! Returns the face of corner c */
+	static int face ( int c ) { return c/3; }
+
+	/*! Returns the next corner of c in its face */
+	static int next ( int c ) { return c%3==2? c-2:c+1; }
+
+	/*! Returns the previous corner of c in its face */
+	static int prev ( int c ) { return c%3==0? c+2:c-1; }
+
+	/*! Returns the vertex of corner c, which is the origin of half-edge c */
+	int vertex ( int c ) const { return _cv[c]; }
+
+	/*! Returns the destination vertex of half-edge h */
+	int dest ( int h ) const { return _cv[next(h)]; }
+
+	/*! Returns the half-edge in the opposite direction of h in the adjacent face, or -1 if h is a boundary edge */
+	int twin ( int h ) const { return _twin[h]; }
+
+	/*! Returns the corner facing corner c across the edge opposite to c, or -1 if there is none */
+	int opposite ( int c ) const { int t=_twin[next(c)]; return t<0? -1:prev(t); }
+
+	/*! Returns the next corner around the vertex of c, in the order of the faces around it, or -1 at a boundary */
+	int swing ( int c ) const { return _twin[prev(c)]; }
+
+	/*! Returns the number of faces adjacent to vertex v */
+	int degree ( int v ) const { return _vi[v+1]-_vi[v]; }
+
+	/*! Returns the corners of vertex v, ordered by adjacency, degree(v) being its size.
+		When v is at a boundary the first corner starts the fan of faces around v. */
+	const int* star ( int v ) const { return _vc.pt()+_vi[v]; }
+
+	/*! Returns true if the fan of faces around v is not closed */
+	bool boundary ( int v ) const { return degree(v)>0 && _twin[_vc[_vi[v]]]<0; }
+
+	/*! Appends to ring the vertices adjacent to v, following the order of the faces around it.
+		Vertices adjacent through non-manifold edges may appear more than once. */
+	void one_ring ( int v, GsArray<int>& ring ) const;
+
+	/*! Returns the number of edges, without repetitions */
+	int count_edges () const { return _edges(0); }
+
+	/*! Makes E to contain the pairs of vertex indices of all edges, without repetitions,
+		and with the smaller index first. The number of edges will be E.size()/2 */
+	void get_edges ( GsArray<int>& E ) const { E.size(0); _edges(&E); }
+
+   private :
+	int _edges ( GsArray<int>* E ) const;
+ };
+
+//============================= end of file ==========================
+
+# endif // GS_MODEL_ADJACENCY_H
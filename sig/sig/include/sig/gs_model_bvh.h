@@ -0,0 +1,102 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_MODEL_BVH_H
+# define GS_MODEL_BVH_H
+
+/** \file gs_model_bvh.h
+ * Bounding volume hierarchy for ray queries on models.*/
+
+# include <float.h>
+# include <sig/gs_model.h>
+
+/*! Maximum depth of the hierarchy, which bounds the traversal stack */
+# define GS_BVH_STACK 128
+
+/*! \class GsModelBvh gs_model_bvh.h
+	\brief Bounding volume hierarchy for ray queries
+
+	GsModelBvh keeps a hierarchy of axis-aligned boxes over the triangles of a GsModel,
+	built with the surface area heuristic and stored as a flat array of nodes in depth-first
+	order. The vertices of the triangles are copied in the order they are referenced by the
+	leaves, so that queries do not access the model. It is usually obtained with GsModel::bvh(),
+	which builds it on the first request and keeps it in the model until the model is changed.
+	Rays are given as GsLine objects and intersection points are parameterized as
+	(1-t)p1 + (t)p2, in the same way as in GsLine::intersects_triangle(). */
+class GsModelBvh
+ { public :
+	/*! Result of a ray query */
+	struct Hit
+	{	int f;		 //!< index of the intersected face, or -1 if there is no intersection
+		float t;	 //!< line parameter of the intersection point
+		float u, v;	 //!< barycentric coordinates of the intersection point in the face
+	};
+
+	/*! Node of the hierarchy */
+	struct Node
+	{	GsPnt a, b; //!< box of the node
+		int i;		//!< first triangle for leaves, or index of the second child for internal nodes
+		int n;		//!< number of triangles for leaves, 0 for internal nodes
+	};
+
+   private :
+	GsArray<Node> _nodes; // hierarchy in depth-first order, the first child follows its parent
+	GsArray<int> _fi;	  // face index of each triangle, in the order referenced by the leaves
+	GsArray<GsPnt> _tv;	  // three vertices per triangle, in the same order
+	int _nthreads;
+	friend class GsModel; // for saving and loading the hierarchy in GsModel's binary format
+
+   public :
+	/*! Constructor of an empty hierarchy */
+	GsModelBvh ();
+
+	/*! Frees all data */
+	void init ();
+
+	/*! Builds the hierarchy for the faces of m */
+	void build ( const GsModel& m );
+
+	/*! Returns the number of nodes in the hierarchy */
+	int nodes () const { return _nodes.size(); }
+
+	/*! Returns the number of triangles in the hierarchy */
+	int triangles () const { return _fi.size(); }
+
+	/*! Sets the number of threads used by the batched queries, 0 uses the available
+		hardware threads (the default), and 1 disables multithreading. */
+	void threads ( int n ) { _nthreads=n; }
+
+	/*! Returns the number of threads set with threads(int) */
+	int threads () const { return _nthreads; }
+
+	/*! Finds the intersection with the smallest t in [tmin,tmax] and returns true,
+		or returns false if there is none. The default range considers the ray starting
+		at p1 in direction p2-p1; use -FLT_MAX as tmin to consider the whole line. */
+	bool closest_hit ( const GsLine& ray, Hit& hit, float tmin=0, float tmax=FLT_MAX ) const;
+
+	/*! Returns true as soon as any intersection with t in [tmin,tmax] is found */
+	bool any_hit ( const GsLine& ray, float tmin=0, float tmax=FLT_MAX ) const;
+
+	/*! Calls closest_hit() for all rays, in parallel for large batches.
+		Array hits will have the same size as rays, with f=-1 for rays with no intersection. */
+	void closest_hits ( const GsArray<GsLine>& rays, GsArray<Hit>& hits, float tmin=0, float tmax=FLT_MAX ) const;
+
+	/*! Calls any_hit() for all rays, in parallel for large batches.
+		Array hits will have the same size as rays, with 1 for rays with an intersection and 0 otherwise. */
+	void any_hits ( const GsArray<GsLine>& rays, GsArray<gsbyte>& hits, float tmin=0, float tmax=FLT_MAX ) const;
+
+   private :
+	struct Ray;
+	struct Batch;
+	void _build ( GsArray<int>& ti, const GsArray<GsBox>& tb, const GsArray<GsPnt>& tc, int first, int n, int depth );
+	bool _traverse ( const Ray& r, Hit* hit ) const;
+	static void _batch_thread ( int i0, int i1, void* udata );
+ };
+
+//============================= end of file ==========================
+
+# endif // GS_MODEL_BVH_H
@@ -0,0 +1,58 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_PARALLEL_H
+# define GS_PARALLEL_H
+
+/** \file gs_parallel.h 
+ * Simple parallel execution of loops.*/
+
+# include <sig/gs.h>
+
+/*! Returns the number of concurrent threads supported by the hardware, at least 1. */
+int gs_hardware_threads ();
+
+/*! Splits the range [0,n) in nt contiguous intervals and calls f(i0,i1,udata) for each
+	interval [i0,i1) in its own thread. The first interval is processed by the calling
+	thread and the function only returns after all intervals are processed.
+	If nt<=0 the number of hardware threads is used. nt is never greater than n. */
+void gs_parallel_for ( int n, int nt, void (*f)(int i0,int i1,void* udata), void* udata );
+
+/*! GsThreadPool keeps a set of worker threads alive across calls to run(), avoiding
+	the cost of creating threads at every call, as needed for per-frame work.
+	The tasks of a run are split in contiguous ranges, one per thread, and each
+	thread takes chunks from the front of its own range. A thread that finishes its
+	range steals the second half of the largest remaining range of another thread,
+	so that tasks of uneven cost remain balanced. */
+class GsThreadPool
+{  private :
+	struct Data;
+	Data* _data;
+
+   public :
+	/*! Creates the pool with nt threads, counting the calling thread. If nt<=0
+		the number of hardware threads is used. */
+	GsThreadPool ( int nt=0 );
+
+	/*! Stops and joins all worker threads */
+   ~GsThreadPool ();
+
+	/*! Returns the number of threads used by run(), counting the calling thread */
+	int threads () const;
+
+	/*! Calls f(i,thread,udata) for each task i in [0,n), where thread is the index in
+		[0,threads()) of the thread executing the call. Tasks are taken in chunks of
+		the given size. The calling thread works as thread 0 and the method only
+		returns after all tasks are processed. The order in which tasks execute is not
+		defined, therefore each task should only write to its own data. run() should
+		not be called from inside a task or from several threads at the same time. */
+	void run ( int n, void (*f)(int i,int thread,void* udata), void* udata, int chunk=1 );
+};
+
+//============================= end of file ==========================
+
+# endif // GS_PARALLEL_H
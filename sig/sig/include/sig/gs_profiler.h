@@ -0,0 +1,130 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_PROFILER_H
+# define GS_PROFILER_H
+
+/** \file gs_profiler.h
+ * Runtime profiling of frames
+ */
+
+# include <atomic>
+# include <sig/gs_array.h>
+# include <sig/gs_string.h>
+
+//================================ GsProfiler ============================================
+
+/*! GsProfiler records, while enabled, the CPU scopes, GPU times and counters of each
+	frame in a ring buffer keeping the most recent frames. Frames are delimited by calls
+	to next_frame(), which WsViewer makes at the beginning of each draw, so that a frame
+	covers all the work done from one draw to the next one. Scopes are nested intervals
+	recorded with GsProfileScope objects, from any thread. GPU times are the durations
+	measured by timer queries (see GlRenderer), which are only available some frames
+	later and are added to their frame if it is still in the buffer. Counters are only
+	updated from the thread owning the OpenGL context. All names given to the profiler
+	must be static strings, as only their pointers are stored.
+	All methods are static and do nothing while the profiler is disabled. */
+class GsProfiler
+{  public :
+	enum Counter { DrawCalls, Triangles, BytesUploaded, ProgramSwitches, NumCounters };
+
+	struct Scope
+	{	const char* name;
+		double start, end;	// time in seconds since the profiler was enabled
+		int depth;			// nesting level in its thread
+		int thread;			// index of the thread, in the order threads were first seen
+	};
+
+	struct GpuTime
+	{	const char* name;
+		double ms;			// duration in milliseconds
+	};
+
+	struct Frame
+	{	int number;
+		double start, end;	// time in seconds since the profiler was enabled
+		int thread;			// thread calling next_frame()
+		GsArray<Scope> scopes;
+		GsArray<GpuTime> gpu;
+		uint64_t counters[NumCounters];
+		double ms () const { return (end-start)*1000.0; }
+		double gpu_ms () const;
+	};
+
+   private :
+	static std::atomic<bool> _enabled; // read without locking by count() and the other threads
+	static uint64_t _counters[NumCounters];
+
+   public :
+	/*! Enables or disables the profiler. When enabled, all recorded frames are cleared,
+		the ring buffer is set to keep the given number of frames, and a first frame is
+		started. */
+	static void enable ( bool b, int frames=120 );
+
+	/*! Returns true if the profiler is enabled */
+	static bool enabled () { return _enabled; }
+
+	/*! Finishes the current frame, adding it to the ring buffer, and starts a new one */
+	static void next_frame ();
+
+	/*! Returns the number of the current frame, or -1 if the profiler is disabled */
+	static int frame_number ();
+
+	/*! Starts a scope in the current frame, returning the index to be given to end_scope(),
+		or -1 if the profiler is disabled. The number of the current frame is put in f.
+		Usually called by GsProfileScope. */
+	static int begin_scope ( const char* name, int& f );
+
+	/*! Ends the scope of index i started in frame f */
+	static void end_scope ( int f, int i );
+
+	/*! Adds n to counter c of the current frame */
+	static void count ( Counter c, uint64_t n=1 ) { if ( _enabled ) _counters[c]+=n; }
+
+	/*! Adds a GPU duration to frame f, if f is in the buffer or is the current frame */
+	static void gpu_time ( int f, const char* name, double ms );
+
+	/*! Returns the number of finished frames in the buffer */
+	static int frames ();
+
+	/*! Returns finished frame i, where 0 is the oldest and frames()-1 the most recent one */
+	static const Frame& frame ( int i );
+
+	/*! Returns the index of the slowest finished frame, or -1 if there are none */
+	static int slowest_frame ();
+
+	/*! Returns the name of counter c */
+	static const char* counter_name ( Counter c );
+
+	/*! Writes a summary of finished frame i: its time, the time statistics of the buffer,
+		its counters, the total time of its scopes grouped by name and nesting level, and
+		its GPU times grouped by name */
+	static void summary ( int i, GsString& s );
+
+	/*! Saves the finished frames in the Chrome trace event format, which can be opened
+		in chrome://tracing or in Perfetto. Scopes appear in the track of their threads,
+		GPU times are placed one after the other from the start of their frame in a
+		separate track, and counters are shown as counter tracks. */
+	static bool export_trace ( const char* file );
+};
+
+//================================ GsProfileScope ============================================
+
+/*! Records a scope in the current frame of GsProfiler from its construction to its
+	destruction. Nothing is recorded if the profiler is disabled. */
+class GsProfileScope
+{  private :
+	int _frame, _index;
+   public :
+	GsProfileScope ( const char* name )
+	{	_index = GsProfiler::enabled()? GsProfiler::begin_scope(name,_frame) : -1; }
+   ~GsProfileScope () { if ( _index>=0 ) GsProfiler::end_scope ( _frame, _index ); }
+};
+
+//================================ End of File =================================================
+
+# endif // GS_PROFILER_H
@@ -0,0 +1,86 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GS_SKINNING_H
+# define GS_SKINNING_H
+
+/** \file gs_skinning.h
+ * Packed linear blend skinning influences.*/
+
+# include <sig/gs_array.h>
+# include <sig/gs_vec.h>
+# include <sig/gs_mat.h>
+
+/*! \class GsSkinning gs_skinning.h
+	\brief Packed linear blend skinning influences
+
+	GsSkinning stores the influences of joints over the vertices of a mesh in a
+	compact structure of arrays. Vertices are sorted by their number of influences,
+	and for each group of vertices with the same number of influences, the joint
+	index, weight, and weighted local position and normal of each influence are
+	stored contiguously, for blocks of 4 vertices. This allows apply() to blend
+	4 vertices at once with SSE instructions, with no branches in the inner loop.
+	Large meshes are also split among the threads of a pool shared by all skinnings. */
+class GsSkinning
+ { private :
+	struct Group { int n, nv, vi, ii; }; // influences per vertex, padded number of vertices, first vertex and first influence
+	struct Influence { int v, j; float w; GsPnt p; GsVec n; }; // used only while defining influences
+	GsArray<Group> _groups;
+	GsArray<int> _vid;	 // original index of each packed vertex, -1 for padding vertices
+	GsArray<int> _j;	 // joint index of each packed influence
+	GsArray<float> _w, _x, _y, _z, _nx, _ny, _nz; // weight, weighted local position and weighted local normal
+	GsArray<Influence> _def;
+	int _nverts, _ninfs;
+	int _nthreads;
+
+   public :
+	/*! Constructor with no influences defined */
+	GsSkinning ();
+
+	/*! Clears all influences */
+	void init ();
+
+	/*! Starts the definition of new influences, clearing the current ones */
+	void begin ();
+
+	/*! Adds an influence of joint j with weight w over vertex v, where p and n are the
+		position and normal of the vertex expressed in the frame of the joint in the bind pose. */
+	void add ( int v, int j, float w, const GsPnt& p, const GsVec& n=GsVec::null );
+
+	/*! Packs all influences given with add(). Vertices with no influences are ignored by apply(). */
+	void end ();
+
+	/*! Returns the number of vertices with influences */
+	int vertices () const { return _nverts; }
+
+	/*! Returns the total number of influences */
+	int influences () const { return _ninfs; }
+
+	/*! Sets the number of threads to be used by apply(), 0 uses the available hardware threads
+		(the default), and 1 disables multithreading. Small meshes are never split. */
+	void threads ( int n ) { _nthreads=n; }
+
+	/*! Returns the number of threads set with threads(int) */
+	int threads () const { return _nthreads; }
+
+	/*! Computes the position of each vertex with influences, and its normal if N is not null,
+		given the current global matrices of the joints, indexed by the joint indices used in add().
+		Arrays V and N must be large enough to store all vertex indices used in add(). */
+	void apply ( const GsMat* gmats, GsPnt* V, GsVec* N=0 ) const;
+
+	/*! Retrieves the influences in vertex order: counts[v] will have the number of influences of vertex v,
+		and their joints and weights are appended in joints and weights, in the order they were added. */
+	void get_influences ( GsArray<int>& counts, GsArray<int>& joints, GsArray<float>& weights ) const;
+
+   private :
+	void _apply ( int b1, int b2, const GsMat* gmats, GsPnt* V, GsVec* N ) const;
+	static void _apply_thread ( int i, int thread, void* udata );
+};
+
+//============================= end of file ==========================
+
+# endif // GS_SKINNING_H
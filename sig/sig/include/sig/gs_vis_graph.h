@@ -13,6 +13,7 @@
  */
 
 # include <sig/gs_vec.h>
+# include <sig/gs_grid.h>
 # include <sig/gs_graph.h>
 # include <sig/gs_buffer.h>
 # include <sig/gs_polygons.h>
@@ -45,11 +46,15 @@ class GsVisGraphNode : public GsGraphNode
 
 /*! \class GsVisGraph gs_vis_graph.h
 	\brief a simple visibility graph for 2D path planning
-*/   
+
+	Visibility tests only consider the polygon edges stored in the cells of a uniform
+	grid traversed by the tested segment. */
 class GsVisGraph : public GsShareable
 {  public :
 
    protected :
+	struct Edge { int p, v, vp; }; // polygon p edge from vertex v to vertex vp
+	struct Buffers { GsArray<int> cells; GsArray<gsuint> marks; gsuint mark; Buffers() { mark=0; } };
 	float _radius, _dang;
 	GsVisGraphNode *_vi, *_vg;
 	GsPolygons* _polygons;  // sharable polygons
@@ -57,6 +62,12 @@ class GsVisGraph : public GsShareable
 	GsArrayPt<GsBuffer<GsVisGraphNode*>> _nodes;
 	GsGraph<GsVisGraphNode,GsVisGraphLink> _graph;
 	GsArray<GsVisGraphNode*> _path;
+	GsGridBase _grid;        // uniform grid covering all polygon edges
+	GsArray<int> _cellfirst; // first position in _celledges of each cell, with cells()+1 positions
+	GsArray<int> _celledges; // indices in _edges of the edges crossing each cell
+	GsArray<Edge> _edges;    // all polygon edges
+	float _eps;              // tolerance used to find the cells of edges and segments
+	Buffers _buffers;        // buffers for the visibility tests of the calling thread
 
    public :
 	/*! Default constructor */
@@ -75,8 +86,10 @@ class GsVisGraph : public GsShareable
 	void init ();
 
 	/*! Builds the visibility graph. GsVisGraph will keep a reference to parameter polys,
-		and will convert all non-ccw polygons in it to ccw orientation. */
-	void build ( GsPolygons* polys, float r=-1, float dang=-1 );
+		and will convert all non-ccw polygons in it to ccw orientation. The visible
+		vertices of each polygon vertex are determined with nt threads, or with the
+		number of hardware threads if nt<=0. */
+	void build ( GsPolygons* polys, float r=-1, float dang=-1, int nt=0 );
 
 	GsVisGraphNode* node ( int pol, int vtx ) const { return _nodes[pol]->cget(vtx); }
 	int psize ( int pol ) const { return _nodes[pol]->size(); }
@@ -92,8 +105,13 @@ class GsVisGraph : public GsShareable
 	const GsVisGraphNode* vg () const { return _vg; }
 
    protected :
+	void _build_grid ();
+	bool _free ( const GsPnt2& a, const GsPnt2& b, int p1, int v1, int p2, int v2, Buffers& buf ) const;
+	void _get_visible ( GsVisGraphNode* n, int pk, int vk, const GsPnt2* sm, const GsPnt2* sp,
+						GsArray<GsVisGraphNode*>& nodes, Buffers& buf ) const;
 	void _connect_to_visible ( GsVisGraphNode* n, int pk=-1, int vk=-1, const GsPnt2* sm=0, const GsPnt2* sp=0 );
 	void _add_if_free ( GsVisGraphNode* n1, GsVisGraphNode* n2, int p1=-1, int v1=-1, int p2=-1, int v2=-1 );
+	static void _get_links ( int i0, int i1, void* udata );
 
 
 	/*! Returns a reference to polygon index i, which must be a valid index */
@@ -13,6 +13,7 @@
  */
 
 # include <sig/gs_array.h>
+# include <sig/gs_box.h>
 # include <sig/sn_node.h>
 
 //======================================= SnGroup ====================================
@@ -26,7 +27,10 @@
 class SnGroup : public SnNode
  { private :
 	gscbool _separator;
+	gscbool _culling;
+	gscbool _boxuptodate;
 	GsArray<SnNode*> _children;
+	GsBox _box; // cached bounding box of the subtree
 
    public :
 	static const char* class_name;
@@ -64,6 +68,31 @@ class SnGroup : public SnNode
 	/*! Returns the group separator behavior state. */
 	bool separator () const { return _separator==1; }
 
+	/*! Sets the culling behavior of the group, which is false by default. When true,
+		renderers performing culling test the bounding box of the whole subtree and skip
+		the group if the box is not visible. The box is computed with SaBBox once, and
+		again after children are added, removed or replaced in the group, or after
+		touch_culling_box() is called. It is therefore meant for subtrees that do not
+		change often, and the application has to call touch_culling_box() when shapes
+		or transformations change inside the subtree. Culling only applies to separator
+		groups, since skipping a non-separator group would also skip the transformations
+		and materials it passes on to the nodes after it. See can_cull(). */
+	void culling ( bool b ) { _culling=(char)b; }
+
+	/*! Returns the culling behavior state. */
+	bool culling () const { return _culling==1; }
+
+	/*! Returns true if culling is on and the group is a separator, which is the
+		condition used by renderers to skip the group when its box is not visible. */
+	bool can_cull () const { return _culling==1 && _separator==1; }
+
+	/*! Returns the bounding box of the subtree in the coordinates of the group,
+		computing it if needed. See culling(). */
+	const GsBox& culling_box ();
+
+	/*! Marks the culling box to be computed again at the next culling_box() call. */
+	void touch_culling_box () { _boxuptodate=0; }
+
 	/*! Changes the capacity of the children array. If the requested capacity
 		is smaller than the current size, nothing is done. */
 	void capacity ( int c );
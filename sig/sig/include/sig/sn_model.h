@@ -25,8 +25,20 @@
 	a specialized node rendered with OpenGL buffers from specific mesh formats
 	can be defined. */
 class SnModel : public SnShape
- { protected :
+ { public :
+	/*! Optional data for linear blend skinning performed by the renderer on the GPU.
+		When used, the model keeps its bind pose and only the palette changes per frame. */
+	struct Skinning
+	{	struct Influence { gsbyte j[4]; float w[4]; }; //!< up to 4 palette indices and weights
+		GsArray<Influence> influences; //!< one entry per vertex of the model
+		GsArray<GsMat> palette; //!< joint global matrices multiplied by their inverse bind pose matrices
+		bool palette_changed;	//!< to be set when the palette is updated, it is cleared by the renderer
+		Skinning () { palette_changed=true; }
+	};
+
+   protected :
 	GsModel* _model;
+	Skinning* _skinning;
 
    public :
 	static const char* class_name; //<! Contains string SnModel
@@ -52,12 +64,28 @@ class SnModel : public SnShape
 	void model ( GsModel* m );
 
 	/*! Access to the (always valid) shared GsModel object.
-		When accessing this method touch() is automatically called. */
-	GsModel* model () { touch(); return _model; }
+		When accessing this method touch() and GsModel::changed() are automatically called. */
+	GsModel* model () { touch(); _model->changed(); return _model; }
+
+	/*! Access to the shared GsModel marking only the given data as changed, for ex.
+		model_changed(SnShape::VerticesChanged) when only vertex positions will be updated.
+		Array sizes and face indices must not be changed; use model() in such cases. */
+	GsModel* model_changed ( gsbyte c ) { touch(c); _model->changed(); return _model; }
 
 	/*! Const access to the (always valid) shared GsModel. No call to touch() */
 	const GsModel* cmodel () const { return _model; }
 
+	/*! Returns the skinning data, which is null (the default) if not used. */
+	Skinning* skinning () { return _skinning; }
+
+	/*! Creates the skinning data if needed and returns it. The renderer will only use it
+		for models with normals per vertex and without textures or colors per vertex or face.
+		The node is marked as changed so that the influences can be uploaded. */
+	Skinning* init_skinning ();
+
+	/*! Deletes the skinning data, if any, and marks the node as changed. */
+	void remove_skinning ();
+
 	/*! Returns the bounding box of all vertices used.
 		The returned box can be empty. */
 	virtual void get_bounding_box ( GsBox &b ) const override;
@@ -55,9 +55,13 @@ enum gsRenderMode { gsRenderModeDefault,
 	creating shape nodes.  */
 class SnShape : public SnNode
 {  public :
-	enum ChangeType { Unchanged=0, RenderModeChanged=1, MaterialChanged=2, Changed=8 };
+	enum ChangeType { Unchanged=0, RenderModeChanged=1, MaterialChanged=2, Changed=8,
+					  VerticesChanged=16, NormalsChanged=32, ColorsChanged=64, TexCoordsChanged=128,
+					  DataChanged=240 //!< all partial data flags together
+					};
    protected :
-	mutable gsbyte _changed; // 0:unchanged, otherwise flags: 1:render mode, 2:mtl, 4:resolution, 8:first time/full change
+	mutable gsbyte _changed; // 0:unchanged, otherwise flags: 1:render mode, 2:mtl, 4:resolution, 8:first time/full change,
+							 // 16:vertices, 32:normals, 64:colors, 128:texture coordinates
 	mutable gscbool _auto_clear_data; // default is 0
 	gscenum _render_mode;
 	gscenum _overriden_render_mode; // -1 if not overriden
@@ -66,6 +70,8 @@ class SnShape : public SnNode
 	GsMaterial _material;
 	GsMaterial _overriden_material;
 	SnShapeRenderer* _renderer;
+	mutable GsBox _box;             // cached bounding box
+	mutable gscbool _boxuptodate;
 
    protected :
 
@@ -133,6 +139,12 @@ class SnShape : public SnNode
 	/*! Equivalent to calling changed(Changed); */
 	void touch () { _changed=Changed; }
 
+	/*! Adds the given partial data flags (VerticesChanged, NormalsChanged, ColorsChanged,
+		TexCoordsChanged) to the current change state, so that renderers supporting
+		partial updates only re-send the corresponding data. Changes in the number
+		of elements or in the connectivity require the full touch() instead. */
+	void touch ( gsbyte c ) { _changed|=c; }
+
 	/*! If turned on all possible internal buffers are released after a render call,
 		such that memory is saved but the geometry information is lost after 
 		it is passed to the graphics hardware. If turned on the shape will
@@ -154,6 +166,12 @@ class SnShape : public SnNode
 	/*! Returns the bounding box of the shape. */
 	virtual void get_bounding_box ( GsBox &box ) const=0;
 
+	/*! Returns the bounding box of the shape kept from the last call to get_bounding_box()
+		made by this method. The box is computed again while the shape is marked as
+		changed, and once after the shape is rendered with a change. Used by renderers
+		performing culling. */
+	const GsBox& cached_bounding_box () const;
+
    protected :
 
 	/*! Calls a->shape_apply() for this node */
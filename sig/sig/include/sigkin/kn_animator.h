@@ -0,0 +1,80 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef KN_ANIMATOR_H
+# define KN_ANIMATOR_H
+
+//================================ KnAnimator =================================================
+
+# include <sig/gs_array.h>
+# include <sig/gs_mat.h>
+# include <sig/gs_shareable.h>
+
+class GsThreadPool;
+class KnSkeleton;
+class KnController;
+
+/*! Evaluates the animation of many characters in parallel. Each character is a
+	skeleton driven by a controller, usually a KnCtScheduler blending several
+	KnCtMotion tracks. At each call to evaluate(), the controller of every character
+	is evaluated, its buffer is applied to the skeleton, and the global matrices of
+	the skeleton are updated, with characters distributed among the threads of a
+	work-stealing GsThreadPool. As each character only writes to its own skeleton and
+	controller, results do not depend on the number of threads. Controllers should
+	therefore not be shared between characters, while KnMotions can be shared. */
+class KnAnimator : public GsShareable
+{  public :
+	struct Character { KnSkeleton* skeleton; KnController* controller; };
+
+   private :
+	GsArray<Character> _chars;
+	GsThreadPool* _pool;
+	double _t;
+	static void _evaluate ( int i, int thread, void* udata );
+
+   public :
+	/*! Constructor with the number of threads to use, if nt<=0 the number of
+		hardware threads is used */
+	KnAnimator ( int nt=0 );
+
+	/*! Destructor is public but pay attention to the use of ref()/unref() */
+	virtual ~KnAnimator ();
+
+	/*! Changes the number of threads used, if nt<=0 the number of hardware threads is used */
+	void threads ( int nt );
+
+	/*! Returns the number of threads used */
+	int threads () const;
+
+	/*! Removes all characters */
+	void init ();
+
+	/*! Adds a character and returns its index. Both sk and ct are referenced.
+		If the buffer of ct is not connected to sk it is connected here.
+		The controller should be started by the user before evaluation. */
+	int add ( KnSkeleton* sk, KnController* ct );
+
+	/*! Removes character i, the last character takes its index */
+	void remove ( int i );
+
+	/*! Returns the number of characters */
+	int characters () const { return _chars.size(); }
+
+	/*! Access to character i */
+	const Character& character ( int i ) const { return _chars[i]; }
+
+	/*! Evaluates all characters at time t, leaving all global matrices up to date */
+	void evaluate ( double t );
+
+	/*! Returns the global matrices of character i, indexed by joint index,
+		as computed by the last call to evaluate() */
+	const GsArray<GsMat>& global_matrices ( int i ) const;
+};
+
+//================================ End of File =================================================
+
+# endif  // KN_ANIMATOR_H
@@ -0,0 +1,75 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef KN_CHANNEL_LAYOUT_H
+# define KN_CHANNEL_LAYOUT_H
+
+//================================ KnChannelLayout =================================================
+
+# include <sig/gs_array.h>
+
+class KnChannels;
+
+/*! KnChannelLayout groups the values of the channels in a KnChannels array by the
+	way they are interpolated: linear values (translations, swings and ik positions),
+	angles (euler rotations and twists), and quaternions (Quat channels and the
+	rotation of IKGoal channels). The interpolation methods process each group in a
+	single loop, without the per-channel type dispatch of KnChannel::interp().
+	Quaternions are processed 4 at a time with SSE instructions: 4 quaternions are
+	loaded and transposed in registers so that all their w, x, y and z components are
+	blended together. Slerp uses a polynomial approximation of the slerp weights,
+	with errors below 1E-7, instead of acosf() and sinf() calls.
+	The layout of a KnChannels is obtained with KnChannels::layout(). */
+class KnChannelLayout
+{  public :
+	/*! Location of a group of values: float position in a posture, channel index,
+		and offset of the values in the channel */
+	struct Entry { int pos, ch, off; };
+
+   private :
+	GsArray<Entry> _lin;  // linearly interpolated values, one entry per float
+	GsArray<Entry> _ang;  // angles, one entry per float
+	GsArray<Entry> _quat; // quaternions, one entry per quaternion
+	int _floats;
+
+   public :
+	/*! Constructor for an empty layout */
+	KnChannelLayout () { _floats=0; }
+
+	/*! Builds the groups from the current types of the channels in ch */
+	void compile ( const KnChannels& ch );
+
+	/*! Returns the number of floats of the compiled channels */
+	int floats () const { return _floats; }
+
+	/*! Returns the number of linear values, angles, or quaternions, respectively */
+	int linears () const { return _lin.size(); }
+	int angles () const { return _ang.size(); }
+	int quats () const { return _quat.size(); }
+
+	/*! Access to entry i of the linear values, angles, or quaternions, respectively */
+	const Entry& linear ( int i ) const { return _lin[i]; }
+	const Entry& angle ( int i ) const { return _ang[i]; }
+	const Entry& quat ( int i ) const { return _quat[i]; }
+
+	/*! Puts in v the interpolation between v1 and v2 at parameter t in [0,1].
+		All arrays are in the float layout of the compiled channels, and v may be v1 or v2. */
+	void interp ( const float* v1, const float* v2, float t, float* v ) const;
+
+	/*! Interpolates v1 with the values in the float buffers connected to the channels
+		of ch, which must be the compiled ones, placing the result in these buffers.
+		Channels not connected to a buffer are skipped. */
+	void interp ( const float* v1, float t, const KnChannels& ch ) const;
+
+	/*! Puts in v the weighted sum of the arrays in values, using the weights in w.
+		Resulting quaternions are normalized. */
+	void interp ( const GsArray<float*>& values, const GsArray<float>& w, float* v ) const;
+};
+
+//================================ End of File =================================================
+
+# endif  // KN_CHANNEL_LAYOUT_H
@@ -13,6 +13,7 @@
 # include <sigkin/kn_channel.h>
 
 class KnPosture;
+class KnChannelLayout;
 
 /*! KnChannels manipulates an array of channels and is used to
 	specify postures and motions. */
@@ -21,6 +22,7 @@ class KnChannels : public GsShareable
 	class HashTable;
 	GsArray<KnChannel> _channels;
 	mutable HashTable* _htable;
+	mutable KnChannelLayout* _layout;
 	int _floats;
 
    public :
@@ -85,11 +87,17 @@ class KnChannels : public GsShareable
 
 	/*! Recalculates and stores the number of floats required to store all the
 		channels. Note that it is invalidated each time a channel type is
-		changed without using the KnChannels methods. */
+		changed without using the KnChannels methods. The layout is also
+		invalidated here, see layout(). */
 	int count_floats ();
 	
 	/*! Returns the number of floats required to store all the channels. */
 	int floats () const { return _floats; }
+
+	/*! Returns the layout grouping the channel values by interpolation type, which
+		is compiled at the first call after the channels are changed. As for floats(),
+		call count_floats() after changing channel types without the KnChannels methods. */
+	const KnChannelLayout& layout () const;
 	
 	/*! Counts and returns the float position of the 1st value used by channel c */
 	int floatpos ( int c ) const;
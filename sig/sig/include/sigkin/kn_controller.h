@@ -92,8 +92,9 @@ class KnController : public GsShareable
 	void stop () { _active=false; controller_stop (); }
 
 	/*! Evaluates the controller at a local time t. The result of the evaluation
-		will be sent to the connected skeleton or posture buffer. */ 
-	void evaluate ( double t ) { _active = controller_evaluate ( t ); }
+		will be sent to the connected skeleton or posture buffer. While GsProfiler
+		is enabled, the evaluation is recorded as a scope named with controller_type(). */ 
+	void evaluate ( double t );
 
 	/*! Simply makes a call to controller_duration(). */
 	double duration () { return controller_duration (); }
@@ -16,6 +16,7 @@ class KnCtMotion : public KnController
  { private :
 	KnPosture _buffer; // internal buffer for storing the evaluations of the motion
 	KnMotion* _motion;			   // the motion
+	KnChannels* _mchannels;		   // copy of the motion channels, connected to _buffer
 	KnMotion::InterpType _play_mode; // its play mode
 	double _duration;				// the time-warped duration
 	float _maxtwarp;  // max time warping factor allowed to increase the motion speed
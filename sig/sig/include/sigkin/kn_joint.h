@@ -39,8 +39,8 @@ class KnJoint
 	GsModel* _colgeo;		// the attached geometry used for collision detection
 	KnJoint* _parent;		// the parent joint
 	GsArray<KnJoint*> _children; // the children joints
-	GsMat _gmat;			// global matrix: from the root to the children of this joint
-	GsMat _lmat;			// local matrix: from this joint to its children
+	GsMat* _gmat;			// global matrix: from the root to the children of this joint, in KnSkeleton::_gmats
+	GsMat* _lmat;			// local matrix: from this joint to its children, in KnSkeleton::_lmats
 	gscbool _lmattodate;	// true if lmat is up to date
 	gscenum _rtype;			// one of the RotType enumerator
 	KnJointName _name;		// the given name
@@ -63,6 +63,9 @@ class KnJoint
 	KnJoint ( KnSkeleton* kn, KnJoint* parent, RotType rtype, int i );
    ~KnJoint ();
 
+	// updates the global matrix only if the joint is marked as dirty in the skeleton
+	void _update_gmat_dirty ();
+
    public :
 
 	/*! Init this joint with the same parameters as given joint j.
@@ -164,8 +167,8 @@ class KnJoint
 	/*! Recursivelly updates the local matrix and the global
 		matrices of the joint and all its children. It assumes
 		that the global matrix of the parent is up to date.
-		Note: whenever this method is called, the whole branch
-		under the joint is updated */
+		Only joints marked as dirty by set_lmat_changed(), and
+		the joints below them, are recomputed */
 	void update_gmat ();
 
 	/*! Same as update_gmat(), but it stops at the given stopjoints */
@@ -177,7 +180,8 @@ class KnJoint
 	void update_branch_gmat ( KnJoint* stopjoint=0 );
 
 	/*! Updates the local matrix and set the global matrix of this joint
-		to be the local matrix multiplied by the parent global matrix */
+		to be the local matrix multiplied by the parent global matrix.
+		Nothing is done if the joint is not dirty */
 	void update_gmat_local ();
 
 	/*! Finds and updates the local and global matrices of all joints
@@ -186,21 +190,23 @@ class KnJoint
 	void update_gmat_up ( KnJoint* stop_joint=0 );
 
 	/*! Ensures that the local matrix is updated and returns it. */
-	const GsMat& lmat () { update_lmat(); return _lmat; }
+	const GsMat& lmat () { update_lmat(); return *_lmat; }
 
 	/*! Will force the reconstruction of the local matrix from the
-		rotation and position parameters. The skeleton is also notified
-		with a call to invalidate_global_matrices() */
+		rotation and position parameters, and marks the joint as dirty
+		so that its subtree is recomputed in the next global matrices
+		update. The skeleton is also notified with a call to
+		invalidate_global_matrices() */
 	void set_lmat_changed ();
 
 	/*! Returns the current global matrix. Be sure that it is up to
 		date by calling one of the several updated methods. It gives
 		the transformation from the root to the children of this joint */
-	const GsMat& gmat () const { return _gmat; }
+	const GsMat& gmat () const { return *_gmat; }
 
 	/*! Returns the translation encoded in the current global matrix.
 		Be sure that the global matrix is up to date */
-	GsVec gcenter () const { return GsVec(_gmat.e14,_gmat.e24,_gmat.e34); }
+	GsVec gcenter () const { return GsVec(_gmat->e14,_gmat->e24,_gmat->e34); }
 
 	/*! Get a single visualization model for this node and all the
 		children (update_gmat) is called */
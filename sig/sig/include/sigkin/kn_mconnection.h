@@ -45,7 +45,8 @@ class KnMConnection : public GsShareable
 	void apply_frame ( int f );
 
 	/*! Evaluates and applies the motion at time t to the connected channels.
-		Equivalent to KnMotion::apply_frame() */
+		Equivalent to KnMotion::apply(), with the keyframe search hint kept in this connection,
+		so that each connection plays efficiently in any direction with KnMotion::search_frame(). */
 	void apply ( float t, KnMotion::InterpType itype=KnMotion::Linear, int* lastframe=0 )
 		{ KnMotion::apply(_motion,_channels,_last_apply_frame,t,itype,lastframe); }
 };
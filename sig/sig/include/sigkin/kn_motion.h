@@ -13,6 +13,7 @@
 # include <sig/gs_shareable.h>
 # include <sigkin/kn_channels.h>
 # include <sigkin/kn_posture.h>
+# include <sigkin/kn_motion_pack.h>
 
 class GsVars;
 class KnSkeleton;
@@ -30,6 +31,7 @@ class KnMotion : public GsShareable
 	int   _last_apply_frame;  // used to speed up playing with monotone time
 	float _freq;			  // sampling rate
 	GsVars* _userdata;		  // to store user data
+	KnMotionPack* _pack;	  // compressed frames, if packed
 
    public :
 	/*! Constructor */
@@ -60,7 +62,10 @@ class KnMotion : public GsShareable
 	void compress ();
 
 	/*! Loads a motion file and returns true if no errors.
-		Both .sm and .bvh formats are read here. The filename is updated. */
+		The .sm, .bvh and binary formats are read here. The filename is updated.
+		If use_cache() is true, text files are loaded from their binary cache file
+		when it exists and is up to date, otherwise the cache file is (re)generated
+		after loading the text file, see cache_file(). */
 	bool load ( const char* filename );
 
 	/*! Loads a motion file and returns true if no errors.
@@ -77,6 +82,31 @@ class KnMotion : public GsShareable
 	/*! Save the motion to a file and returns true if no errors */
 	bool save ( GsOutput& out );
 
+	/*! Returns true if the file starts with the signature of the binary motion format */
+	static bool binary_file ( const char* file );
+
+	/*! Loads a motion saved with save_bin(), mapping the file in memory, and returns true
+		if no errors. If a source file is given, false is returned if the size or the
+		modification time of the source file are not the ones stored in the file.
+		The filename is set to source, if given, or to file otherwise. */
+	bool load_bin ( const char* file, const char* source=0 );
+
+	/*! Saves the channels, keytimes and frame values of the motion in binary format.
+		If a source file is given, its size and modification time are stored so that
+		load_bin() can detect if the source file changed. User data is not saved. */
+	bool save_bin ( const char* file, const char* source=0 ) const;
+
+	/*! Enables or disables the use of binary cache files by load(), default is true.
+		Cache files that cannot be written, for instance in read-only folders, are not used. */
+	static void use_cache ( bool b );
+
+	/*! Returns true if binary cache files are used by load() */
+	static bool use_cache ();
+
+	/*! Puts in file the name of the binary cache file of the given source motion file,
+		which is the source file name with the added extension .kmb */
+	static void cache_file ( const char* source, GsString& file );
+
 	/*! Save the motion to a file in BVH format and returns true if no errors.
 		Channels to be saved are get from the skeleton channel definitioin.
 		A skeleton has to be attached to the motion as bvh contains skeleton definition.
@@ -127,7 +157,8 @@ class KnMotion : public GsShareable
 	int postfloats () const { return _frames.size()<=0? 0 : posture(0)->values.size(); }
 
 	/*! Returns the KnPosture of frame f. It is the user
-		responsibility to ensure that 0<=f and f<frames()  */
+		responsibility to ensure that 0<=f and f<frames().
+		If the motion is packed, only the posture of frame 0 exists. */
 	KnPosture* posture ( int f ) const { return _frames[f].posture; }
 
 	/*! Set the joints to be considered by the distance function in all posture frames,
@@ -156,9 +187,35 @@ class KnMotion : public GsShareable
 	/*! Set sampling rate. */
 	void set_freq ( float freq ) { _freq = freq; }
 
+	/*! Replaces the postures of all frames, except the first one, by a KnMotionPack built
+		with the given parameters, considerably reducing the memory used by long motions.
+		Keytimes, channels and the first posture are kept, and apply(), apply_frame(),
+		connections, save() and save_bvh() work as before, decompressing values at sample time.
+		Methods changing or accessing the postures of the frames unpack the motion first.
+		Returns false if the motion is empty or already packed. */
+	bool pack_frames ( const KnMotionPack::Params& p=KnMotionPack::Params() );
+
+	/*! Recreates the postures of all frames from the pack, the pack is deleted.
+		Values will have the errors introduced by the compression. */
+	void unpack_frames ();
+
+	/*! Returns true if the frames are packed */
+	bool packed () const { return _pack!=0; }
+
+	/*! Returns the pack of the frames, or null if the motion is not packed */
+	const KnMotionPack* frames_pack () const { return _pack; }
+
 	/*! Returns the last applied frame */
 	int last_applied_frame() const { return _last_apply_frame; }
 
+	/*! Returns the index f of the last frame with keytime(f)<=t, or -1 if t<keytime(0)
+		or if the motion is empty. If t is not after the last keytime, then f<frames()-1 and
+		keytime(f)<=t<keytime(f+1). The frames around the given hint frame are checked first,
+		then, if freq() is not zero, the frames around (t-keytime(0))/freq(), so that sequenced
+		calls in both directions and uniformly sampled motions take constant time.
+		Otherwise a binary search is performed. Keytimes must be in non-decreasing order. */
+	int search_frame ( float t, int hint=-1 ) const;
+
 	/*! Connects the keypostures' shared channels to the given skeleton,
 		establishing a direct link between each channel in the motion
 		to the corresponding channels in the skeleton's joints.
@@ -192,11 +249,11 @@ class KnMotion : public GsShareable
 	static void apply ( KnMotion* m, KnChannels* c, int& lastf, float t, KnMotion::InterpType itype, int* lastframe );
 
 	/*! Evaluates and applies the motion at time t to the connected skeleton or posture.
-		The search for the 2 keyframes to be interpolated (adjacent to t) is done linearly,
-		however as 99% of the cases the evaluation is monotone, the previous frame number
-		used serves as a starting point for the search, resulting in maximum efficiency.
+		The 2 keyframes to be interpolated (adjacent to t) are found with search_frame(),
+		using the previous frame number as hint, so that monotone evaluations in both
+		directions take constant time, and random access takes at most a binary search.
 		To optimize evaluations from several controllers sharing a same motion file,
-		parameter lastframe can be used to maintain the starting frame to be considered.
+		parameter lastframe can be used to maintain the hint frame to be considered.
 		Note: make sure joint limits are properly set in the skeleton, for instance, joints
 		with Euler angles will by default be frozen with value 0 */
 	void apply ( float t, InterpType itype=Linear, int* lastframe=0 )
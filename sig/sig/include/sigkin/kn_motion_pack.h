@@ -0,0 +1,104 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef KN_MOTION_PACK_H
+# define KN_MOTION_PACK_H
+
+//================================ KnMotionPack =================================================
+
+# include <sig/gs_array.h>
+# include <sig/gs_output.h>
+
+class KnMotion;
+
+/*! KnMotionPack stores the frames of a KnMotion in compressed form, and is used by
+	KnMotion::pack_frames(). Instead of one KnPosture per frame, each varying float or
+	quaternion of the channels becomes a curve with its keys stored contiguously.
+	Values that are constant in all frames are only stored once, quaternions are
+	quantized with the smallest-three encoding in 48 bits, and keys can optionally be
+	reduced to the ones needed to reproduce all frames within the given tolerances.
+	Frames are decompressed when sampled, with the same interpolation types used by
+	KnChannel::interp(). Sampling does not change the pack, so several threads can
+	sample the same pack at the same time. */
+class KnMotionPack
+{  public :
+	/*! Compression parameters. Tolerances are used to detect constant values and,
+		when reduce is true, to remove keys. Linear values use lintol, and euler angles,
+		twists and quaternions use angtol, in radians. Keys are only removed in motions
+		with up to 65536 frames. */
+	struct Params
+	{	float lintol, angtol;
+		bool reduce;
+		Params () { lintol=1E-4f; angtol=1E-4f; reduce=false; }
+	};
+
+	/*! Statistics computed by build(), with memory sizes in bytes and the maximum
+		errors measured by sampling all frames after compression */
+	struct Stats
+	{	int frames, curves, constants, keys;
+		gsuint32 rawbytes, packedbytes;
+		float linerror, angerror;
+		void output ( GsOutput& o ) const;
+	};
+
+	/*! Curve types, corresponding to the groups of KnChannelLayout */
+	enum CurveType { Linear, Angle, Quat };
+
+   private :
+	struct Curve
+	{	gsint32 pos;     // float position in the posture
+		gsint32 key;     // index of the first key in _keys, or -1 if all frames are keys
+		gsint32 nkeys;   // number of keys
+		gsint32 data;    // index of the first value in _fdata or _qdata
+		gscenum type;    // CurveType
+	};
+	GsArray<Curve> _curves;
+	GsArray<float> _base;      // values of the first frame, used for constant values
+	GsArray<gsuint16> _keys;   // frame indices of the keys of reduced curves
+	GsArray<float> _fdata;     // values of linear and angle curves
+	GsArray<gsuint16> _qdata;  // quantized quaternions, 3 words each
+	int _frames;
+	Stats _stats;
+
+   public :
+	/*! Constructor for an empty pack */
+	KnMotionPack ();
+
+	/*! Makes the pack empty */
+	void init ();
+
+	/*! Builds the pack from the frames of m, which must not be packed and must have
+		at least one frame. Statistics are updated. */
+	void build ( const KnMotion* m, const Params& p );
+
+	/*! Returns the number of frames in the pack */
+	int frames () const { return _frames; }
+
+	/*! Returns the number of floats of one decompressed posture */
+	int postfloats () const { return _base.size(); }
+
+	/*! Returns the statistics of the last build() */
+	const Stats& stats () const { return _stats; }
+
+	/*! Returns the memory used by the pack in bytes */
+	gsuint32 bytes () const;
+
+	/*! Puts in values the posture at frame f interpolated with frame f+1 at parameter
+		t in [0,1]. Array values must have postfloats() positions. If f is the last
+		frame, t must be 0 */
+	void sample ( int f, float t, float* values ) const;
+
+	/*! Encodes the unit quaternion q in 3 words with the smallest-three encoding */
+	static void encode ( const float* q, gsuint16* w );
+
+	/*! Decodes a quaternion encoded with encode() */
+	static void decode ( const gsuint16* w, float* q );
+};
+
+//================================ End of File =================================================
+
+# endif  // KN_MOTION_PACK_H
@@ -32,6 +32,13 @@ class KnSkeleton : public GsShareable
 	GsArray<KnJoint*> _joints;
 	mutable GsTable<KnJoint*> _jhash;
 	bool _gmat_uptodate;
+
+	// flat forward kinematics data, indexed as _joints, where parents come before children:
+	GsArray<GsMat> _lmats;	 // local matrices of the joints
+	GsArray<GsMat> _gmats;	 // global matrices of the joints
+	GsArray<int> _jparents;	 // index of the parent of each joint, -1 for the root
+	GsArray<gscbool> _gdirty; // joints with the global matrix out of date
+	friend class KnJoint;
 	bool _enforce_rot_limits;
 
 	// collision detection:
@@ -144,13 +151,19 @@ class KnSkeleton : public GsShareable
 		as it does not rely on the hash table. */
 	KnJoint* lsearch_joint ( const char* n ) const;
 
-	/*! Calls root()->update_gmat() only if it is required due to any
-		changes to the local matrices in joints */
+	/*! Updates the global matrices only if it is required due to any
+		changes to the local matrices in joints. The joints are traversed
+		in a single pass over the flat joint arrays, and only the joints
+		marked as dirty, and their descendants, are recomputed */
 	void update_global_matrices ();
 
 	/*! Returns true if all global matrices are up to date */
 	bool global_matrices_uptodate () { return _gmat_uptodate; }
 
+	/*! Returns the global matrices of all joints, indexed as the joints() array.
+		They are only valid after a call to update_global_matrices() */
+	const GsArray<GsMat>& global_matrices () const { return _gmats; }
+
 	/*! Set the internal flag that controls global matrices update to false.
 		This method is automatically called each time a joint value is changed */
 	void invalidate_global_matrices ();
@@ -229,6 +242,7 @@ class KnSkeleton : public GsShareable
 	bool export_joints ( GsOutput& out );
 
    private :
+	void _relink_matrices ();
 	int _loadjdata ( GsInput& in, KnJoint* j, GsDirs& paths, GsInput* igeo );
 	KnJoint* _loadj ( GsInput& in, KnJoint* p, GsDirs& paths, int type, GsInput* igeo );
 
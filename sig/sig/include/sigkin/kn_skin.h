@@ -11,6 +11,7 @@
 //================================ KnSkin ===================================
 
 # include <sig/gs_array.h>
+# include <sig/gs_skinning.h>
 # include <sig/sn_model.h>
 
 class SnLines;
@@ -19,14 +20,23 @@ class KnJoint;
 class KnSkeleton;
 
 /*! Maintains a model and skinning weights.
+	Skinning is linear blend skinning: each joint contributes its global matrix
+	multiplied by the inverse of its global matrix in the bind pose (the palette),
+	and vertices and normals are blended with the weights of the joints.
+	The blending can be done by the CPU (default), with the packed influences in SK, or on the GPU with gpu_skinning(true),
+	in which case the model keeps its bind pose and only the palette is updated.
 	This class is usually owned (via sharing) by a KnSkeleton. */
 class KnSkin : public SnModel
 {  public :
-	struct Weight { KnJoint* j; float w; GsVec v; GsQuat q; };
-	struct SkinVtx { int n; Weight* w; };
-	GsArray<SkinVtx> SV;
+	GsSkinning SK;	   // influences of the joints over the vertices, indexed by joint index
+	GsArray<GsPnt> BV; // bind pose vertices
+	GsArray<GsVec> BN; // bind pose normals, only used if the model has normals per vertex
+	GsArray<GsMat> IB; // inverse global matrices of the joints in the bind pose, indexed by joint index
+	GsArray<GsMat> G;  // global matrices of the joints used by the cpu skinning
 	KnSkeleton* skeleton;
 	bool _intn;
+	bool _gpu;
+	GsArray<GsBox> _jbox; // bind pose boxes of the vertices influenced by each joint, used with gpu skinning
 
    public :
 	/*! Constructor  */
@@ -44,9 +54,28 @@ class KnSkin : public SnModel
 		and if not given, it is extracted from filename. */
 	bool init ( KnSkeleton* skel, const char* filename, const char* basedir=0 );
 
-	/*! Computes the positions of all vertices of the skin according to the weights.
+	/*! Computes the positions and normals of all vertices of the skin according to the weights.
+		With gpu skinning only the palette is updated and sent to the renderer.
 		Will only update if the skin mesh is visible, otherwise nothing is done. */
 	void update ();
+
+	/*! Switches skinning to be computed by the renderer (true) or by update() (false).
+		Vertices are limited to their 4 most influential joints on the GPU, and
+		gpu skinning is only used for models with normals per vertex and up to 256 joints.
+		The bounding box is then computed from the palette, see get_bounding_box(). */
+	void gpu_skinning ( bool b );
+
+	/*! Returns true if gpu skinning is being used */
+	bool gpu_skinning () const { return _gpu; }
+
+	/*! With gpu skinning the model keeps its bind pose, so the box is the union of the
+		bind pose boxes of the vertices influenced by each joint, transformed by the palette.
+		This box contains the skinned vertices if their weights add to one, and is made
+		out of date by update() so that renderers culling by the box see the current pose. */
+	virtual void get_bounding_box ( GsBox& b ) const override;
+
+   protected :
+	void _update_palette ( GsArray<GsMat>& pal );
 };
 
 
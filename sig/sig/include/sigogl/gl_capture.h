@@ -0,0 +1,86 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GL_CAPTURE_H
+# define GL_CAPTURE_H
+
+/** \file gl_capture.h
+ * Asynchronous capture of OpenGL frames
+ */
+
+# include <sig/gs.h>
+
+//================================= GlCapture ===============================
+
+/*! GlCapture saves a sequence of frames without stalling the rendering thread.
+	capture() starts the read of the frame into one of a ring of pixel pack
+	buffers and returns without waiting; the pixels are retrieved in later calls,
+	after the fence placed after each read is signaled, and are then sent through a
+	bounded queue to encoder threads, which flip the images vertically and write them.
+	When the queue is full capture() waits for the encoders, keeping memory bounded.
+	Frames can be saved as png, bmp or tga images, as raw rgba files, or written in
+	sequence to the standard input of an external encoder process.
+	All methods must be called from the thread owning the OpenGL context. */
+class GlCapture
+{  public :
+	enum Format { Png, Bmp, Tga, Raw, Pipe };
+
+   private :
+	struct Data;
+	Data* _data;
+
+   public :
+	/*! Constructor specifying the number of pixel pack buffers, which is the number of
+		frames being read at the same time, the maximum number of frames waiting in the
+		queue, and the number of encoder threads. If threads<=0, the number of hardware
+		threads minus one is used. OpenGL objects are only created by the first capture. */
+	GlCapture ( int buffers=3, int queue=8, int threads=0 );
+
+	/*! Destructor calls close(), so the OpenGL context must be active */
+   ~GlCapture ();
+
+	/*! Starts a new sequence, with files named as the given file followed by a 4-digit
+		frame number starting at n, and with the format defined by the file extension:
+		bmp, tga, raw, or otherwise png. Raw files have the rgba bytes of all pixels,
+		starting from the top line. */
+	void open ( const char* file, int n=1 );
+
+	/*! Starts a new sequence sent to the standard input of the given command, as raw
+		rgba frames starting from the top line. A single encoder thread is then used
+		in order to keep the order of the frames. SIGPIPE is ignored while the pipe is
+		open, so that an encoder that exits early is reported by error(). Returns false
+		if the command could not be started. */
+	bool open_pipe ( const char* command );
+
+	/*! Retrieves all frames being read, waits for all frames to be written, and
+		finishes the sequence. */
+	void close ();
+
+	/*! Returns true if a sequence is open */
+	bool opened () const;
+
+	/*! Returns the output format of the current sequence */
+	Format format () const;
+
+	/*! Starts reading the viewport of the front buffer, or of the back buffer if
+		front is false, as the next frame */
+	void capture ( bool front=true );
+
+	/*! Returns the number of the next frame to be captured */
+	int frame_number () const;
+
+	/*! Returns the number of frames already written in the current sequence */
+	int frames_written () const;
+
+	/*! Returns true if an encoder could not write a frame, in which case the
+		following frames are discarded until close() is called */
+	bool error () const;
+};
+
+//================================= End of File ===============================
+
+# endif // GL_CAPTURE_H
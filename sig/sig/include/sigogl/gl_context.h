@@ -43,6 +43,9 @@ class GlContext : public GsShareable
 	bool _depthtest;
 	GLuint _curprogram;
 	GLenum _polygonmode;
+	// Uniform updates:
+	gsuint _projstamp, _lightstamp;
+	GsLight _lastlight;
 
    public :
 	GsLight light;
@@ -66,8 +69,9 @@ class GlContext : public GsShareable
 
 	/*! Set pointers for the transformations to be accessed by GlContext. 
 		It is the user resposibility to provide pointers to valid matrices.
-		No calls to OpenGL are made. */
-	void projection ( const GsMat* m ) { _projection=m; }
+		No calls to OpenGL are made. The projection has to be set again when
+		the contents of its matrix change, see uniform_projection(). */
+	void projection ( const GsMat* m );
 	void modelview ( const GsMat* m ) { _localframe=m; }
 	const GsMat* projection () { return _projection; }
 	const GsMat* modelview () { return _localframe; }
@@ -87,6 +91,20 @@ class GlContext : public GsShareable
 
 	void use_program ( GLuint pid );
 	void use_program ( const GlProgram* p ) { use_program(p->id); }
+
+	/*! Sends the projection matrix to uniform location p->uniloc[u] of program p, which
+		must be the current program, unless p already received it after the last call to
+		projection(m). Uniform values are kept by each program, so that when shapes using
+		the same program are rendered in sequence the matrix is only sent once. */
+	void uniform_projection ( const GlProgram* p, int u=0 );
+
+	/*! Sends the light position and intensities to uniform locations u and u+1 of the
+		current program p, unless p already received the same light values. */
+	void uniform_light ( const GlProgram* p, int u );
+
+	/*! Sends the colors and parameters of material m to uniform locations u and u+1 of
+		the current program p, unless p already received the same material. */
+	void uniform_material ( const GlProgram* p, const GsMaterial& m, int u );
 };
 
 //================================= End of File ===============================
@@ -0,0 +1,56 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# ifndef GL_PROFILER_H
+# define GL_PROFILER_H
+
+/** \file gl_profiler.h
+ * GPU timer queries for GsProfiler
+ */
+
+# include <sig/gs.h>
+
+//================================= GlProfiler ===============================
+
+/*! GlProfiler measures the GPU time of OpenGL commands with GL_TIME_ELAPSED queries
+	and sends the results to GsProfiler. Each begin()/end() pair records the time of
+	the commands issued between them, which cannot be nested. Results are only read
+	by collect() when they are available, usually one or two frames later, so that
+	the rendering thread never waits for the GPU; each result is then added to the
+	frame of GsProfiler that was current when begin() was called. Query objects are
+	reused once their results are read. GlRenderer uses a GlProfiler to time the
+	rendering of each shape while GsProfiler is enabled.
+	All methods must be called from the thread owning the OpenGL context. */
+class GlProfiler
+{  private :
+	struct Data;
+	Data* _data;
+
+   public :
+	/*! Constructor. Query objects are only created by the first begin() call. */
+	GlProfiler ();
+
+	/*! Destructor deletes the query objects, requiring the OpenGL context to be active */
+   ~GlProfiler ();
+
+	/*! Starts timing a set of commands identified by the given static string.
+		Nothing is done if GsProfiler is disabled. */
+	void begin ( const char* name );
+
+	/*! Ends the timing started by the last begin() call */
+	void end ();
+
+	/*! Sends to GsProfiler the results already available, in the order of the queries */
+	void collect ();
+
+	/*! Returns the number of queries waiting for their results */
+	int pending () const;
+};
+
+//================================ End of File ========================================
+
+# endif // GL_PROFILER_H
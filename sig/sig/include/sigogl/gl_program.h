@@ -9,6 +9,7 @@
 # define GL_PROGRAM_H
 
 # include <sig/gs.h>
+# include <sig/gs_material.h>
 # include <sigogl/gl_types.h>
 
 class GlShader;
@@ -22,6 +23,10 @@ class GlProgram
 	GLuint id;
 	GLint *uniloc;
 	gsbyte nu;
+	// uniform values last sent with GlContext methods, used to skip redundant updates:
+	mutable gsuint projstamp, lightstamp;
+	mutable GsMaterial material;
+	mutable gscbool materialsent;
    private :
 	gscbool _linked;
    private : // resource management information
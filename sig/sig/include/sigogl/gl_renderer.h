@@ -14,22 +14,64 @@
 
 # include <sig/sa_action.h>
 # include <sig/sn_shape.h>
+# include <sig/gs_frustum.h>
 # include <sigogl/gl_context.h>
 
+class GlrBase;
+class GlProfiler;
+
 /*! \class GlRenderer gl_renderer.h
 	\brief OpenGL 4 shader-based render action
 
 	GlRenderer traverses the scene graph invoking the scene node methods
-	for shader-based OpenGL 4 rendering. No particular scene optimization
-	strategy is incorporated. This class can be derived or serve as a guide
-	to write other renderers optimizing different aspects of an application. */
+	for shader-based OpenGL 4 rendering. In DirectTraversal mode (the default)
+	all visible shapes are rendered. In CullingTraversal mode the cached bounding
+	box of each shape, and of each separator group with culling turned on (see SnGroup::culling()),
+	is tested against the view frustum of the projection and modelview matrices,
+	and nodes that are entirely outside the frustum are skipped. Subtrees of groups
+	entirely inside the frustum are rendered without further tests.
+	SortedTraversal performs the same culling, but instead of rendering shapes during
+	the traversal it queues them with their matrices, and then renders opaque shapes
+	sorted by program, material and increasing depth, followed by transparent shapes
+	in decreasing depth. Uniforms already sent to a program are not sent again by the
+	GlContext uniform methods, so that sorting reduces state changes. Consecutive opaque
+	shapes with the same instance key and program, and materials only differing in
+	their diffuse colors, are drawn together with GlrBase::render_instances(), what
+	draws with a single call all SnModel nodes sharing a GsModel without materials.
+	While GsProfiler is enabled the GPU time of each shape, or of each set of instances
+	drawn together, is measured with a GlProfiler and reported with the instance name
+	of the shape.
+	This class can be derived or serve as a guide to write other renderers
+	optimizing different aspects of an application. */
 class GlRenderer : private SaAction
 {  public :
-	enum Mode { DirectTraversal };
+	enum Mode { DirectTraversal, CullingTraversal, SortedTraversal };
 
    protected :
 	GlContext* _context;
 	Mode _mode;
+	GsMat _projection;    // copy of the projection matrix used for culling
+	GsFrustum _frustum;   // frustum in the coordinates of the top matrix
+	gscbool _frustumuptodate;
+	int _inside;          // >0 while traversing a group entirely inside the frustum
+	int _rendered, _culled, _instanced;
+	struct Packet
+	{	SnShape* shape;
+		SnMaterial* material; // material node applying to the shape, or null
+		GsMat mat;            // modelview matrix
+		GLuint program;       // see GlrBase::sort_info()
+		gsuint32 mtlhash;     // hash of the shape material
+		const void* instkey;  // see GlrBase::instance_key()
+		float depth;          // depth of the box center in eye coordinates
+		int order;            // position in the traversal
+		gscbool transparent;
+	};
+	GsArray<Packet> _queue;
+	GsArray<SnShape*> _ishapes; // shapes, matrices and materials of instances drawn together
+	GsArray<GsMat> _imats;
+	GsArray<GsMaterial> _imtls;
+	GlProfiler* _profiler;      // created when GsProfiler is first enabled
+	gscbool _profiling;         // true during an apply() while GsProfiler is enabled
 
    public :
 	/*! Constructor requires a pointer to the (shared) GlContext to be used. 
@@ -42,6 +84,18 @@ class GlRenderer : private SaAction
 	/*! Set the rendering optimization mode */
 	void traversal_mode ( Mode m ) { _mode=m; }
 
+	/*! Get the rendering optimization mode */
+	Mode traversal_mode () const { return _mode; }
+
+	/*! Returns the number of shapes rendered in the last apply() call */
+	int rendered () const { return _rendered; }
+
+	/*! Returns the number of shapes and groups skipped by culling in the last apply() call */
+	int culled () const { return _culled; }
+
+	/*! Returns the number of shapes drawn together with other instances in the last apply() call */
+	int instanced () const { return _instanced; }
+
 	/*! Provides access to GsShareable::ref(). */
 	void ref () { GsShareable::ref(); }
 
@@ -60,22 +114,29 @@ class GlRenderer : private SaAction
 
 	/*! Initializes the matrix stack and the context transformations to identity. */
 	void init ()
-	{ SaAction::init(); _context->projection(&GsMat::id); _context->modelview(&_matstack[0]); }
+	{ SaAction::init(); _context->projection(&GsMat::id); _context->modelview(&_matstack[0]); _projection=GsMat::id; }
 
 	/*! Initializes the matrix stack and the modelview transformation to identity,
 		and set the projection transformation to p. */
 	void init ( const GsMat* p ) 
-	{ SaAction::init(); _context->projection(p); _context->modelview(&_matstack[0]); }
+	{ SaAction::init(); _context->projection(p); _context->modelview(&_matstack[0]); _projection=*p; }
 
 	/*! Initializes the matrix stack and the context with given transformations. */
 	void init ( const GsMat* p, const GsMat* c )
-	{ SaAction::init(*c); _context->projection(p); _context->modelview(&_matstack[0]); }
+	{ SaAction::init(*c); _context->projection(p); _context->modelview(&_matstack[0]); _projection=*p; }
 
 	/*! Calls the base class apply() method. */
 	void apply ( SnNode* n );
 
    private :
+	GsFrustum::Result _cull ( const GsBox& b );
+	void _enqueue ( SnShape* s );
+	void _render_queue ();
+	static int _compare ( const Packet* p1, const Packet* p2 );
+	void _render ( GlrBase* r, SnShape* s );
+	virtual bool group_apply ( SnGroup* g ) override;
 	virtual bool shape_apply ( SnShape* s ) override;
+	virtual void mult_matrix ( const GsMat& mat ) override;
 	virtual void push_matrix () override;
 	virtual void pop_matrix () override;
 };
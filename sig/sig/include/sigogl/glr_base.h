@@ -8,7 +8,9 @@
 # ifndef GLR_BASE_H
 # define GLR_BASE_H
 
+# include <sig/gs_mat.h>
 # include <sig/sn_shape.h>
+# include <sigogl/gl_types.h>
 
 class GlrBase : public SnShapeRenderer
  { public:
@@ -16,6 +18,24 @@ class GlrBase : public SnShapeRenderer
 	/*! Required render shape method. */
 	virtual void render ( SnShape* shape, GlContext* c )=0;
 
+	/*! Gives information for renderers sorting shapes before rendering them: the id
+		of the program render() will use, or 0 if not known, and if the shape has
+		transparent parts. The default implementation gives 0 and checks the alpha
+		of the shape material. */
+	virtual void sort_info ( SnShape* shape, GLuint& program, bool& transparent );
+
+	/*! Returns a key identifying the vertex data render() uses for the shape, so that
+		renderers sorting shapes can draw together, with render_instances(), opaque
+		shapes with the same non-null key and program. The default implementation
+		returns null, meaning that the shape is not drawn with instancing. */
+	virtual const void* instance_key ( SnShape* shape );
+
+	/*! Draws n shapes with the same instance key. Each shape is drawn with its
+		modelview matrix in mats and its material in mtls, and materials can only
+		differ in their diffuse colors. The default implementation renders each
+		shape with render(). */
+	virtual void render_instances ( SnShape** shapes, const GsMat* mats, const GsMaterial* mtls, int n, GlContext* c );
+
 	/*! Set the instantiators for all shape renderers. This function is automatically
 		called at OpenGL initialization time, but can be called again to re-define
 		the original instantiators. */
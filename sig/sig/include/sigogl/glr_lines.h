@@ -27,6 +27,7 @@ class GlrLines : public GlrBase
 	virtual ~GlrLines ();
 	virtual void init ( SnShape* s ) override;
 	virtual void render ( SnShape* s, GlContext* c ) override;
+	virtual void sort_info ( SnShape* s, GLuint& program, bool& transparent ) override;
 };
 
 //================================ End of File =================================================
@@ -12,23 +12,51 @@
  * SnModel renderer
  */
 
-//# include <sig/sn_shape.h>
-# include <sigogl/gl_objects.h>
+# include <sig/sn_model.h>
 # include <sigogl/glr_base.h>
 
+class GlProgram;
+
 /*! \class GlrModel sr_model.h
 	\brief SnModel renderer
 
-	Renderer for SnModel */
+	Renderer for SnModel. The vertex array and buffers of models that are not
+	skinned are shared by all renderers drawing the same GsModel with the same
+	buffer layout in the same GlContext, so that GPU memory grows with the number
+	of different models and not with the number of SnModel nodes. Vertex arrays
+	cannot be shared among OpenGL contexts, so each GlContext, which corresponds to
+	one window or offscreen context, has its own buffers. When several SnModel nodes share
+	the same GsModel, changes made to the model are uploaded by the renderer of
+	the first touched node rendered, and are then seen by all nodes.
+	Models without materials rendered in flat, gouraud or phong mode can also
+	be drawn with instancing, see render_instances(). */
 class GlrModel : public GlrBase
- { protected :
-	GlObjects _glo; // indices for opengl vertex arrays and buffers
-	bool _normalspervertex;
+ { public :
+	struct Buffers; // vertex array and buffers holding the data of a model
+   protected :
+	Buffers* _buf;		// buffers in use, shared by the renderers of the same GsModel if not skinned
    public :
 	GlrModel ();
 	virtual ~GlrModel ();
 	virtual void init ( SnShape* s ) override;
 	virtual void render ( SnShape* s, GlContext* c ) override;
+	virtual void sort_info ( SnShape* s, GLuint& program, bool& transparent ) override;
+
+	/*! Returns the GsModel of s if s can be drawn with instancing, or null otherwise */
+	virtual const void* instance_key ( SnShape* s ) override;
+
+	/*! Draws all shapes with a single instanced draw call, sending the matrices and
+		diffuse colors of the instances in a vertex buffer */
+	virtual void render_instances ( SnShape** shapes, const GsMat* mats, const GsMaterial* mtls, int n, GlContext* c ) override;
+
+	/*! Returns the number of buffer sets currently shared among renderers */
+	static int shared_buffers ();
+
+   protected :
+	const GlProgram* _update ( SnShape* s, GlContext* c, gscbool& textured, GsModel::MtlMode& mtlmode, SnModel::Skinning*& skin );
+	bool _attach ( GsModel* m, GlContext* c, gsbyte layout, bool share );
+	void _release ();
+	void _upload ( int b, GLenum target, gsuint size, const void* data );
 };
 
 //================================ End of File =================================================
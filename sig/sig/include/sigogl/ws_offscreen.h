@@ -0,0 +1,116 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+/** \file ws_offscreen.h
+ * Offscreen rendering of scenes without windows
+ */
+
+# ifndef WS_OFFSCREEN_H
+# define WS_OFFSCREEN_H
+
+# include <sig/gs_color.h>
+# include <sig/gs_light.h>
+# include <sig/gs_camera.h>
+
+class SnNode;
+class SnGroup;
+class GsImage;
+class GlRenderer;
+
+/*! \class WsOffscreen ws_offscreen.h
+	\brief Renders scenes to images without windows
+
+	WsOffscreen renders a scene graph to a framebuffer object of its own OpenGL context,
+	which is not attached to any visible window, and reads the result into a GsImage.
+	No events are processed and ws_run() is not needed, so that batch jobs can render
+	images on machines without a display: on linux a surfaceless egl context is then
+	used, with mesa's llvmpipe software renderer as fallback. The scene is rendered
+	in the same way as by WsViewer, with the same camera, light and background
+	parameters, but without the viewer axis, bounding box and user interface. */
+class WsOffscreen
+ { private :
+	struct Data;
+	Data* _data;
+
+   public :
+	/*! Creates the OpenGL context and a framebuffer of the given size. If samples>1,
+		the scene is rendered with multisampling antialiasing. If software is true,
+		a software renderer is requested, see wsi_new_offscreen(). Method valid()
+		tells if the context could be created. */
+	WsOffscreen ( int w, int h, int samples=4, bool software=false );
+
+	/*! Destructs all internal data, and calls unref() for the root node. */
+   ~WsOffscreen ();
+
+	/*! Returns true if the OpenGL context was created */
+	bool valid () const;
+
+	/*! Activates the OpenGL context used by the offscreen renderer. It is activated
+		by render(), but it is needed if OpenGL objects are deleted or created
+		outside of render(), for example when deleting nodes of a rendered scene. */
+	void activate_ogl_context () const;
+
+	/*! Changes the size of the rendered images */
+	void size ( int w, int h );
+
+	/*! Returns the width of the rendered images */
+	int w () const;
+
+	/*! Returns the height of the rendered images */
+	int h () const;
+
+	/*! Returns the root of the scene, which is initially an empty SnGroup */
+	SnNode* root () const;
+
+	/*! Returns the root of the scene as an SnGroup, which is only valid if the
+		root was not replaced by a node of another type */
+	SnGroup* rootg () const;
+
+	/*! Sets a new root node, calling unref() for the old one and ref() for the new one.
+		If null is given an empty SnGroup is used. */
+	void root ( SnNode* r );
+
+	/*! Returns the renderer used for the scene, for example to set its traversal mode */
+	GlRenderer* scene_renderer () const;
+
+	/*! Access to the camera */
+	GsCamera& camera ();
+
+	/*! Sets the camera */
+	void camera ( const GsCamera& cam );
+
+	/*! Access to the light */
+	GsLight& light ();
+
+	/*! Sets the light */
+	void light ( const GsLight& l );
+
+	/*! Returns the background color */
+	GsColor background () const;
+
+	/*! Sets the background color */
+	void background ( GsColor c );
+
+	/*! Adjusts the camera to view the whole scene, as in WsViewer::view_all() */
+	void view_all ();
+
+	/*! Renders the scene. Returns false if the framebuffer could not be created. */
+	bool render ();
+
+	/*! Reads the last rendered frame into img */
+	void snapshot ( GsImage& img );
+
+	/*! Renders the scene and reads it into img */
+	bool render ( GsImage& img ) { if ( !render() ) return false; snapshot(img); return true; }
+
+	/*! Renders the scene and saves it in a png, bmp or tga file according to the extension */
+	bool render ( const char* file );
+};
+
+//================================ End of File =================================================
+
+# endif // WS_OFFSCREEN_H
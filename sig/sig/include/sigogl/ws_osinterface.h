@@ -61,6 +61,20 @@ void wsi_activate_ogl_context ( void* win );
 // system-dependent function to load an OpenGL function by name
 extern void* wsi_get_ogl_procedure ( const char *name );
 
+//========== Offscreen ===========
+
+// creates an OpenGL context without a visible window, sharing objects with the windows; on linux,
+// when there is no display and no window, a surfaceless egl context is created instead, and windows
+// should not be created afterwards; if software is true mesa's llvmpipe renderer is requested,
+// and it is also tried if no egl context can be created otherwise; returns null on failure
+void* wsi_new_offscreen ( bool software );
+
+// deletes the offscreen context
+void wsi_del_offscreen ( void* ctx );
+
+// set the offscreen OpenGL context to be active
+void wsi_activate_offscreen ( void* ctx );
+
 //========== Events ===========
 
 // get window events and send them to the respective windows; returns number of open windows
@@ -61,7 +61,9 @@ class WsViewer : public WsWindow
 				   VCmdAxis,		//!< display the global axis
 				   VCmdBoundingBox,	//!< display the scence bounding box
 				   VCmdStatistics,	//!< display rendering statistics
-				   VCmdSpinAnim		//!< turn on/off spin animation
+				   VCmdSpinAnim,	//!< turn on/off spin animation
+				   VCmdProfiler,	//!< turn on/off GsProfiler and the display of its frame summary
+				   VCmdSaveTrace	//!< save the frames recorded by GsProfiler in a Chrome trace file
 				};
 
    private : // internal data
@@ -95,6 +97,10 @@ class WsViewer : public WsWindow
 		It can only be called if the user has not changed the type of the root node. */
 	SnGroup* rootg () const;
 
+	/*! Access to the internal renderer used for the scene, for example to turn on
+		its GlRenderer::CullingTraversal mode */
+	GlRenderer* scene_renderer () const;
+
 	/*! Changes the scene root pointer. When the new node r is given, r->ref() is 
 		called, and the old root node has its unref() method called. If r is null,
 		an empty SnGroup is created and used as root. */
@@ -208,7 +214,11 @@ class WsViewer : public WsWindow
 
 	/*! Turns on or off snapshot saving per frame. Optional parameters specify the
 		desired base file name and the start number (>1) for enumerating files.
-		The file name extension defines the image format: bmp, tga, or otherwise png. */
+		The file name extension defines the image format: bmp, tga, raw (rgba bytes),
+		or otherwise png. If the file name starts with '|', the rest of it is a command
+		receiving the frames as raw rgba data in its standard input. Frames are read
+		and saved asynchronously with GlCapture, and turning snapshots off waits for
+		all frames to be saved. */
 	void snapshots ( bool onoff, const char* file=0, int n=-1 );
 
    protected : //----> methods overriding WsWindow virtual methods
@@ -0,0 +1,30 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+layout (location = 4) in mat4 iView;  // instance transformation, applied before vView (uses locations 4 to 7)
+layout (location = 8) in vec4 iColor; // instance diffuse color
+
+uniform mat4	 vProj;
+uniform mat4	 vView;
+uniform vec3     lPos;    // light position
+uniform vec3[3]  lInt;    // light intensities: ambient, diffuse, and specular 
+uniform vec3[4]  mColors; // material colors  : ambient, diffuse, specular, and emission 
+uniform float[2] mParams; // material params  : shininess, transparency
+
+flat out vec4 Color;
+
+vec4 shade ( vec3 p, vec3 n, vec3 lp, vec3[3] li, vec3 ka, vec3 kd, vec3 ks, vec3 emi, float sh, float alpha );
+
+void main ()
+{
+	mat4 view = iView * vView;
+	vec4 p4 = vec4(vPos,1.0f) * view; // vertex pos in eye coords
+	vec3 p = p4.xyz / p4.w;
+
+	vec3 n = normalize ( vNorm*transpose(inverse(mat3(view))) ); // vertex normal 
+
+	Color = shade ( p, n, lPos, lInt, mColors[0], iColor.rgb/255.0, mColors[2], mColors[3], mParams[0], mParams[1] );
+
+	gl_Position = vec4(p,1.0) * vProj;
+}
@@ -0,0 +1,23 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+layout (location = 4) in mat4 iView;  // instance transformation, applied before vView (uses locations 4 to 7)
+layout (location = 8) in vec4 iColor; // instance diffuse color
+
+uniform mat4 vProj;
+uniform mat4 vView;
+
+out vec3 Pos;
+out vec4 Color;
+out vec3 Norm;
+
+void main ()
+{
+	mat4 view = iView * vView;
+	vec4 p4 = vec4(vPos,1.0f) * view; // vertex pos in eye coords
+	Pos = p4.xyz / p4.w;
+	Color = iColor / 255.0;
+	Norm = normalize ( vNorm*transpose(inverse(mat3(view))) );
+	gl_Position = vec4(Pos,1.0) * vProj;
+}
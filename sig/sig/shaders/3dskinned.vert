@@ -0,0 +1,42 @@
+# version 330
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNorm;
+layout (location = 2) in uvec4 vJoints;  // indices of up to 4 influencing joints
+layout (location = 3) in vec4 vWeights; // and their weights
+
+uniform mat4	 vProj;
+uniform mat4	 vView;
+uniform vec3     lPos;	  // light position
+uniform vec3[3]  lInt;    // light intensities: ambient, diffuse, and specular
+uniform vec3[4]  mColors; // material colors  : ambient, diffuse, specular, and emission
+uniform float[2] mParams; // material params  : shininess, transparency
+uniform samplerBuffer Palette; // joint matrices, one line per texel and 4 texels per matrix
+
+out vec4 Color;
+
+vec4 shade ( vec3 p, vec3 n, vec3 lp, vec3[3] li, vec3 ka, vec3 kd, vec3 ks, vec3 emi, float sh, float alpha );
+
+void main ()
+{
+	vec4 r0 = vec4(0.0); vec4 r1 = vec4(0.0); vec4 r2 = vec4(0.0);
+	for ( int i=0; i<4; i++ ) // blend the first 3 lines of the influencing matrices
+	{	int j = int(vJoints[i])*4;
+		r0 += texelFetch ( Palette, j ) * vWeights[i];
+		r1 += texelFetch ( Palette, j+1 ) * vWeights[i];
+		r2 += texelFetch ( Palette, j+2 ) * vWeights[i];
+	}
+
+	vec4 v4 = vec4(vPos,1.0f);
+	vec3 sp = vec3 ( dot(r0,v4), dot(r1,v4), dot(r2,v4) ); // skinned position
+	vec3 sn = vec3 ( dot(r0.xyz,vNorm), dot(r1.xyz,vNorm), dot(r2.xyz,vNorm) ); // skinned normal
+
+	vec4 p4 = vec4(sp,1.0f) * vView; // vertex pos in eye coords
+	vec3 p = p4.xyz / p4.w;
+
+	vec3 n = normalize ( sn*transpose(inverse(mat3(vView))) ); // vertex normal
+
+	Color = shade ( p, n, lPos, lInt, mColors[0], mColors[1], mColors[2], mColors[3], mParams[0], mParams[1] );
+
+	gl_Position = vec4(p,1.0) * vProj;
+}
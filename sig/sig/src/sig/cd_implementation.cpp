@@ -7,6 +7,278 @@
 
 # include <sig/cd_implementation.h>
 
+//# define GS_USE_TRACE1 // hierarchy construction
+# include <sig/gs_trace.h>
+
+// maximum number of triangles stored in a leaf of the hierarchy:
+# define CD_LEAF_SIZE 2
+
+//================================ Geometric Tests =====================================
+
+// Separating axis test between box (ca,ra) given in the frame of object a and box (cb,rb)
+// given in the frame of object b, where (R,T) maps coordinates from frame b to frame a.
+// Returns true if the boxes overlap or are closer than toler along all tested axes.
+static bool _boxes_overlap ( const GsVec& ca, const GsVec& ra, const GsVec& cb, const GsVec& rb,
+							 const float R[3][3], const GsVec& T, float toler )
+{
+	int i, j, i1, i2, j1, j2;
+	float AR[3][3], a0, b0;
+	GsVec t;
+
+	for ( i=0; i<3; i++ )
+	{	t[i] = R[i][0]*cb.x + R[i][1]*cb.y + R[i][2]*cb.z + T(i) - ca(i);
+		for ( j=0; j<3; j++ ) AR[i][j] = GS_ABS(R[i][j]) + gstiny; // epsilon for near parallel axes
+	}
+
+	// 3 axes of a:
+	for ( i=0; i<3; i++ )
+	{	b0 = rb.x*AR[i][0] + rb.y*AR[i][1] + rb.z*AR[i][2];
+		if ( GS_ABS(t[i]) > ra(i)+b0+toler ) return false;
+	}
+
+	// 3 axes of b:
+	for ( j=0; j<3; j++ )
+	{	a0 = ra.x*AR[0][j] + ra.y*AR[1][j] + ra.z*AR[2][j];
+		if ( GS_ABS(t.x*R[0][j]+t.y*R[1][j]+t.z*R[2][j]) > a0+rb(j)+toler ) return false;
+	}
+
+	// 9 cross products between the axes of a and b:
+	for ( i=0; i<3; i++ )
+	{	i1=(i+1)%3; i2=(i+2)%3;
+		for ( j=0; j<3; j++ )
+		{	j1=(j+1)%3; j2=(j+2)%3;
+			a0 = ra(i1)*AR[i2][j] + ra(i2)*AR[i1][j];
+			b0 = rb(j1)*AR[i][j2] + rb(j2)*AR[i][j1];
+			if ( GS_ABS(t(i2)*R[i1][j]-t(i1)*R[i2][j]) > a0+b0+toler ) return false;
+		}
+	}
+
+	return true;
+}
+
+// Returns true if the projections of triangles p and q on axis ax do not overlap
+static bool _tris_separated ( const GsVec& ax, const GsPnt* p, const GsPnt* q )
+{
+	if ( ax.isnull() ) return false; // degenerate axis cannot separate anything
+
+	float p0=dot(ax,p[0]), p1=dot(ax,p[1]), p2=dot(ax,p[2]);
+	float q0=dot(ax,q[0]), q1=dot(ax,q[1]), q2=dot(ax,q[2]);
+
+	if ( GS_MAX3(p0,p1,p2) < GS_MIN3(q0,q1,q2) ) return true;
+	if ( GS_MAX3(q0,q1,q2) < GS_MIN3(p0,p1,p2) ) return true;
+	return false;
+}
+
+// Exact triangle-triangle intersection with the separating axis theorem: the two face
+// normals, the 9 edge-edge cross products, and the 6 in-plane edge normals which are
+// only needed to separate coplanar triangles. Touching triangles are reported as intersecting.
+static bool _tris_intersect ( const GsPnt* p, const GsPnt* q )
+{
+	int i, j;
+	GsVec ep[3] = { p[1]-p[0], p[2]-p[1], p[0]-p[2] };
+	GsVec eq[3] = { q[1]-q[0], q[2]-q[1], q[0]-q[2] };
+	GsVec np = cross ( ep[0], ep[1] );
+	GsVec nq = cross ( eq[0], eq[1] );
+
+	if ( _tris_separated(np,p,q) ) return false;
+	if ( _tris_separated(nq,p,q) ) return false;
+
+	for ( i=0; i<3; i++ )
+		for ( j=0; j<3; j++ )
+			if ( _tris_separated(cross(ep[i],eq[j]),p,q) ) return false;
+
+	for ( i=0; i<3; i++ )
+	{	if ( _tris_separated(cross(np,ep[i]),p,q) ) return false;
+		if ( _tris_separated(cross(nq,eq[i]),p,q) ) return false;
+	}
+
+	return true;
+}
+
+// Squared distance between point x and triangle p, by locating the Voronoi region of x
+static float _dist2_point_tri ( const GsPnt& x, const GsPnt* p )
+{
+	GsVec ab=p[1]-p[0], ac=p[2]-p[0], ax=x-p[0];
+	float d1=dot(ab,ax), d2=dot(ac,ax);
+	if ( d1<=0 && d2<=0 ) return dist2 ( x, p[0] );
+
+	GsVec bx=x-p[1];
+	float d3=dot(ab,bx), d4=dot(ac,bx);
+	if ( d3>=0 && d4<=d3 ) return dist2 ( x, p[1] );
+
+	float vc=d1*d4-d3*d2;
+	if ( vc<=0 && d1>=0 && d3<=0 ) return dist2 ( x, p[0]+ab*(d1/(d1-d3)) );
+
+	GsVec cx=x-p[2];
+	float d5=dot(ab,cx), d6=dot(ac,cx);
+	if ( d6>=0 && d5<=d6 ) return dist2 ( x, p[2] );
+
+	float vb=d5*d2-d1*d6;
+	if ( vb<=0 && d2>=0 && d6<=0 ) return dist2 ( x, p[0]+ac*(d2/(d2-d6)) );
+
+	float va=d3*d6-d5*d4;
+	if ( va<=0 && d4>=d3 && d5>=d6 ) return dist2 ( x, p[1]+(p[2]-p[1])*((d4-d3)/((d4-d3)+(d5-d6))) );
+
+	float den = va+vb+vc;
+	if ( den==0 ) return dist2 ( x, p[0] ); // degenerate triangle, edges are tested separatelly
+	return dist2 ( x, p[0]+ab*(vb/den)+ac*(vc/den) );
+}
+
+// Squared distance between segments [p1,q1] and [p2,q2]
+static float _dist2_seg_seg ( const GsPnt& p1, const GsPnt& q1, const GsPnt& p2, const GsPnt& q2 )
+{
+	const float eps = gstiny*gstiny;
+	GsVec d1=q1-p1, d2=q2-p2, r=p1-p2;
+	float a=dot(d1,d1), e=dot(d2,d2), f=dot(d2,r);
+	float s, t;
+
+	if ( a<=eps && e<=eps ) return dist2 ( p1, p2 );
+	if ( a<=eps )
+	{	s = 0;
+		t = f/e; t = GS_BOUND(t,0,1);
+	}
+	else
+	{	float c = dot(d1,r);
+		if ( e<=eps )
+		{	t = 0;
+			s = -c/a; s = GS_BOUND(s,0,1);
+		}
+		else
+		{	float b=dot(d1,d2), den=a*e-b*b;
+			if ( den!=0 ) { s=(b*f-c*e)/den; s=GS_BOUND(s,0,1); } else s=0;
+			t = (b*s+f)/e;
+			if ( t<0 ) { t=0; s=-c/a; s=GS_BOUND(s,0,1); }
+			else if ( t>1 ) { t=1; s=(b-c)/a; s=GS_BOUND(s,0,1); }
+		}
+	}
+	return dist2 ( p1+d1*s, p2+d2*t );
+}
+
+// Returns true if the distance between triangles p and q is smaller than toler
+static bool _tris_closer ( const GsPnt* p, const GsPnt* q, float toler )
+{
+	if ( _tris_intersect(p,q) ) return true;
+
+	int i, j;
+	float t2 = toler*toler;
+	for ( i=0; i<3; i++ )
+	{	if ( _dist2_point_tri(p[i],q)<t2 ) return true;
+		if ( _dist2_point_tri(q[i],p)<t2 ) return true;
+	}
+	for ( i=0; i<3; i++ )
+		for ( j=0; j<3; j++ )
+			if ( _dist2_seg_seg(p[i],p[(i+1)%3],q[j],q[(j+1)%3])<t2 ) return true;
+
+	return false;
+}
+
+//================================ CdImplementation::Object =====================================
+
+class CdImplementation::Object
+{  public :
+	struct Node
+	{	GsVec c, r; // center and half sizes of the node box, in model coordinates
+		int i;		// first triangle for leaves, or index of the second child for internal nodes
+		int n;		// number of triangles for leaves, 0 for internal nodes
+	};
+	GsArray<Node> nodes; // hierarchy in depth-first order, the first child follows its parent
+	GsArray<GsPnt> tv;	 // three vertices per triangle, in the order referenced by the leaves
+	float R[3][3];		 // rotation of the current transformation
+	GsVec T;			 // translation of the current transformation
+	GsBox wbox;			 // bounding box of the object in world coordinates
+	GsArray<int> deact;	 // sorted ids of the objects forming deactivated pairs with this one
+	bool active;
+	int id;
+
+   public :
+	Object ( const GsModel& m );
+	void transformation ( const GsMat& m );
+	bool deactivated ( int oid ) const { return deact.bsearch(oid,gs_compare)>=0; }
+
+   private :
+	void _build ( const GsModel& m, GsArray<int>& ti, const GsArray<GsPnt>& tc, int first, int n );
+};
+
+CdImplementation::Object::Object ( const GsModel& m )
+{
+	int i, fsize=m.F.size();
+	GsArray<int> ti(fsize);
+	GsArray<GsPnt> tc(fsize);
+
+	for ( i=0; i<fsize; i++ ) { ti[i]=i; tc[i]=m.face_center(i); }
+
+	if ( fsize>0 )
+	{	nodes.capacity ( 2*fsize ); // a binary tree with n leaves has 2n-1 nodes
+		_build ( m, ti, tc, 0, fsize );
+		nodes.compress ();
+	}
+	GS_TRACE1 ( "Hierarchy with "<<nodes.size()<<" nodes built for "<<fsize<<" triangles" );
+
+	tv.size ( 3*fsize );
+	for ( i=0; i<fsize; i++ )
+	{	const GsModel::Face& f = m.F[ti[i]];
+		tv[3*i]=m.V[f.a]; tv[3*i+1]=m.V[f.b]; tv[3*i+2]=m.V[f.c];
+	}
+
+	active = true;
+	id = -1;
+	transformation ( GsMat::id );
+}
+
+void CdImplementation::Object::_build ( const GsModel& m, GsArray<int>& ti, const GsArray<GsPnt>& tc, int first, int n )
+{
+	int i, ni=nodes.size();
+	GsBox box, cbox;
+
+	for ( i=first; i<first+n; i++ )
+	{	const GsModel::Face& f = m.F[ti[i]];
+		box.extend ( m.V[f.a] );
+		box.extend ( m.V[f.b] );
+		box.extend ( m.V[f.c] );
+		cbox.extend ( tc[ti[i]] );
+	}
+
+	Node& node = nodes.push();
+	node.c = box.center();
+	node.r = box.size()/2.0f;
+	if ( n<=CD_LEAF_SIZE ) { node.i=first; node.n=n; return; }
+	node.n = 0;
+
+	// split the triangles by the center of their centers box, along its longest axis:
+	GsVec s = cbox.size();
+	int axis = s.x>s.y? (s.x>s.z? 0:2) : (s.y>s.z? 1:2);
+	float mid = cbox.center()(axis);
+	int tmp, k=first, j=first+n-1;
+	while ( k<=j )
+	{	if ( tc[ti[k]](axis)<mid ) k++;
+		else { GS_SWAP(ti[k],ti[j]); j--; }
+	}
+	int n1 = k-first;
+	if ( n1==0 || n1==n ) n1=n/2; // all centers are equal along the axis
+
+	_build ( m, ti, tc, first, n1 );
+	nodes[ni].i = nodes.size(); // node reference may be invalid at this point
+	_build ( m, ti, tc, first+n1, n-n1 );
+}
+
+void CdImplementation::Object::transformation ( const GsMat& m )
+{
+	int i;
+	for ( i=0; i<3; i++ )
+	{	R[i][0]=m.e[i*4]; R[i][1]=m.e[i*4+1]; R[i][2]=m.e[i*4+2]; T[i]=m.e[i*4+3]; }
+
+	if ( nodes.empty() ) { wbox.set_empty(); return; }
+
+	// world box enclosing the transformed root box:
+	const Node& root = nodes[0];
+	GsVec c, h;
+	for ( i=0; i<3; i++ )
+	{	c[i] = R[i][0]*root.c.x + R[i][1]*root.c.y + R[i][2]*root.c.z + T[i];
+		h[i] = GS_ABS(R[i][0])*root.r.x + GS_ABS(R[i][1])*root.r.y + GS_ABS(R[i][2])*root.r.z;
+	}
+	wbox.set ( c-h, c+h );
+}
+
 //================================ CdImplementation =====================================
 
 CdImplementation::CdImplementation ()
@@ -18,51 +290,89 @@ CdImplementation::~CdImplementation ()
 }
 
 void CdImplementation::init ()
-{ 
+{
+	_objects.init ();
+	_sap.size(0);
+	_cand.size(0);
+	_pairs.size(0);
 }
 
 int CdImplementation::insert_object ( const GsModel& m )
 {
-	return 0;
+	Object* o = new Object ( m );
+	o->id = _objects.insert ( o );
+	_sap.push() = o->id;
+	return o->id;
 }
 
 void CdImplementation::remove_object ( int id )
 {
+	if ( !id_valid(id) ) return;
+	Object* o = _objects[id];
+
+	for ( int i=0; i<o->deact.size(); i++ )
+	{	GsArray<int>& d = _objects[o->deact[i]]->deact;
+		int pos = d.bsearch ( id, gs_compare );
+		if ( pos>=0 ) d.remove ( pos );
+	}
+
+	int pos = _sap.lsearch ( id, gs_compare );
+	if ( pos>=0 ) _sap.remove ( pos );
+
+	_objects.remove ( id );
 }
 
 bool CdImplementation::id_valid ( int id )
 {
-	return false;
+	return id>=0 && id<=_objects.maxid() && _objects[id];
 }
 
 void CdImplementation::update_transformation ( int id, const GsMat& m )
 {
+	if ( id_valid(id) ) _objects[id]->transformation ( m );
 }
 
 void CdImplementation::activate_object ( int id )
 {
+	if ( id_valid(id) ) _objects[id]->active = true;
 }
 
 void CdImplementation::deactivate_object ( int id )
 {
+	if ( id_valid(id) ) _objects[id]->active = false;
 }
 
 void CdImplementation::activate_pair ( int id1, int id2 )
 {
+	if ( !id_valid(id1) || !id_valid(id2) ) return;
+	GsArray<int>& d1 = _objects[id1]->deact;
+	GsArray<int>& d2 = _objects[id2]->deact;
+	int pos = d1.bsearch ( id2, gs_compare );
+	if ( pos>=0 ) d1.remove ( pos );
+	pos = d2.bsearch ( id1, gs_compare );
+	if ( pos>=0 ) d2.remove ( pos );
 }
-	
+
 void CdImplementation::deactivate_pair ( int id1, int id2 )
 {
+	if ( id1==id2 || !id_valid(id1) || !id_valid(id2) ) return;
+	_objects[id1]->deact.uniqinsort ( id2, gs_compare );
+	_objects[id2]->deact.uniqinsort ( id1, gs_compare );
 }
 
 bool CdImplementation::pair_deactivated ( int id1, int id2 )
 {
-	return true;
+	if ( !id_valid(id1) || !id_valid(id2) ) return false;
+	return _objects[id1]->deactivated ( id2 );
 }
 
 int CdImplementation::count_deactivated_pairs ()
 {
-	return 0;
+	int n=0;
+	for ( int id=0, maxid=_objects.maxid(); id<=maxid; id++ )
+	{	if ( _objects[id] ) n += _objects[id]->deact.size();
+	}
+	return n/2;
 }
 
 const GsArray<int>& CdImplementation::colliding_pairs () const
@@ -72,18 +382,115 @@ const GsArray<int>& CdImplementation::colliding_pairs () const
 
 bool CdImplementation::collide ()
 {
-	return false;
+	return collide_tolerance ( 0 );
 }
 
 bool CdImplementation::collide_all ()
 {
-	return false;
+	_pairs.size(0);
+	_broad_phase ( 0 );
+	for ( int i=0, s=_cand.size(); i<s; i+=2 )
+	{	if ( _collide_pair(_objects[_cand[i]],_objects[_cand[i+1]],0) )
+		{	_pairs.push()=_cand[i]; _pairs.push()=_cand[i+1]; }
+	}
+	return _pairs.size()>0;
 }
 
 bool CdImplementation::collide_tolerance ( float toler )
 {
+	if ( toler<0 ) toler=0;
+	_pairs.size(0);
+	_broad_phase ( toler );
+	for ( int i=0, s=_cand.size(); i<s; i+=2 )
+	{	if ( _collide_pair(_objects[_cand[i]],_objects[_cand[i+1]],toler) )
+		{	_pairs.push()=_cand[i]; _pairs.push()=_cand[i+1];
+			return true;
+		}
+	}
 	return false;
 }
 
-//=================================== EOF =====================================
+//================================ protected =====================================
+
+void CdImplementation::_broad_phase ( float toler )
+{
+	int i, j, id, s=_sap.size();
+	float x;
+
+	// insertion sort by the minimum x coordinate, almost linear since objects
+	// move little between queries and the order of the last query is kept:
+	for ( i=1; i<s; i++ )
+	{	id = _sap[i];
+		x = _objects[id]->wbox.a.x;
+		for ( j=i-1; j>=0 && _objects[_sap[j]]->wbox.a.x>x; j-- ) _sap[j+1]=_sap[j];
+		_sap[j+1] = id;
+	}
 
+	// sweep along x collecting the pairs with overlapping world boxes:
+	_cand.size(0);
+	for ( i=0; i<s; i++ )
+	{	Object* a = _objects[_sap[i]];
+		if ( !a->active || a->nodes.empty() ) continue;
+		for ( j=i+1; j<s; j++ )
+		{	Object* b = _objects[_sap[j]];
+			if ( b->wbox.a.x > a->wbox.b.x+toler ) break; // no more overlaps along x
+			if ( !b->active || b->nodes.empty() ) continue;
+			if ( b->wbox.a.y > a->wbox.b.y+toler || a->wbox.a.y > b->wbox.b.y+toler ) continue;
+			if ( b->wbox.a.z > a->wbox.b.z+toler || a->wbox.a.z > b->wbox.b.z+toler ) continue;
+			if ( a->deactivated(b->id) ) continue;
+			if ( a->id<b->id ) { _cand.push()=a->id; _cand.push()=b->id; }
+			else { _cand.push()=b->id; _cand.push()=a->id; }
+		}
+	}
+}
+
+bool CdImplementation::_collide_pair ( Object* a, Object* b, float toler )
+{
+	int i, j, k, na, nb;
+	float R[3][3];
+	GsVec T, d=b->T-a->T;
+	GsPnt q[3];
+
+	// transformation from the frame of b to the frame of a:
+	for ( i=0; i<3; i++ )
+	{	for ( j=0; j<3; j++ ) R[i][j] = a->R[0][i]*b->R[0][j] + a->R[1][i]*b->R[1][j] + a->R[2][i]*b->R[2][j];
+		T[i] = a->R[0][i]*d.x + a->R[1][i]*d.y + a->R[2][i]*d.z;
+	}
+
+	_stack.size(0);
+	_stack.push()=0; _stack.push()=0;
+	while ( _stack.size()>0 )
+	{	nb = _stack.pop();
+		na = _stack.pop();
+		const Object::Node& x = a->nodes[na];
+		const Object::Node& y = b->nodes[nb];
+		if ( !_boxes_overlap(x.c,x.r,y.c,y.r,R,T,toler) ) continue;
+
+		if ( x.n>0 && y.n>0 ) // two leaves: test the triangles
+		{	for ( i=0; i<y.n; i++ )
+			{	const GsPnt* p = &b->tv[3*(y.i+i)];
+				for ( k=0; k<3; k++ )
+				{	q[k].set ( R[0][0]*p[k].x + R[0][1]*p[k].y + R[0][2]*p[k].z + T.x,
+							   R[1][0]*p[k].x + R[1][1]*p[k].y + R[1][2]*p[k].z + T.y,
+							   R[2][0]*p[k].x + R[2][1]*p[k].y + R[2][2]*p[k].z + T.z );
+				}
+				for ( j=0; j<x.n; j++ )
+				{	p = &a->tv[3*(x.i+j)];
+					if ( toler>0? _tris_closer(p,q,toler) : _tris_intersect(p,q) ) return true;
+				}
+			}
+		}
+		else if ( y.n>0 || ( x.n==0 && x.r.norm2()>=y.r.norm2() ) ) // descend in the largest box
+		{	_stack.push()=na+1; _stack.push()=nb;
+			_stack.push()=x.i;  _stack.push()=nb;
+		}
+		else
+		{	_stack.push()=na; _stack.push()=nb+1;
+			_stack.push()=na; _stack.push()=y.i;
+		}
+	}
+
+	return false;
+}
+
+//=================================== EOF =====================================
@@ -11,7 +11,7 @@
 
 CdImplementation* CdDefAllocator ()
 {
-	return new CdImplementation; // empty implementaiton
+	return new CdImplementation; // default implementation
 }
 
 static CdImplementation* (*CdCurAllocator)() = CdDefAllocator;
@@ -345,6 +345,67 @@ void gs_string_append ( char*&s, const char* toadd )
 	delete[] tmp;
 }
 
+//========================== conversions ==========================
+
+# define ISDIGIT(c) ((c)>='0' && (c)<='9')
+# define ISSPACE(c) ((c)==' ' || ((c)>='\t' && (c)<='\r'))
+
+// Mantissas of up to 19 significant digits with exponents up to 22 are exactly converted
+// with one floating point operation, which gives the correctly rounded double:
+float gs_atof ( const char* s )
+{
+	static const double p10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+								  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const char* s0 = s;
+	bool neg=false, digits=false;
+	uint64_t m=0;
+	int nd=0, e10=0;
+
+	while ( ISSPACE(*s) ) s++;
+	if ( *s=='-' ) { neg=true; s++; } else if ( *s=='+' ) s++;
+	for ( ; ISDIGIT(*s); s++ )
+	{	digits=true;
+		if ( m==0 && *s=='0' ) continue;
+		if ( ++nd>19 ) return (float)atof(s0);
+		m = m*10+(*s-'0');
+	}
+	if ( *s=='.' )
+	{	for ( s++; ISDIGIT(*s); s++ )
+		{	digits=true; e10--;
+			if ( m==0 && *s=='0' ) continue;
+			if ( ++nd>19 ) return (float)atof(s0);
+			m = m*10+(*s-'0');
+		}
+	}
+	if ( !digits || *s=='x' || *s=='X' ) return (float)atof(s0); // inf, nan, hexadecimal or invalid
+	if ( *s=='E' || *s=='e' ) // the exponent is only considered if it has digits
+	{	const char* t=s+1;
+		bool eneg = *t=='-';
+		if ( *t=='-' || *t=='+' ) t++;
+		int x=0;
+		for ( ; ISDIGIT(*t); t++ ) if ( x<10000 ) x = x*10+(*t-'0');
+		e10 += eneg? -x:x;
+	}
+	if ( m==0 ) return neg? -0.0f:0.0f;
+	if ( e10<-22 || e10>22 || m>(uint64_t(1)<<53) ) return (float)atof(s0);
+	double d = e10<0? double(m)/p10[-e10] : double(m)*p10[e10];
+	return float( neg? -d:d );
+}
+
+int gs_atoi ( const char* s )
+{
+	const char* s0 = s;
+	bool neg=false;
+	int64_t n=0;
+	while ( ISSPACE(*s) ) s++;
+	if ( *s=='-' ) { neg=true; s++; } else if ( *s=='+' ) s++;
+	for ( int nd=0; ISDIGIT(*s); s++ )
+	{	if ( ++nd>18 ) return atoi(s0);
+		n = n*10+(*s-'0');
+	}
+	return int( neg? -n:n );
+}
+
 //========================== IO ==========================
 
 # ifdef GS_WINDOWS
@@ -0,0 +1,49 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_frustum.h>
+
+//================================ GsFrustum ============================================
+
+// In clip coordinates (x,y,z,w) a point is inside when -w<=x,y,z<=w, and each plane
+// is given by the last line of the matrix plus or minus one of the other lines:
+void GsFrustum::set ( const GsMat& m )
+{
+	const float* e = m.e;
+	for ( int i=0; i<3; i++ )
+	{	for ( int k=0; k<4; k++ )
+		{	_p[2*i][k]   = e[12+k] + e[4*i+k];
+			_p[2*i+1][k] = e[12+k] - e[4*i+k];
+		}
+	}
+}
+
+bool GsFrustum::contains ( const GsPnt& p ) const
+{
+	for ( int i=0; i<6; i++ )
+	{	const float* q = _p[i];
+		if ( q[0]*p.x + q[1]*p.y + q[2]*p.z + q[3] < 0 ) return false;
+	}
+	return true;
+}
+
+GsFrustum::Result GsFrustum::test ( const GsBox& b ) const
+{
+	if ( b.empty() ) return Intersecting;
+	Result r = Inside;
+	for ( int i=0; i<6; i++ )
+	{	const float* q = _p[i];
+		// corner farthest along the plane normal, and the opposite one:
+		float f = q[0]*(q[0]>=0? b.b.x:b.a.x) + q[1]*(q[1]>=0? b.b.y:b.a.y) + q[2]*(q[2]>=0? b.b.z:b.a.z) + q[3];
+		if ( f<0 ) return Outside;
+		float n = q[0]*(q[0]>=0? b.a.x:b.b.x) + q[1]*(q[1]>=0? b.a.y:b.b.y) + q[2]*(q[2]>=0? b.a.z:b.b.z) + q[3];
+		if ( n<0 ) r = Intersecting;
+	}
+	return r;
+}
+
+//============================== end of file ===============================
@@ -12,7 +12,7 @@
 
 //xxx
 # define GS_USE_TRACE1 // Node operations
-# define GS_USE_TRACE2 // Search
+//# define GS_USE_TRACE2 // Search (disabled as searches may run in parallel)
 # include <sig/gs_trace.h>
 
 //============================== GsGraphNode =====================================
@@ -20,6 +20,7 @@
 GsGraphNode::GsGraphNode ()
 {
 	_index=0;
+	_id=0;
 	_graph=0;
 	_blocked=0;
 }
@@ -189,6 +190,41 @@ class GsGraphPathTree
 	}
 };
 
+//============================== GsGraphSearch ===============================================
+
+GsGraphSearch::GsGraphSearch ()
+{
+	_stamp = 0;
+	_expanded = 0;
+}
+
+void GsGraphSearch::compress ()
+{
+	_entries.capacity(0);
+	_open.init();
+	_open.compress();
+	_stamp = 0;
+}
+
+// prepares the buffers for a new search in n nodes, resetting the stamps of new entries
+// and of all entries when the stamp wraps around:
+void GsGraphSearch::_begin ( int n )
+{
+	int oldsize = _entries.size();
+	if ( oldsize<n ) _entries.size ( n );
+	if ( ++_stamp==0 ) { oldsize=0; _stamp=1; }
+	for ( int i=oldsize; i<_entries.size(); i++ ) _entries[i].stamp=0;
+	_open.init ();
+	_expanded = 0;
+}
+
+GsGraphSearch::Entry& GsGraphSearch::_entry ( int i )
+{
+	Entry& e = _entries[i];
+	if ( e.stamp!=_stamp ) { e.stamp=_stamp; e.parent=-1; e.cost=0; e.depth=0; e.closed=false; e.node=0; }
+	return e;
+}
+
 //============================== GsGraphBase ===============================================
 
 # define MARKFREE 0
@@ -201,6 +237,8 @@ GsGraphBase::GsGraphBase ( GsManagerBase* nm, GsManagerBase* lm )
 	_curmark = 1;
 	_mark_status = MARKFREE;
 	_pt = 0; // allocated only if shortest path is called
+	_search = 0;
+	_nextid = 0;
 	_lman = lm;
 	_lman->ref(); // nm is managed by the list _nodes
 	_leave_indices_after_save = 0;
@@ -210,6 +248,7 @@ GsGraphBase::~GsGraphBase ()
 {
 	_nodes.init (); // Important: this ensures that _lman is used before _lman->unref()
 	delete _pt;
+	delete _search;
 	_lman->unref();
 }
 
@@ -218,6 +257,7 @@ void GsGraphBase::init ()
 	_nodes.init();
 	_curmark = 1;
 	_mark_status = MARKFREE;
+	_nextid = 0;
 }
 
 void GsGraphBase::compress ()
@@ -346,6 +386,7 @@ GsGraphNode* GsGraphBase::insert ( GsGraphNode* n )
 {
 	_nodes.insert_next ( n );
 	n->_graph = this;
+	n->_id = _nextid++;
 	return n;
 }
 
@@ -499,49 +540,79 @@ void GsGraphBase::get_disconnected_components ( GsArray<int>& components, GsArra
 //----------------------------------- shortest path ----------------------------------
 
 bool GsGraphBase::search_path
-				 ( GsGraphNode* n1, GsGraphNode* n2, GsArray<GsGraphNode*>& path, float& cost,
-				   float (*distfunc) ( const GsGraphNode*, const GsGraphNode*, void* udata ),
-				   void* udata )
+				 ( GsGraphSearch& s, GsGraphNode* n1, GsGraphNode* n2, GsArray<GsGraphNode*>& path,
+				   float& cost, GsGraphSearch::DistFunc distfunc, void* udata, float weight ) const
 {
-	GS_TRACE2 ( "search_shortest_path starting..." );
+	GS_TRACE2 ( "search_path starting..." );
 	path.size(0);
+	cost = 0;
 
 	if ( n1==n2 )
 	{	GS_TRACE2 ( "n1==n2." );
+		s._expanded = 0;
 		path.push()=n1;
-		return 0;
+		return true;
 	}
 
-	begin_marking ();
-	if ( !_pt ) _pt = new GsGraphPathTree;
-	_pt->init ( this, n2 );
+	// links are followed from n2 to n1, so that the parents give the path from n1 to n2:
+	s._begin ( _nextid );
+	bool bidirectional_block = bidirectional_block_test();
+	int closest=-1;
+	float cdist=0;
+	s._entry(n2->_id).node = n2;
+	s._open.insert ( n2->_id, distfunc? weight*distfunc(n2,n1,udata) : 0 );
 
-	if ( distfunc )
-	{	_pt->distfunc = distfunc;
-		_pt->udata = udata;
-	}
-//xxx
 	GS_TRACE2 ( "searching..." );
-	while ( _pt->has_leaf() )
-	{	if ( _pt->expand_lowest_cost_leaf(n1) ) break;
-	}
-	end_marking ();
+	bool found=false;
+	while ( !s._open.empty() )
+	{	int ni = s._open.top();
+		s._open.remove ();
+		GsGraphSearch::Entry& e = s._entry(ni);
+		if ( e.closed ) continue; // node was inserted again with a lower cost
+		e.closed = true;
+		s._expanded++;
+		GsGraphNode* node = e.node;
+		if ( node==n1 ) { found=true; break; }
+
+		if ( distfunc )
+		{	float d = distfunc ( node, n1, udata );
+			if ( closest<0 || d<cdist ) { closest=ni; cdist=d; }
+		}
 
-	if ( _pt->N.top().node==n1 ) // found
-	{	cost = _pt->make_path ( _pt->N.size()-1, path );
-		GS_TRACE2 ( "Found! size:"<<path.size()<<" cost:"<<cost );
-		return true;
-	}
-	else if ( distfunc) // not found but closest goal available
-	{	GS_TRACE2 ( "Closest returned." );
-		cost = _pt->make_path ( _pt->iclosest, path );
-		return false;
+		float ncost = e.cost;
+		const GsArray<GsGraphLink*>& a = node->links();
+		for ( int i=0, size=a.size(); i<size; i++ )
+		{	GsGraphLink* li = a[i];
+			GsGraphNode* lin = li->node();
+			if ( li->blocked() || lin->blocked() ) continue;
+			if ( bidirectional_block && lin->link(node)->blocked() ) continue;
+			GsGraphSearch::Entry& le = s._entry(lin->_id);
+			float c = ncost + li->cost();
+			if ( le.closed || (le.node && c>=le.cost) ) continue;
+			le.cost = c;
+			le.parent = ni;
+			le.node = lin;
+			s._open.insert ( lin->_id, distfunc? c+weight*distfunc(lin,n1,udata) : c );
+		}
 	}
-	else // not found
+
+	int i = found? (int)n1->_id : closest;
+	if ( i<0 )
 	{	GS_TRACE2 ( "Not Found." );
-		cost = 0;
 		return false;
 	}
+	cost = s._entry(i).cost;
+	while ( i>=0 ) { path.push()=s._entry(i).node; i=s._entry(i).parent; }
+	GS_TRACE2 ( (found?"Found! size:":"Closest returned. size:")<<path.size()<<" cost:"<<cost );
+	return found;
+}
+
+bool GsGraphBase::search_path
+				 ( GsGraphNode* n1, GsGraphNode* n2, GsArray<GsGraphNode*>& path, float& cost,
+				   GsGraphSearch::DistFunc distfunc, void* udata, float weight )
+{
+	if ( !_search ) _search = new GsGraphSearch;
+	return search_path ( *_search, n1, n2, path, cost, distfunc, udata, weight );
 }
 
 bool GsGraphBase::local_search ( GsGraphNode* startn, GsGraphNode* endn,
@@ -584,6 +655,11 @@ void GsGraphBase::bidirectional_block_test ( bool b )
 	_pt->bidirectional_block = b;
 }
 
+bool GsGraphBase::bidirectional_block_test () const
+{
+	return _pt && _pt->bidirectional_block;
+}
+
 //------------------------------------- I/O --------------------------------
 
 void GsGraphBase::output ( GsOutput& o ) const
@@ -644,6 +720,7 @@ void GsGraphBase::input ( GsInput& inp )
 	{ 
 		nodes.push() = _nodes.insert_next(); // allocate one node
 		nodes.top()->_graph = this;
+		nodes.top()->_id = _nextid++;
 
 		inp.get(); // get node blocked status
 		set_blocked ( nodes.top()->_blocked, inp.ltoken() );
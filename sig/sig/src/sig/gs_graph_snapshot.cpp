@@ -0,0 +1,194 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_graph_snapshot.h>
+
+//============================== GsGraphSnapshot ===============================================
+
+void GsGraphSnapshot::init ()
+{
+	_first.size(0); _target.size(0); _cost.size(0);
+	_lblocked.size(0); _nblocked.size(0); _nodes.size(0); _index.size(0);
+}
+
+void GsGraphSnapshot::build ( const GsGraphBase& g )
+{
+	init ();
+	int n = g.num_nodes();
+	if ( n==0 ) { _first.push()=0; return; }
+
+	// index the nodes:
+	_nodes.size ( n );
+	_nblocked.size ( n );
+	_index.size ( g.max_id() );
+	_index.setall ( -1 );
+	GsGraphNode* first = g.first_node();
+	GsGraphNode* node = first;
+	int i=0;
+	do { _index[node->id()] = i;
+		 _nodes[i] = node;
+		 _nblocked[i] = node->blocked()? 1:0;
+		 node = node->next();
+		 i++;
+	   } while ( node!=first );
+
+	// store the links of each node contiguously:
+	bool bidirectional_block = g.bidirectional_block_test();
+	_first.size ( n+1 );
+	int nl=0;
+	for ( i=0; i<n; i++ ) { _first[i]=nl; nl+=_nodes[i]->nlinks(); }
+	_first[n] = nl;
+	_target.size ( nl );
+	_cost.size ( nl );
+	_lblocked.size ( nl );
+	for ( i=0; i<n; i++ )
+	{	node = _nodes[i];
+		const GsArray<GsGraphLink*>& a = node->links();
+		for ( int k=0, l=_first[i]; k<a.size(); k++, l++ )
+		{	GsGraphNode* ln = a[k]->node();
+			_target[l] = _index[ln->id()];
+			_cost[l] = a[k]->cost();
+			bool blocked = a[k]->blocked()!=0;
+			if ( bidirectional_block && !blocked )
+			{	int li = ln->search_link(node);
+				if ( li>=0 && ln->link(li)->blocked() ) blocked=true;
+			}
+			_lblocked[l] = blocked? 1:0;
+		}
+	}
+}
+
+gsuint GsGraphSnapshot::bytes () const
+{
+	return gsuint ( sizeof(int)*(_first.size()+_target.size()+_index.size()) + sizeof(float)*_cost.size() +
+					_lblocked.size() + _nblocked.size() + sizeof(GsGraphNode*)*_nodes.size() );
+}
+
+bool GsGraphSnapshot::search_path ( GsGraphSearch& s, int i1, int i2, GsArray<int>& path, float& cost,
+									GsGraphSearch::DistFunc distfunc, void* udata, float weight ) const
+{
+	path.size(0);
+	cost = 0;
+
+	if ( i1==i2 )
+	{	s._expanded = 0;
+		path.push()=i1;
+		return true;
+	}
+
+	// as in GsGraphBase, links are followed from i2 to i1 and the parents give the path:
+	s._begin ( _nodes.size() );
+	GsGraphNode* goal = _nodes[i1];
+	int closest=-1;
+	float cdist=0;
+	s._entry(i2).node = _nodes[i2];
+	s._open.insert ( i2, distfunc? weight*distfunc(_nodes[i2],goal,udata) : 0 );
+
+	bool found=false;
+	while ( !s._open.empty() )
+	{	int ni = s._open.top();
+		s._open.remove ();
+		GsGraphSearch::Entry& e = s._entry(ni);
+		if ( e.closed ) continue; // node was inserted again with a lower cost
+		e.closed = true;
+		s._expanded++;
+		if ( ni==i1 ) { found=true; break; }
+
+		if ( distfunc )
+		{	float d = distfunc ( _nodes[ni], goal, udata );
+			if ( closest<0 || d<cdist ) { closest=ni; cdist=d; }
+		}
+
+		float ncost = e.cost;
+		for ( int l=_first[ni], end=_first[ni+1]; l<end; l++ )
+		{	int t = _target[l];
+			if ( _lblocked[l] || _nblocked[t] ) continue;
+			GsGraphSearch::Entry& le = s._entry(t);
+			float c = ncost + _cost[l];
+			if ( le.closed || (le.node && c>=le.cost) ) continue;
+			le.cost = c;
+			le.parent = ni;
+			le.node = _nodes[t];
+			s._open.insert ( t, distfunc? c+weight*distfunc(_nodes[t],goal,udata) : c );
+		}
+	}
+
+	int i = found? i1 : closest;
+	if ( i<0 ) return false;
+	cost = s._entry(i).cost;
+	while ( i>=0 ) { path.push()=i; i=s._entry(i).parent; }
+	return found;
+}
+
+bool GsGraphSnapshot::local_search ( GsGraphSearch& s, int start, int end, int maxdepth, float maxdist,
+									 int& depth, float& dist ) const
+{
+	depth = 0;
+	dist = 0;
+	s._begin ( _nodes.size() );
+	if ( start==end ) return true;
+
+	s._entry(start).node = _nodes[start];
+	s._open.insert ( start, 0 );
+	while ( !s._open.empty() )
+	{	int ni = s._open.top();
+		s._open.remove ();
+		GsGraphSearch::Entry& e = s._entry(ni);
+		if ( e.closed ) continue;
+		depth = e.depth;
+		dist = e.cost;
+		if ( maxdepth>0 && depth>maxdepth ) return false; // max depth reached
+		if ( maxdist>0 && dist>maxdist ) return false; // max dist reached
+		e.closed = true;
+		s._expanded++;
+		if ( ni==end ) return true;
+
+		for ( int l=_first[ni], lend=_first[ni+1]; l<lend; l++ )
+		{	int t = _target[l];
+			if ( _lblocked[l] || _nblocked[t] ) continue;
+			GsGraphSearch::Entry& le = s._entry(t);
+			float c = dist + _cost[l];
+			if ( le.closed || (le.node && c>=le.cost) ) continue;
+			le.cost = c;
+			le.depth = depth+1;
+			le.parent = ni;
+			le.node = _nodes[t];
+			s._open.insert ( t, c );
+		}
+	}
+	return false; // not found
+}
+
+void GsGraphSnapshot::get_disconnected_components ( GsArray<int>& components, GsArray<int>& nodes ) const
+{
+	int n = _nodes.size();
+	components.size ( 0 );
+	nodes.size ( n );
+	nodes.size ( 0 );
+
+	GsArray<char> visited ( n );
+	visited.setall ( 0 );
+	GsArray<int> stack;
+
+	for ( int i=0; i<n; i++ )
+	{	if ( visited[i] ) continue;
+		components.push() = nodes.size();
+		visited[i] = 1;
+		stack.push() = i;
+		while ( stack.size()>0 )
+		{	int k = stack.pop();
+			nodes.push() = k;
+			for ( int l=_first[k], end=_first[k+1]; l<end; l++ )
+			{	int t = _target[l];
+				if ( !visited[t] ) { visited[t]=1; stack.push()=t; }
+			}
+		}
+		components.push() = nodes.size()-1;
+	}
+}
+
+//============================== end of file ===============================
@@ -5,6 +5,7 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <math.h>
 # include <sig/gs_grid.h>
 
 //============================ GsGridBase =================================
@@ -159,6 +160,46 @@ void GsGridBase::get_intersection ( GsPnt2 a, GsPnt2 b, GsArray<int>& cells ) co
 	}
  }
 
+void GsGridBase::get_segment_intersection ( GsPnt2 a, GsPnt2 b, GsArray<int>& cells, float eps ) const
+ {
+   if ( dimensions()!=2 ) return;
+
+   GsPnt2 tmp;
+   if ( a.y>b.y ) GS_SWAPT ( a, b, tmp );
+   float minx=_axis[0].min, miny=_axis[1].min;
+   float lx=_seglen[0], ly=_seglen[1];
+   int sx=_axis[0].segs, sy=_axis[1].segs;
+
+   // rows touched by the segment:
+   int j1 = int ( floorf((a.y-eps-miny)/ly) );
+   int j2 = int ( floorf((b.y+eps-miny)/ly) );
+   if ( j2<0 || j1>=sy ) return;
+   j1 = GS_MAX ( j1, 0 );
+   j2 = GS_MIN ( j2, sy-1 );
+
+   float dy = b.y-a.y;
+   for ( int j=j1; j<=j2; j++ )
+	{ // part of the segment inside the enlarged row:
+	  float y1 = GS_MAX ( a.y, miny+float(j)*ly-eps );
+	  float y2 = GS_MIN ( b.y, miny+float(j+1)*ly+eps );
+	  float x1, x2;
+	  if ( dy<=0 || y1>y2 ) // horizontal segment or numerical limit case, use all the segment
+	   { x1=a.x; x2=b.x; }
+	  else
+	   { x1 = a.x + (y1-a.y)*(b.x-a.x)/dy;
+		 x2 = a.x + (y2-a.y)*(b.x-a.x)/dy;
+	   }
+	  if ( x1>x2 ) { float t=x1; x1=x2; x2=t; }
+	  int i1 = int ( floorf((x1-eps-minx)/lx) );
+	  int i2 = int ( floorf((x2+eps-minx)/lx) );
+	  if ( i2<0 || i1>=sx ) continue;
+	  i1 = GS_MAX ( i1, 0 );
+	  i2 = GS_MIN ( i2, sx-1 );
+	  int index = _size[1]*j + i1; // == cell_index(i1,j);
+	  for ( int i=i1; i<=i2; i++ ) cells.push() = index++;
+	}
+ }
+
 void GsGridBase::get_intersection ( GsPnt a, GsPnt b, GsArray<int>& cells ) const
  {
    if ( dimensions()!=3 ) return;
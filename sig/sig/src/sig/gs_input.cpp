@@ -7,7 +7,6 @@
 
 # include <stdlib.h>
 # include <string.h>
-# include <ctype.h>
 
 # include <sig/gs_input.h>
 # include <sig/gs_string.h>
@@ -22,13 +21,31 @@
 # define CHKDATA	 if ( !_data ) _data = new Data
 # define INITDATA	if ( _data ) _data->init()
 
+// character classes of the C locale, without function calls:
+# define ISSPACE(c) ((c)==' ' || ((c)>='\t' && (c)<='\r'))
+# define ISDIGIT(c) ((c)>='0' && (c)<='9')
+# define ISALPHA(c) (((c)>='a' && (c)<='z') || ((c)>='A' && (c)<='Z'))
+# define ISALNUM(c) (ISALPHA(c) || ISDIGIT(c))
+
+// size of the blocks read from files:
+static const int BufSize = 65536;
+
 //=============================== GsInput =================================
 
 struct GsInput::Data
 {	GsArray<char> ungetstack; // unget buffer of chars
 	GsString	  ltoken;	 // buffer with the last token read
 	gsbyte		  ltype;	  // last token type read
-	void init () { ungetstack.size(0); ltoken.set(""); ltype=(gsbyte)End; }
+	char*		  buf;		 // block of data read from the input file
+	const char*	  pos;		 // current position in buf or in the input string
+	const char*	  end;		 // end of the data in buf or in the input string
+	long		  filepos;	 // position of buf in the file, or -1 if the file is read by char
+	gsbyte		  eof;		 // 1 if the last block read reached the end of the file
+	gsbyte		  synced;	 // 1 if buf is empty and the file is at the input position
+	gsbyte		  frombuf;	 // 1 if the last char read came from pos-1
+	Data () { buf=0; init(); }
+   ~Data () { delete[] buf; }
+	void init () { ungetstack.size(0); ltoken.set(""); ltype=(gsbyte)End; pos=end=buf; filepos=-1; eof=frombuf=0; synced=1; }
 };
 
 void GsInput::_init ( char c )
@@ -44,6 +61,88 @@ void GsInput::_init ( char c )
 	_filename = 0;
 }
 
+bool GsInput::_refill ()
+{
+	if ( _type!=(gsbyte)TypeFile ) return false;
+	Data& d = *_data;
+	if ( !d.buf ) d.buf = new char[BufSize];
+	d.filepos = ftell ( _cur.f );
+	int n=0;
+	if ( d.filepos>=0 )
+	{	n = (int) fread ( d.buf, 1, BufSize, _cur.f );
+	}
+	else // pipes and terminals are read by char to not wait for a full block
+	{	int c = fgetc ( _cur.f );
+		if ( c!=EOF ) { d.buf[0]=(char)c; n=1; }
+	}
+	d.pos = d.buf;
+	d.end = d.buf+n;
+	d.eof = n==0? 1:0;
+	d.synced = 0;
+	return n>0;
+}
+
+void GsInput::_sync () const
+{
+	if ( _type!=(gsbyte)TypeFile || !_data ) return;
+	Data& d = *_data;
+	if ( d.pos<d.end )
+	{	if ( d.filepos>=0 ) // reading again the used part of the block is also correct in text mode
+		{	fseek ( _cur.f, d.filepos, SEEK_SET );
+			if ( d.pos>d.buf ) { size_t n=fread ( d.buf, 1, size_t(d.pos-d.buf), _cur.f ); (void)n; }
+		}
+		else
+		{	ungetc ( (gsbyte)*d.pos, _cur.f );
+		}
+	}
+	d.pos = d.end = d.buf;
+	d.synced = 1;
+}
+
+inline int GsInput::_readchar ()
+{
+	int c;
+
+	CHKDATA;
+	Data& d = *_data;
+
+	if ( d.ungetstack.size()>0 ) 
+	{	c = d.ungetstack.pop();
+		d.frombuf = 0;
+	}
+	else if ( d.pos<d.end || _refill() )
+	{	c = ISFILE? (gsbyte)*d.pos++ : *d.pos++; // file chars are unsigned as returned by fgetc()
+		d.frombuf = 1;
+	}
+	else
+	{	c = -1;
+		d.frombuf = 0;
+	}
+
+	if ( c=='\n' ) _curline++;
+
+	if ( _lowercase && c>='A' && c<='Z' ) c = c-'A'+'a';
+
+	return c;
+}
+
+// puts back the char just returned by readchar():
+void GsInput::_unread ( int c )
+{
+	if ( _data->frombuf )
+	{	_data->pos--;
+		_data->frombuf = 0;
+		if ( c=='\n' ) _curline--;
+	}
+	else unget ( (char)c );
+}
+
+int GsInput::_peekbyte ()
+{
+	if ( _data->ungetstack.size()==0 && _data->pos<_data->end ) return (gsbyte)*_data->pos;
+	int c=_readchar(); _unread(c); return c;
+}
+
 GsInput::GsInput ( char com )
 {
 	GS_TRACE2 ("Default Constructor");
@@ -73,6 +172,9 @@ void GsInput::init ( const char *buff )
 	if ( buff )
 	{	_cur.s = buff;
 		_type = (gsbyte) TypeString;
+		CHKDATA;
+		_data->pos = buff;
+		_data->end = buff+strlen(buff);
 	}
 }
 
@@ -106,40 +208,36 @@ void GsInput::close ()
 
 void GsInput::abandon ()
 { 
+	_sync ();
 	_type = (gsbyte) TypeInvalid;
 	close ();   
 }
 
+FILE* GsInput::filept () const
+{
+	if ( _type!=(gsbyte)TypeFile ) return 0;
+	_sync ();
+	return _cur.f;
+}
+
 bool GsInput::end ()
 {
 	if ( _data ) { if (_data->ungetstack.size()>0) return false; }
 
-	if ( ISFILE ) return feof(_cur.f)? true:false;
+	if ( ISFILE )
+	{	if ( !_data ) return feof(_cur.f)? true:false;
+		if ( _data->pos<_data->end ) return false;
+		return _data->eof || ( _data->synced && feof(_cur.f) );
+	}
 
-	if ( ISSTRING ) return *(_cur.s)? false:true;
+	if ( ISSTRING ) return _data->pos<_data->end? false:true;
 
 	return true;
 }
 
 int GsInput::readchar () // comments not handled, unget yes
 {
-	int c = -1;
-
-	CHKDATA;
-
-	if ( _data->ungetstack.size()>0 ) 
-	{	c = _data->ungetstack.pop();
-	}
-	else
-	{	if ( ISFILE ) { c=fgetc(_cur.f); }
-		else if ( ISSTRING ) c = *_cur.s? *_cur.s++ : -1;
-	}
-
-	if ( c=='\n' ) _curline++;
-
-	if ( _lowercase && c>='A' && c<='Z' ) c = c-'A'+'a';
-
-	return c;
+	return _readchar();
 }
 
 int GsInput::readline ( GsString& buf )
@@ -148,7 +246,7 @@ int GsInput::readline ( GsString& buf )
 
 	char st[2]; st[1]=0;
 	buf.len(0);
-	do { c = readchar();
+	do { c = _readchar();
 		 if ( c==EOF ) break;
 		 st[0] = (char)c;
 		 buf.append(st);
@@ -161,6 +259,7 @@ void GsInput::readall ( GsArray<gsbyte>& buf )
 {
 	if ( ISFILE )
 	{
+		_sync ();
 		long start = ftell(_cur.f);
 		fseek ( _cur.f, 0, SEEK_END );
 		int size = (int)(ftell(_cur.f)-start);
@@ -171,10 +270,10 @@ void GsInput::readall ( GsArray<gsbyte>& buf )
 	}
 	else if ( ISSTRING )
 	{
-		int len = strlen(_cur.s);
+		int len = int(_data->end-_data->pos);
 		buf.sizecap ( len, len+1 );
-		strcpy ( (char*)&buf[0], _cur.s );
-		_cur.s += buf.size();
+		strcpy ( (char*)&buf[0], _data->pos );
+		_data->pos += buf.size();
 	}
 }
 
@@ -182,6 +281,7 @@ void GsInput::readall ( GsString& buf )
 {
 	if ( ISFILE )
 	{
+		_sync ();
 		long start = ftell(_cur.f);
 		fseek ( _cur.f, 0, SEEK_END );
 		int size = (int)(ftell(_cur.f)-start);
@@ -192,35 +292,53 @@ void GsInput::readall ( GsString& buf )
 	}
 	else if ( ISSTRING )
 	{
-		buf.set ( _cur.s );
-		_cur.s += buf.len();
+		buf.set ( _data->pos );
+		_data->pos += buf.len();
 	}
 }
 
 void GsInput::skipline ()
 {
 	int c;
-	do { c = readchar();
+	do { c = _readchar();
 	   } while ( c!=EOF && c!='\n' );
 }
 
 GsInput::TokenType GsInput::check ()
  { 
+   CHKDATA;
+   Data& d = *_data;
+
    // skip white spaces ang get 1st char:
    int c;
-   do { c = readchar();
-		if ( c==_comchar ) do { c=readchar(); } while ( c!=EOF && c!='\n' );
+   do { if ( d.ungetstack.size()==0 ) // skip spaces directly in the buffer
+		 { while ( d.pos<d.end && ISSPACE(*d.pos) && *d.pos!=_comchar )
+			{ if ( *d.pos=='\n' ) _curline+=2; // as below
+			  d.pos++;
+			}
+		 }
+		c = _readchar();
+		if ( c==_comchar ) do { c=_readchar(); } while ( c!=EOF && c!='\n' );
 		if ( c=='\n' ) _curline++;
 		if ( c==EOF ) return End;
-	  } while ( isspace(c) );
+	  } while ( ISSPACE(c) );
  
    // check if delimiter preceeding number:
-   if ( (c=='.'||c=='+'||c=='-') && isdigit(_peekbyte()) ) { unget(c); return Number; }
+   int n = _peekbyte();
+   if ( (c=='.'||c=='+'||c=='-') && ISDIGIT(n) ) { _unread(c); return Number; }
+
+   // a sign followed by a point needs one more char, as in "-.5":
+   if ( (c=='+'||c=='-') && n=='.' )
+	{ _readchar();
+	  bool num = ISDIGIT(_peekbyte());
+	  unget ( '.' ); unget ( (char)c ); // both return in the unget stack
+	  return num? Number : Delimiter;
+	}
 
    // check other cases:
-   unget(c);
-   if ( isdigit(c) ) return Number;
-   if ( isalpha(c) || c=='"' || c=='_' ) return String;
+   _unread(c);
+   if ( ISDIGIT(c) ) return Number;
+   if ( ISALPHA(c) || c=='"' || c=='_' ) return String;
    return Delimiter;
  }
 
@@ -239,10 +357,19 @@ GsInput::TokenType GsInput::get ()
 	return get ( check() );
 }
 
+// Tokens are scanned directly in the buffer when they cannot reach its end and no
+// conversion to lowercase is needed, otherwise characters are read with _readchar():
+# define BUFCHAR(p) ( ISFILE? (int)(gsbyte)*(p) : (int)*(p) )
+# define NEXTCHAR ( p? ( *p=='\n'? (_curline++,*p++) : BUFCHAR(p++) ) : _readchar() )
+# define UNREAD(c) if ( p ) { if ( *--p=='\n' ) _curline--; } else _unread(c)
+
 GsInput::TokenType GsInput::get ( TokenType type )
  {
-   _data->ltype = type;
-   _data->ltoken.len(0);
+   CHKDATA;
+   Data& d = *_data;
+   d.ltype = type;
+   d.ltoken.len(0);
+   const char* p = d.ungetstack.size()==0 && d.end-d.pos>_maxtoksize+1? d.pos : 0;
 
    if ( type==End )
 	{
@@ -250,14 +377,16 @@ GsInput::TokenType GsInput::get ( TokenType type )
 	}
    else if ( type==String )
 	{
-	  GsString &s = _data->ltoken;
+	  GsString &s = d.ltoken;
 	  s.len ( _maxtoksize );
-	  int i, c = readchar();
+	  if ( _lowercase ) p=0;
+	  int i, c = NEXTCHAR;
 	  if ( c=='"' ) // inside quotes mode
 	   { GS_TRACE1 ( "Got String between quotes..." );
+		 if ( p ) { d.pos=p; p=0; } // escapes and new lines are handled by _readchar()
 		 for ( i=0; i<_maxtoksize; i++ )
-		  { c = readchar();
-			if ( c=='\\' ) c=getescape(readchar());
+		  { c = _readchar();
+			if ( c=='\\' ) c=getescape(_readchar());
 			if ( c==EOF || c=='"' ) break;
 			s[i]=c;
 		  }
@@ -266,29 +395,29 @@ GsInput::TokenType GsInput::get ( TokenType type )
 	   { GS_TRACE1 ( "Got String..." );
 		 for ( i=0; i<_maxtoksize; i++ )
 		  { if ( c==EOF ) break;
-			if ( !isalnum(c) && c!='_' ) { unget(c); break; }
+			if ( !ISALNUM(c) && c!='_' ) { UNREAD(c); break; }
 			s[i] = c;
-			c = readchar();
+			c = NEXTCHAR;
 		  }
 	   }
 	  s.len(i);
 	}
    else if ( type==Number )
 	{ GS_TRACE1 ( "Got Number..." );
-	  GsString& s = _data->ltoken;
+	  GsString& s = d.ltoken;
 	  s.len ( _maxtoksize );
 	  bool pnt=false, exp=false;
-	  int i, c = readchar();
+	  int i, c = NEXTCHAR;
 	  s[0]=c; // we know the 1st is part of a number (can be +/-)
 	  for ( i=1; i<_maxtoksize; i++ )
-	   { c = readchar();
-		 if ( !isdigit(c) )
+	   { c = NEXTCHAR;
+		 if ( !ISDIGIT(c) )
 		  { if ( c=='e' ) c='E';
 			if ( !pnt && c=='.' ) pnt=true;
 			else if ( pnt && c=='.' ) break;
 			else if ( !exp && c=='E' ) exp=pnt=true;
 			else if ( (c=='+'||c=='-') && s[i-1]=='E' ); // ok
-			else { unget(c); break; }
+			else { UNREAD(c); break; }
 		  }
 		 s[i]=c; 
 	   }
@@ -297,11 +426,14 @@ GsInput::TokenType GsInput::get ( TokenType type )
 	}
    else // Delimiter
 	{ GS_TRACE1 ( "Got Delimiter..." );
-	  _data->ltoken.len (1);
-	  _data->ltoken[0] = readchar();
+	  p = 0;
+	  d.ltoken.len (1);
+	  d.ltoken[0] = _readchar();
 	} 
 
-   GS_TRACE1 ( "Token: "<<_data->ltoken );
+   if ( p ) { d.pos=p; d.frombuf=0; }
+
+   GS_TRACE1 ( "Token: "<<d.ltoken );
    return type;
  }
 
@@ -327,7 +459,7 @@ const GsString& GsInput::getfilename ()
 
 int GsInput::geti ()
  {
-   return get()==Number? _data->ltoken.atoi():0;
+   return get()==Number? gs_atoi(_data->ltoken):0;
  }
 
 long GsInput::getl()
@@ -337,7 +469,7 @@ long GsInput::getl()
 
 float GsInput::getf ()
  {
-   return get()==Number? _data->ltoken.atof():0;
+   return get()==Number? gs_atof(_data->ltoken):0;
  }
 
 const GsString& GsInput::ltoken() const
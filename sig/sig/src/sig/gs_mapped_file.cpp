@@ -0,0 +1,113 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <sig/gs_mapped_file.h>
+
+# ifdef GS_WINDOWS
+# include <Windows.h>
+# else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# endif
+
+//# define GS_USE_TRACE1 // open/close
+# include <sig/gs_trace.h>
+
+static const char EmptyFile[1] = { 0 }; // data of empty files, which cannot be mapped
+
+//============================= GsMappedFile ==========================
+
+GsMappedFile::GsMappedFile ()
+ {
+   _data = 0;
+   _size = 0;
+   _mapped = 0;
+   _handle = 0;
+ }
+
+GsMappedFile::~GsMappedFile ()
+ {
+   close ();
+ }
+
+bool GsMappedFile::open ( const char* filename )
+ {
+   close ();
+   if ( !filename ) return false;
+   GS_TRACE1 ( "Mapping "<<filename<<"..." );
+
+   # ifdef GS_WINDOWS
+   HANDLE f = CreateFileA ( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+   if ( f==INVALID_HANDLE_VALUE ) return false;
+   LARGE_INTEGER s;
+   if ( GetFileSizeEx(f,&s) )
+	{ _size = (size_t)s.QuadPart;
+	  if ( _size==0 ) _data=EmptyFile;
+	  HANDLE m = _size? CreateFileMappingA ( f, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+	  if ( m )
+	   { _data = (const char*) MapViewOfFile ( m, FILE_MAP_READ, 0, 0, 0 );
+		 if ( _data ) { _mapped=1; _handle=m; } else CloseHandle(m);
+	   }
+	}
+   CloseHandle ( f );
+   # else
+   int f = ::open ( filename, O_RDONLY );
+   if ( f<0 ) return false;
+   struct stat s;
+   if ( fstat(f,&s)==0 )
+	{ _size = (size_t)s.st_size;
+	  if ( _size==0 ) _data=EmptyFile;
+	  void* pt = _size? mmap ( 0, _size, PROT_READ, MAP_PRIVATE, f, 0 ) : MAP_FAILED;
+	  if ( pt!=MAP_FAILED ) { _data=(const char*)pt; _mapped=1; }
+	}
+   ::close ( f );
+   # endif
+
+   if ( !_data ) // mapping not available, read the file instead
+	{ FILE* fp = fopen ( filename, "rb" );
+	  if ( !fp ) return false;
+	  fseek ( fp, 0, SEEK_END );
+	  _size = (size_t) ftell ( fp );
+	  fseek ( fp, 0, SEEK_SET );
+	  char* buf = (char*) malloc ( _size+1 );
+	  _size = buf? fread ( buf, 1, _size, fp ) : 0;
+	  fclose ( fp );
+	  if ( !buf ) return false;
+	  _data = buf;
+	}
+
+   GS_TRACE1 ( "Size: "<<int(_size)<<(_mapped?" (mapped)":" (read)") );
+   return true;
+ }
+
+void GsMappedFile::close ()
+ {
+   if ( _data && _data!=EmptyFile )
+	{ if ( !_mapped )
+	   { free ( (void*)_data );
+	   }
+	  else
+	   {
+		 # ifdef GS_WINDOWS
+		 UnmapViewOfFile ( _data );
+		 CloseHandle ( (HANDLE)_handle );
+		 # else
+		 munmap ( (void*)_data, _size );
+		 # endif
+	   }
+	}
+   _data = 0;
+   _size = 0;
+   _mapped = 0;
+   _handle = 0;
+ }
+
+//============================= EOF ===================================
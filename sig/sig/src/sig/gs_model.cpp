@@ -5,10 +5,12 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <math.h>
 # include <stdlib.h>
 # include <iostream>
 
 # include <sig/gs_model.h>
+# include <sig/gs_model_bvh.h>
 # include <sig/gs_quat.h>
 # include <sig/gs_dirs.h>
 # include <sig/gs_table.h>
@@ -47,6 +49,21 @@ GsModel::GsModel ()
 	textured = 0;
 	_geomode = Empty;
 	_mtlmode = NoMtl;
+	_adjacency = 0;
+	_bvh = 0;
+	_adjstamp = _bvhstamp = 0;
+	_stamp = 0;
+}
+
+GsModel::GsModel ( const GsModel& m )
+{
+	primitive = 0;
+	textured = m.textured;
+	_adjacency = 0;
+	_bvh = 0;
+	_adjstamp = _bvhstamp = 0;
+	_stamp = 0;
+	*this = m; // changes the stamp, so that the caches are only built when requested
 }
 
 GsModel::~GsModel ()
@@ -125,6 +142,10 @@ void GsModel::init ()
 	delete primitive;
 	primitive=0;
 
+	free_adjacency ();
+	free_bvh ();
+	changed ();
+
 	culling = 1;
 	_geomode = Empty;
 	_mtlmode = NoMtl;
@@ -139,6 +160,9 @@ void GsModel::operator = ( const GsModel& m )
    F = m.F;
    Fn = m.Fn;
    Ft = m.Fn;
+   free_adjacency ();
+   free_bvh ();
+   changed ();
 
    name = m.name;
    filename = m.filename;
@@ -313,6 +337,7 @@ void GsModel::add_model ( const GsModel& m )
    // the model will for sure not be a primitive anymore
    if ( primitive )
 	{ delete primitive; primitive=0; }
+   changed ();
 
    GS_TRACE4 ( "add_model: ok." );
  }
@@ -429,6 +454,92 @@ void GsModel::order_transparent_materials ()
 	// faces would need to be sorted and rendered from back to front with respect to V
 }
 
+// Merges points of dimension d closer than prec, keeping the first point of each cluster.
+// A hash grid with cells of size prec is used, so that only the 3^d neighbor cells are visited.
+// The new index of each point is stored in map, and the number of kept points is returned.
+static int weld_points ( float* p, int n, int d, float prec, GsArray<int>& map )
+ {
+   int i, j, k, a, h;
+   map.size ( n );
+   int hsize=16;
+   while ( hsize<2*n ) hsize*=2;
+   GsArray<int> head(hsize), next(n);
+   head.setall ( -1 );
+
+   const float cell = prec>0? prec:1.0f; // with prec 0 nothing is merged anyway
+   const float prec2 = prec*prec;
+   int64_t c[3], nc[3];
+   int cr = d==3? 1:0; // range of neighbor cells in z
+
+   for ( i=k=0; i<n; i++ )
+	{ const float* pi = p+i*d;
+	  for ( a=0; a<3; a++ ) c[a] = a<d? (int64_t)floorf(pi[a]/cell) : 0;
+	  int r=-1;
+	  for ( nc[0]=c[0]-1; nc[0]<=c[0]+1; nc[0]++ )
+	   for ( nc[1]=c[1]-1; nc[1]<=c[1]+1; nc[1]++ )
+		for ( nc[2]=c[2]-cr; nc[2]<=c[2]+cr; nc[2]++ )
+		 { h = int ( (nc[0]*73856093)^(nc[1]*19349663)^(nc[2]*83492791) ) & (hsize-1);
+		   for ( j=head[h]; j>=0; j=next[j] )
+			{ if ( r>=0 && j>r ) continue; // keep the first point found
+			  float d2=0;
+			  for ( a=0; a<d; a++ ) d2 += (p[j*d+a]-pi[a])*(p[j*d+a]-pi[a]);
+			  if ( d2<prec2 ) r=j;
+			}
+		 }
+	  if ( r>=0 ) { map[i]=map[r]; continue; }
+	  map[i] = k++;
+	  h = int ( (c[0]*73856093)^(c[1]*19349663)^(c[2]*83492791) ) & (hsize-1);
+	  next[i]=head[h]; head[h]=i;
+	}
+
+   // compress the points, kept points have increasing new indices:
+   for ( i=k=0; i<n; i++ )
+	{ if ( map[i]!=k ) continue;
+	  for ( a=0; a<d; a++ ) p[k*d+a]=p[i*d+a];
+	  k++;
+	}
+   return k;
+ }
+
+// Keeps in a the elements kept by weld_points()
+template <class X>
+static void compress_welded ( GsArray<X>& a, const GsArray<int>& map )
+ {
+   int i, k;
+   for ( i=k=0; i<map.size(); i++ ) if ( map[i]==k ) a[k++]=a[i];
+   a.size ( k );
+ }
+
+void GsModel::_weld ( float prec, bool v, bool n, bool t )
+ {
+   GsArray<int> mapv, mapn, mapt;
+   if ( v && V.size()>0 )
+	{ bool nv = N.size()==V.size() && Fn.empty(); // normals per vertex
+	  bool mv = ( _mtlmode==PerVertexMtl || _mtlmode==PerVertexColor ) && M.size()==V.size();
+	  V.size ( weld_points ( &V[0].x, V.size(), 3, prec, mapv ) );
+	  if ( nv ) compress_welded ( N, mapv );
+	  if ( mv ) compress_welded ( M, mapv );
+	  GS_TRACE2 ( "Vertices after welding: "<<V.size() );
+	}
+   if ( n && N.size()>1 && Fn.size()==F.size() )
+	{ N.size ( weld_points ( &N[0].x, N.size(), 3, prec, mapn ) );
+	  GS_TRACE2 ( "Normals after welding: "<<N.size() );
+	}
+   if ( t && T.size()>1 && Ft.size()==F.size() )
+	{ T.size ( weld_points ( &T[0].x, T.size(), 2, prec, mapt ) );
+	  GS_TRACE2 ( "Texture coordinates after welding: "<<T.size() );
+	}
+
+   // update all face indices in one pass:
+   int fsize = F.size();
+   for ( int i=0; i<fsize; i++ )
+	{ if ( mapv.size() ) { Face& f=F[i];  f.a=mapv[f.a]; f.b=mapv[f.b]; f.c=mapv[f.c]; }
+	  if ( mapn.size() ) { Face& f=Fn[i]; f.a=mapn[f.a]; f.b=mapn[f.b]; f.c=mapn[f.c]; }
+	  if ( mapt.size() ) { Face& f=Ft[i]; f.a=mapt[f.a]; f.b=mapt[f.b]; f.c=mapt[f.c]; }
+	}
+   changed ();
+ }
+
 void GsModel::remove_redundant_normals ( float prec )
  {
    if ( Fn.empty() ) return;
@@ -445,98 +556,18 @@ void GsModel::remove_redundant_normals ( float prec )
 	{ // nothing to test, only 1 normal
 	}
    else
-	{ // remove references to duplicated normals
-	  int i, j, k;
-	  GsArray<int> iarray;
-	  prec = prec*prec;
-	  iarray.size ( nsize );
-	  iarray.setall ( -1 );
-	  for ( i=0; i<nsize; i++ ) 
-	   { for ( j=i+1; j<nsize; j++ ) 
-		  { if ( iarray[j]>=0 ) continue;
-			if ( dist2(N[i],N[j])<prec )
-			 { GS_TRACE2 ( "Detected normal "<<i<<" close to "<<j );
-			   iarray[j]=i;
-			   for ( k=0; k<fsize; k++ ) // replace references to j by i
-				{ if ( Fn[k].a==j ) Fn[k].a=i;
-				  if ( Fn[k].b==j ) Fn[k].b=i;
-				  if ( Fn[k].c==j ) Fn[k].c=i;
-				}
-			 }
-		  }
-	   }
-
-	  int toadd = 0;
-	  for ( i=0; i<iarray.size(); i++ ) 
-	   { if ( iarray[i]>=0 )
-		  { GS_TRACE2 ( "Detected unused normal "<<i );
-			toadd++;
-			iarray[i]=-1; // unused mark is now -1
-		  }
-		 else
-		  iarray[i] = toadd;
-	   }
-
-	  for ( i=0; i<fsize; i++ ) // update indices
-	   { Fn[i].a -= iarray[Fn[i].a];
-		 Fn[i].b -= iarray[Fn[i].b];
-		 Fn[i].c -= iarray[Fn[i].c];
-	   }
-
-	  for ( i=0,j=0; i<iarray.size(); i++ ) // compress N
-	   { if ( iarray[i]<0 )
-		  { N.remove(j); }
-		 else
-		  { j++; }
-	   }
+	{ _weld ( prec, false, true, false );
 	}
  }
 
 void GsModel::merge_redundant_vertices ( float prec )
  {
-   prec = prec*prec;
-   
-   int fsize = F.size();
-   int vsize = V.size();
-   int i, j;
-
-   // build iarray marking replacements:
-   GsArray<int> iarray;
-   iarray.size ( vsize );
-   for ( i=0; i<vsize; i++ ) iarray[i]=i;
-   
-   for ( i=0; i<vsize; i++ )
-	for ( j=0; j<vsize; j++ )
-	 { if ( i==j ) break; // keep i < j
-	   if ( dist2(V[i],V[j])<prec ) // equal
-		{ iarray[j]=i;
-		}
-	 }
-
-   // fix face indices:
-   for ( i=0; i<fsize; i++ )
-	{ F[i].a = iarray[ F[i].a ];
-	  F[i].b = iarray[ F[i].b ];
-	  F[i].c = iarray[ F[i].c ];
-	}
-
-   // compress indices:   
-   int ind=0;
-   bool newv;
-   for ( i=0; i<vsize; i++ )
-	{ newv = iarray[i]==i;
-	  V[ind] = V[i];
-	  iarray[i] = ind;
-	  if ( newv ) ind++;
-	}
-   V.size ( ind );
+   _weld ( prec, true, false, false );
+ }
 
-   // fix face indices again:
-   for ( i=0; i<fsize; i++ )
-	{ F[i].a = iarray[ F[i].a ];
-	  F[i].b = iarray[ F[i].b ];
-	  F[i].c = iarray[ F[i].c ];
-	}
+void GsModel::weld ( float prec )
+ {
+   _weld ( prec, true, true, true );
  }
 
 void GsModel::flat ( bool comp )
@@ -547,15 +578,15 @@ void GsModel::flat ( bool comp )
 	_geomode = F.empty()||V.empty()? Empty:Faces;
 }
 
-// This is 3 times faster than with global sorting method, could still try hash tables
+// Fans of faces around vertices come from the cached adjacency structure
 void GsModel::smooth ( float crease_angle )
  {
    GS_TRACE5("Starting smooth...");
    if ( F.empty() ) return;
    int i, vsize=V.size();
 
-   // Get array of edges:
-   GsArray<Face>* va = get_edges_per_vertex();
+   // Get faces around vertices:
+   const GsModelAdjacency& adj = adjacency();
    GsArray<GsVec> na; // flat normals per face
 
    // Compute flat normals for all faces:
@@ -567,11 +598,12 @@ void GsModel::smooth ( float crease_angle )
    Fn.size(0);
    N.size ( vsize );
    for ( i=0; i<vsize; i++ )
-	{ GsArray<Face>& ea = va[i];
+	{ const int* st = adj.star(i);
+	  int size = adj.degree(i);
 	  GsVec nsum (GsVec::null);
-	  for ( int j=0; j<ea.size(); j++ )
-		nsum += na[ea[j].a]; // ImprNote: normals could be weighted by face areas
-	  N[i] = nsum / (float)ea.size();
+	  for ( int j=0; j<size; j++ )
+		nsum += na[adj.face(st[j])]; // ImprNote: normals could be weighted by face areas
+	  N[i] = nsum / (float)size;
 	  N[i].normalize();
 	}
 
@@ -584,12 +616,12 @@ void GsModel::smooth ( float crease_angle )
 	  for ( i=0; i<Fn.size(); i++ ) Fn[i]=F[i];
 	  // Make normals per vertex:
 	  for ( i=0; i<vsize; i++ )
-	   { GsArray<Face>& ea = va[i];
+	   { const int* st = adj.star(i);
 		 // build angle array and search for a "crease angled edge":
-		 int j, ini=-1, size=ea.size();
+		 int j, ini=-1, size=adj.degree(i);
 		 ang.size(size);
 		 for ( j=0; j<size; j++ )
-		  { ang[j] = ::angle( na[ea[j].a], na[ea[(j+1)%size].a] );
+		  { ang[j] = ::angle( na[adj.face(st[j])], na[adj.face(st[(j+1)%size])] );
 			if ( ini<0 && ang[j]>crease_angle ) ini=j+1;
 		  }
 		 // smooth groups of normals starting from creased angle:
@@ -600,14 +632,12 @@ void GsModel::smooth ( float crease_angle )
 			est=ini;
 			for ( ei=ini; ei<esize; ei++ )
 			 { j = ei%size;
-			   nsum += na[ea[j].a];
+			   nsum += na[adj.face(st[j])];
 			   ncount++;
 			   if ( ang[j]>crease_angle ) // add normal and re-start
 				{ for ( int k=est; k<=ei; k++ )
-				   { Face& fn = Fn[ea[k%size].a];
-					 if ( i==fn.a ) fn.a = N.size();
-					 else if ( i==fn.b ) fn.b = N.size();
-					 else fn.c = N.size();
+				   { int c = st[k%size]; // corner of vertex i
+					 (&Fn[adj.face(c)].a)[c%3] = N.size();
 				   }
 				  N.push() = nsum / (float)ncount;
 				  N.top().normalize();
@@ -631,25 +661,32 @@ void GsModel::smooth ( float crease_angle )
 	}
 
    // Finalize:
-   delete[] va;
    compress ();
    GS_TRACE5("Done.");
  }
 
 float GsModel::count_mean_vertex_degree ()
  {
-   int i;
    if ( F.empty() ) return 0.0f;
 
-   GsArray<int> vi(V.size());
-   vi.setall(0);
+   // each edge is adjacent to two vertices:
+   double k = 2.0*double(adjacency().count_edges());
+   return float( k/double(V.size()) );
+ }
 
-   for ( i=0; i<F.size(); i++ )
-	{ vi[F[i].a]++; vi[F[i].b]++; vi[F[i].c]++; }
+const GsModelAdjacency& GsModel::adjacency ()
+ {
+   if ( _adjacency && _adjstamp==_stamp ) return *_adjacency;
+   if ( !_adjacency ) _adjacency = new GsModelAdjacency;
+   _adjacency->build ( F.empty()? 0 : &F[0].a, F.size(), V.size() );
+   _adjstamp = _stamp;
+   return *_adjacency;
+ }
 
-   double k=0;
-   for ( i=0; i<vi.size(); i++ ) k += double(vi[i]);
-   return float( k/double(vi.size()) );
+void GsModel::free_adjacency ()
+ {
+   delete _adjacency;
+   _adjacency = 0;
  }
 
 int GsModel::common_vertices_of_faces ( int i1, int i2 )
@@ -674,42 +711,22 @@ void GsModel::get_bounding_box ( GsBox &box ) const
    for ( i=0; i<s; i++ ) box.extend ( V[i] );
  }
 
-static int fcompare ( const GsModel::Face *f1, const GsModel::Face *f2 )
- {
-   return f1->b-f2->b;
- }
-
 GsArray<GsModel::Face>* GsModel::get_edges_per_vertex()
  {
    if ( F.empty() ) return 0;
-   int i, j, k;
+   const GsModelAdjacency& adj = adjacency();
 
    // Allocate array per vertex:
    GsArray<Face>* va = new GsArray<Face>[V.size()];
 
-   // Get slight improvements by reducing re-allocations per vertex:
-   for ( i=0; i<V.size(); i++ ) va[i].capacity(8);
-
-   // Add unique edges per vertex, respecting orientation, and with face info:
-   for ( i=0; i<F.size(); i++ )
-	{ const Face& f=F[i];
-	  va[f.a].uniqinsort ( Face(i,f.b,f.c), fcompare );
-	  va[f.b].uniqinsort ( Face(i,f.c,f.a), fcompare );
-	  va[f.c].uniqinsort ( Face(i,f.a,f.b), fcompare );
-	}
-
-   // Sort edges per vertex by adjacency:
-   for ( i=0; i<V.size(); i++ )
-	{ GsArray<Face>& ea = va[i];
-	  int max = ea.size()-1;
-	  for ( j=1; j<max; j++ )
-	   { for ( k=j; k<=max; k++ )
-		  { if ( ea[j-1].c==ea[k].b ) break; }
-		 if ( k<=max ) // found
-		  { Face tmp; GS_SWAP(ea[j],ea[k]); }
-		 else 
-		  { // It does happen to not find correct adjancency when loading external meshes
-		  }
+   // Add edges per vertex, respecting orientation and adjacency, and with face info:
+   for ( int i=0, s=V.size(); i<s; i++ )
+	{ const int* st = adj.star(i);
+	  int d = adj.degree(i);
+	  va[i].size(d);
+	  for ( int j=0; j<d; j++ )
+	   { int c=st[j];
+		 va[i][j].set ( adj.face(c), adj.dest(c), adj.vertex(adj.prev(c)) );
 	   }
 	}
 
@@ -721,24 +738,22 @@ GsArray<int>* GsModel::get_edges()
 {
 	if ( F.empty() ) return 0;
 
-	// The approach here is to ensure uniqueness by sorting the edges per vertex,
-	// this is faster than global tree sorting after about 700 vertices.
-	// Allocate array per vertex:
-	GsArray<int>* va = new GsArray<int>[V.size()];
+	// Get unique edges from the adjacency structure:
+	GsArray<int> E;
+	adjacency().get_edges ( E );
 
-	// Get slight improvements by reducing re-allocations per vertex:
+	// Count edges per vertex to allocate each array only once:
 	int i, s;
-	for ( i=0, s=V.size(); i<s; i++ ) va[i].reserve(8);
+	GsArray<int> count ( V.size() );
+	count.setall ( 0 );
+	for ( i=0, s=E.size(); i<s; i+=2 ) count[E[i]]++;
 
-	// Add unique edges per vertex:
-	// Note: tests indicated uniqpush() about 2x faster than uniqinsort()
-	int min, max;
-	for ( i=0, s=F.size(); i<s; i++ )
-	{	const Face& f=F[i];
-		GS_MIN_MAX(f.a,f.b,min,max); va[min].uniqpush ( max, gs_compare );
-		GS_MIN_MAX(f.b,f.c,min,max); va[min].uniqpush ( max, gs_compare );
-		GS_MIN_MAX(f.c,f.a,min,max); va[min].uniqpush ( max, gs_compare );
-	}
+	// Allocate array per vertex:
+	GsArray<int>* va = new GsArray<int>[V.size()];
+	for ( i=0, s=V.size(); i<s; i++ ) va[i].reserve ( count[i] );
+
+	// Add edges to the vertex with the smaller index:
+	for ( i=0, s=E.size(); i<s; i+=2 ) va[E[i]].push() = E[i+1];
 
 	// return:
 	return va;
@@ -748,36 +763,29 @@ void GsModel::get_edges ( GsArray<int> &E )
 {
 	E.size(0);
 	if ( F.empty() ) return;
+	adjacency().get_edges ( E );
+}
 
-	// Get array of edges:
-	GsArray<int>* va = get_edges();
-
-	// Put result in linear array E:
-	E.reserve ( F.size()+V.size()-2 ); // E=F+V-2 estimation if a polyhedron
-	for ( int i=0, is=V.size(); i<is; i++ )
-	{	for ( int j=0, js=va[i].size(); j<js; j++ )
-		{	E.push() = i;
-			E.push() = va[i][j];
-		}
-	}
+const GsModelBvh& GsModel::bvh () const
+{
+	if ( _bvh && _bvhstamp==_stamp ) return *_bvh;
+	if ( !_bvh ) _bvh = new GsModelBvh;
+	_bvh->build ( *this );
+	_bvhstamp = _stamp;
+	return *_bvh;
+}
 
-	// delete va array:
-	delete[] va;
+void GsModel::free_bvh ()
+{
+	delete _bvh;
+	_bvh = 0;
 }
 
 int GsModel::pick_face ( const GsLine& line ) const
 {
-	float t, u, v;
-	int closestf=-1;
-	float closestt;
-
-	for ( int i=0; i<F.size(); i++ )
-	{	const Face& f = F[i];
-		if ( line.intersects_triangle ( V[f.a], V[f.b], V[f.c], t, u, v ) )
-		{	if ( closestf<0 || t<closestt ) { closestf=i; closestt=t; }
-		}
-	}
-   return closestf;
+	GsModelBvh::Hit hit;
+	bvh().closest_hit ( line, hit, -FLT_MAX, FLT_MAX );
+	return hit.f;
 }
 
 void GsModel::normalize ( float maxcoord )
@@ -902,6 +910,7 @@ void GsModel::invert_faces ()
 	for ( i=0, s=F.size(); i<s; i++ ) GS_SWAP ( F[i].b, F[i].c );
 	for ( i=0, s=Fn.size(); i<s; i++ ) GS_SWAP ( Fn[i].b, Fn[i].c );
 	for ( i=0, s=Ft.size(); i<s; i++ ) GS_SWAP ( Ft[i].b, Ft[i].c );
+	changed ();
 }
 
 void GsModel::invert_normals ()
@@ -914,6 +923,7 @@ void GsModel::translate ( const GsVec &tr )
 	int i, s=V.size();
 	for ( i=0; i<s; i++ ) V[i]+=tr;
 	if ( primitive ) { primitive->center += tr; }
+	changed ();
 }
 
 void GsModel::scale ( float factor )
@@ -921,6 +931,7 @@ void GsModel::scale ( float factor )
 	int i, s=V.size();
 	for ( i=0; i<s; i++ ) V[i]*=factor;
 	if ( primitive ) { primitive->ra*=factor; primitive->rb*=factor; primitive->rc*=factor; }
+	changed ();
 }
 
 void GsModel::centralize ()
@@ -946,6 +957,7 @@ void GsModel::transform ( const GsMat& mat, bool primtransf )
 
 	size = V.size();
 	for ( i=0; i<size; i++ ) V[i] = m * V[i];
+	changed ();
 
 	size = N.size();
 	if ( size<=0 ) return;
@@ -965,6 +977,7 @@ void GsModel::rotate ( const GsQuat& q )
 	for ( i=0, s=N.size(); i<s; i++ ) N[i] = q.apply(N[i]);
 
 	if ( primitive ) { primitive->orientation = q * primitive->orientation; }
+	changed ();
 }
 
 //================================ End of File =================================================
@@ -0,0 +1,118 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <string.h>
+# include <sig/gs_model_adjacency.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+//============================= GsModelAdjacency ==========================
+
+GsModelAdjacency::GsModelAdjacency ()
+ {
+   _nv = 0;
+ }
+
+void GsModelAdjacency::init ()
+ {
+   _cv.capacity(0); _twin.capacity(0); _vi.capacity(0); _vc.capacity(0);
+   _nv = 0;
+ }
+
+void GsModelAdjacency::build ( const int* fv, int nf, int nv )
+ {
+   int c, i, v, s, e, nc=3*nf;
+   GS_TRACE1 ( "Building adjacency of "<<nf<<" faces and "<<nv<<" vertices..." );
+
+   _nv = nv;
+   _cv.size ( nc );
+   if ( nc ) memcpy ( _cv.pt(), fv, sizeof(int)*nc );
+
+   // sort corners by vertex with a counting sort:
+   _vi.size ( nv+1 );
+   _vi.setall ( 0 );
+   for ( c=0; c<nc; c++ ) _vi[_cv[c]+1]++;
+   for ( v=0; v<nv; v++ ) _vi[v+1] += _vi[v];
+   GsArray<int> pos ( nv );
+   for ( v=0; v<nv; v++ ) pos[v]=_vi[v];
+   _vc.size ( nc );
+   for ( c=0; c<nc; c++ ) _vc[pos[_cv[c]]++] = c;
+
+   // the twin of each half-edge w->v arriving at v is the only half-edge v->w leaving v:
+   GsArray<int>& mark = pos; // destination marks, -1 if not used and -2 if used more than once
+   mark.setall ( -1 );
+   _twin.size ( nc );
+   _twin.setall ( -1 );
+   for ( v=0; v<nv; v++ )
+	{ s=_vi[v]; e=_vi[v+1];
+	  for ( i=s; i<e; i++ ) { int& m=mark[dest(_vc[i])]; m = m==-1? _vc[i]:-2; }
+	  for ( i=s; i<e; i++ ) { c=prev(_vc[i]); if ( mark[_cv[c]]>=0 ) _twin[c]=mark[_cv[c]]; }
+	  for ( i=s; i<e; i++ ) mark[dest(_vc[i])] = -1;
+	}
+
+   // keep only twins that agree in both directions, which excludes non-manifold edges:
+   for ( c=0; c<nc; c++ )
+	{ if ( _twin[c]>=0 && _twin[_twin[c]]!=c ) _twin[c]=-1;
+	}
+
+   // order corners around each vertex by following the fans of faces, starting at boundaries:
+   GsArray<gsbyte> visited ( nc );
+   visited.setall ( 0 );
+   GsArray<int> fan;
+   for ( v=0; v<nv; v++ )
+	{ s=_vi[v]; e=_vi[v+1];
+	  if ( e-s<2 ) continue;
+	  fan.size(0);
+	  while ( fan.size()<e-s )
+	   { int start=-1;
+		 for ( i=s; i<e; i++ ) // a corner with no previous corner in its fan, if any
+		  { c=_vc[i];
+			if ( visited[c] ) continue;
+			if ( start<0 ) start=c;
+			if ( _twin[c]<0 ) { start=c; break; }
+		  }
+		 for ( c=start; c>=0 && !visited[c]; c=swing(c) ) { visited[c]=1; fan.push()=c; }
+	   }
+	  memcpy ( &_vc[s], fan.pt(), sizeof(int)*fan.size() );
+	}
+
+   GS_TRACE1 ( "Done." );
+ }
+
+void GsModelAdjacency::one_ring ( int v, GsArray<int>& ring ) const
+ {
+   const int* st = star(v);
+   int d = degree(v);
+   for ( int i=0; i<d; i++ )
+	{ int c=st[i];
+	  ring.push() = dest(c);
+	  // the previous vertex of c is the destination of the next corner, unless the fan is open here:
+	  if ( swing(c)<0 ) ring.push() = _cv[prev(c)];
+	}
+ }
+
+int GsModelAdjacency::_edges ( GsArray<int>* E ) const
+ {
+   GsArray<int> mark ( _nv );
+   mark.setall ( -1 );
+   int n=0;
+   for ( int v=0; v<_nv; v++ )
+	{ const int* st = star(v);
+	  for ( int i=0, d=degree(v); i<d; i++ )
+	   { int w[2] = { dest(st[i]), _cv[prev(st[i])] };
+		 for ( int k=0; k<2; k++ )
+		  { if ( w[k]<=v || mark[w[k]]==v ) continue;
+			mark[w[k]]=v; n++;
+			if ( E ) { E->push()=v; E->push()=w[k]; }
+		  }
+	   }
+	}
+   return n;
+ }
+
+//============================= EOF ===================================
@@ -0,0 +1,252 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <string.h>
+# include <sig/gs_model.h>
+# include <sig/gs_model_bvh.h>
+# include <sig/gs_primitive.h>
+# include <sig/gs_mapped_file.h>
+
+//# define GS_USE_TRACE1 // IO
+# include <sig/gs_trace.h>
+
+//================================ format ==================================
+
+/* The binary format stores the arrays of GsModel in the same layout they have in memory.
+   The file starts with a BinHeader, which is followed by the sections it lists, each one
+   starting at an offset multiple of 16 from the start of the file. Group strings are
+   stored as offsets in the strings section, which contains null-terminated strings.
+   The signature detects files corrupted by text mode conversions, and files written with
+   another byte order or version, or with different sizes of the stored types, are rejected. */
+
+static const char BinMagic[8] = { '\x89', 'G', 'S', 'M', '\r', '\n', '\x1a', '\n' };
+static const gsuint32 BinVersion = 1;
+static const gsuint32 BinByteOrder = 0x01020304;
+static const int BinAlign = 16;
+
+enum BinSections { SecV, SecN, SecT, SecF, SecFn, SecFt, SecM, SecG, SecStrings, SecPrimitive,
+				   SecBvhNodes, SecBvhFaces, SecBvhVerts, NumSections };
+
+struct BinSection
+{	uint64_t offset; // position in the file
+	gsint32 count;	 // number of elements
+	gsint32 size;	 // size of each element
+};
+
+struct BinHeader
+{	char magic[8];
+	gsuint32 version;
+	gsuint32 byteorder;
+	gsint32 name;	// offset of the model name in the strings section, or -1
+	gscbool culling, textured, primitive, bvh;
+	BinSection sec[NumSections];
+};
+
+struct BinGroup
+{	gsint32 fi, fn;
+	gsint32 mtlname, dmap; // offsets in the strings section, or -1
+};
+
+// size of the elements of each section:
+static void section_sizes ( int* size )
+{
+	int s[NumSections] = { sizeof(GsPnt), sizeof(GsVec), sizeof(GsPnt2), sizeof(GsModel::Face), sizeof(GsModel::Face),
+						   sizeof(GsModel::Face), sizeof(GsMaterial), sizeof(BinGroup), 1, sizeof(GsPrimitive),
+						   sizeof(GsModelBvh::Node), sizeof(int), sizeof(GsPnt) };
+	memcpy ( size, s, sizeof(s) );
+}
+
+//================================ save ==================================
+
+static int add_string ( GsArray<char>& strings, const char* s )
+{
+	if ( !s ) return -1;
+	int pos = strings.size();
+	int len = (int)strlen(s)+1;
+	strings.size ( pos+len );
+	memcpy ( &strings[pos], s, len );
+	return pos;
+}
+
+bool GsModel::binary_file ( const char* file )
+{
+	FILE* fp = fopen ( file, "rb" );
+	if ( !fp ) return false;
+	char sig[8];
+	bool ok = fread(sig,1,8,fp)==8 && memcmp(sig,BinMagic,8)==0;
+	fclose ( fp );
+	return ok;
+}
+
+bool GsModel::save_bin ( const char* file, bool withbvh ) const
+{
+	GS_TRACE1 ( "Saving binary model "<<file<<"..." );
+	FILE* fp = fopen ( file, "wb" );
+	if ( !fp ) return false;
+
+	const GsModelBvh* h = withbvh && F.size()>0? &bvh() : 0;
+
+	GsArray<char> strings;
+	GsArray<BinGroup> groups ( G.size() );
+	int name_pos = name.len()? add_string(strings,name) : -1;
+	for ( int i=0; i<G.size(); i++ )
+	{	groups[i].fi = G[i].fi;
+		groups[i].fn = G[i].fn;
+		groups[i].mtlname = add_string ( strings, G[i].mtlname );
+		groups[i].dmap = add_string ( strings, G[i].dmap? G[i].dmap->fname.pt : 0 );
+	}
+
+	const void* data[NumSections] = { V.pt(), N.pt(), T.pt(), F.pt(), Fn.pt(), Ft.pt(), M.pt(), groups.pt(), strings.pt(),
+									  primitive, h? h->_nodes.pt():0, h? h->_fi.pt():0, h? h->_tv.pt():0 };
+	int count[NumSections] = { V.size(), N.size(), T.size(), F.size(), Fn.size(), Ft.size(), M.size(), groups.size(), strings.size(),
+							   primitive? 1:0, h? h->_nodes.size():0, h? h->_fi.size():0, h? h->_tv.size():0 };
+	int size[NumSections];
+	section_sizes ( size );
+
+	BinHeader hd;
+	memset ( &hd, 0, sizeof(BinHeader) );
+	memcpy ( hd.magic, BinMagic, 8 );
+	hd.version = BinVersion;
+	hd.byteorder = BinByteOrder;
+	hd.name = name_pos;
+	hd.culling = culling;
+	hd.textured = textured;
+	hd.primitive = primitive? 1:0;
+	hd.bvh = h? 1:0;
+	uint64_t pos = sizeof(BinHeader);
+	for ( int s=0; s<NumSections; s++ )
+	{	pos = (pos+BinAlign-1)/BinAlign*BinAlign;
+		hd.sec[s].offset = pos;
+		hd.sec[s].count = count[s];
+		hd.sec[s].size = size[s];
+		pos += uint64_t(count[s])*size[s];
+	}
+
+	static const char zeros[BinAlign] = { 0 };
+	bool ok = fwrite ( &hd, sizeof(BinHeader), 1, fp )==1;
+	pos = sizeof(BinHeader);
+	for ( int s=0; s<NumSections && ok; s++ )
+	{	if ( hd.sec[s].offset>pos ) ok = fwrite ( zeros, size_t(hd.sec[s].offset-pos), 1, fp )==1;
+		size_t n = size_t(count[s])*size[s];
+		if ( n ) ok = ok && fwrite ( data[s], n, 1, fp )==1;
+		pos = hd.sec[s].offset+n;
+	}
+	if ( fclose(fp)!=0 ) ok=false;
+	GS_TRACE1 ( (ok?"Done.":"Error!") );
+	return ok;
+}
+
+//================================ load ==================================
+
+template <typename X>
+static void copy_section ( GsArray<X>& a, const char* data, const BinSection& s )
+{
+	a.size ( s.count );
+	if ( s.count ) memcpy ( (void*)a.pt(), data+s.offset, sizeof(X)*s.count );
+}
+
+// checks that the stored hierarchy only references existing nodes and faces, and
+// that its depth fits the traversal stack of GsModelBvh (see GS_BVH_STACK):
+static bool valid_bvh ( const GsModelBvh::Node* nodes, int nn, const int* fi, int nfi, int nfaces )
+{
+	for ( int i=0; i<nfi; i++ ) if ( fi[i]<0 || fi[i]>=nfaces ) return false;
+	GsArray<int> depth ( nn );
+	depth.setall ( -1 );
+	if ( nn>0 ) depth[0]=0;
+	for ( int ni=0; ni<nn; ni++ )
+	{	const GsModelBvh::Node& node = nodes[ni];
+		if ( node.n<0 ) return false;
+		if ( node.n>0 ) // leaf
+		{	if ( node.i<0 || int64_t(node.i)+node.n>nfi ) return false;
+			continue;
+		}
+		// children come after their parent, so that each node is visited once:
+		if ( ni+1>=nn || node.i<=ni+1 || node.i>=nn ) return false;
+		if ( depth[ni]<0 ) continue; // not reachable from the root
+		if ( depth[ni]+1>=GS_BVH_STACK ) return false;
+		depth[ni+1] = GS_MAX ( depth[ni+1], depth[ni]+1 );
+		depth[node.i] = GS_MAX ( depth[node.i], depth[ni]+1 );
+	}
+	return true;
+}
+
+bool GsModel::load_bin ( const char* file )
+{
+	GS_TRACE1 ( "Loading binary model "<<file<<"..." );
+	GsMappedFile mf;
+	if ( !mf.open(file) ) return false;
+	if ( mf.size()<sizeof(BinHeader) ) return false;
+
+	BinHeader hd;
+	memcpy ( &hd, mf.data(), sizeof(BinHeader) );
+	if ( memcmp(hd.magic,BinMagic,8)!=0 || hd.version!=BinVersion || hd.byteorder!=BinByteOrder ) return false;
+
+	// validate sections before changing the model:
+	int size[NumSections];
+	section_sizes ( size );
+	for ( int s=0; s<NumSections; s++ )
+	{	const BinSection& sec = hd.sec[s];
+		if ( sec.size!=size[s] || sec.count<0 || sec.offset%BinAlign!=0 ) return false;
+		if ( sec.offset>mf.size() || uint64_t(sec.count)*sec.size>mf.size()-sec.offset ) return false;
+	}
+	const char* data = mf.data();
+	const BinSection& strsec = hd.sec[SecStrings];
+	const char* strings = data+strsec.offset;
+	if ( strsec.count>0 && strings[strsec.count-1]!=0 ) return false;
+	if ( hd.sec[SecPrimitive].count>1 || hd.name>=strsec.count ) return false;
+	const BinGroup* groups = (const BinGroup*)(data+hd.sec[SecG].offset);
+	for ( int i=0; i<hd.sec[SecG].count; i++ )
+	{	if ( groups[i].mtlname>=strsec.count || groups[i].dmap>=strsec.count ) return false;
+		if ( groups[i].fi<0 || groups[i].fn<0 || int64_t(groups[i].fi)+groups[i].fn>hd.sec[SecF].count ) return false;
+	}
+
+	init ();
+	copy_section ( V, data, hd.sec[SecV] );
+	copy_section ( N, data, hd.sec[SecN] );
+	copy_section ( T, data, hd.sec[SecT] );
+	copy_section ( F, data, hd.sec[SecF] );
+	copy_section ( Fn, data, hd.sec[SecFn] );
+	copy_section ( Ft, data, hd.sec[SecFt] );
+	copy_section ( M, data, hd.sec[SecM] );
+
+	G.size ( hd.sec[SecG].count );
+	for ( int i=0; i<G.size(); i++ )
+	{	G[i].init ( groups[i].fi, groups[i].fn );
+		if ( groups[i].mtlname>=0 ) G[i].mtlname = gs_string_new ( strings+groups[i].mtlname );
+		if ( groups[i].dmap>=0 )
+		{	G[i].dmap = new Texture;
+			G[i].dmap->id = -2;
+			G[i].dmap->fname.set ( strings+groups[i].dmap );
+		}
+	}
+
+	if ( hd.name>=0 ) name = strings+hd.name;
+	culling = hd.culling;
+	textured = hd.textured;
+	if ( hd.sec[SecPrimitive].count==1 )
+	{	primitive = new GsPrimitive;
+		memcpy ( (void*)primitive, data+hd.sec[SecPrimitive].offset, sizeof(GsPrimitive) );
+	}
+
+	// a stored hierarchy that does not match the faces is dropped, and rebuilt when requested:
+	if ( hd.bvh && hd.sec[SecBvhFaces].count==F.size() && hd.sec[SecBvhVerts].count==3*F.size() &&
+		 valid_bvh ( (const GsModelBvh::Node*)(data+hd.sec[SecBvhNodes].offset), hd.sec[SecBvhNodes].count,
+					 (const int*)(data+hd.sec[SecBvhFaces].offset), hd.sec[SecBvhFaces].count, F.size() ) )
+	{	_bvh = new GsModelBvh;
+		copy_section ( _bvh->_nodes, data, hd.sec[SecBvhNodes] );
+		copy_section ( _bvh->_fi, data, hd.sec[SecBvhFaces] );
+		copy_section ( _bvh->_tv, data, hd.sec[SecBvhVerts] );
+		_bvhstamp = _stamp;
+	}
+
+	detect_mode ();
+	GS_TRACE1 ( "Done." );
+	return true;
+}
+
+//============================= EOF ===================================
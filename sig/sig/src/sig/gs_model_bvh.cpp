@@ -0,0 +1,270 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_model_bvh.h>
+# include <sig/gs_parallel.h>
+
+//# define GS_USE_TRACE1 // build
+# include <sig/gs_trace.h>
+
+# define GS_BVH_BINS 12		 // number of bins used to evaluate the surface area heuristic
+# define GS_BVH_MAX_LEAF 8	 // leaves with more triangles are always split
+# define GS_BVH_SAH_DEPTH 48 // deeper nodes are split by the median, so that the traversal stack is bounded
+# define GS_BVH_MIN_RAYS 256 // a thread only receives a range of rays if it has this many rays
+# define EPSILON 0.00001f	 // relative to the lengths of the ray and of the triangle edges
+
+//============================= GsModelBvh ==========================
+
+struct GsModelBvh::Ray
+{	GsPnt o; GsVec d, id;
+	float dd; // squared length of d
+	float tmin, tmax;
+	Ray ( const GsLine& l, float t1, float t2 )
+	{	o=l.p1; d=l.p2-l.p1; dd=dot(d,d);
+		for ( int k=0; k<3; k++ ) id[k] = d[k]==0? 0 : 1.0f/d[k];
+		tmin=t1; tmax=t2;
+	}
+};
+
+struct GsModelBvh::Batch
+{	const GsModelBvh* bvh;
+	const GsLine* rays;
+	Hit* hits;		// for closest hits
+	gsbyte* anyhits; // for any hits
+	float tmin, tmax;
+};
+
+GsModelBvh::GsModelBvh ()
+ {
+   _nthreads = 0;
+ }
+
+void GsModelBvh::init ()
+ {
+   _nodes.capacity(0); _fi.capacity(0); _tv.capacity(0);
+ }
+
+static float area ( const GsBox& b )
+ {
+   GsVec s = b.size();
+   return s.x*s.y + s.y*s.z + s.z*s.x;
+ }
+
+void GsModelBvh::build ( const GsModel& m )
+ {
+   int i, fsize=m.F.size();
+   GS_TRACE1 ( "Building hierarchy of "<<fsize<<" faces..." );
+
+   _nodes.size(0);
+
+   GsArray<int> ti(fsize);
+   GsArray<GsBox> tb(fsize);
+   GsArray<GsPnt> tc(fsize);
+   for ( i=0; i<fsize; i++ )
+	{ const GsModel::Face& f = m.F[i];
+	  ti[i] = i;
+	  tb[i].set_empty(); tb[i].extend(m.V[f.a]); tb[i].extend(m.V[f.b]); tb[i].extend(m.V[f.c]);
+	  tc[i] = tb[i].center();
+	}
+
+   if ( fsize>0 )
+	{ _nodes.capacity ( 2*fsize ); // a binary tree with n leaves has 2n-1 nodes
+	  _build ( ti, tb, tc, 0, fsize, 0 );
+	  _nodes.compress ();
+	}
+
+   _fi = ti;
+   _tv.size ( 3*fsize );
+   for ( i=0; i<fsize; i++ )
+	{ const GsModel::Face& f = m.F[ti[i]];
+	  _tv[3*i]=m.V[f.a]; _tv[3*i+1]=m.V[f.b]; _tv[3*i+2]=m.V[f.c];
+	}
+   GS_TRACE1 ( "Done with "<<_nodes.size()<<" nodes." );
+ }
+
+void GsModelBvh::_build ( GsArray<int>& ti, const GsArray<GsBox>& tb, const GsArray<GsPnt>& tc, int first, int n, int depth )
+ {
+   int i, k, ni=_nodes.size();
+   GsBox box, cbox;
+   for ( i=first; i<first+n; i++ ) { box.extend ( tb[ti[i]] ); cbox.extend ( tc[ti[i]] ); }
+
+   Node& node = _nodes.push();
+   node.a = box.a;
+   node.b = box.b;
+   node.i = first;
+   node.n = n;
+   if ( n==1 ) return;
+
+   // evaluate the surface area heuristic with binned centroids, the cost being
+   // relative to the one of intersecting a triangle, and to the area of the node:
+   int bestaxis=-1, bestbin=0;
+   float bestcost=FLT_MAX;
+   GsVec cs = cbox.size();
+   if ( depth<GS_BVH_SAH_DEPTH )
+	{ for ( k=0; k<3; k++ )
+	   { if ( cs[k]<=0 ) continue;
+		 int count[GS_BVH_BINS];
+		 GsBox bins[GS_BVH_BINS];
+		 float la[GS_BVH_BINS]; int ln[GS_BVH_BINS];
+		 for ( i=0; i<GS_BVH_BINS; i++ ) { count[i]=0; bins[i].set_empty(); }
+		 float f = float(GS_BVH_BINS)/cs[k];
+		 for ( i=first; i<first+n; i++ )
+		  { int b = GS_MIN ( int((tc[ti[i]](k)-cbox.a(k))*f), GS_BVH_BINS-1 );
+			count[b]++;
+			bins[b].extend ( tb[ti[i]] );
+		  }
+		 GsBox acc; int nacc=0;
+		 for ( i=0; i<GS_BVH_BINS-1; i++ ) // left side of the split after bin i
+		  { if ( count[i] ) { acc.extend(bins[i]); nacc+=count[i]; }
+			la[i]=nacc? area(acc):0; ln[i]=nacc;
+		  }
+		 acc.set_empty(); nacc=0;
+		 for ( i=GS_BVH_BINS-1; i>0; i-- ) // right side of the split after bin i-1
+		  { if ( count[i] ) { acc.extend(bins[i]); nacc+=count[i]; }
+			if ( ln[i-1]==0 || nacc==0 ) continue;
+			float cost = float(ln[i-1])*la[i-1] + float(nacc)*area(acc);
+			if ( cost<bestcost ) { bestcost=cost; bestaxis=k; bestbin=i-1; }
+		  }
+	   }
+	  float a = area(box);
+	  if ( a>0 ) bestcost = 1.0f + bestcost/a; // one traversal step plus the expected intersections
+	  if ( n<=GS_BVH_MAX_LEAF && ( bestaxis<0 || bestcost>=float(n) ) ) return; // leaf
+	}
+   else if ( n<=GS_BVH_MAX_LEAF ) return; // leaf
+
+   // partition the triangles:
+   int n1;
+   if ( bestaxis>=0 )
+	{ float f = float(GS_BVH_BINS)/cs[bestaxis];
+	  int tmp, j=first+n-1;
+	  k=first;
+	  while ( k<=j )
+	   { int b = GS_MIN ( int((tc[ti[k]](bestaxis)-cbox.a(bestaxis))*f), GS_BVH_BINS-1 );
+		 if ( b<=bestbin ) k++;
+		 else { GS_SWAP(ti[k],ti[j]); j--; }
+	   }
+	  n1 = k-first;
+	}
+   else // all centroids are equal or the node is too deep: split by the median
+	{ n1 = n/2;
+	}
+
+   _nodes[ni].n = 0;
+   _build ( ti, tb, tc, first, n1, depth+1 );
+   _nodes[ni].i = _nodes.size(); // node reference may be invalid at this point
+   _build ( ti, tb, tc, first+n1, n-n1, depth+1 );
+ }
+
+// returns true if the ray enters the box of the node within [tmin,tmax], with tmin updated to the entry point:
+static inline bool slabs ( const GsPnt& a, const GsPnt& b, const GsPnt& o, const GsVec& id, float& tmin, float tmax )
+ {
+   for ( int k=0; k<3; k++ )
+	{ if ( id.e[k]==0 ) // ray parallel to the slab
+	   { if ( o.e[k]<a.e[k] || o.e[k]>b.e[k] ) return false;
+		 continue;
+	   }
+	  float t1 = (a.e[k]-o.e[k])*id.e[k];
+	  float t2 = (b.e[k]-o.e[k])*id.e[k];
+	  if ( t1>t2 ) { float tmp=t1; t1=t2; t2=tmp; }
+	  if ( t1>tmin ) tmin=t1;
+	  if ( t2<tmax ) tmax=t2;
+	}
+   return tmin<=tmax;
+ }
+
+bool GsModelBvh::_traverse ( const Ray& r, Hit* hit ) const
+ {
+   if ( _nodes.empty() ) return false;
+   float tmax = r.tmax;
+   float t0 = r.tmin;
+   if ( !slabs ( _nodes[0].a, _nodes[0].b, r.o, r.id, t0, tmax ) ) return false;
+
+   int stack[GS_BVH_STACK];
+   float tstack[GS_BVH_STACK]; // entry parameter of the nodes in the stack
+   int sp=0, ni=0;
+   bool found=false;
+   while ( true )
+	{ const Node& node = _nodes[ni];
+	  if ( node.n>0 ) // test triangles as in GsLine::intersects_triangle(), but with a relative epsilon
+	   { const GsPnt* tv = &_tv[3*node.i];
+		 for ( int i=0; i<node.n; i++, tv+=3 )
+		  { GsVec e1=tv[1]-tv[0], e2=tv[2]-tv[0];
+			GsVec pvec = cross ( r.d, e2 );
+			float det = dot ( e1, pvec );
+			if ( det*det <= EPSILON*EPSILON*r.dd*dot(e1,e1)*dot(e2,e2) ) continue; // parallel or degenerate
+			float inv = 1.0f/det;
+			GsVec tvec = r.o-tv[0];
+			float u = dot(tvec,pvec)*inv;
+			if ( u<0 || u>1.0f ) continue;
+			GsVec qvec = cross ( tvec, e1 );
+			float v = dot(r.d,qvec)*inv;
+			if ( v<0 || u+v>1.0f ) continue;
+			float t = dot(e2,qvec)*inv;
+			if ( t<r.tmin || t>tmax ) continue;
+			if ( !hit ) return true;
+			found=true; tmax=t;
+			hit->f=_fi[node.i+i]; hit->t=t; hit->u=u; hit->v=v;
+		  }
+	   }
+	  else // visit the closest child first
+	   { int c1=ni+1, c2=node.i;
+		 float t1=r.tmin, t2=r.tmin;
+		 bool h1 = slabs ( _nodes[c1].a, _nodes[c1].b, r.o, r.id, t1, tmax );
+		 bool h2 = slabs ( _nodes[c2].a, _nodes[c2].b, r.o, r.id, t2, tmax );
+		 if ( h1 && h2 )
+		  { if ( t2<t1 ) { int tmp=c1; c1=c2; c2=tmp; float ft=t1; t1=t2; t2=ft; }
+			tstack[sp]=t2; stack[sp++]=c2; ni=c1; continue;
+		  }
+		 if ( h1 ) { ni=c1; continue; }
+		 if ( h2 ) { ni=c2; continue; }
+	   }
+	  do { if ( sp==0 ) return found; sp--; } while ( tstack[sp]>tmax ); // skip nodes beyond the closest hit
+	  ni = stack[sp];
+	}
+ }
+
+bool GsModelBvh::closest_hit ( const GsLine& ray, Hit& hit, float tmin, float tmax ) const
+ {
+   hit.f = -1;
+   return _traverse ( Ray(ray,tmin,tmax), &hit );
+ }
+
+bool GsModelBvh::any_hit ( const GsLine& ray, float tmin, float tmax ) const
+ {
+   return _traverse ( Ray(ray,tmin,tmax), 0 );
+ }
+
+void GsModelBvh::_batch_thread ( int i0, int i1, void* udata )
+ {
+   const Batch& b = *(const Batch*)udata;
+   for ( int i=i0; i<i1; i++ )
+	{ if ( b.hits ) b.bvh->closest_hit ( b.rays[i], b.hits[i], b.tmin, b.tmax );
+	  else b.anyhits[i] = b.bvh->any_hit ( b.rays[i], b.tmin, b.tmax )? 1:0;
+	}
+ }
+
+static int batch_threads ( int nthreads, int nrays )
+ {
+   int nt = nthreads>0? nthreads : gs_hardware_threads();
+   return GS_MAX ( 1, GS_MIN ( nt, nrays/GS_BVH_MIN_RAYS ) );
+ }
+
+void GsModelBvh::closest_hits ( const GsArray<GsLine>& rays, GsArray<Hit>& hits, float tmin, float tmax ) const
+ {
+   hits.size ( rays.size() );
+   Batch b = { this, rays.pt(), hits.pt(), 0, tmin, tmax };
+   gs_parallel_for ( rays.size(), batch_threads(_nthreads,rays.size()), _batch_thread, &b );
+ }
+
+void GsModelBvh::any_hits ( const GsArray<GsLine>& rays, GsArray<gsbyte>& hits, float tmin, float tmax ) const
+ {
+   hits.size ( rays.size() );
+   Batch b = { this, rays.pt(), 0, hits.pt(), tmin, tmax };
+   gs_parallel_for ( rays.size(), batch_threads(_nthreads,rays.size()), _batch_thread, &b );
+ }
+
+//============================= EOF ===================================
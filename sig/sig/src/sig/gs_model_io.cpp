@@ -17,6 +17,25 @@
 
 //=================================== GsModel =================================================
 
+// reads n numbers, returning false if another token is found:
+static bool read_numbers ( GsInput& in, float* f, int n )
+{
+	for ( int i=0; i<n; i++ )
+	{	if ( in.get()!=GsInput::Number ) return false;
+		f[i] = gs_atof ( in.ltoken() );
+	}
+	return true;
+}
+
+static bool read_numbers ( GsInput& in, int* v, int n )
+{
+	for ( int i=0; i<n; i++ )
+	{	if ( in.get()!=GsInput::Number ) return false;
+		v[i] = gs_atoi ( in.ltoken() );
+	}
+	return true;
+}
+
 bool GsModel::load ( const char* fname )
 {
 	if ( !fname || fname[0]==0 ) return false;
@@ -24,7 +43,10 @@ bool GsModel::load ( const char* fname )
 	bool ret;
 
 	GsString fn=fname;
-	if ( has_extension(fn,"m") )
+	if ( binary_file(fname) )
+	{	ret = load_bin(fname);
+	}
+	else if ( has_extension(fn,"m") )
 	{	if ( !in.open(fname) ) return false;
 		ret = load ( in );
 	}
@@ -96,35 +118,35 @@ bool GsModel::load ( GsInput &in )
 		}
 		else if ( s=="vertices" ) // read vertices: x y z
 		{	V.size(in.geti());
-			for ( i=0; i<V.size(); i++ ) // fscanf call is equiv to: in >> V[i];
-			{	if ( fscanf ( in.filept(), "%f %f %f", &V[i].x, &V[i].y, &V[i].z )!=3 ) return false; }
+			for ( i=0; i<V.size(); i++ ) // same as in >> V[i], but checking the tokens
+			{	if ( !read_numbers ( in, &V[i].x, 3 ) ) return false; }
 		}
 		else if ( s=="faces" ) // read F: a b c
 		{	F.size(in.geti());
-			for ( i=0; i<F.size(); i++ ) // fscanf call is equiv to: in >> F[i];
-			{	if ( fscanf ( in.filept(), "%d %d %d", &F[i].a, &F[i].b, &F[i].c )!=3 ) return false;
+			for ( i=0; i<F.size(); i++ ) // same as in >> F[i], but checking the tokens
+			{	if ( !read_numbers ( in, &F[i].a, 3 ) ) return false;
 				F[i].validate();
 			}
 		}
 		else if ( s=="normals" ) // read N: x y z
 		{	N.size(in.geti());
-			for ( i=0; i<N.size(); i++ ) // fscanf call is equiv to: in >> N[i];
-			{	if ( fscanf ( in.filept(), "%f %f %f", &N[i].x, &N[i].y, &N[i].z )!=3 ) return false; }
+			for ( i=0; i<N.size(); i++ ) // same as in >> N[i], but checking the tokens
+			{	if ( !read_numbers ( in, &N[i].x, 3 ) ) return false; }
 		}
 		else if ( s=="fnormals" ) // read Fn: a b c
 		{	Fn.size(in.geti());
-			for ( i=0; i<Fn.size(); i++ ) // fscanf call is equiv to: in >> Fn[i];
-			{	if ( fscanf ( in.filept(), "%d %d %d", &Fn[i].a, &Fn[i].b, &Fn[i].c )!=3 ) return false; }
+			for ( i=0; i<Fn.size(); i++ ) // same as in >> Fn[i], but checking the tokens
+			{	if ( !read_numbers ( in, &Fn[i].a, 3 ) ) return false; }
 		}
 		else if ( s=="ftextcoords" ) // read Ft: a b c
 		{	Ft.size(in.geti());
-			for ( i=0; i<Ft.size(); i++ ) // fscanf call is equiv to: in >> Ft[i];
-			{	if ( fscanf ( in.filept(), "%d %d %d", &Ft[i].a, &Ft[i].b, &Ft[i].c )!=3 ) return false; }
+			for ( i=0; i<Ft.size(); i++ ) // same as in >> Ft[i], but checking the tokens
+			{	if ( !read_numbers ( in, &Ft[i].a, 3 ) ) return false; }
 		}
 		else if ( s=="fmaterials" ) // read Fm: i
 		{	Fm.size(in.geti());
-			for ( i=0; i<Fm.size(); i++ ) // fscanf call is equiv to: in >> Fm[i];
-			{	if ( fscanf ( in.filept(), "%d", &Fm[i] )!=1 ) return false; }
+			for ( i=0; i<Fm.size(); i++ ) // same as in >> Fm[i], but checking the tokens
+			{	if ( !read_numbers ( in, &Fm[i], 1 ) ) return false; }
 		}
 		else if ( s=="groups" ) // read material groups
 		{	G.size(in.geti());
@@ -139,8 +161,8 @@ bool GsModel::load ( GsInput &in )
 		}
 		else if ( s=="textcoords" ) // read T: u v
 		{	T.size(in.geti());
-			for ( i=0; i<T.size(); i++ ) // fscanf call is equiv to: in >> T[i];
-			{	if ( fscanf ( in.filept(), "%f %f", &T[i].x, &T[i].y )!=2 ) return false; }
+			for ( i=0; i<T.size(); i++ ) // same as in >> T[i], but checking the tokens
+			{	if ( !read_numbers ( in, &T[i].x, 2 ) ) return false; }
 		}
 		else if ( s=="materials" ) // read M: mtls
 		{	M.size(in.geti());
@@ -212,6 +234,9 @@ bool GsModel::save ( const char* fname )
 	if ( has_extension(filename,"iv") )
 	{	return save_iv(fname);
 	}
+	else if ( has_extension(filename,"mb") )
+	{	return save_bin(fname);
+	}
 	else
 	{	GsOutput out;
 		if ( !out.open(fname) ) return false;
@@ -5,10 +5,14 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <stdlib.h>
+# include <string.h>
 # include <sig/gs_strings.h>
 # include <sig/gs_string.h>
 # include <sig/gs_model.h>
 # include <sig/gs_dirs.h>
+# include <sig/gs_mapped_file.h>
+# include <sig/gs_parallel.h>
 
 //# define GS_USE_TRACE1	// keyword tracking
 //# define GS_USE_TRACE2	// trace specific keywords
@@ -16,29 +20,113 @@
 //# define GS_USE_TRACE4	// final stats
 # include <sig/gs_trace.h>
 
-# define GETID(n,A) in>>n; if (n>0) n--; else if (n<0) n+=A.size()
+//================================ parsing ==================================
 
-static void get_face ( GsInput& in, GsModel& m, int& vc, int& vt, int& vn )
+// Files are parsed directly from memory following the same token rules of GsInput
+// (with '#' comments and GsInput's default maximum token size), so that the result
+// is the same as reading them with GsInput.
+class ObjScanner
+{  public :
+	enum { MaxTok=128 };
+	const char* p;		// current position
+	const char* e;		// end of the data
+	char tok[MaxTok+1];	// last token read, null-terminated
+	GsInput::TokenType type; // type of the last token read
+
+   public :
+	ObjScanner ( const char* s, const char* end ) : p(s), e(end), type(GsInput::End) { tok[0]=0; }
+
+	GsInput::TokenType check ();
+	GsInput::TokenType get ();
+	float getf () { return get()==GsInput::Number? gs_atof(tok):0; }
+	int geti () { return get()==GsInput::Number? gs_atoi(tok):0; }
+	bool is ( const char* s ) const { return gs_compare(tok,s)==0; }
+	void skipline () { while ( p<e && *p++!='\n' ); }
+	void readline ( GsString& s ) { const char* s0=p; skipline(); s.len(int(p-s0)); memcpy(&s[0],s0,p-s0); }
+
+};
+
+// character classes of the C locale, as used by GsInput, without function calls:
+# define ISSPACE(c) ((c)==' ' || ((c)>='\t' && (c)<='\r'))
+# define ISDIGIT(c) ((c)>='0' && (c)<='9')
+# define ISALPHA(c) (((c)>='a' && (c)<='z') || ((c)>='A' && (c)<='Z'))
+
+GsInput::TokenType ObjScanner::check ()
 {
-	vc = vt = vn = -1;
-	GETID(vc,m.V);
+	while ( p<e )
+	{	if ( *p=='#' ) { while ( p<e && *p!='\n' ) p++; }
+		else if ( ISSPACE(*p) ) p++;
+		else break;
+	}
+	if ( p==e ) return GsInput::End;
 
-	if ( in.check()==GsInput::Delimiter ) // if not had only: vc
-	{	in.get(); // get /
-		if ( in.check()==GsInput::Number ) // get vt from: vc/vt or vc/vt/vn
-		{	GETID(vt,m.T);
+	char c = *p;
+	if ( (c=='.'||c=='+'||c=='-') && p+1<e && ISDIGIT(p[1]) ) return GsInput::Number;
+	if ( (c=='+'||c=='-') && p+2<e && p[1]=='.' && ISDIGIT(p[2]) ) return GsInput::Number; // as in "-.5"
+	if ( ISDIGIT(c) ) return GsInput::Number;
+	if ( ISALPHA(c) || c=='"' || c=='_' ) return GsInput::String;
+	return GsInput::Delimiter;
+}
+
+static char getescape ( char c )
+{
+	switch ( c )
+	{	case 'n' : return '\n';
+		case 't' : return '\t';
+		case '\n': return '\\';
+		default  : return c;
+	}
+}
+
+GsInput::TokenType ObjScanner::get ()
+{
+	int i=0;
+	type = check();
+
+	if ( type==GsInput::String )
+	{	if ( *p=='"' ) // inside quotes mode
+		{	for ( p++; i<MaxTok && p<e; i++ )
+			{	char c = *p++;
+				if ( c=='\\' ) { if ( p==e ) break; c=getescape(*p++); }
+				if ( c=='"' ) break;
+				tok[i]=c;
+			}
 		}
-		if ( in.check()==GsInput::Delimiter ) // get vn from: vc/vt/vn or vc//vn
-		{	in.get(); // get /
-			GETID(vn,m.N);
+		else // normal mode, GsInput drops the char following a token of maximum size
+		{	while ( i<MaxTok && p<e && ( ISALPHA(*p) || ISDIGIT(*p) || *p=='_' ) ) tok[i++]=*p++;
+			if ( i==MaxTok && p<e ) p++;
+		}
+	}
+	else if ( type==GsInput::Number )
+	{	bool pnt=false, exp=false;
+		for ( tok[i++]=*p++; i<MaxTok && p<e; i++ )
+		{	char c = *p;
+			if ( !ISDIGIT(c) )
+			{	if ( c=='e' ) c='E';
+				if ( !pnt && c=='.' ) pnt=true;
+				else if ( pnt && c=='.' ) { p++; break; } // GsInput also drops the second point
+				else if ( !exp && c=='E' ) exp=pnt=true;
+				else if ( (c=='+'||c=='-') && tok[i-1]=='E' ); // ok
+				else break;
+			}
+			tok[i]=c; p++;
 		}
 	}
+	else if ( type==GsInput::Delimiter )
+	{	tok[i++]=*p++;
+	}
+
+	tok[i]=0;
+	return type;
 }
 
-static GsColor read_color ( GsInput& in )
+//================================ materials ==================================
+
+static GsColor read_color ( ObjScanner& in )
 {
-	float r, g, b;
-	in >> r >> g >> b;
+	float r = in.getf();
+	float g = in.getf();
+	float b = in.getf();
 	GsColor c(r,g,b);
 	return c;
 }
@@ -59,53 +147,53 @@ static void read_materials ( GsModel& model,
 							 const GsStrings& paths )
 {
 	GsString fullf;
-	GsInput in;
-	in.lowercase(false);
+	GsMappedFile mf;
 
 	for ( int i=0; i<=paths.size(); i++ )
 	{	fullf = i<paths.size()? paths[i] : "";
 		fullf << file;
 		GS_TRACE3 ( "Opening material file ["<<fullf<<"]..." );
-		in.init ( fopen(fullf,"rt") );
-		if ( in.valid() ) break;
+		if ( mf.open(fullf) ) break;
 	}
-	if ( !in.valid() ) { GS_TRACE3 ( "Could not open!"); return; } // could not get materials
-	in.commentchar ('#');
+	if ( !mf.valid() ) { GS_TRACE3 ( "Could not open!"); return; } // could not get materials
 
-	while ( !in.end() )
-	{	in.get();
-		if ( in.ltoken()=="newmtl" )
+	ObjScanner in ( mf.data(), mf.data()+mf.size() );
+	while ( in.get()!=GsInput::End )
+	{	if ( in.is("newmtl") )
 		{	M.push().init();
 			Td.push()=0;
 			in.get();
-			GS_TRACE3 ( "new material: "<<in.ltoken() );
-			mnames.push ( in.ltoken() );
+			GS_TRACE3 ( "new material: "<<in.tok );
+			mnames.push ( in.tok );
+		}
+		else if ( M.empty() ) // no material defined yet
+		{	in.skipline();
 		}
-		else if ( in.ltoken()=="Ka" )
+		else if ( in.is("Ka") )
 		{	M.top().ambient = read_color ( in );
 		}
-		else if ( in.ltoken()=="Kd" )
+		else if ( in.is("Kd") )
 		{	M.top().diffuse = read_color ( in );
 		}
-		else if ( in.ltoken()=="Ks" )
+		else if ( in.is("Ks") )
 		{	M.top().specular = read_color ( in );
 		}
-		else if ( in.ltoken()=="Ke" ) // not sure if this one exists
+		else if ( in.is("Ke") ) // not sure if this one exists
 		{	M.top().emission = read_color ( in );
 		}
-		else if ( in.ltoken()=="Ns" )
-		{	in >> M.top().shininess;
+		else if ( in.is("Ns") )
+		{	M.top().shininess = in.getf();
 		}
-		else if ( in.ltoken()=="d" || in.ltoken()=="Tr" )
+		else if ( in.is("d") || in.is("Tr") )
 		{	int a = int(in.getf()*255.0f);
-			//if ( in.ltoken()[0]=='T' ) a=255-a;
+			//if ( in.tok[0]=='T' ) a=255-a;
 			M.top().diffuse.a = (gsbyte)(GS_BOUND(a,0,255));
 		}
-		else if ( in.ltoken()=="illum" )
+		else if ( in.is("illum") )
 		{	int i = in.geti();
 			if ( i==1 ) M.top().specular = GsColor::black;
 		}
-		else if ( in.ltoken()=="map_Kd" || in.ltoken()=="map_Ka" ) // diffuse texture
+		else if ( in.is("map_Kd") || in.is("map_Ka") ) // diffuse texture
 		{	GsString txfile;
 			in.readline(txfile);
 			txfile.trim();
@@ -121,74 +209,72 @@ static void read_materials ( GsModel& model,
 	}
 }
 
-static bool process_line ( GsInput& in, GsModel& m, GsArray<int>& Fm,
-						   GsStrings& paths, GsStrings& mnames, int& curmtl,
-						   GsArray<int>& va, GsArray<int>& ta, GsArray<int>& na,
-						   GsArray<GsModel::Texture*>& Td )
+//================================ obj lines ==================================
+
+enum ObjKey { ObjEmpty, ObjV, ObjVn, ObjVt, ObjF, ObjOther };
+
+static ObjKey get_key ( ObjScanner& in )
 {
 	in.get();
+	GS_TRACE1 ( "Processing: ["<<in.tok<<"]" );
+	const char* t = in.tok; // same as comparing with gs_compare()
+	if ( t[0]==0 ) return ObjEmpty;
+	if ( t[0]=='v' || t[0]=='V' )
+	{	if ( t[1]==0 ) return ObjV;
+		if ( t[2]==0 && ( t[1]=='n' || t[1]=='N' ) ) return ObjVn;
+		if ( t[2]==0 && ( t[1]=='t' || t[1]=='T' ) ) return ObjVt;
+	}
+	else if ( ( t[0]=='f' || t[0]=='F' ) && t[1]==0 ) return ObjF;
+	return ObjOther;
+}
 
-	GS_TRACE1 ( "Processing: ["<<in.ltoken()<<"] (len="<<in.ltoken().len()<<")" );
+# define GETID(n,s) n=in.geti(); if (n>0) n--; else if (n<0) n+=s
 
-	if ( in.ltoken().len()==0 ) return true;
+static void get_face ( ObjScanner& in, int nv, int nt, int nn, int& vc, int& vt, int& vn )
+{
+	vc = vt = vn = -1;
+	GETID(vc,nv);
 
-	if ( in.ltoken()=="v" ) // v x y z [w]
-	{	GS_TRACE1 ( "v" );
-		m.V.push();
-		in >> m.V.top();
-	}
-	else if ( in.ltoken()=="vn" ) // vn i j k
-	{	GS_TRACE1 ( "vn" );
-		m.N.push();
-		in >> m.N.top();
-	}
-	else if ( in.ltoken()=="vt" ) // vt u v [w]
-	{	GS_TRACE1 ( "vt" );
-		m.T.push();
-		in >> m.T.top();
-	}
-	else if ( in.ltoken()=="f" ) // f v/t/n v/t/n v/t/n (or v/t or v//n or v)
-	{	GS_TRACE1 ( "f" );
-		int i=0;
-		va.size(0); ta.size(0); na.size(0);
-		while ( true )
-		{	if ( in.get()==GsInput::End ) break;
-			in.unget();
-			get_face ( in, m, va.push(), ta.push(), na.push() );
+	if ( in.check()==GsInput::Delimiter ) // if not had only: vc
+	{	in.get(); // get /
+		if ( in.check()==GsInput::Number ) // get vt from: vc/vt or vc/vt/vn
+		{	GETID(vt,nt);
 		}
-		if ( va.size()<3 ) return false;
-		for ( i=2; i<va.size(); i++ ) // triangulate
-		{	m.F.push().set ( va[0], va[i-1], va[i] );
-			Fm.push() = curmtl;
-			if ( ta[0]>=0 && ta[1]>=0 && ta[i]>=0 )
-				m.Ft.push().set ( ta[0], ta[i-1], ta[i] );
-			if ( na[0]>=0 && na[1]>=0 && na[i]>=0 )
-				m.Fn.push().set ( na[0], na[i-1], na[i] );
+		if ( in.check()==GsInput::Delimiter ) // get vn from: vc/vt/vn or vc//vn
+		{	in.get(); // get /
+			GETID(vn,nn);
 		}
 	}
-	else if ( in.ltoken()=="s" ) // smoothing groups not loaded
+}
+
+// processes the lines which are not vertex or face definitions:
+static void process_line ( ObjScanner& in, GsModel& m, GsStrings& paths, GsStrings& mnames,
+						   int& curmtl, GsArray<GsModel::Texture*>& Td )
+{
+	get_key ( in );
+
+	if ( in.is("s") ) // smoothing groups not loaded
 	{	GS_TRACE1 ( "s" );
 		in.get();
-		GS_TRACE2 ( "s: "<<in.ltoken() );
+		GS_TRACE2 ( "s: "<<in.tok );
 	}
-	else if ( in.ltoken()=="o" ) // object name
+	else if ( in.is("o") ) // object name
 	{	GS_TRACE1 ( "o" );
 		in.get();
-		m.name = in.ltoken();
+		m.name = in.tok;
 	}
-	else if ( in.ltoken()=="usemap" ) // usemap name/off
+	else if ( in.is("usemap") ) // usemap name/off
 	{	GS_TRACE1 ( "usemap" );
 	}
-	else if ( in.ltoken()=="usemtl" || in.ltoken()=="g" ) // usemtl name
+	else if ( in.is("usemtl") || in.is("g") ) // usemtl name
 	{	GS_TRACE1 ( "usemtl" );
-		in.get ();
-		if ( in.ltype()!=GsInput::End )
-		{	int i = mnames.lsearch ( in.ltoken() );
+		if ( in.get()!=GsInput::End )
+		{	int i = mnames.lsearch ( in.tok );
 			if ( i>=0 ) curmtl=i;
 		}
-		GS_TRACE1 ( "curmtl = " << curmtl << " (" << in.ltoken() << ")" );
+		GS_TRACE1 ( "curmtl = " << curmtl << " (" << in.tok << ")" );
 	}
-	else if ( in.ltoken()=="mtllib" ) // mtllib file1 file2 ...
+	else if ( in.is("mtllib") ) // mtllib file1 file2 ...
 	{	GS_TRACE1 ( "mtllib" );
 		GsString token, file;
 		while ( in.check()==GsInput::String )
@@ -200,17 +286,117 @@ static bool process_line ( GsInput& in, GsModel& m, GsArray<int>& Fm,
 			read_materials ( m, m.M, Td, mnames, file, paths );
 		}
 	}
+}
 
-	return true;
+//================================ chunks ==================================
+
+// Large files are split in blocks of lines parsed in parallel. Vertex lines are counted
+// first, so that each block can store its vertices directly in the model and resolve
+// relative indices, and then each block keeps its own faces, which are concatenated at
+// the end together with the processing of all other lines in their original order.
+struct ObjChunk
+{	const char *s, *e;			// block of lines
+	int nv, nn, nt;				// number of v, vn and vt lines in the block
+	int v, n, t;				// number of v, vn and vt lines before the block
+	GsArray<GsModel::Face> F, Ft, Fn; // triangles of the block
+	GsArray<const char*> L;		// other lines, to be processed after parsing
+	GsArray<int> Lf;			// number of triangles in F before each line in L
+	bool ok;					// false if a face with less than 3 vertices was found
+};
+
+struct ObjData
+{	GsModel* m;
+	ObjChunk* chunks;
+};
+
+static inline const char* next_line ( const char* l, const char* e )
+{
+	const char* le = (const char*) memchr ( l, '\n', e-l );
+	return le? le+1 : e;
+}
+
+static void count_lines ( int i0, int i1, void* udata )
+{
+	ObjData& d = *((ObjData*)udata);
+	for ( int i=i0; i<i1; i++ )
+	{	ObjChunk& c = d.chunks[i];
+		for ( const char* l=c.s; l<c.e; )
+		{	const char* le = next_line ( l, c.e );
+			ObjScanner in ( l, le );
+			switch ( get_key(in) )
+			{	case ObjV : c.nv++; break;
+				case ObjVn : c.nn++; break;
+				case ObjVt : c.nt++; break;
+				default : break;
+			}
+			l = le;
+		}
+	}
 }
 
-bool GsModel::load_obj ( const char* file )
+static void parse_lines ( int i0, int i1, void* udata )
 {
-	GsInput in ( fopen(file,"r") );
-	if ( !in.valid() ) return false;
+	ObjData& d = *((ObjData*)udata);
+	GsModel& m = *d.m;
+	GsArray<int> va(0,8), ta(0,8), na(0,8); // buffers
+	for ( int i=i0; i<i1; i++ )
+	{	ObjChunk& c = d.chunks[i];
+		GsVec* V = m.V.pt()+c.v;
+		GsVec* N = m.N.pt()+c.n;
+		GsVec2* T = m.T.pt()+c.t;
+		int nv=c.v, nn=c.n, nt=c.t; // current sizes of V, N and T
+		for ( const char* l=c.s; l<c.e; )
+		{	const char* le = next_line ( l, c.e );
+			ObjScanner in ( l, le );
+			switch ( get_key(in) )
+			{	case ObjEmpty : break;
+
+				case ObjV : // v x y z [w]
+				{	GsVec& p = V[nv++-c.v];
+					p.x=in.getf(); p.y=in.getf(); p.z=in.getf();
+				} break;
+
+				case ObjVn : // vn i j k
+				{	GsVec& p = N[nn++-c.n];
+					p.x=in.getf(); p.y=in.getf(); p.z=in.getf();
+				} break;
+
+				case ObjVt : // vt u v [w]
+				{	GsVec2& p = T[nt++-c.t];
+					p.x=in.getf(); p.y=in.getf();
+				} break;
+
+				case ObjF : // f v/t/n v/t/n v/t/n (or v/t or v//n or v)
+				{	va.size(0); ta.size(0); na.size(0);
+					while ( in.check()!=GsInput::End )
+					{	get_face ( in, nv, nt, nn, va.push(), ta.push(), na.push() );
+					}
+					if ( va.size()<3 ) { c.ok=false; return; }
+					for ( int j=2; j<va.size(); j++ ) // triangulate
+					{	c.F.push().set ( va[0], va[j-1], va[j] );
+						if ( ta[0]>=0 && ta[1]>=0 && ta[j]>=0 )
+							c.Ft.push().set ( ta[0], ta[j-1], ta[j] );
+						if ( na[0]>=0 && na[1]>=0 && na[j]>=0 )
+							c.Fn.push().set ( na[0], na[j-1], na[j] );
+					}
+				} break;
+
+				case ObjOther :
+				{	c.L.push() = l;
+					c.Lf.push() = c.F.size();
+				} break;
+			}
+			l = le;
+		}
+	}
+}
 
-	in.commentchar ( '#' );
-	in.lowercase ( false );
+//================================ load_obj ==================================
+
+bool GsModel::load_obj ( const char* file, int nt )
+{
+	GsMappedFile mf;
+	if ( !mf.open(file) ) return false;
 
 	GsString path=file;
 	GsString fname;
@@ -224,21 +410,65 @@ bool GsModel::load_obj ( const char* file )
 	name = fname;
 	remove_extension ( name );
 
-	GsString line;
+	// split the file in blocks of lines of at least 1MB:
+	const char* data = mf.data();
+	const char* end = data+mf.size();
+	if ( nt<=0 ) nt = gs_hardware_threads();
+	int i, nc = int ( GS_MIN ( (size_t)nt, mf.size()/(1<<20)+1 ) );
+	ObjChunk* chunks = new ObjChunk[nc];
+	for ( i=0; i<nc; i++ )
+	{	ObjChunk& c = chunks[i];
+		c.s = i==0? data : chunks[i-1].e;
+		c.e = i==nc-1? end : data+mf.size()/nc*(i+1);
+		if ( c.e<c.s ) c.e=c.s; else if ( c.e<end && c.e>data && c.e[-1]!='\n' ) c.e=next_line(c.e,end);
+		c.nv = c.nn = c.nt = 0;
+		c.ok = true;
+	}
+	GS_TRACE1 ( "Parsing "<<nc<<" block(s)..." );
+
+	ObjData d;
+	d.m = this;
+	d.chunks = chunks;
+	gs_parallel_for ( nc, nt, count_lines, &d );
+	int nv=0, nn=0, ntx=0;
+	for ( i=0; i<nc; i++ )
+	{	chunks[i].v=nv; nv+=chunks[i].nv;
+		chunks[i].n=nn; nn+=chunks[i].nn;
+		chunks[i].t=ntx; ntx+=chunks[i].nt;
+	}
+	V.size ( nv );
+	N.size ( nn );
+	T.size ( ntx );
+	gs_parallel_for ( nc, nt, parse_lines, &d );
+
+	// concatenate faces and process other lines in order:
 	GsStrings mtlnames;
 	GsArray<int> Fm; // materials per face
-	GsArray<int> v(0,8), t(0,8), n(0,8); // buffers
 	GsArray<GsModel::Texture*> Td; // diffuse textures per material
-
-	GsInput lineinp;
-	lineinp.commentchar('#');
-	while ( in.readline(line)>=0 )
-	{	lineinp.init ( line );
-		if ( !process_line(lineinp,*this,Fm,paths,mtlnames,curmtl,v,t,n,Td) ) return false;
+	int nf=0, nft=0, nfn=0;
+	bool ok=true;
+	for ( i=0; i<nc; i++ )
+	{	nf+=chunks[i].F.size(); nft+=chunks[i].Ft.size(); nfn+=chunks[i].Fn.size();
+		if ( !chunks[i].ok ) ok=false;
+	}
+	if ( !ok ) { delete[] chunks; init(); return false; }
+	F.capacity ( nf ); Ft.capacity ( nft ); Fn.capacity ( nfn ); Fm.capacity ( nf );
+	for ( i=0; i<nc; i++ )
+	{	ObjChunk& c = chunks[i];
+		for ( int k=0; k<c.L.size(); k++ )
+		{	while ( Fm.size()<F.size()+c.Lf[k] ) Fm.push()=curmtl;
+			ObjScanner in ( c.L[k], next_line(c.L[k],end) );
+			process_line ( in, *this, paths, mtlnames, curmtl, Td );
+		}
+		F.push ( c.F );
+		Ft.push ( c.Ft );
+		Fn.push ( c.Fn );
+		while ( Fm.size()<F.size() ) Fm.push()=curmtl;
 	}
+	delete[] chunks;
 
 	define_groups ( Fm, &mtlnames );
-	for ( int i=0; i<G.size(); i++) G[i].dmap = Td[i]; 
+	for ( i=0; i<G.size(); i++) G[i].dmap = Td[i];
 
 	order_transparent_materials ();
 	validate();
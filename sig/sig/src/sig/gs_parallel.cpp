@@ -0,0 +1,185 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <sig/gs_parallel.h>
+
+//============================= gs_parallel ==========================
+
+int gs_hardware_threads ()
+ {
+   unsigned n = std::thread::hardware_concurrency(); // may return 0 if not computable
+   return n>0? (int)n : 1;
+ }
+
+void gs_parallel_for ( int n, int nt, void (*f)(int i0,int i1,void* udata), void* udata )
+ {
+   if ( n<=0 ) return;
+   if ( nt<=0 ) nt = gs_hardware_threads();
+   if ( nt>n ) nt = n;
+   if ( nt==1 ) { f(0,n,udata); return; }
+
+   std::thread* th = new std::thread[nt-1];
+   for ( int t=1; t<nt; t++ ) // intervals are balanced so that sizes differ by at most 1
+	{ th[t-1] = std::thread ( f, int(int64_t(n)*t/nt), int(int64_t(n)*(t+1)/nt), udata );
+	}
+   f ( 0, n/nt, udata );
+   for ( int t=1; t<nt; t++ ) th[t-1].join();
+   delete[] th;
+ }
+
+//============================= GsThreadPool ==========================
+
+struct GsThreadPool::Data
+ { struct Range { std::mutex m; int lo, hi; }; // tasks still to be processed by a thread
+   int nt;
+   std::thread* workers;
+   Range* ranges;
+   std::mutex m;
+   std::condition_variable start, done;
+   int job;		 // incremented at each run to wake up the workers
+   int working;	 // workers still processing the current job
+   bool quit;
+   int chunk;
+   void (*f)(int,int,void*);
+   void* udata;
+   Data ( int n );
+  ~Data ();
+   bool take ( int t, int& i0, int& i1 );
+   bool steal ( int t );
+   void process ( int t );
+   void worker ( int t );
+ };
+
+GsThreadPool::Data::Data ( int n )
+ {
+   nt = n;
+   ranges = new Range[nt];
+   for ( int t=0; t<nt; t++ ) ranges[t].lo=ranges[t].hi=0;
+   job = working = 0;
+   quit = false;
+   chunk = 1;
+   f = 0;
+   udata = 0;
+   workers = nt>1? new std::thread[nt-1] : 0;
+   for ( int t=1; t<nt; t++ ) workers[t-1] = std::thread ( &Data::worker, this, t );
+ }
+
+GsThreadPool::Data::~Data ()
+ {
+   { std::lock_guard<std::mutex> lock(m);
+	 quit = true;
+   }
+   start.notify_all ();
+   for ( int t=1; t<nt; t++ ) workers[t-1].join();
+   delete[] workers;
+   delete[] ranges;
+ }
+
+// takes a chunk from the front of the range of thread t
+bool GsThreadPool::Data::take ( int t, int& i0, int& i1 )
+ {
+   Range& r = ranges[t];
+   std::lock_guard<std::mutex> lock(r.m);
+   if ( r.lo>=r.hi ) return false;
+   i0 = r.lo;
+   i1 = r.lo = GS_MIN ( r.lo+chunk, r.hi );
+   return true;
+ }
+
+// moves to thread t the second half of the largest range among the other threads
+bool GsThreadPool::Data::steal ( int t )
+ {
+   for (;;)
+	{ int v=-1, vsize=0;
+	  for ( int k=1; k<nt; k++ )
+	   { int u = (t+k)%nt;
+		 std::lock_guard<std::mutex> lock(ranges[u].m);
+		 int size = ranges[u].hi-ranges[u].lo;
+		 if ( size>vsize ) { v=u; vsize=size; }
+	   }
+	  if ( v<0 ) return false;
+
+	  int lo, hi;
+	  { std::lock_guard<std::mutex> lock(ranges[v].m);
+		Range& r = ranges[v];
+		if ( r.lo>=r.hi ) continue; // emptied meanwhile, look again
+		hi = r.hi;
+		lo = r.hi = r.lo+(r.hi-r.lo)/2; // if a single task remains it is stolen
+	  }
+	  std::lock_guard<std::mutex> lock(ranges[t].m);
+	  ranges[t].lo = lo;
+	  ranges[t].hi = hi;
+	  return true;
+	}
+ }
+
+void GsThreadPool::Data::process ( int t )
+ {
+   int i0, i1;
+   do { while ( take(t,i0,i1) ) { for ( int i=i0; i<i1; i++ ) f(i,t,udata); }
+	  } while ( steal(t) );
+ }
+
+void GsThreadPool::Data::worker ( int t )
+ {
+   int lastjob = 0;
+   for (;;)
+	{ { std::unique_lock<std::mutex> lock(m);
+		start.wait ( lock, [&]{ return quit || job!=lastjob; } );
+		if ( quit ) return;
+		lastjob = job;
+	  }
+	  process ( t );
+	  std::lock_guard<std::mutex> lock(m);
+	  if ( --working==0 ) done.notify_one();
+	}
+ }
+
+GsThreadPool::GsThreadPool ( int nt )
+ {
+   _data = new Data ( nt>0? nt : gs_hardware_threads() );
+ }
+
+GsThreadPool::~GsThreadPool ()
+ {
+   delete _data;
+ }
+
+int GsThreadPool::threads () const
+ {
+   return _data->nt;
+ }
+
+void GsThreadPool::run ( int n, void (*f)(int i,int thread,void* udata), void* udata, int chunk )
+ {
+   if ( n<=0 ) return;
+   Data& d = *_data;
+   if ( d.nt==1 ) { for ( int i=0; i<n; i++ ) f(i,0,udata); return; }
+
+   d.f = f;
+   d.udata = udata;
+   d.chunk = chunk>0? chunk:1;
+   for ( int t=0; t<d.nt; t++ ) // the workers are waiting, no locking needed
+	{ d.ranges[t].lo = int(int64_t(n)*t/d.nt);
+	  d.ranges[t].hi = int(int64_t(n)*(t+1)/d.nt);
+	}
+
+   { std::lock_guard<std::mutex> lock(d.m);
+	 d.working = d.nt-1;
+	 d.job++;
+   }
+   d.start.notify_all ();
+   d.process ( 0 );
+
+   std::unique_lock<std::mutex> lock(d.m);
+   d.done.wait ( lock, [&]{ return d.working==0; } );
+ }
+
+//============================= EOF ===================================
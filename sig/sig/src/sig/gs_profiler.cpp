@@ -0,0 +1,286 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <mutex>
+# include <sig/gs_profiler.h>
+
+//================================= Data ===============================
+
+std::atomic<bool> GsProfiler::_enabled ( false );
+uint64_t GsProfiler::_counters[GsProfiler::NumCounters];
+
+static std::mutex Mutex;					// protects the frames and the thread indices
+static GsArray<GsProfiler::Frame*> Ring;	// finished frames, from Ring[First], used as a circular buffer
+static int First=0, Count=0;
+static GsProfiler::Frame* Current=0;		// frame being recorded
+static int NextNumber=0;					// frame numbers are never reused, even after re-enabling
+static double T0=0;							// time when the profiler was enabled
+static int NumThreads=0;
+static thread_local int ThreadIndex=-1;
+static thread_local int Depth=0;			// number of open scopes in the thread
+
+static int thread_index () // must be called with Mutex locked
+{
+	if ( ThreadIndex<0 ) ThreadIndex=NumThreads++;
+	return ThreadIndex;
+}
+
+static void start_frame ( GsProfiler::Frame* f ) // must be called with Mutex locked
+{
+	f->number = NextNumber++;
+	f->start = f->end = gs_time()-T0;
+	f->thread = thread_index();
+	f->scopes.size(0);
+	f->gpu.size(0);
+	for ( int c=0; c<GsProfiler::NumCounters; c++ ) f->counters[c]=0;
+}
+
+// returns the finished or current frame of number n, or null if not in the buffer:
+static GsProfiler::Frame* find_frame ( int n ) // must be called with Mutex locked
+{
+	if ( !Current ) return 0;
+	if ( n==Current->number ) return Current;
+	int i = Count-(Current->number-n);
+	if ( i<0 || i>=Count ) return 0;
+	return Ring[(First+i)%Ring.size()];
+}
+
+static void clear_frames ()
+{
+	while ( Ring.size() ) delete Ring.pop();
+	delete Current;
+	Current=0;
+	First=Count=0;
+}
+
+double GsProfiler::Frame::gpu_ms () const
+{
+	double ms=0;
+	for ( int i=0; i<gpu.size(); i++ ) ms+=gpu[i].ms;
+	return ms;
+}
+
+//============================= GsProfiler ==========================
+
+void GsProfiler::enable ( bool b, int frames )
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	clear_frames ();
+	_enabled = b;
+	if ( !b ) return;
+	Ring.size ( frames>0? frames:1 );
+	for ( int i=0; i<Ring.size(); i++ ) Ring[i]=0;
+	for ( int c=0; c<NumCounters; c++ ) _counters[c]=0;
+	T0 = gs_time();
+	Current = new Frame;
+	start_frame ( Current );
+}
+
+void GsProfiler::next_frame ()
+{
+	if ( !_enabled ) return;
+	std::lock_guard<std::mutex> lock(Mutex);
+	if ( !Current ) return; // disabled by another thread
+	Frame* f = Current;
+	f->end = gs_time()-T0;
+	for ( int c=0; c<NumCounters; c++ ) { f->counters[c]=_counters[c]; _counters[c]=0; }
+
+	// when the buffer is full the oldest frame is replaced and reused as the new one:
+	if ( Count<Ring.size() )
+	{	Ring[(First+Count)%Ring.size()] = f;
+		Count++;
+		Current = new Frame;
+	}
+	else
+	{	Current = Ring[First];
+		Ring[First] = f;
+		First = (First+1)%Ring.size();
+	}
+	start_frame ( Current );
+}
+
+int GsProfiler::frame_number ()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Current? Current->number : -1;
+}
+
+int GsProfiler::begin_scope ( const char* name, int& f )
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if ( !Current ) return -1;
+	Scope& s = Current->scopes.push();
+	s.name = name;
+	s.start = gs_time()-T0;
+	s.end = -1; // still open
+	s.depth = Depth++;
+	s.thread = thread_index();
+	f = Current->number;
+	return Current->scopes.size()-1;
+}
+
+void GsProfiler::end_scope ( int f, int i )
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	Depth--;
+	Frame* fr = find_frame ( f );
+	if ( fr && i<fr->scopes.size() ) fr->scopes[i].end = gs_time()-T0;
+}
+
+void GsProfiler::gpu_time ( int f, const char* name, double ms )
+{
+	if ( !_enabled ) return;
+	std::lock_guard<std::mutex> lock(Mutex);
+	Frame* fr = find_frame ( f );
+	if ( !fr ) return;
+	GpuTime& g = fr->gpu.push();
+	g.name = name;
+	g.ms = ms;
+}
+
+int GsProfiler::frames ()
+{
+	return Count;
+}
+
+const GsProfiler::Frame& GsProfiler::frame ( int i )
+{
+	return *Ring[(First+i)%Ring.size()];
+}
+
+int GsProfiler::slowest_frame ()
+{
+	int s=-1;
+	for ( int i=0; i<Count; i++ ) if ( s<0 || frame(i).ms()>frame(s).ms() ) s=i;
+	return s;
+}
+
+const char* GsProfiler::counter_name ( Counter c )
+{
+	switch ( c )
+	{	case DrawCalls: return "draw calls";
+		case Triangles: return "triangles";
+		case BytesUploaded: return "bytes uploaded";
+		case ProgramSwitches: return "program switches";
+		default: return "";
+	}
+}
+
+void GsProfiler::summary ( int i, GsString& s )
+{
+	s.len(0);
+	std::lock_guard<std::mutex> lock(Mutex);
+	if ( i<0 || i>=Count ) return;
+	const Frame& f = frame(i);
+	char buf[256];
+
+	double min=f.ms(), max=f.ms(), sum=0;
+	for ( int k=0; k<Count; k++ )
+	{	double ms = frame(k).ms();
+		sum+=ms; if ( ms<min ) min=ms; if ( ms>max ) max=ms;
+	}
+	snprintf ( buf, sizeof(buf), "frame %d: %.2f ms\n%d frames: avg %.2f min %.2f max %.2f ms\n",
+			   f.number, f.ms(), Count, sum/Count, min, max );
+	s << buf;
+	for ( int c=0; c<NumCounters; c++ )
+	{	snprintf ( buf, sizeof(buf), "%s: %llu\n", counter_name(Counter(c)), (unsigned long long)f.counters[c] );
+		s << buf;
+	}
+
+	// scopes with the same name and depth are added, in the order they first appear:
+	GsArray<Scope> sum_scopes;
+	GsArray<int> calls;
+	for ( int k=0; k<f.scopes.size(); k++ )
+	{	const Scope& sc = f.scopes[k];
+		if ( sc.end<0 ) continue;
+		int j;
+		for ( j=0; j<sum_scopes.size(); j++ ) if ( sum_scopes[j].name==sc.name && sum_scopes[j].depth==sc.depth ) break;
+		if ( j==sum_scopes.size() ) { sum_scopes.push()=sc; sum_scopes.top().start=sum_scopes.top().end=0; calls.push()=0; }
+		sum_scopes[j].end += sc.end-sc.start;
+		calls[j]++;
+	}
+	if ( sum_scopes.size() ) s << "cpu:\n";
+	for ( int j=0; j<sum_scopes.size(); j++ )
+	{	snprintf ( buf, sizeof(buf), "%*s%s: %.3f ms (%d)\n", 2*sum_scopes[j].depth+1, "",
+				   sum_scopes[j].name, 1000.0*sum_scopes[j].end, calls[j] );
+		s << buf;
+	}
+
+	// gpu times with the same name are added:
+	GsArray<GpuTime> sum_gpu;
+	for ( int k=0; k<f.gpu.size(); k++ )
+	{	int j;
+		for ( j=0; j<sum_gpu.size(); j++ ) if ( sum_gpu[j].name==f.gpu[k].name ) break;
+		if ( j==sum_gpu.size() ) { sum_gpu.push()=f.gpu[k]; sum_gpu.top().ms=0; }
+		sum_gpu[j].ms += f.gpu[k].ms;
+	}
+	if ( sum_gpu.size() )
+	{	snprintf ( buf, sizeof(buf), "gpu: %.3f ms\n", f.gpu_ms() );
+		s << buf;
+	}
+	for ( int j=0; j<sum_gpu.size(); j++ )
+	{	snprintf ( buf, sizeof(buf), "  %s: %.3f ms\n", sum_gpu[j].name, sum_gpu[j].ms );
+		s << buf;
+	}
+}
+
+// writes name as a json string:
+static void put_name ( FILE* fp, const char* name )
+{
+	fputc ( '"', fp );
+	for ( const char* c=name? name:""; *c; c++ )
+	{	if ( *c=='"' || *c=='\\' ) fputc ( '\\', fp );
+		if ( (unsigned char)*c>=32 ) fputc ( *c, fp );
+	}
+	fputc ( '"', fp );
+}
+
+bool GsProfiler::export_trace ( const char* file )
+{
+	FILE* fp = fopen ( file, "wt" );
+	if ( !fp ) return false;
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	// times are in microseconds; gpu times use the track after the last thread:
+	const double us = 1000000.0;
+	int gputrack = NumThreads;
+	fprintf ( fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	for ( int t=0; t<=NumThreads; t++ )
+	{	fprintf ( fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", t );
+		if ( t==gputrack ) fprintf ( fp, "\"gpu\"}},\n" ); else fprintf ( fp, "\"thread %d\"}},\n", t );
+	}
+	for ( int i=0; i<Count; i++ )
+	{	const Frame& f = frame(i);
+		fprintf ( fp, "{\"name\":\"frame %d\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+				  f.number, f.thread, f.start*us, (f.end-f.start)*us );
+		for ( int k=0; k<f.scopes.size(); k++ )
+		{	const Scope& s = f.scopes[k];
+			if ( s.end<0 ) continue;
+			fprintf ( fp, "{\"name\":" );
+			put_name ( fp, s.name );
+			fprintf ( fp, ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+					  s.thread, s.start*us, (s.end-s.start)*us );
+		}
+		double ts = f.start*us;
+		for ( int k=0; k<f.gpu.size(); k++ )
+		{	fprintf ( fp, "{\"name\":" );
+			put_name ( fp, f.gpu[k].name );
+			fprintf ( fp, ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+					  gputrack, ts, f.gpu[k].ms*1000.0 );
+			ts += f.gpu[k].ms*1000.0;
+		}
+		for ( int c=0; c<NumCounters; c++ )
+		{	fprintf ( fp, "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%llu}},\n",
+					  counter_name(Counter(c)), f.start*us, (unsigned long long)f.counters[c] );
+		}
+	}
+	fprintf ( fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"sig\"}}\n]}\n" );
+	return fclose(fp)==0;
+}
+
+//================================ End of File =================================================
@@ -0,0 +1,248 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <mutex>
+# include <sig/gs_skinning.h>
+# include <sig/gs_parallel.h>
+
+# if defined(__SSE2__) || defined(_M_X64) // SSE2 is always available in 64 bits
+# define GS_SKINNING_SSE
+# include <xmmintrin.h>
+# endif
+
+//# define GS_USE_TRACE1 // packing
+# include <sig/gs_trace.h>
+
+// vertices are processed in blocks of 4, and a thread only receives a range if it has this many blocks:
+# define GS_SKINNING_MIN_BLOCKS 1024
+
+//============================= GsSkinning ==========================
+
+GsSkinning::GsSkinning ()
+ {
+   _nverts = _ninfs = 0;
+   _nthreads = 0;
+ }
+
+void GsSkinning::init ()
+ {
+   _groups.size(0); _vid.size(0); _j.size(0);
+   _w.size(0); _x.size(0); _y.size(0); _z.size(0); _nx.size(0); _ny.size(0); _nz.size(0);
+   _def.size(0);
+   _nverts = _ninfs = 0;
+ }
+
+void GsSkinning::begin ()
+ {
+   init ();
+ }
+
+void GsSkinning::add ( int v, int j, float w, const GsPnt& p, const GsVec& n )
+ {
+   Influence& d = _def.push();
+   d.v=v; d.j=j; d.w=w; d.p=p; d.n=n;
+ }
+
+void GsSkinning::end ()
+ {
+   int i, k, v, nv=0, maxn=0;
+   for ( i=0; i<_def.size(); i++ ) if ( _def[i].v>=nv ) nv=_def[i].v+1;
+
+   // count the influences of each vertex and list them in vertex order:
+   GsArray<int> count(nv), first(nv+1), order(_def.size());
+   count.setall(0);
+   for ( i=0; i<_def.size(); i++ ) count[_def[i].v]++;
+   first[0]=0;
+   for ( v=0; v<nv; v++ ) { first[v+1]=first[v]+count[v]; if ( count[v]>maxn ) maxn=count[v]; }
+   for ( i=0; i<_def.size(); i++ ) order[first[_def[i].v]++]=i;
+   for ( v=nv; v>0; v-- ) first[v]=first[v-1]; // restore the first indices
+   first[0]=0;
+
+   // create one group per number of influences, with a multiple of 4 vertices:
+   GsArray<int> nvn(maxn+1), gid(maxn+1);
+   nvn.setall(0);
+   for ( v=0; v<nv; v++ ) nvn[count[v]]++;
+   int tv=0, ti=0;
+   for ( k=1; k<=maxn; k++ )
+	{ if ( !nvn[k] ) continue;
+	  gid[k] = _groups.size();
+	  Group& g = _groups.push();
+	  g.n=k; g.nv=(nvn[k]+3)&~3; g.vi=tv; g.ii=ti;
+	  tv+=g.nv; ti+=g.nv*k;
+	  _nverts+=nvn[k]; _ninfs+=nvn[k]*k;
+	}
+
+   // pack influences, padding vertices have null weights:
+   _vid.size(tv); _vid.setall(-1);
+   _j.size(ti); _j.setall(0);
+   GsArray<float>* fa[7] = { &_w, &_x, &_y, &_z, &_nx, &_ny, &_nz };
+   for ( k=0; k<7; k++ ) { fa[k]->size(ti); fa[k]->setall(0); }
+   nvn.setall(0); // now used to count the vertices added to each group
+   for ( v=0; v<nv; v++ )
+	{ int n=count[v];
+	  if ( !n ) continue;
+	  const Group& g = _groups[gid[n]];
+	  int l = nvn[n]++;
+	  _vid[g.vi+l] = v;
+	  for ( k=0; k<n; k++ )
+	   { const Influence& d = _def[order[first[v]+k]];
+		 i = g.ii + k*g.nv + l;
+		 _j[i]=d.j; _w[i]=d.w;
+		 _x[i]=d.p.x*d.w;  _y[i]=d.p.y*d.w;  _z[i]=d.p.z*d.w;
+		 _nx[i]=d.n.x*d.w; _ny[i]=d.n.y*d.w; _nz[i]=d.n.z*d.w;
+	   }
+	}
+
+   _def.capacity(0);
+   GS_TRACE1 ( "Packed "<<_nverts<<" vertices and "<<_ninfs<<" influences in "<<_groups.size()<<" groups" );
+ }
+
+# ifdef GS_SKINNING_SSE
+// loads line r of 4 matrices transposed, so that ai has element i of the line of each matrix:
+static inline void load_lines ( const float* m[4], int r, __m128& a0, __m128& a1, __m128& a2, __m128& a3 )
+ {
+   a0=_mm_loadu_ps(m[0]+r); a1=_mm_loadu_ps(m[1]+r); a2=_mm_loadu_ps(m[2]+r); a3=_mm_loadu_ps(m[3]+r);
+   _MM_TRANSPOSE4_PS ( a0, a1, a2, a3 );
+ }
+
+static inline __m128 dot4 ( __m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 x, __m128 y, __m128 z, __m128 w )
+ {
+   return _mm_add_ps ( _mm_add_ps(_mm_mul_ps(a0,x),_mm_mul_ps(a1,y)), _mm_add_ps(_mm_mul_ps(a2,z),_mm_mul_ps(a3,w)) );
+ }
+
+static inline __m128 dot3 ( __m128 a0, __m128 a1, __m128 a2, __m128 x, __m128 y, __m128 z )
+ {
+   return _mm_add_ps ( _mm_add_ps(_mm_mul_ps(a0,x),_mm_mul_ps(a1,y)), _mm_mul_ps(a2,z) );
+ }
+# endif
+
+void GsSkinning::_apply ( int b1, int b2, const GsMat* gmats, GsPnt* V, GsVec* N ) const
+ {
+   int g, b, k, q;
+   for ( g=0; g<_groups.size(); g++ )
+	{ const Group& G = _groups[g];
+	  int gb1=G.vi/4, gb2=(G.vi+G.nv)/4;
+	  if ( gb1<b1 ) gb1=b1;
+	  if ( gb2>b2 ) gb2=b2;
+	  for ( b=gb1; b<gb2; b++ )
+	   { const int* vid = &_vid[b*4];
+		 const int ib = G.ii + b*4-G.vi; // first influence of the block
+		 # ifdef GS_SKINNING_SSE
+		 const float* m[4];
+		 __m128 a0, a1, a2, a3, x, y, z, w;
+		 __m128 px=_mm_setzero_ps(), py=px, pz=px, nx=px, ny=px, nz=px;
+		 for ( k=0; k<G.n; k++ )
+		  { const int i = ib + k*G.nv;
+			for ( q=0; q<4; q++ ) m[q]=gmats[_j[i+q]].e;
+			x=_mm_loadu_ps(&_x[i]); y=_mm_loadu_ps(&_y[i]); z=_mm_loadu_ps(&_z[i]); w=_mm_loadu_ps(&_w[i]);
+			load_lines ( m, 0, a0, a1, a2, a3 );
+			px = _mm_add_ps ( px, dot4(a0,a1,a2,a3,x,y,z,w) );
+			if ( N ) nx = _mm_add_ps ( nx, dot3(a0,a1,a2,_mm_loadu_ps(&_nx[i]),_mm_loadu_ps(&_ny[i]),_mm_loadu_ps(&_nz[i])) );
+			load_lines ( m, 4, a0, a1, a2, a3 );
+			py = _mm_add_ps ( py, dot4(a0,a1,a2,a3,x,y,z,w) );
+			if ( N ) ny = _mm_add_ps ( ny, dot3(a0,a1,a2,_mm_loadu_ps(&_nx[i]),_mm_loadu_ps(&_ny[i]),_mm_loadu_ps(&_nz[i])) );
+			load_lines ( m, 8, a0, a1, a2, a3 );
+			pz = _mm_add_ps ( pz, dot4(a0,a1,a2,a3,x,y,z,w) );
+			if ( N ) nz = _mm_add_ps ( nz, dot3(a0,a1,a2,_mm_loadu_ps(&_nx[i]),_mm_loadu_ps(&_ny[i]),_mm_loadu_ps(&_nz[i])) );
+		  }
+		 float r[6][4];
+		 _mm_storeu_ps(r[0],px); _mm_storeu_ps(r[1],py); _mm_storeu_ps(r[2],pz);
+		 if ( N )
+		  { __m128 l = _mm_add_ps ( _mm_add_ps(_mm_mul_ps(nx,nx),_mm_mul_ps(ny,ny)), _mm_mul_ps(nz,nz) );
+			l = _mm_sqrt_ps ( _mm_max_ps(l,_mm_set1_ps(1.0e-30f)) ); // null normals remain null
+			_mm_storeu_ps(r[3],_mm_div_ps(nx,l)); _mm_storeu_ps(r[4],_mm_div_ps(ny,l)); _mm_storeu_ps(r[5],_mm_div_ps(nz,l));
+		  }
+		 for ( q=0; q<4; q++ )
+		  { if ( vid[q]<0 ) break; // only the last block of a group may have padding
+			GsPnt& p=V[vid[q]]; p.x=r[0][q]; p.y=r[1][q]; p.z=r[2][q];
+			if ( N ) { GsVec& n=N[vid[q]]; n.x=r[3][q]; n.y=r[4][q]; n.z=r[5][q]; }
+		  }
+		 # else
+		 for ( q=0; q<4; q++ )
+		  { if ( vid[q]<0 ) break;
+			GsPnt p; GsVec n;
+			for ( k=0; k<G.n; k++ )
+			 { const int i = ib + k*G.nv + q;
+			   const GsMat& a = gmats[_j[i]];
+			   p.x += a.e11*_x[i] + a.e12*_y[i] + a.e13*_z[i] + a.e14*_w[i];
+			   p.y += a.e21*_x[i] + a.e22*_y[i] + a.e23*_z[i] + a.e24*_w[i];
+			   p.z += a.e31*_x[i] + a.e32*_y[i] + a.e33*_z[i] + a.e34*_w[i];
+			   if ( N )
+				{ n.x += a.e11*_nx[i] + a.e12*_ny[i] + a.e13*_nz[i];
+				  n.y += a.e21*_nx[i] + a.e22*_ny[i] + a.e23*_nz[i];
+				  n.z += a.e31*_nx[i] + a.e32*_ny[i] + a.e33*_nz[i];
+				}
+			 }
+			V[vid[q]] = p;
+			if ( N ) { if ( n.norm2()>0 ) n.normalize(); N[vid[q]] = n; }
+		  }
+		 # endif
+	   }
+	}
+ }
+
+struct GsSkinningCall { const GsSkinning* s; const GsMat* gmats; GsPnt* V; GsVec* N; int nb, nt; };
+
+// the threads are created once and shared by all skinnings, one call at a time:
+static std::mutex PoolMutex;
+static GsThreadPool& pool ()
+ {
+   static GsThreadPool p;
+   return p;
+ }
+
+void GsSkinning::_apply_thread ( int i, int /*thread*/, void* udata )
+ {
+   GsSkinningCall* c = (GsSkinningCall*)udata;
+   c->s->_apply ( int(int64_t(c->nb)*i/c->nt), int(int64_t(c->nb)*(i+1)/c->nt), c->gmats, c->V, c->N );
+ }
+
+void GsSkinning::apply ( const GsMat* gmats, GsPnt* V, GsVec* N ) const
+ {
+   int nb = _vid.size()/4;
+   int nt = _nthreads>0? _nthreads : gs_hardware_threads();
+   if ( nt>nb/GS_SKINNING_MIN_BLOCKS ) nt=nb/GS_SKINNING_MIN_BLOCKS;
+   if ( nt<=1 ) { _apply(0,nb,gmats,V,N); return; }
+
+   // if another thread is using the pool the mesh is skinned by the calling thread:
+   std::unique_lock<std::mutex> lock ( PoolMutex, std::try_to_lock );
+   if ( !lock.owns_lock() ) { _apply(0,nb,gmats,V,N); return; }
+   GsSkinningCall c = { this, gmats, V, N, nb, nt };
+   pool().run ( nt, _apply_thread, &c );
+ }
+
+void GsSkinning::get_influences ( GsArray<int>& counts, GsArray<int>& joints, GsArray<float>& weights ) const
+ {
+   int g, l, k, v, nv=0;
+   for ( l=0; l<_vid.size(); l++ ) if ( _vid[l]>=nv ) nv=_vid[l]+1;
+   counts.size(nv); counts.setall(0);
+   for ( g=0; g<_groups.size(); g++ )
+	{ const Group& G = _groups[g];
+	  for ( l=0; l<G.nv; l++ ) { v=_vid[G.vi+l]; if ( v>=0 ) counts[v]=G.n; }
+	}
+
+   GsArray<int> first(nv+1);
+   first[0]=0;
+   for ( v=0; v<nv; v++ ) first[v+1]=first[v]+counts[v];
+   joints.size(first[nv]);
+   weights.size(first[nv]);
+   for ( g=0; g<_groups.size(); g++ )
+	{ const Group& G = _groups[g];
+	  for ( l=0; l<G.nv; l++ )
+	   { v=_vid[G.vi+l];
+		 if ( v<0 ) continue;
+		 for ( k=0; k<G.n; k++ )
+		  { int i = G.ii + k*G.nv + l;
+			joints[first[v]+k] = _j[i];
+			weights[first[v]+k] = _w[i];
+		  }
+	   }
+	}
+ }
+
+//============================= EOF ===================================
@@ -224,7 +224,7 @@ void GsString::upper ()
 
 int GsString::atoi () const
  {
-   return ::atoi(_data);
+   return gs_atoi(_data);
  }
 
 long GsString::atol() const
@@ -234,7 +234,7 @@ long GsString::atol() const
 
 float GsString::atof () const
  {
-   return (float)::atof(_data);
+   return gs_atof(_data);
  }
 
 void GsString::trim ()
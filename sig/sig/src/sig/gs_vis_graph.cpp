@@ -5,11 +5,13 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <math.h>
 # include <sig/gs_vis_graph.h>
 # include <sig/gs_geo2.h>
+# include <sig/gs_parallel.h>
 
-# define GS_USE_TRACE1 // build
-# define GS_USE_TRACE2 // search
+//# define GS_USE_TRACE1 // build
+//# define GS_USE_TRACE2 // search
 # include <sig/gs_trace.h>
 
 //=== GsBuffer =======================================================================
@@ -20,6 +22,7 @@ GsVisGraph::GsVisGraph ()
 	_radius = 0;
 	_polygons = 0;
 	_vi = _vg = 0;
+	_eps = 0;
 }
 
 void GsVisGraph::init ()
@@ -29,6 +32,9 @@ void GsVisGraph::init ()
 	_bdisks.size(0);
 	_nodes.init();
 	_graph.init();
+	_vi = _vg = 0;
+	_grid.init ( 0, 0 );
+	_cellfirst.size(0); _celledges.size(0); _edges.size(0);
 }
 
 # define FOR_ALL_POL(p)			for ( int p=0; p<s; p++ ) 
@@ -37,7 +43,15 @@ void GsVisGraph::init ()
 # define FOR_ALL_VERTICES(p,P,v,vs)	FOR_ALL_POL(p) { FOR_ALL_PVTX(p,P,v,vs) {
 # define END_FOR }}
 
-void GsVisGraph::build ( GsPolygons* polys, float r, float dang )
+// data of the parallel computation of links in build():
+struct VisGraphLinks
+{	GsVisGraph* vg;
+	GsArray<GsVisGraphNode*> sources; // polygon vertices in the order they are processed
+	GsArray<int> pols, vtxs;          // polygon and vertex index of each source
+	GsArrayPt<GsArray<GsVisGraphNode*>> links; // pairs of nodes to link, one array per chunk
+};
+
+void GsVisGraph::build ( GsPolygons* polys, float r, float dang, int nt )
 {
 	GS_TRACE1 ( "Build started..." );
 
@@ -80,36 +94,159 @@ void GsVisGraph::build ( GsPolygons* polys, float r, float dang )
 		}
 	}
 
-	// Compute links:
+	GS_TRACE1 ( "Building grid..." );
+	_build_grid ();
+
+	// Determine in parallel the links of each vertex, in chunks of consecutive vertices:
 	GS_TRACE1 ( "Adding edges..." );
+	VisGraphLinks data;
+	data.vg = this;
 	int s = _nodes.size();
-	FOR_ALL_POL(pi)
-	{
-		FOR_ALL_PVTX(pi,Pi,vi,vis)
-		{
+	FOR_ALL_VERTICES(pi,Pi,vi,vis)
+		data.sources.push() = Pi.get(vi);
+		data.pols.push() = pi;
+		data.vtxs.push() = vi;
+	END_FOR
+	if ( nt<=0 ) nt = gs_hardware_threads();
+	int chunks = GS_MIN ( data.sources.size(), 4*nt );
+	for ( int i=0; i<chunks; i++ ) data.links.push();
+	gs_parallel_for ( chunks, nt, _get_links, &data );
+
+	// Add links in the same order as they are determined by a sequential traversal:
+	for ( int c=0; c<chunks; c++ )
+	{	const GsArray<GsVisGraphNode*>& a = *data.links[c];
+		for ( int i=0, size=a.size(); i<size; i+=2 )
+		{	if ( a[i]->search_link(a[i+1])>=0 ) continue; // link already there
+			_graph.link ( a[i], a[i+1], dist(a[i]->p,a[i+1]->p) );
+		}
+	}
+
+	GS_TRACE1 ( "Done." );
+}
+
+void GsVisGraph::_get_links ( int i0, int i1, void* udata )
+{
+	VisGraphLinks& data = *(VisGraphLinks*)udata;
+	const GsVisGraph& vg = *data.vg;
+	int n = data.sources.size();
+	int chunks = data.links.size();
+	Buffers buf;
+	GsArray<GsVisGraphNode*> visible;
+
+	for ( int c=i0; c<i1; c++ )
+	{	GsArray<GsVisGraphNode*>& links = *data.links[c];
+		for ( int k=int(int64_t(n)*c/chunks), kend=int(int64_t(n)*(c+1)/chunks); k<kend; k++ )
+		{	int pi=data.pols[k], vi=data.vtxs[k];
+			const GsBuffer<GsVisGraphNode*>& Pi = *vg._nodes[pi];
 			int vim = Pi.vid(vi-1);
 			int vip = Pi.vidpos(vi+1);
-			const GsPnt2& p = Pi.get(vi)->p;
+			GsVisGraphNode* nv = Pi.get(vi);
+			const GsPnt2& p = nv->p;
 			const GsPnt2& pm = Pi.get(vim)->p;
 			const GsPnt2& pp = Pi.get(vip)->p;
 
-			_add_if_free ( //na, nb, pa, va, pi, vi );
-			//_nodes[pi]->get(vi)->linkto ( _nodes[pi]->get(vip), 0 );//xxx
-			_nodes[pi]->get(vi), _nodes[pi]->get(vip), pi,vi, pi,vip );//xxx
+			// Polygon edge:
+			if ( vg._free(p,pp,pi,vi,pi,vip,buf) ) { links.push()=nv; links.push()=Pi.get(vip); }
 
 			// Only consider connecting CCW corners:
 			if ( ccw(pm,p,pp)<=0 ) continue;
 
 			// Connect to other polygons:
-			GsVisGraphNode* n = _nodes[pi]->get(vi);
-			_connect_to_visible ( n, pi, vi, &pm, &pp );
+			visible.size(0);
+			vg._get_visible ( nv, pi, vi, &pm, &pp, visible, buf );
+			for ( int i=0; i<visible.size(); i++ ) { links.push()=nv; links.push()=visible[i]; }
 		}
 	}
+}
 
-	GS_TRACE1 ( "Done." );
+void GsVisGraph::_build_grid ()
+{
+	_edges.size(0);
+	int s = _nodes.size();
+	GsPnt2 a, b;
+	FOR_ALL_VERTICES(pi,Pi,vi,vis)
+		Edge& e = _edges.push();
+		e.p=pi; e.v=vi; e.vp=Pi.vidpos(vi+1);
+		const GsPnt2& p = Pi.get(vi)->p;
+		if ( _edges.size()==1 ) { a=p; b=p; }
+		else { a.x=GS_MIN(a.x,p.x); a.y=GS_MIN(a.y,p.y); b.x=GS_MAX(b.x,p.x); b.y=GS_MAX(b.y,p.y); }
+	END_FOR
+	if ( _edges.empty() ) return;
+
+	// grid with about one cell per edge, slightly larger than the bounding box of the edges:
+	float w = b.x-a.x, h = b.y-a.y;
+	float m = 0.01f*GS_MAX(w,h) + 1.0E-4f;
+	a.x-=m; a.y-=m; b.x+=m; b.y+=m;
+	w = b.x-a.x; h = b.y-a.y;
+	float c = sqrtf ( float(_edges.size())/(w*h) ); // cells per unit length
+	int nx = GS_BOUND ( int(ceilf(c*w)), 1, 1024 );
+	int ny = GS_BOUND ( int(ceilf(c*h)), 1, 1024 );
+	GsArray<GsGridAxis> axis;
+	axis.push().set ( nx, a.x, b.x );
+	axis.push().set ( ny, a.y, b.y );
+	_grid.init ( axis );
+	_eps = 0.001f*GS_MIN(_grid.seglen(0),_grid.seglen(1));
+
+	// store edge indices per cell, enlarging edge boxes by _eps, in two passes:
+	GsArray<int> cells;
+	GsArray<int> ecells; // pairs of edge and cell
+	for ( int i=0; i<_edges.size(); i++ )
+	{	const Edge& e = _edges[i];
+		const GsPnt2& p1 = _nodes[e.p]->cget(e.v)->p;
+		const GsPnt2& p2 = _nodes[e.p]->cget(e.vp)->p;
+		cells.size(0);
+		_grid.get_intersection ( GsPnt2(GS_MIN(p1.x,p2.x)-_eps,GS_MIN(p1.y,p2.y)-_eps),
+								 GsPnt2(GS_MAX(p1.x,p2.x)+_eps,GS_MAX(p1.y,p2.y)+_eps), cells );
+		for ( int k=0; k<cells.size(); k++ ) { ecells.push()=i; ecells.push()=cells[k]; }
+	}
+	_cellfirst.size ( _grid.cells()+1 );
+	_cellfirst.setall ( 0 );
+	for ( int k=1; k<ecells.size(); k+=2 ) _cellfirst[ecells[k]+1]++;
+	for ( int k=1; k<_cellfirst.size(); k++ ) _cellfirst[k]+=_cellfirst[k-1];
+	_celledges.size ( ecells.size()/2 );
+	cells = _cellfirst;
+	for ( int k=0; k<ecells.size(); k+=2 ) _celledges[cells[ecells[k+1]]++] = ecells[k];
 }
 
-void GsVisGraph::_connect_to_visible ( GsVisGraphNode* na, int pa, int va, const GsPnt2* sm, const GsPnt2* sp )
+bool GsVisGraph::_free ( const GsPnt2& a, const GsPnt2& b, int p1, int v1, int p2, int v2, Buffers& buf ) const
+{
+	if ( _edges.empty() ) return true;
+
+	// edges are marked when tested, as they can be in several cells:
+	if ( buf.marks.size()!=_edges.size() ) { buf.marks.size(_edges.size()); buf.marks.setall(0); buf.mark=0; }
+	if ( ++buf.mark==0 ) { buf.marks.setall(0); buf.mark=1; }
+
+	buf.cells.size(0);
+	_grid.get_segment_intersection ( a, b, buf.cells, _eps );
+
+	// visibility tests:
+	for ( int ci=0; ci<buf.cells.size(); ci++ )
+	{	int cell = buf.cells[ci];
+		for ( int k=_cellfirst[cell], kend=_cellfirst[cell+1]; k<kend; k++ )
+		{	int ei = _celledges[k];
+			if ( buf.marks[ei]==buf.mark ) continue;
+			buf.marks[ei] = buf.mark;
+			const Edge& e = _edges[ei];
+			int pi=e.p, vi=e.v, vip=e.vp;
+
+			// bounding disk prunning:
+			if ( pi!=p1 && pi!=p2 && gs_point_segment_dist(_bdisks[pi].x,_bdisks[pi].y, a.x,a.y,b.x,b.y)>_bdisks[pi].z ) continue; // skip this polygon
+
+			// do not test segements with endpoints in n1-n2 line:
+			if ( pi==p1 && (vi==v1||vip==v1) ) continue;
+			if ( pi==p2 && (vi==v2||vip==v2) ) continue;
+
+			// intersection test:
+			const GsPnt2& c = _nodes[pi]->cget(vi)->p;
+			const GsPnt2& d = _nodes[pi]->cget(vip)->p;
+			if ( gs_segments_intersect(a.x,a.y,b.x,b.y, c.x,c.y,d.x,d.y) ) return false;
+		}
+	}
+	return true;
+}
+
+void GsVisGraph::_get_visible ( GsVisGraphNode* na, int pa, int va, const GsPnt2* sm, const GsPnt2* sp,
+								GsArray<GsVisGraphNode*>& nodes, Buffers& buf ) const
 {
 	GsPnt2 a(na->p);
 	double x, y;
@@ -117,8 +254,7 @@ void GsVisGraph::_connect_to_visible ( GsVisGraphNode* na, int pa, int va, const
 	int s = _nodes.size();
 	FOR_ALL_VERTICES(pi,Pi,vi,vis)
 
-		//if ( pi==pa ) continue;
-		GsVisGraphNode* nb = _nodes[pi]->get(vi);
+		GsVisGraphNode* nb = Pi.get(vi);
 
 		// disconsider same vertices:
 		// treat connection between vertices in same polygon:
@@ -127,9 +263,7 @@ void GsVisGraph::_connect_to_visible ( GsVisGraphNode* na, int pa, int va, const
 		if ( pi==pa )
 		{	if ( va==vi ) continue;
 			if ( va==vim ) continue;
-			if ( va==vip ) {
-			//add_if_free ( na, nb, pa, va, pi, vi );
-			continue; }
+			if ( va==vip ) continue;
 		}
 
 		const GsPnt2& b = Pi.get(vi)->p;
@@ -143,42 +277,33 @@ void GsVisGraph::_connect_to_visible ( GsVisGraphNode* na, int pa, int va, const
 		if ( sm && gs_segment_line_intersect ( sm->x,sm->y,sp->x,sp->y, a.x,a.y,b.x,b.y, x,y ) ) continue;
 		if ( gs_segment_line_intersect ( bm.x,bm.y,bp.x,bp.y, a.x,a.y,b.x,b.y, x,y ) ) continue;
 
-		_add_if_free ( na, nb, pa, va, pi, vi );
+		if ( _free ( a, b, pa, va, pi, vi, buf ) ) nodes.push()=nb;
 
 	END_FOR
 }
 
-void GsVisGraph::_add_if_free ( GsVisGraphNode* n1, GsVisGraphNode* n2, int p1, int v1, int p2, int v2 )
+void GsVisGraph::_connect_to_visible ( GsVisGraphNode* na, int pa, int va, const GsPnt2* sm, const GsPnt2* sp )
 {
-	GsPnt2 a(n1->p);
-	GsPnt2 b(n2->p);
-	int s = _nodes.size();
+	GsArray<GsVisGraphNode*> nodes;
+	_get_visible ( na, pa, va, sm, sp, nodes, _buffers );
+	for ( int i=0; i<nodes.size(); i++ )
+	{	if ( na->search_link(nodes[i])>=0 ) continue; // link already there
+		_graph.link ( na, nodes[i], dist(na->p,nodes[i]->p) );
+	}
+}
 
+void GsVisGraph::_add_if_free ( GsVisGraphNode* n1, GsVisGraphNode* n2, int p1, int v1, int p2, int v2 )
+{
 	if ( n1->search_link(n2)>=0 ) return; // link already there
 
-	// visibility tests:
-	FOR_ALL_POL(pi)
-	{
-		// bounding disk prunning:
-		if ( pi!=p1 && pi!=p2 && gs_point_segment_dist(_bdisks[pi].x,_bdisks[pi].y, a.x,a.y,b.x,b.y)>_bdisks[pi].z ) continue; // skip this polygon
-
-		FOR_ALL_PVTX(pi,Pi,vi,vis)
-		{
-			// do not test segements with endpoints in n1-n2 line:
-			int vip = Pi.vidpos(vi+1);
-
-			if ( pi==p1 && (vi==v1||vip==v1) ) continue;
-			if ( pi==p2 && (vi==v2||vip==v2) ) continue;
-
-			// intersection test:
-			const GsPnt2& c = Pi.get(vi)->p;
-			const GsPnt2& d = Pi.get(vip)->p;
-			if ( gs_segments_intersect(a.x,a.y,b.x,b.y, c.x,c.y,d.x,d.y) ) return;
-		}
-	}
+	// add link with its length as cost:
+	if ( _free(n1->p,n2->p,p1,v1,p2,v2,_buffers) ) _graph.link ( n1, n2, dist(n1->p,n2->p) );
+}
 
-	// add link:
-	_graph.link ( n1, n2, 0 );
+// euclidian distance between nodes, used as A* heuristic:
+static float nodedist ( const GsGraphNode* n1, const GsGraphNode* n2, void* udata )
+{
+	return dist ( ((const GsVisGraphNode*)n1)->p, ((const GsVisGraphNode*)n2)->p );
 }
 
 bool GsVisGraph::search_shortest_path ( const GsPnt2& pi, const GsPnt2& pg, GsPolygon& path, float* cost )
@@ -202,10 +327,10 @@ bool GsVisGraph::search_shortest_path ( const GsPnt2& pi, const GsPnt2& pg, GsPo
 	_add_if_free ( _vi, _vg );
 
 	// search path:
-//xxx: rename/fix to shortest:
 	GS_TRACE2 ( "Searching..." );
 	float gcost;
-	bool found = _graph.search_path ( _vi, _vg, _path, gcost );
+	bool found = _graph.search_path ( _vi, _vg, _path, gcost, nodedist );
+	if ( !found ) _path.size(0); // the path to the closest node is not used
 	path.open ( true );
 	path.size ( _path.size() );
 	for ( int i=_path.size()-1; i>=0; i-- ) path[i]=_path[i]->p;
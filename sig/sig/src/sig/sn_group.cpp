@@ -7,6 +7,7 @@
 
 # include <sig/sn_group.h>
 # include <sig/sa_action.h>
+# include <sig/sa_bbox.h>
 
 //# define GS_USE_TRACE1  // Const/Dest
 # include <sig/gs_trace.h>
@@ -15,7 +16,7 @@
 
 const char* SnGroup::class_name = "SnGroup";
 
-# define INITIALIZE _separator=false
+# define INITIALIZE _separator=false; _culling=false; _boxuptodate=false
 
 SnGroup::SnGroup ()
 		:SnNode ( SnNode::TypeGroup, SnGroup::class_name )
@@ -54,6 +55,17 @@ void SnGroup::capacity ( int c )
 	_children.capacity ( c ); 
 }
 
+const GsBox& SnGroup::culling_box ()
+{
+	if ( !_boxuptodate )
+	{	SaBBox bbox;
+		bbox.apply ( this );
+		_box = bbox.get();
+		_boxuptodate = true;
+	}
+	return _box;
+}
+
 SnNode* SnGroup::get ( int pos ) const
 {
 	if ( _children.size()==0 ) return 0;
@@ -73,6 +85,7 @@ SnNode* SnGroup::add ( SnNode *sn )
 {
 	sn->ref(); // Increment reference counter
 	_children.push() = sn;
+	_boxuptodate = false;
 	return sn;
 }
 
@@ -109,6 +122,7 @@ SnNode *SnGroup::remove ( int pos )
 	{	sn = _children[pos];
 		_children.remove(pos);
 	}
+	_boxuptodate = false;
 
 	int oldref = sn->getref();
 	sn->unref();
@@ -126,6 +140,7 @@ void SnGroup::remove_all ()
 {
 	GS_TRACE3 ( "remove_all" );
 	while ( _children.size() ) _children.pop()->unref();
+	_boxuptodate = false;
 }
 
 SnNode *SnGroup::replace ( int pos, SnNode *sn )
@@ -137,6 +152,7 @@ SnNode *SnGroup::replace ( int pos, SnNode *sn )
 	sn->ref();
 	SnNode *old = _children[pos];
 	_children[pos] = sn;
+	_boxuptodate = false;
 
 	int oldref = old->getref();
 	old->unref();
@@ -43,6 +43,7 @@ SnModel::SnModel ( const char* classname ) : SnShape ( classname )
 	GS_TRACE1 ( "Protected Constructor" );
 	_model = new GsModel;
 	_model->ref();
+	_skinning = 0;
 }
 
 SnModel::SnModel ( GsModel* m ) : SnShape ( class_name )
@@ -50,12 +51,14 @@ SnModel::SnModel ( GsModel* m ) : SnShape ( class_name )
 	GS_TRACE1 ( "Constructor" );
 	_model = m? m : new GsModel;
 	_model->ref();
+	_skinning = 0;
 }
 
 SnModel::~SnModel ()
 {
 	GS_TRACE1 ( "Destructor" );
 	_model->unref();
+	delete _skinning;
 }
 
 void SnModel::model ( GsModel* m )
@@ -67,6 +70,20 @@ void SnModel::model ( GsModel* m )
 	touch ();
 }
 
+SnModel::Skinning* SnModel::init_skinning ()
+{
+	if ( !_skinning ) _skinning = new Skinning;
+	touch ();
+	return _skinning;
+}
+
+void SnModel::remove_skinning ()
+{
+	delete _skinning;
+	_skinning = 0;
+	touch ();
+}
+
 void SnModel::get_bounding_box ( GsBox& b ) const
 {
 	if ( _model->primitive )
@@ -27,6 +27,7 @@ SnShape::SnShape ( const char* name ) : SnNode ( SnNode::TypeShape, name )
 	_can_override_render_mode = 1;
 	_material_is_overriden = 0;
 	_renderer = 0;
+	_boxuptodate = 0;
 }
 
 SnShape::~SnShape ()
@@ -101,10 +102,20 @@ bool SnShape::prep_render ()
 
 void SnShape::post_render ()
 {
-	// 4. Reset changed flag
+	// 4. Reset changed flag, making sure a box cached before the change is not used:
+	if ( _changed ) _boxuptodate = 0;
 	changed ( Unchanged );
 }
 
+const GsBox& SnShape::cached_bounding_box () const
+{
+	if ( _changed || !_boxuptodate )
+	{	get_bounding_box ( _box );
+		_boxuptodate = 1;
+	}
+	return _box;
+}
+
 bool SnShape::apply ( SaAction* a )
 {
 	return a->shape_apply(this);
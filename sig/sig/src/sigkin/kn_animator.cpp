@@ -0,0 +1,87 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_parallel.h>
+# include <sig/gs_profiler.h>
+# include <sigkin/kn_animator.h>
+# include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_controller.h>
+
+//============================ KnAnimator ============================
+
+KnAnimator::KnAnimator ( int nt )
+{
+	_pool = new GsThreadPool ( nt );
+	_t = 0;
+}
+
+KnAnimator::~KnAnimator ()
+{
+	init ();
+	delete _pool;
+}
+
+void KnAnimator::threads ( int nt )
+{
+	if ( nt<=0 ) nt = gs_hardware_threads();
+	if ( nt==_pool->threads() ) return;
+	delete _pool;
+	_pool = new GsThreadPool ( nt );
+}
+
+int KnAnimator::threads () const
+{
+	return _pool->threads();
+}
+
+void KnAnimator::init ()
+{
+	while ( _chars.size() ) remove ( _chars.size()-1 );
+}
+
+int KnAnimator::add ( KnSkeleton* sk, KnController* ct )
+{
+	sk->ref ();
+	ct->ref ();
+	if ( ct->buffer().skeleton()!=sk ) ct->buffer().connect ( sk );
+	Character& c = _chars.push();
+	c.skeleton = sk;
+	c.controller = ct;
+	return _chars.size()-1;
+}
+
+void KnAnimator::remove ( int i )
+{
+	_chars[i].skeleton->unref();
+	_chars[i].controller->unref();
+	_chars[i] = _chars.top();
+	_chars.pop();
+}
+
+void KnAnimator::_evaluate ( int i, int /*thread*/, void* udata )
+{
+	KnAnimator* a = (KnAnimator*)udata;
+	Character& c = a->_chars[i];
+	GsProfileScope scope ( "animator character" );
+	c.controller->evaluate ( a->_t );
+	c.controller->buffer().apply ();
+	c.skeleton->update_global_matrices ();
+}
+
+void KnAnimator::evaluate ( double t )
+{
+	GsProfileScope scope ( "animator" );
+	_t = t;
+	_pool->run ( _chars.size(), _evaluate, this );
+}
+
+const GsArray<GsMat>& KnAnimator::global_matrices ( int i ) const
+{
+	return _chars[i].skeleton->global_matrices();
+}
+
+//============================ End of File ============================
@@ -0,0 +1,266 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <sigkin/kn_channels.h>
+# include <sigkin/kn_channel_layout.h>
+
+# if defined(__SSE2__) || defined(_M_X64) // SSE2 is always available in 64 bits
+# define KN_LAYOUT_SSE
+# include <xmmintrin.h>
+# endif
+
+//================================ slerp ==================================
+
+/* The slerp weights sin((1-t)a)/sin(a) and sin(ta)/sin(a), where cos(a) is the dot product x
+   of the two quaternions, are evaluated with their series in (x-1), as described in
+   "A Fast and Accurate Algorithm for Computing SLERP" by D. Eberly. The series is truncated
+   at SlerpTerms terms and the last term is scaled by SlerpMu to compensate the truncation.
+   As t is the same for all quaternions, the coefficients are computed once per call. */
+
+static const int SlerpTerms = 16;
+static const float SlerpMu = 1.9166676f;
+
+struct SlerpCoefs { float t, d, ct[SlerpTerms], cd[SlerpTerms]; };
+
+static void slerp_coefs ( float t, SlerpCoefs& c )
+{
+	c.t = t;
+	c.d = 1.0f-t;
+	for ( int i=1; i<=SlerpTerms; i++ )
+	{	float u = 1.0f/float(i*(2*i+1));
+		float v = float(i)/float(2*i+1);
+		if ( i==SlerpTerms ) { u*=SlerpMu; v*=SlerpMu; }
+		c.ct[i-1] = u*c.t*c.t - v;
+		c.cd[i-1] = u*c.d*c.d - v;
+	}
+}
+
+static const float Identity[4] = { 1.0f, 0, 0, 0 };
+
+# ifdef KN_LAYOUT_SSE
+
+// loads 4 quaternions and transposes them so that each register has one component of all of them
+static inline void load4 ( const float* const q[4], __m128& w, __m128& x, __m128& y, __m128& z )
+{
+	w=_mm_loadu_ps(q[0]); x=_mm_loadu_ps(q[1]); y=_mm_loadu_ps(q[2]); z=_mm_loadu_ps(q[3]);
+	_MM_TRANSPOSE4_PS ( w, x, y, z );
+}
+
+static inline void store4 ( float* const q[4], __m128 w, __m128 x, __m128 y, __m128 z )
+{
+	_MM_TRANSPOSE4_PS ( w, x, y, z );
+	_mm_storeu_ps(q[0],w); _mm_storeu_ps(q[1],x); _mm_storeu_ps(q[2],y); _mm_storeu_ps(q[3],z);
+}
+
+// q may point to the same quaternions as q1 or q2
+static void slerp4 ( const SlerpCoefs& c, const float* const q1[4], const float* const q2[4], float* const q[4] )
+{
+	__m128 w1, x1, y1, z1, w2, x2, y2, z2;
+	load4 ( q1, w1, x1, y1, z1 );
+	load4 ( q2, w2, x2, y2, z2 );
+	__m128 dot = _mm_add_ps ( _mm_add_ps ( _mm_add_ps ( _mm_mul_ps(w1,w2), _mm_mul_ps(x1,x2) ), _mm_mul_ps(y1,y2) ), _mm_mul_ps(z1,z2) );
+
+	// quaternions in opposite directions use the equivalent representation of q1:
+	__m128 sg = _mm_and_ps ( dot, _mm_set1_ps(-0.0f) );
+	const __m128 one = _mm_set1_ps ( 1.0f );
+	__m128 xm1 = _mm_sub_ps ( _mm_xor_ps(dot,sg), one );
+
+	__m128 bt=one, bd=one;
+	for ( int i=SlerpTerms-1; i>=0; i-- )
+	{	bt = _mm_add_ps ( one, _mm_mul_ps ( _mm_mul_ps(_mm_set1_ps(c.ct[i]),xm1), bt ) );
+		bd = _mm_add_ps ( one, _mm_mul_ps ( _mm_mul_ps(_mm_set1_ps(c.cd[i]),xm1), bd ) );
+	}
+	__m128 r = _mm_xor_ps ( _mm_mul_ps(_mm_set1_ps(c.d),bd), sg );
+	__m128 s = _mm_mul_ps ( _mm_set1_ps(c.t), bt );
+
+	store4 ( q, _mm_add_ps(_mm_mul_ps(r,w1),_mm_mul_ps(s,w2)), _mm_add_ps(_mm_mul_ps(r,x1),_mm_mul_ps(s,x2)),
+				_mm_add_ps(_mm_mul_ps(r,y1),_mm_mul_ps(s,y2)), _mm_add_ps(_mm_mul_ps(r,z1),_mm_mul_ps(s,z2)) );
+}
+
+// normalizes and makes w>=0, null quaternions remain null
+static inline void normalize4 ( __m128& w, __m128& x, __m128& y, __m128& z )
+{
+	__m128 f = _mm_sqrt_ps ( _mm_add_ps ( _mm_add_ps ( _mm_add_ps ( _mm_mul_ps(w,w), _mm_mul_ps(x,x) ), _mm_mul_ps(y,y) ), _mm_mul_ps(z,z) ) );
+	const __m128 zero = _mm_setzero_ps ();
+	f = _mm_or_ps ( f, _mm_and_ps ( _mm_cmpeq_ps(f,zero), _mm_set1_ps(1.0f) ) );
+	w = _mm_div_ps(w,f); x = _mm_div_ps(x,f); y = _mm_div_ps(y,f); z = _mm_div_ps(z,f);
+	__m128 sg = _mm_and_ps ( _mm_cmplt_ps(w,zero), _mm_set1_ps(-0.0f) );
+	w = _mm_xor_ps(w,sg); x = _mm_xor_ps(x,sg); y = _mm_xor_ps(y,sg); z = _mm_xor_ps(z,sg);
+}
+
+# else
+
+static void slerp1 ( const SlerpCoefs& c, const float* q1, const float* q2, float* q )
+{
+	float dot = q1[0]*q2[0] + q1[1]*q2[1] + q1[2]*q2[2] + q1[3]*q2[3];
+	float sg = dot<0? -1.0f : 1.0f;
+	float xm1 = sg*dot-1.0f;
+	float bt=1.0f, bd=1.0f;
+	for ( int i=SlerpTerms-1; i>=0; i-- )
+	{	bt = 1.0f + c.ct[i]*xm1*bt;
+		bd = 1.0f + c.cd[i]*xm1*bd;
+	}
+	float r = sg*c.d*bd;
+	float s = c.t*bt;
+	for ( int k=0; k<4; k++ ) q[k] = r*q1[k] + s*q2[k];
+}
+
+static void normalize1 ( float* q )
+{
+	float f = sqrtf ( q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3] );
+	if ( f==0 ) return;
+	for ( int k=0; k<4; k++ ) q[k]/=f;
+	if ( q[0]<0 ) for ( int k=0; k<4; k++ ) q[k]=-q[k];
+}
+
+# endif
+
+//============================ KnChannelLayout ============================
+
+void KnChannelLayout::compile ( const KnChannels& ch )
+{
+	_lin.size(0); _ang.size(0); _quat.size(0);
+	int c, k, pos=0;
+	for ( c=0; c<ch.size(); c++ )
+	{	const KnChannel& chc = ch(c);
+		switch ( chc.type() )
+		{	case KnChannel::Quat:
+				{ Entry& e=_quat.push(); e.pos=pos; e.ch=c; e.off=0; }
+				break;
+			case KnChannel::IKGoal:
+				for ( k=0; k<3; k++ ) { Entry& e=_lin.push(); e.pos=pos+k; e.ch=c; e.off=k; }
+				{ Entry& e=_quat.push(); e.pos=pos+3; e.ch=c; e.off=3; }
+				break;
+			case KnChannel::XRot: case KnChannel::YRot: case KnChannel::ZRot: case KnChannel::Twist:
+				{ Entry& e=_ang.push(); e.pos=pos; e.ch=c; e.off=0; }
+				break;
+			default: // XPos, YPos, ZPos, Swing and IKPos
+				for ( k=0; k<chc.size(); k++ ) { Entry& e=_lin.push(); e.pos=pos+k; e.ch=c; e.off=k; }
+		}
+		pos += chc.size();
+	}
+	_floats = pos;
+}
+
+void KnChannelLayout::interp ( const float* v1, const float* v2, float t, float* v ) const
+{
+	int i, k, n;
+	float r = 1.0f-t;
+	for ( i=0, n=_lin.size(); i<n; i++ ) { k=_lin[i].pos; v[k] = v1[k]*r + v2[k]*t; }
+	for ( i=0, n=_ang.size(); i<n; i++ ) { k=_ang[i].pos; v[k] = gs_anglerp ( v1[k], v2[k], t ); }
+
+	SlerpCoefs c;
+	slerp_coefs ( t, c );
+	n = _quat.size();
+	# ifdef KN_LAYOUT_SSE
+	const float* q1[4]; const float* q2[4]; float* q[4];
+	float scratch[4];
+	for ( i=0; i<n; i+=4 )
+	{	for ( int j=0; j<4; j++ )
+		{	if ( i+j<n ) { k=_quat[i+j].pos; q1[j]=v1+k; q2[j]=v2+k; q[j]=v+k; }
+			else { q1[j]=q2[j]=Identity; q[j]=scratch; }
+		}
+		slerp4 ( c, q1, q2, q );
+	}
+	# else
+	for ( i=0; i<n; i++ ) { k=_quat[i].pos; slerp1 ( c, v1+k, v2+k, v+k ); }
+	# endif
+}
+
+// returns the buffer position connected to the values of entry e, or null
+static inline float* connection ( const KnChannels& ch, const KnChannelLayout::Entry& e )
+{
+	const KnChannel& c = ch(e.ch);
+	return c.status()==KnChannel::BufferConnection? c.buffer()+e.off : 0;
+}
+
+void KnChannelLayout::interp ( const float* v1, float t, const KnChannels& ch ) const
+{
+	int i, n;
+	float* b;
+	float r = 1.0f-t;
+	for ( i=0, n=_lin.size(); i<n; i++ )
+	{	if ( (b=connection(ch,_lin[i])) ) b[0] = v1[_lin[i].pos]*r + b[0]*t;
+	}
+	for ( i=0, n=_ang.size(); i<n; i++ )
+	{	if ( (b=connection(ch,_ang[i])) ) b[0] = gs_anglerp ( v1[_ang[i].pos], b[0], t );
+	}
+
+	SlerpCoefs c;
+	slerp_coefs ( t, c );
+	n = _quat.size();
+	# ifdef KN_LAYOUT_SSE
+	const float* q1[4]; const float* q2[4]; float* q[4];
+	float scratch[4][4];
+	for ( i=0; i<n; i+=4 )
+	{	for ( int j=0; j<4; j++ )
+		{	b = i+j<n? connection(ch,_quat[i+j]) : 0;
+			if ( b ) { q1[j]=v1+_quat[i+j].pos; q2[j]=q[j]=b; }
+			else { q1[j]=Identity; q2[j]=q[j]=scratch[j]; scratch[j][0]=1.0f; scratch[j][1]=scratch[j][2]=scratch[j][3]=0; }
+		}
+		slerp4 ( c, q1, q2, q );
+	}
+	# else
+	for ( i=0; i<n; i++ )
+	{	if ( (b=connection(ch,_quat[i])) ) slerp1 ( c, v1+_quat[i].pos, b, b );
+	}
+	# endif
+}
+
+void KnChannelLayout::interp ( const GsArray<float*>& values, const GsArray<float>& w, float* v ) const
+{
+	int i, j, k, n, vsize=values.size();
+	float s;
+	for ( i=0, n=_lin.size(); i<n; i++ )
+	{	k = _lin[i].pos;
+		for ( s=0, j=0; j<vsize; j++ ) s += values[j][k]*w[j];
+		v[k] = s;
+	}
+	for ( i=0, n=_ang.size(); i<n; i++ )
+	{	k = _ang[i].pos;
+		for ( s=0, j=0; j<vsize; j++ ) s += values[j][k]*w[j];
+		v[k] = s;
+	}
+
+	n = _quat.size();
+	# ifdef KN_LAYOUT_SSE
+	const float* qi[4]; float* q[4];
+	float scratch[4];
+	int pos[4];
+	for ( i=0; i<n; i+=4 )
+	{	for ( k=0; k<4; k++ )
+		{	pos[k] = i+k<n? _quat[i+k].pos : -1;
+			q[k] = pos[k]>=0? v+pos[k] : scratch;
+		}
+		__m128 sw=_mm_setzero_ps(), sx=sw, sy=sw, sz=sw, qw, qx, qy, qz;
+		for ( j=0; j<vsize; j++ )
+		{	for ( k=0; k<4; k++ ) qi[k] = pos[k]>=0? values[j]+pos[k] : Identity;
+			load4 ( qi, qw, qx, qy, qz );
+			__m128 wj = _mm_set1_ps ( w[j] );
+			sw = _mm_add_ps ( sw, _mm_mul_ps(qw,wj) );
+			sx = _mm_add_ps ( sx, _mm_mul_ps(qx,wj) );
+			sy = _mm_add_ps ( sy, _mm_mul_ps(qy,wj) );
+			sz = _mm_add_ps ( sz, _mm_mul_ps(qz,wj) );
+		}
+		normalize4 ( sw, sx, sy, sz );
+		store4 ( q, sw, sx, sy, sz );
+	}
+	# else
+	for ( i=0; i<n; i++ )
+	{	float* q = v+_quat[i].pos;
+		q[0]=q[1]=q[2]=q[3]=0;
+		for ( j=0; j<vsize; j++ )
+		{	const float* qj = values[j]+_quat[i].pos;
+			for ( k=0; k<4; k++ ) q[k] += qj[k]*w[j];
+		}
+		normalize1 ( q );
+	}
+	# endif
+}
+
+//============================ End of File ============================
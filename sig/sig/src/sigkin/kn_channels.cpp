@@ -7,6 +7,7 @@
 
 # include <sigkin/kn_channels.h>
 # include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_channel_layout.h>
 
 //========================= KnChannels::HashTable ============================
 
@@ -42,6 +43,7 @@ KnChannels::KnChannels ()
  {
    _floats=0;
    _htable=0;
+   _layout=0;
  }
 
 KnChannels::KnChannels ( const KnChannels& c )
@@ -49,11 +51,13 @@ KnChannels::KnChannels ( const KnChannels& c )
    _channels = c._channels;
    _floats = c._floats;
    _htable = 0;
+   _layout = 0;
  }
 
 KnChannels::~KnChannels ()
  {
    delete _htable;
+   delete _layout;
  }
 
 void KnChannels::init()
@@ -61,6 +65,7 @@ void KnChannels::init()
    _channels.size ( 0 );
    _floats = 0;
    if ( _htable ) { delete _htable; _htable=0; }
+   if ( _layout ) { delete _layout; _layout=0; }
  }
 
 void KnChannels::_add ( KnJoint* j, KnChannel::Type t )
@@ -77,6 +82,7 @@ void KnChannels::_add ( KnJoint* j, KnChannel::Type t )
 
    _floats += KnChannel::size(t);
    if ( _htable ) { delete _htable; _htable=0; }
+   if ( _layout ) { delete _layout; _layout=0; }
  }
 
 bool KnChannels::insert ( int pos, KnChannel::Type type )
@@ -88,6 +94,7 @@ bool KnChannels::insert ( int pos, KnChannel::Type type )
    _channels[pos].init ( type );
    _floats += KnChannel::size ( type );
    if ( _htable ) { delete _htable; _htable=0; }
+   if ( _layout ) { delete _layout; _layout=0; }
 
    return true;
  }
@@ -106,9 +113,19 @@ int KnChannels::count_floats ()
    for ( i=0; i<csize; i++ )
 	{ _floats += _channels[i].size();
 	}
+   if ( _layout ) { delete _layout; _layout=0; }
    return _floats;
  }
 
+const KnChannelLayout& KnChannels::layout () const
+ {
+   if ( !_layout )
+	{ _layout = new KnChannelLayout;
+	  _layout->compile ( *this );
+	}
+   return *_layout;
+ }
+
 int KnChannels::floatpos ( int c ) const
 {
 	if ( c>=_channels.size() ) c=_channels.size()-1;
@@ -407,6 +424,7 @@ int KnChannels::force_quat_channels ()
 	  if ( _channels[c].status()>KnChannel::JointConnection )
 	   _channels[c].disconnect();
 	}
+   if ( n ) count_floats ();
    return n;
  }
 
@@ -415,6 +433,7 @@ void KnChannels::copyfrom ( const KnChannels& c )
    _channels = c._channels;
    _floats = c._floats;
    if ( _htable ) { delete _htable; _htable=0; }
+   if ( _layout ) { delete _layout; _layout=0; }
  }
 
 bool KnChannels::operator == ( const KnChannels& c )
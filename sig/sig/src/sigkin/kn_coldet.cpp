@@ -178,7 +178,7 @@ int KnColdet::update ( KnSkeleton* s )
 	int i, size=cs->j.size();
 	for ( i=0; i<size; i++ )
 	{	j = cs->j[i];
-		_coldet->update_transformation ( j->_coldetid, j->_gmat );
+		_coldet->update_transformation ( j->_coldetid, j->gmat() );
 		count++;
 	};
 
@@ -187,12 +187,12 @@ int KnColdet::update ( KnSkeleton* s )
 
 void KnColdet::update ( KnJoint* j )
 {
-	_coldet->update_transformation ( j->_coldetid, j->_gmat );
+	_coldet->update_transformation ( j->_coldetid, j->gmat() );
 }
 
 void KnColdet::update_subtree ( KnJoint* j )
 {
-	_coldet->update_transformation ( j->_coldetid, j->_gmat );
+	_coldet->update_transformation ( j->_coldetid, j->gmat() );
 
 	for ( int i=0, s=j->_children.size(); i<s; i++ )
 	{	update_subtree ( j->_children[i] );
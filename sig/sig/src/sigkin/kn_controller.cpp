@@ -1,6 +1,7 @@
 
 # include <sigkin/kn_controller.h>
 # include <sig/gs_string.h>
+# include <sig/gs_profiler.h>
 
 //============================= KnController ============================
 
@@ -20,6 +21,12 @@ KnController::~KnController ()
    delete _conch;
  }
 
+void KnController::evaluate ( double t )
+ {
+   GsProfileScope scope ( controller_type() );
+   _active = controller_evaluate ( t );
+ }
+
 void KnController::emphasist ( float t )
  { 
    if ( t<0 )
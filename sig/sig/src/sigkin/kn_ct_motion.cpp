@@ -9,6 +9,7 @@ const char* KnCtMotion::type_name = "Motion";
 KnCtMotion::KnCtMotion ()
  {
    _motion = 0;
+   _mchannels = 0;
    _play_mode = KnMotion::Linear;
    _duration = 0;
    _twarp = _maxtwarp = _mintwarp = 1.0f;
@@ -24,6 +25,7 @@ KnCtMotion::~KnCtMotion ()
 void KnCtMotion::init ( KnMotion* m )
  {
    if ( _motion ) _motion->unref();
+   if ( _mchannels ) { _mchannels->unref(); _mchannels=0; }
    if ( !m ) { _motion=0; _duration=0; _buffer.init(); return; }
 
    _motion = m;
@@ -34,7 +36,12 @@ void KnCtMotion::init ( KnMotion* m )
 
    disconnect (); // clear flags with respect to previous connections
    _buffer.init ( new KnChannels(*m->channels()) );
-   _motion->connect ( &_buffer );
+
+   // a copy of the motion channels is connected to the buffer, leaving the motion
+   // untouched so that it can be shared and evaluated by several controllers at once:
+   _mchannels = new KnChannels ( *m->channels() );
+   _mchannels->ref();
+   _mchannels->connect ( &_buffer );
  }
 
 void KnCtMotion::warp_limits ( float wmin, float wmax )
@@ -161,11 +168,11 @@ bool KnCtMotion::controller_evaluate ( double t )
    if ( _loop )
 	{ double x = t/_duration;
 	  if ( x>1.0 ) t = _duration *( x-int(x) );
-	  _motion->apply ( float(t)*_twarp, _play_mode, &_last_apply_frame );
+	  KnMotion::apply ( _motion, _mchannels, _last_apply_frame, float(t)*_twarp, _play_mode, 0 );
 	  return true;
 	}
    else
-	{ _motion->apply ( float(t)*_twarp, _play_mode, &_last_apply_frame );
+	{ KnMotion::apply ( _motion, _mchannels, _last_apply_frame, float(t)*_twarp, _play_mode, 0 );
 	  return t>=_duration? false:true; // returns the activation state
 	}
  }
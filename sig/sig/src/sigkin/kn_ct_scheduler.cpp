@@ -13,6 +13,7 @@ KnCtScheduler::KnCtScheduler ()
  {
    _lastt = 0;
    _sk = 0;
+   _domtr = -1;
  }
 
 KnCtScheduler::~KnCtScheduler ()
@@ -166,9 +167,9 @@ bool KnCtScheduler::controller_evaluate ( double t )
 	   }
 
 	  // 2. Evaluate controller if needed:
+	  tloc = t-tstart;
 	  if ( tout<0 || t<tout ) // tout not known or valid and before extension period
 	   { if ( !ct->active() ) ct->start();
-		 tloc = t-tstart;
 		 ct->evaluate ( tloc ); // evaluate to the controller buffer with local time
 	   }
 
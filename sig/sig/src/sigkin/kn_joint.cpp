@@ -24,6 +24,8 @@ KnJoint::KnJoint ( KnSkeleton* kn, KnJoint* parent, RotType rtype, int i )
 
 	_parent = parent;
 
+	_gmat = 0; // set by KnSkeleton::add_joint()
+	_lmat = 0;
 	_lmattodate = 0;
 	_name = 0;
 	_index = i;
@@ -48,7 +50,7 @@ KnJoint::~KnJoint()
 
 void KnJoint::init ( const KnJoint* j )
 {
-	_lmattodate = false;
+	set_lmat_changed ();
 	_rtype = j->_rtype;
 	_name = j->_name;
 	_offset = j->_offset;
@@ -80,6 +82,7 @@ void KnJoint::update_lmat ()
 {
 	if ( _lmattodate ) return;
 	_lmattodate = 1;
+	GsMat& lm = *_lmat;
 
 	// update the 3x3 rotation submatrix if required:
 	if ( !_rot.insync(KnJointRot::JT) )
@@ -99,27 +102,38 @@ void KnJoint::update_lmat ()
 		float z2z = z2*q.z;
 		float z2w = z2*q.w;
 
-		_lmat[0] = 1.0f - y2y - z2z; _lmat[1] = x2y - z2w;		  _lmat[2]  = x2z + y2w;
-		_lmat[4] = x2y + z2w;		 _lmat[5] = 1.0f - x2x - z2z; _lmat[6]  = y2z - x2w;
-		_lmat[8] = x2z - y2w;		 _lmat[9] = y2z + x2w;		  _lmat[10] = 1.0f - x2x - y2y;
+		lm[0] = 1.0f - y2y - z2z; lm[1] = x2y - z2w;        lm[2]  = x2z + y2w;
+		lm[4] = x2y + z2w;        lm[5] = 1.0f - x2x - z2z; lm[6]  = y2z - x2w;
+		lm[8] = x2z - y2w;        lm[9] = y2z + x2w;        lm[10] = 1.0f - x2x - y2y;
 
-		if (_lmat[0]==0 && _lmat[1]==0 && _lmat[2]==0) _lmat=GsMat::id; // to avoid a null matrix
+		if (lm[0]==0 && lm[1]==0 && lm[2]==0) lm=GsMat::id; // to avoid a null matrix
 	}
 
 	// now update offset + translation:
-	_lmat.e14 = _pos.valuex() + _offset.x;
-	_lmat.e24 = _pos.valuey() + _offset.y;
-	_lmat.e34 = _pos.valuez() + _offset.z;
+	lm.e14 = _pos.valuex() + _offset.x;
+	lm.e24 = _pos.valuey() + _offset.y;
+	lm.e34 = _pos.valuez() + _offset.z;
 }
 
-void KnJoint::update_gmat ()
+void KnJoint::_update_gmat_dirty ()
 {
-	update_lmat ();
+	gscbool* dirty = _skeleton->_gdirty.pt();
+	if ( !dirty[_index] ) return;
 
+	update_lmat ();
 	if ( _parent )
-	{	_gmat.multaff ( _parent->_gmat, _lmat ); }
+		_gmat->multaff ( *_parent->_gmat, *_lmat );
 	else
-	{	_gmat = _lmat; }
+		*_gmat = *_lmat;
+
+	// the children now depend on a new matrix:
+	dirty[_index] = 0;
+	for ( int i=0, s=_children.size(); i<s; i++ ) dirty[_children[i]->_index] = 1;
+}
+
+void KnJoint::update_gmat ()
+{
+	_update_gmat_dirty ();
 
 	for ( int i=0, s=_children.size(); i<s; i++ )
 	{	_children[i]->update_gmat();
@@ -128,11 +142,7 @@ void KnJoint::update_gmat ()
 
 void KnJoint::update_gmat ( KnJoint*stopjoint1, KnJoint*stopjoint2 )
 {
-	const GsMat& pmat = _parent? _parent->_gmat : GsMat::id;
-
-	update_lmat ();
-
-	_gmat.multaff ( pmat, _lmat );
+	_update_gmat_dirty ();
 
 	if ( this==stopjoint1 || this==stopjoint2 ) return;
 
@@ -144,24 +154,19 @@ void KnJoint::update_gmat ( KnJoint*stopjoint1, KnJoint*stopjoint2 )
 void KnJoint::update_branch_gmat ( KnJoint* stopjoint )
 {
 	// first update this joint (it may be the root):
-	update_gmat_local ();
+	_update_gmat_dirty ();
 
 	// now continue:
 	KnJoint* j = this;
 	while ( j!=stopjoint && j->_children.size() )
 	{	j = j->_children[0];
-		j->update_lmat ();
-		j->_gmat.multaff ( j->_parent->_gmat, j->_lmat );
+		j->_update_gmat_dirty ();
 	}
 }
 
 void KnJoint::update_gmat_local ()
 {
-	update_lmat ();
-	if ( _parent )
-		_gmat.multaff ( _parent->_gmat, _lmat );
-	else
-		_gmat = _lmat;
+	_update_gmat_dirty ();
 }
 
 void KnJoint::update_gmat_up ( KnJoint* stopjoint )
@@ -176,13 +181,14 @@ void KnJoint::update_gmat_up ( KnJoint* stopjoint )
 	}	while ( j!=0 && j!=stopjoint );
 	  
 	while ( joints.size() )
-	{	joints.pop()->update_gmat_local();
+	{	joints.pop()->_update_gmat_dirty();
 	}
 }
 
 void KnJoint::set_lmat_changed ()
 {
 	_lmattodate = 0;
+	_skeleton->_gdirty[_index] = 1;
 	_skeleton->invalidate_global_matrices();
 }
 
@@ -38,5 +38,12 @@ void KnMConnection::apply_frame ( int f )
 	int fs = _motion->frames();
 	if ( f>=fs ) f=fs-1;
 	if ( f<0 ) f=0;
+	const KnMotionPack* pack = _motion->frames_pack();
+	if ( pack )
+	{	GsArray<float> values ( pack->postfloats() );
+		pack->sample ( f, 0, values.pt() );
+		_channels->apply ( values.pt() );
+		return;
+	}
 	_channels->apply ( _motion->posture(f)->values.pt() );
 }
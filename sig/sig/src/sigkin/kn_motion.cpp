@@ -9,6 +9,7 @@
 # include <sigkin/kn_motion.h>
 # include <sigkin/kn_posture.h>
 # include <sigkin/kn_skeleton.h>
+# include <sigkin/kn_channel_layout.h>
 
 //============================= KnMotion ============================
 
@@ -19,6 +20,7 @@ KnMotion::KnMotion()
    _last_apply_frame = 0;
    _freq = 0;
    _userdata = 0;
+   _pack = 0;
  }
 
 KnMotion::~KnMotion()
@@ -31,8 +33,10 @@ KnMotion::~KnMotion()
 
 void KnMotion::init()
  {
-   while ( _frames.size()>0 ) _frames.pop().posture->unref();
+   while ( _frames.size()>0 ) { KnPosture* p=_frames.pop().posture; if ( p ) p->unref(); }
    _last_apply_frame = 0;
+   delete _pack;
+   _pack = 0;
  }
 
 void KnMotion::compress ()
@@ -89,6 +93,7 @@ bool KnMotion::insert_channel ( int pos, KnJointName jname, KnChannel::Type type
  {
    KnChannels* chs = channels();
    if ( !chs ) return false;
+   if ( _pack ) unpack_frames();
 
    // Insert channel:
    if ( !chs->insert(pos,type) ) return false;
@@ -112,6 +117,7 @@ bool KnMotion::insert_channel ( int pos, KnJointName jname, KnChannel::Type type
 bool KnMotion::remove_frame (int pos )
  {
    if ( pos<0 || pos>=_frames.size() ) return false;
+   if ( _pack ) unpack_frames();
    _frames.get(pos).posture->unref();
    _frames.remove(pos);
    return true;
@@ -120,6 +126,7 @@ bool KnMotion::remove_frame (int pos )
 bool KnMotion::insert_frame ( int pos, float kt, KnPosture* p )
  {
    if ( pos<0 || pos>_frames.size() ) return false;
+   if ( _pack ) unpack_frames();
    _frames.insert ( pos );
    _frames[pos].keytime = kt;
    _frames[pos].posture = p;
@@ -130,6 +137,7 @@ bool KnMotion::insert_frame ( int pos, float kt, KnPosture* p )
 
 void KnMotion::dfjoints ( KnPostureDfJoints* dfjoints )
  {
+   if ( _pack ) unpack_frames();
    int f, frsize = _frames.size();
    for ( f=0; f<frsize; f++ )
 	{ _frames[f].posture->dfjoints ( dfjoints );
@@ -161,9 +169,41 @@ void KnMotion::apply_frame ( int f )
 	int fs = _frames.size();
 	if ( f>=fs ) f=fs-1;
 	if ( f<0 ) f=0;
+	if ( _pack )
+	{	GsArray<float> values ( _pack->postfloats() );
+		_pack->sample ( f, 0, values.pt() );
+		channels()->apply ( values.pt() );
+		return;
+	}
 	_frames[f].posture->apply();
 }
 
+bool KnMotion::pack_frames ( const KnMotionPack::Params& p )
+{
+	if ( _frames.empty() || _pack ) return false;
+	_pack = new KnMotionPack;
+	_pack->build ( this, p );
+	for ( int f=1; f<_frames.size(); f++ )
+	{	_frames[f].posture->unref();
+		_frames[f].posture = 0;
+	}
+	return true;
+}
+
+void KnMotion::unpack_frames ()
+{
+	if ( !_pack ) return;
+	KnPosture* p0 = _frames[0].posture;
+	for ( int f=1; f<_frames.size(); f++ )
+	{	KnPosture* p = new KnPosture ( *p0 );
+		_pack->sample ( f, 0, p->values.pt() );
+		p->ref();
+		_frames[f].posture = p;
+	}
+	delete _pack;
+	_pack = 0;
+}
+
 // Utility to use chosen interpolation type
 inline float _interp ( KnMotion::InterpType itype, float t, float tmin, float tmax )
 {	if ( itype==KnMotion::Linear ) return t;
@@ -172,6 +212,35 @@ inline float _interp ( KnMotion::InterpType itype, float t, float tmin, float tm
 	return t*(tmax-tmin) + tmin; // scale back
 }
 
+int KnMotion::search_frame ( float t, int hint ) const
+{
+	int fsize = _frames.size();
+	if ( fsize==0 || t<_frames[0].keytime ) return -1;
+	if ( t>=_frames[fsize-1].keytime ) return fsize-1;
+
+	// from here keytime(0)<=t<keytime(fsize-1) and the result is in [0,fsize-2]
+	const Frame* fr = _frames.pt();
+	int i, f, guess[2] = { hint, -1 };
+	if ( _freq>0 ) guess[1] = int ( (t-fr[0].keytime)/_freq );
+	for ( i=0; i<2; i++ )
+	{	if ( guess[i]<0 ) continue;
+		f = guess[i]>fsize-2? fsize-2 : guess[i];
+		if ( fr[f].keytime<=t )
+		{	if ( t<fr[f+1].keytime ) return f;
+			if ( f+1<fsize-1 && t<fr[f+2].keytime ) return f+1; // next frame
+		}
+		else if ( f>0 && fr[f-1].keytime<=t ) return f-1; // previous frame
+	}
+
+	// binary search keeping keytime(a)<=t<keytime(b):
+	int a=0, b=fsize-1;
+	while ( b-a>1 )
+	{	f = (a+b)/2;
+		if ( t<fr[f].keytime ) b=f; else a=f;
+	}
+	return a;
+}
+
 void KnMotion::apply ( KnMotion* m, KnChannels* c, int& lastf, float t, KnMotion::InterpType itype, int* lastframe ) // static
 {
 	int fsize=m->frames();
@@ -182,45 +251,39 @@ void KnMotion::apply ( KnMotion* m, KnChannels* c, int& lastf, float t, KnMotion
    
 	t = _interp ( itype, t, kt0, m->keytime(fsize-1) );
 
-	// optimize keytime search for sequenced calls with increasing t
-	int fini=0;
+	// keytime search starting from the last frame, for sequenced calls:
 	if ( lastframe ) lastf = *lastframe;
-	if ( lastf>0 && lastf<fsize )
-	{	if ( t>m->keytime(lastf) ) fini=lastf+1;
-	}
-
-	int i, f;
-	for ( f=fini; f<fsize; f++ )
-	{	if ( t<m->keytime(f) ) break; }
+	int f = m->search_frame ( t, lastf );
 
-	if ( f==fsize ) { c->apply(m->posture(f-1)->values.pt()); return; }
+	if ( f<0 ) return;
+	if ( f==fsize-1 && !m->_pack ) { c->apply(m->posture(f)->values.pt()); return; }
 
-	f--;
 	lastf = f;
 	if ( lastframe ) *lastframe = lastf;
 
-	float* fp1 = &(m->posture(f)->values[0]);
-	float* fp2 = &(m->posture(f+1)->values[0]);
+	// packed motions decompress the interpolated values:
+	const KnChannelLayout& layout = c->layout();
+	float stackbuf[512];
+	GsArray<float> heapbuf;
+	float* values = stackbuf;
+	if ( layout.floats()>512 ) { heapbuf.size(layout.floats()); values=heapbuf.pt(); }
+	if ( m->_pack )
+	{	kt0 = m->keytime(f);
+		m->_pack->sample ( f, f==fsize-1? 0 : (t-kt0)/(m->keytime(f+1)-kt0), values );
+		c->apply ( values );
+		return;
+	}
+
+	const float* fp1 = m->posture(f)->values.pt();
+	const float* fp2 = m->posture(f+1)->values.pt();
 	// convert t to [0,1] according to the adjacent keytimes:
 	kt0 = m->keytime(f);
 	t = (t-kt0) / (m->keytime(f+1)-kt0);
 
 	//gsout<<"t: "<<t<<" frames: "<<f<<gspc<<(f+1)<<"\n";
-	int chfloats;
-	int numchs = c->size();
-
-	float values[4]; // 4 is the max num of values per channel
-	for ( i=0; i<numchs; i++ )
-	{	KnChannel& ch = c->get(i);
-		if ( ch.status()!=KnChannel::Disconnected )
-		{	ch.interp ( fp1, fp2, t, values );
-			chfloats = ch.apply ( values );
-		}
-		else
-		{	chfloats = ch.size();
-		}
-		fp1+=chfloats; fp2+=chfloats;
-	}
+	// interpolate all values with the channel layout and then apply them:
+	layout.interp ( fp1, fp2, t, values );
+	c->apply ( values );
 }
 
 const char* KnMotion::interp_type_name ( InterpType type ) // static
@@ -252,7 +315,8 @@ void KnMotion::operator = ( const KnMotion& m )
 
    int i, fsize = m._frames.size();
    for ( i=0; i<fsize; i++ )
-	{ insert_frame ( i, m.keytime(i), new KnPosture ( *m.posture(i) ) );
+	{ insert_frame ( i, m.keytime(i), new KnPosture ( *m.posture(m._pack?0:i) ) );
+	  if ( m._pack ) m._pack->sample ( i, 0, posture(i)->values.pt() );
 	  posture(i)->dfjoints ( dfj );
 	  posture(i)->channels ( chs );
 	}
@@ -287,6 +351,7 @@ int KnMotion::correct_euler_angles ()
    int count=0;
    
    if ( frsize<=1 ) return count;
+   if ( _pack ) unpack_frames();
 
    KnChannel::Type type;
    KnChannels* chs = channels();
@@ -312,6 +377,7 @@ void KnMotion::change_values ( int f1, int f2, int channel, float mfactor, const
  {
    int frsize = _frames.size();
    if ( frsize==0 ) return;
+   if ( _pack ) unpack_frames();
    f2 = GS_BOUND(f2,0,(frsize-1));
    f1 = GS_BOUND(f1,0,f2);
    KnChannels* chs = channels();
@@ -324,6 +390,7 @@ void KnMotion::change_values ( int f1, int f2, int channel, float mfactor, const
 
 void KnMotion::mirror ( const char* left, const char* right, bool printerrors )
  {
+   if ( _pack ) unpack_frames();
    for ( unsigned int f=0; f<frames(); f++ )
 	{ apply_frame(f);
 	  posture(f)->mirror ( left, right, printerrors );
@@ -332,6 +399,8 @@ void KnMotion::mirror ( const char* left, const char* right, bool printerrors )
 
 void KnMotion::append ( KnMotion* m, float deltakt )
  {
+   if ( _pack ) unpack_frames();
+   if ( m->_pack ) m->unpack_frames();
    float ikt = last_keytime()+deltakt;
    for ( gsuint f=0; f<m->frames(); f++ )
 	{ add_frame ( m->keytime(f)+ikt, m->posture(f) );
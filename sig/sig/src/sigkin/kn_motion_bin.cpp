@@ -0,0 +1,235 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <string.h>
+# include <sig/gs_mapped_file.h>
+# include <sigkin/kn_motion.h>
+
+//# define GS_USE_TRACE1 // IO
+# include <sig/gs_trace.h>
+
+//================================ format ==================================
+
+/* The binary format follows the one of GsModel::save_bin(): a BinHeader is followed by
+   the sections it lists, each one starting at an offset multiple of 16 from the start of
+   the file. Channels are stored with offsets of their joint names in the strings section.
+   The values section has the values of all frames, one posture after the other, so that
+   each posture can be copied with a single memcpy(). When the file is a cache of a text
+   motion file, the size and modification time of the source file are also stored. */
+
+static const char BinMagic[8] = { '\x89', 'K', 'N', 'M', '\r', '\n', '\x1a', '\n' };
+static const gsuint32 BinVersion = 1;
+static const gsuint32 BinByteOrder = 0x01020304;
+static const int BinAlign = 16;
+
+enum BinSections { SecChannels, SecStrings, SecKeytimes, SecValues, NumSections };
+
+struct BinSection
+{	uint64_t offset; // position in the file
+	gsint32 count;	 // number of elements
+	gsint32 size;	 // size of each element
+};
+
+struct BinHeader
+{	char magic[8];
+	gsuint32 version;
+	gsuint32 byteorder;
+	uint64_t srcsize;  // size of the source file, or 0
+	uint64_t srctime;  // modification time of the source file, or 0
+	gsint32 name;	   // offset of the motion name in the strings section, or -1
+	gsint32 postfloats;
+	float freq;
+	gsint32 reserved;
+	BinSection sec[NumSections];
+};
+
+struct BinChannel
+{	gsint32 jname; // offset in the strings section
+	gsint32 type;
+};
+
+static void section_sizes ( int* size )
+{
+	int s[NumSections] = { sizeof(BinChannel), 1, sizeof(float), sizeof(float) };
+	memcpy ( size, s, sizeof(s) );
+}
+
+//================================ save ==================================
+
+static int add_string ( GsArray<char>& strings, const char* s )
+{
+	int pos = strings.size();
+	int len = (int)strlen(s)+1;
+	strings.size ( pos+len );
+	memcpy ( &strings[pos], s, len );
+	return pos;
+}
+
+bool KnMotion::binary_file ( const char* file )
+{
+	FILE* fp = fopen ( file, "rb" );
+	if ( !fp ) return false;
+	char sig[8];
+	bool ok = fread(sig,1,8,fp)==8 && memcmp(sig,BinMagic,8)==0;
+	fclose ( fp );
+	return ok;
+}
+
+bool KnMotion::save_bin ( const char* file, const char* source ) const
+{
+	GS_TRACE1 ( "Saving binary motion "<<file<<"..." );
+	KnChannels* chs = channels();
+	if ( !chs ) return false;
+
+	BinHeader hd;
+	memset ( &hd, 0, sizeof(BinHeader) );
+	if ( source )
+	{	if ( !gs_exists(source) ) return false;
+		hd.srcsize = gs_sizel ();
+		hd.srctime = gs_mtime ( 0 );
+	}
+
+	FILE* fp = fopen ( file, "wb" );
+	if ( !fp ) return false;
+
+	GsArray<char> strings;
+	GsArray<BinChannel> bch ( chs->size() );
+	for ( int i=0; i<chs->size(); i++ )
+	{	bch[i].jname = add_string ( strings, chs->cget(i).jname().st() );
+		bch[i].type = chs->cget(i).type();
+	}
+	int fsize = _frames.size();
+	GsArray<float> keytimes ( fsize );
+	for ( int f=0; f<fsize; f++ ) keytimes[f] = _frames[f].keytime;
+
+	memcpy ( hd.magic, BinMagic, 8 );
+	hd.version = BinVersion;
+	hd.byteorder = BinByteOrder;
+	hd.name = _name? add_string(strings,_name) : -1;
+	hd.postfloats = postfloats();
+	hd.freq = _freq;
+
+	const void* data[NumSections] = { bch.pt(), strings.pt(), keytimes.pt(), 0 };
+	int count[NumSections] = { bch.size(), strings.size(), fsize, fsize*hd.postfloats };
+	int size[NumSections];
+	section_sizes ( size );
+	uint64_t pos = sizeof(BinHeader);
+	for ( int s=0; s<NumSections; s++ )
+	{	pos = (pos+BinAlign-1)/BinAlign*BinAlign;
+		hd.sec[s].offset = pos;
+		hd.sec[s].count = count[s];
+		hd.sec[s].size = size[s];
+		pos += uint64_t(count[s])*size[s];
+	}
+
+	static const char zeros[BinAlign] = { 0 };
+	bool ok = fwrite ( &hd, sizeof(BinHeader), 1, fp )==1;
+	pos = sizeof(BinHeader);
+	for ( int s=0; s<NumSections && ok; s++ )
+	{	if ( hd.sec[s].offset>pos ) ok = fwrite ( zeros, size_t(hd.sec[s].offset-pos), 1, fp )==1;
+		size_t n = size_t(count[s])*size[s];
+		if ( s==SecValues ) // values are written frame by frame, decompressing packed frames
+		{	GsArray<float> values ( _pack? hd.postfloats:0 );
+			for ( int f=0; f<fsize && ok; f++ )
+			{	const float* v = _frames[f].posture? _frames[f].posture->values.pt() : values.pt();
+				if ( !_frames[f].posture ) _pack->sample ( f, 0, values.pt() );
+				ok = fwrite ( v, sizeof(float)*hd.postfloats, 1, fp )==1 || hd.postfloats==0;
+			}
+		}
+		else if ( n ) ok = ok && fwrite ( data[s], n, 1, fp )==1;
+		pos = hd.sec[s].offset+n;
+	}
+	if ( fclose(fp)!=0 ) ok=false;
+	GS_TRACE1 ( (ok?"Done.":"Error!") );
+	return ok;
+}
+
+//================================ load ==================================
+
+bool KnMotion::load_bin ( const char* file, const char* source )
+{
+	GS_TRACE1 ( "Loading binary motion "<<file<<"..." );
+	GsMappedFile mf;
+	if ( !mf.open(file) ) return false;
+	if ( mf.size()<sizeof(BinHeader) ) return false;
+
+	BinHeader hd;
+	memcpy ( &hd, mf.data(), sizeof(BinHeader) );
+	if ( memcmp(hd.magic,BinMagic,8)!=0 || hd.version!=BinVersion || hd.byteorder!=BinByteOrder ) return false;
+
+	// a cache is only valid if its source did not change:
+	if ( source )
+	{	if ( !gs_exists(source) ) return false;
+		if ( hd.srcsize!=gs_sizel() || hd.srctime!=gs_mtime(0) ) { GS_TRACE1 ( "Outdated." ); return false; }
+	}
+
+	// validate sections before changing the motion:
+	int size[NumSections];
+	section_sizes ( size );
+	for ( int s=0; s<NumSections; s++ )
+	{	const BinSection& sec = hd.sec[s];
+		if ( sec.size!=size[s] || sec.count<0 || sec.offset%BinAlign!=0 ) return false;
+		if ( sec.offset>mf.size() || uint64_t(sec.count)*sec.size>mf.size()-sec.offset ) return false;
+	}
+	const char* data = mf.data();
+	const BinSection& strsec = hd.sec[SecStrings];
+	const char* strings = data+strsec.offset;
+	int fsize = hd.sec[SecKeytimes].count;
+	if ( strsec.count>0 && strings[strsec.count-1]!=0 ) return false;
+	if ( hd.name>=strsec.count || hd.postfloats<0 || fsize<1 ) return false;
+	if ( hd.sec[SecValues].count!=fsize*hd.postfloats ) return false;
+	const BinChannel* bch = (const BinChannel*)(data+hd.sec[SecChannels].offset);
+	for ( int i=0; i<hd.sec[SecChannels].count; i++ )
+	{	if ( bch[i].jname<0 || bch[i].jname>=strsec.count ) return false;
+		if ( bch[i].type<0 || bch[i].type>KnChannel::IKGoal ) return false;
+	}
+
+	KnChannels* chs = new KnChannels;
+	for ( int i=0; i<hd.sec[SecChannels].count; i++ ) chs->add ( strings+bch[i].jname, (KnChannel::Type)bch[i].type );
+	if ( chs->floats()!=hd.postfloats ) { delete chs; return false; }
+
+	init ();
+	if ( hd.name>=0 ) name ( strings+hd.name );
+	filename ( source? source:file );
+	_freq = hd.freq;
+
+	const float* keytimes = (const float*)(data+hd.sec[SecKeytimes].offset);
+	const float* values = (const float*)(data+hd.sec[SecValues].offset);
+	_frames.size ( fsize );
+	for ( int f=0; f<fsize; f++ )
+	{	_frames[f].keytime = keytimes[f];
+		KnPosture* p = _frames[f].posture = new KnPosture ( chs );
+		p->ref();
+		memcpy ( p->values.pt(), values+f*hd.postfloats, sizeof(float)*hd.postfloats );
+	}
+
+	GS_TRACE1 ( "Done." );
+	return true;
+}
+
+//================================ cache ==================================
+
+static bool _use_cache = true;
+
+void KnMotion::use_cache ( bool b )
+{
+	_use_cache = b;
+}
+
+bool KnMotion::use_cache ()
+{
+	return _use_cache;
+}
+
+void KnMotion::cache_file ( const char* source, GsString& file )
+{
+	file = source;
+	file << ".kmb";
+}
+
+//============================= EOF ===================================
@@ -162,9 +162,19 @@ bool KnMotion::load_bvh ( GsInput& in )
 bool KnMotion::load ( const char* filename )
  {
    //GS_TRACE3("Load from file...");
+   if ( binary_file(filename) ) return load_bin ( filename );
+
+   GsString cache;
+   if ( use_cache() )
+	{ cache_file ( filename, cache );
+	  if ( load_bin(cache,filename) ) return true;
+	}
+
    GsInput in;
    if ( !in.open(filename) ) return false;
    if ( !load(in) ) return false;
+
+   if ( cache.len() && !_userdata ) save_bin ( cache, filename ); // (re)generate cache
    return true;
  }
 
@@ -281,11 +291,14 @@ bool KnMotion::save ( GsOutput& out )
 
    int i;
    /*chsize = */ chs->size();
+   KnPosture* p = _pack? new KnPosture(*posture(0)) : 0; // to decompress packed frames
    for ( i=0; i<_frames.size(); i++ )
 	{ out << "kt " << _frames[i].keytime << " fr ";
-	  _frames[i].posture->output(out,false,true);
+	  if ( p ) { _pack->sample(i,0,p->values.pt()); p->output(out,false,true); }
+	  else _frames[i].posture->output(out,false,true);
 	}
    out << gsnl;
+   delete p;
 
    if ( _userdata ) out << "userdata" << gsnl << *_userdata << gsnl;
 
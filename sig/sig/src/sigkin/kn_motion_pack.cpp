@@ -0,0 +1,278 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+# include <string.h>
+# include <sig/gs_quat.h>
+# include <sigkin/kn_motion.h>
+# include <sigkin/kn_motion_pack.h>
+# include <sigkin/kn_channel_layout.h>
+
+//============================ static functions ============================
+
+// keys of reduced curves are at most this number of frames apart:
+static const int MaxSpan = 255;
+
+// keys are stored as 16 bit frame indices:
+static const int MaxKeyFrames = 65536;
+
+// smallest-three components are in [-1/sqrt(2),1/sqrt(2)] and quantized in 15 bits:
+static const float QRange = 0.70710678f;
+static const float QScale = 32767.0f;
+
+static float angdist ( float a, float b )
+{
+	float d = fmodf ( fabsf(a-b), float(gs2pi) );
+	return d>float(gspi)? float(gs2pi)-d : d;
+}
+
+// rotation angle between two unit quaternions, using the chord length for precision with small angles:
+static float quatdist ( const float* q1, const float* q2 )
+{
+	float s = q1[0]*q2[0] + q1[1]*q2[1] + q1[2]*q2[2] + q1[3]*q2[3] < 0? -1.0f : 1.0f;
+	float d=0;
+	for ( int i=0; i<4; i++ ) d += (q1[i]-s*q2[i])*(q1[i]-s*q2[i]);
+	d = sqrtf(d)/2.0f;
+	return d>=1.0f? float(gs2pi) : 4.0f*asinf(d);
+}
+
+static inline float lerp ( KnMotionPack::CurveType type, float a, float b, float t )
+{
+	return type==KnMotionPack::Linear? a*(1.0f-t)+b*t : gs_anglerp(a,b,t);
+}
+
+static inline float fdist ( KnMotionPack::CurveType type, float a, float b )
+{
+	return type==KnMotionPack::Linear? GS_DIST(a,b) : angdist(a,b);
+}
+
+// true if all values between frames a and b are interpolated from a and b within tol:
+static bool fits ( KnMotionPack::CurveType type, const float* v, int a, int b, float tol )
+{
+	float d = float(b-a);
+	for ( int i=a+1; i<b; i++ )
+	{	if ( fdist ( type, lerp(type,v[a],v[b],float(i-a)/d), v[i] )>tol ) return false;
+	}
+	return true;
+}
+
+// same as above, with quantized keys in qd and original quaternions in q:
+static bool fits ( const float* qd, const float* q, int a, int b, float tol )
+{
+	float d = float(b-a);
+	float qa[4], s[4];
+	for ( int i=a+1; i<b; i++ )
+	{	memcpy ( qa, qd+a*4, sizeof(float)*4 ); // gslerp may change its 1st argument
+		gslerp ( qa, qd+b*4, float(i-a)/d, s );
+		if ( quatdist(s,q+i*4)>tol ) return false;
+	}
+	return true;
+}
+
+// index of the key before or at frame f in keys[0..n-1], with keys[0]==0:
+static inline int keysearch ( const gsuint16* keys, int n, int f )
+{
+	int a=0, b=n;
+	while ( b-a>1 )
+	{	int m = (a+b)/2;
+		if ( f<keys[m] ) b=m; else a=m;
+	}
+	return a;
+}
+
+//============================ KnMotionPack::Stats ============================
+
+void KnMotionPack::Stats::output ( GsOutput& o ) const
+{
+	o << "frames " << frames << ", curves " << curves << ", constants " << constants
+	  << ", keys " << keys << ", bytes " << rawbytes << " -> " << packedbytes
+	  << " (" << (packedbytes? float(rawbytes)/float(packedbytes):0) << "x)"
+	  << ", max errors: linear " << linerror << ", angular " << angerror;
+}
+
+//============================ KnMotionPack ============================
+
+KnMotionPack::KnMotionPack ()
+{
+	init ();
+}
+
+void KnMotionPack::init ()
+{
+	_curves.size(0); _base.size(0); _keys.size(0); _fdata.size(0); _qdata.size(0);
+	_frames = 0;
+	memset ( &_stats, 0, sizeof(Stats) );
+}
+
+void KnMotionPack::encode ( const float* q, gsuint16* w )
+{
+	int i, k, imax=0;
+	for ( i=1; i<4; i++ ) if ( fabsf(q[i])>fabsf(q[imax]) ) imax=i;
+	float s = q[imax]<0? -1.0f : 1.0f; // the largest component is kept positive
+	for ( i=0, k=0; i<4; i++ )
+	{	if ( i==imax ) continue;
+		float c = GS_BOUND ( s*q[i], -QRange, QRange );
+		w[k++] = gsuint16 ( ((c/QRange)*0.5f+0.5f)*QScale+0.5f );
+	}
+	w[0] |= gsuint16 ( (imax&1)<<15 );
+	w[1] |= gsuint16 ( (imax&2)<<14 );
+}
+
+void KnMotionPack::decode ( const gsuint16* w, float* q )
+{
+	int i, k, imax = ((w[0]>>15)&1) | ((w[1]>>14)&2);
+	float s=0;
+	for ( i=0, k=0; i<4; i++ )
+	{	if ( i==imax ) continue;
+		float c = ( float(w[k++]&0x7FFF)/QScale*2.0f-1.0f )*QRange;
+		q[i] = c;
+		s += c*c;
+	}
+	q[imax] = s<1.0f? sqrtf(1.0f-s) : 0;
+}
+
+void KnMotionPack::build ( const KnMotion* m, const Params& p )
+{
+	init ();
+	const KnChannelLayout& layout = m->channels()->layout();
+	int nf = _frames = m->frames();
+	int i, f, n = m->postfloats();
+	bool reduce = p.reduce && nf<=MaxKeyFrames;
+	_base.size ( n );
+	memcpy ( _base.pt(), m->posture(0)->values.pt(), sizeof(float)*n );
+
+	GsArray<float> v(nf), q(nf*4), qd(nf*4);
+	GsArray<int> keys;
+	keys.reserve ( nf );
+
+	// linear values and angles:
+	for ( i=0; i<layout.linears()+layout.angles(); i++ )
+	{	bool lin = i<layout.linears();
+		CurveType type = lin? Linear : Angle;
+		int pos = lin? layout.linear(i).pos : layout.angle(i-layout.linears()).pos;
+		float tol = lin? p.lintol : p.angtol;
+		bool constant=true;
+		for ( f=0; f<nf; f++ )
+		{	v[f] = m->posture(f)->values[pos];
+			if ( fdist(type,v[f],v[0])>tol ) constant=false;
+		}
+		if ( constant ) { _stats.constants++; continue; }
+
+		keys.size(0);
+		keys.push() = 0;
+		for ( int a=0, b; a<nf-1; a=b )
+		{	b = a+1;
+			if ( reduce ) while ( b+1<nf && b+1-a<=MaxSpan && fits(type,v.pt(),a,b+1,tol) ) b++;
+			keys.push() = b;
+		}
+
+		Curve& c = _curves.push();
+		c.pos=pos; c.type=(gscenum)type; c.nkeys=keys.size(); c.data=_fdata.size();
+		c.key = keys.size()==nf? -1 : _keys.size();
+		for ( f=0; f<keys.size(); f++ )
+		{	_fdata.push() = v[keys[f]];
+			if ( c.key>=0 ) _keys.push() = gsuint16(keys[f]);
+		}
+	}
+
+	// quaternions:
+	gsuint16 w[3];
+	for ( i=0; i<layout.quats(); i++ )
+	{	int pos = layout.quat(i).pos;
+		bool constant=true;
+		for ( f=0; f<nf; f++ )
+		{	memcpy ( q.pt()+f*4, m->posture(f)->values.pt()+pos, sizeof(float)*4 );
+			encode ( q.pt()+f*4, w );
+			decode ( w, qd.pt()+f*4 );
+			if ( quatdist(q.pt()+f*4,q.pt())>p.angtol ) constant=false;
+		}
+		if ( constant ) { _stats.constants++; continue; }
+
+		keys.size(0);
+		keys.push() = 0;
+		for ( int a=0, b; a<nf-1; a=b )
+		{	b = a+1;
+			if ( reduce ) while ( b+1<nf && b+1-a<=MaxSpan && fits(qd.pt(),q.pt(),a,b+1,p.angtol) ) b++;
+			keys.push() = b;
+		}
+
+		Curve& c = _curves.push();
+		c.pos=pos; c.type=(gscenum)Quat; c.nkeys=keys.size(); c.data=_qdata.size();
+		c.key = keys.size()==nf? -1 : _keys.size();
+		for ( f=0; f<keys.size(); f++ )
+		{	encode ( q.pt()+keys[f]*4, w );
+			_qdata.push()=w[0]; _qdata.push()=w[1]; _qdata.push()=w[2];
+			if ( c.key>=0 ) _keys.push() = gsuint16(keys[f]);
+		}
+	}
+
+	_curves.compress(); _keys.compress(); _fdata.compress(); _qdata.compress();
+
+	// statistics:
+	_stats.frames = nf;
+	_stats.curves = _curves.size();
+	for ( i=0; i<_curves.size(); i++ ) _stats.keys += _curves[i].nkeys;
+	_stats.rawbytes = gsuint32 ( nf*(sizeof(KnPosture)+sizeof(float)*n) );
+	_stats.packedbytes = bytes ();
+	GsArray<float> s(n);
+	for ( f=0; f<nf; f++ )
+	{	sample ( f, 0, s.pt() );
+		const float* o = m->posture(f)->values.pt();
+		for ( i=0; i<layout.linears(); i++ )
+		{	int k = layout.linear(i).pos;
+			_stats.linerror = GS_MAX ( _stats.linerror, GS_DIST(s[k],o[k]) );
+		}
+		for ( i=0; i<layout.angles(); i++ )
+		{	int k = layout.angle(i).pos;
+			_stats.angerror = GS_MAX ( _stats.angerror, angdist(s[k],o[k]) );
+		}
+		for ( i=0; i<layout.quats(); i++ )
+		{	int k = layout.quat(i).pos;
+			_stats.angerror = GS_MAX ( _stats.angerror, quatdist(s.pt()+k,o+k) );
+		}
+	}
+}
+
+gsuint32 KnMotionPack::bytes () const
+{
+	return gsuint32 ( sizeof(KnMotionPack) + sizeof(Curve)*_curves.size() + sizeof(float)*_base.size() +
+					  sizeof(gsuint16)*_keys.size() + sizeof(float)*_fdata.size() + sizeof(gsuint16)*_qdata.size() );
+}
+
+void KnMotionPack::sample ( int f, float t, float* values ) const
+{
+	memcpy ( values, _base.pt(), sizeof(float)*_base.size() );
+
+	float q1[4], q2[4];
+	for ( int i=0; i<_curves.size(); i++ )
+	{	const Curve& c = _curves[i];
+
+		// find the keys k and k+1 around frame f, and the parameter u between them:
+		int k=f; float u=t;
+		if ( c.key>=0 )
+		{	const gsuint16* keys = _keys.pt()+c.key;
+			k = keysearch ( keys, c.nkeys, f );
+			if ( k<c.nkeys-1 ) u = ( float(f-keys[k])+t ) / float(keys[k+1]-keys[k]);
+		}
+		bool last = k>=c.nkeys-1;
+
+		if ( c.type==Quat )
+		{	const gsuint16* w = _qdata.pt()+c.data+k*3;
+			float* q = values+c.pos;
+			if ( last || u==0 ) { decode ( w, q ); continue; }
+			decode ( w, q1 );
+			decode ( w+3, q2 );
+			gslerp ( q1, q2, u, q );
+		}
+		else
+		{	const float* v = _fdata.pt()+c.data+k;
+			values[c.pos] = last || u==0? v[0] : lerp ( (CurveType)c.type, v[0], v[1], u );
+		}
+	}
+}
+
+//============================ End of File ============================
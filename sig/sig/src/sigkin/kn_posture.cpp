@@ -7,6 +7,7 @@
  
 # include <sigkin/kn_skeleton.h>
 # include <sigkin/kn_posture.h>
+# include <sigkin/kn_channel_layout.h>
 
 //# define GS_USE_TRACE1  // trace
 //# include <sig/gs_trace.h>
@@ -304,54 +305,24 @@ void interp ( const KnPosture& p1, const KnPosture& p2, float t, KnPosture& p )
 {
 	//gsout<<"SIZES: "<< p1.values.size()<<gspc<<p2.values.size()<<gspc<<p.values.size()<<gsnl;
 
-	KnChannels& ch = *p._channels;
-	const float* fp1 = &p1.values[0];
-	const float* fp2 = &p2.values[0];
-	float* fp = &p.values[0];
-	int chsize=ch.size();
-	int i, dp;
-
-	for ( i=0; i<chsize; i++ )
-	{	dp = ch[i].interp ( fp1, fp2, t, fp );
-		fp1 += dp;
-		fp2 += dp;
-		fp += dp;
-	}
-
+	p._channels->layout().interp ( p1.values.pt(), p2.values.pt(), t, p.values.pt() );
 	p._syncpoints = false;
 }
 
 void interp ( const KnPosture& p, float t )
 {
-	KnChannels& ch = *p._channels;
-	const float* fp1 = p.values.pt();
-	int i, chsize=ch.size();
-	for ( i=0; i<chsize; i++ )
-	{	float* fp2 = ch[i].buffer(); // get buffer pointer of the channel connection
-		if ( !fp2 ) { fp1+=ch[i].size(); continue; } // not connected
-		fp1 += ch[i].interp ( fp1, fp2, t, fp2 );
-	}
+	p._channels->layout().interp ( p.values.pt(), t, *p._channels );
 }
 
 void interp ( const GsArray<KnPosture*>& postures, const GsArray<float>& w, 
 			  KnPosture& p, GsArray<float*>& buffer )
  {
-   int i, j, dp, psize=postures.size();
+   int i, psize=postures.size();
 
    buffer.size ( psize );
-   KnChannels& ch = *p._channels;
-   for ( i=0; i<psize; i++ ) buffer[i]= &(postures[i]->values[0]);
-
-   float* fp = &p.values[0];
-   int chsize=ch.size();
-
-   for ( i=0; i<chsize; i++ )
-	{ //gsout<<ch[i].jname()<<gsnl;
-	  dp = ch[i].interp ( buffer, w, fp );
-	  for ( j=0; j<psize; j++ ) buffer[j]+=dp;
-	  fp += dp;
-	}
+   for ( i=0; i<psize; i++ ) buffer[i]= postures[i]->values.pt();
 
+   p._channels->layout().interp ( buffer, w, p.values.pt() );
    p._syncpoints = false;
  }
 
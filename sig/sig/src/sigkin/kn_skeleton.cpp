@@ -5,6 +5,7 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <string.h>
 # include <sig/gs_model.h>
 
 # include <sigkin/kn_skeleton.h>
@@ -52,6 +53,10 @@ void KnSkeleton::init ()
    _channels->init();
    while ( _postures.size()>0 ) _postures.pop()->unref();
    while ( _joints.size()>0 ) delete _joints.pop();
+   _lmats.size(0);
+   _gmats.size(0);
+   _jparents.size(0);
+   _gdirty.size(0);
    _jhash.init(0);
    _root = 0;
    _gmat_uptodate = false;
@@ -70,6 +75,14 @@ KnJoint* KnSkeleton::add_joint ( KnJoint::RotType rtype, KnJoint* parent, const
    KnJoint* j = new KnJoint ( this, parent, rtype, _joints.size() );
    _joints.push() = j;
 
+   // the parent already exists, so the arrays stay in topological order:
+   const GsMat* base = _lmats.pt();
+   _lmats.push() = GsMat::id;
+   _gmats.push() = GsMat::id;
+   _jparents.push() = parent? parent->_index : -1;
+   _gdirty.push() = 1;
+   if ( _lmats.pt()!=base ) _relink_matrices(); else { j->_lmat=&_lmats.top(); j->_gmat=&_gmats.top(); }
+
    if ( parent ) 
 	parent->_children.push() = j;
    else
@@ -110,7 +123,22 @@ KnJoint* KnSkeleton::joint ( const char* n ) const
 void KnSkeleton::update_global_matrices ()
 {
 	if ( _gmat_uptodate ) return;
-	_root->update_gmat();
+
+	const int* parents = _jparents.pt();
+	const GsMat* lmats = _lmats.pt();
+	GsMat* gmats = _gmats.pt();
+	gscbool* dirty = _gdirty.pt();
+	int i, p, size=_joints.size();
+
+	for ( i=0; i<size; i++ )
+	{	p = parents[i];
+		if ( p>=0 ) dirty[i] |= dirty[p]; // parents are always visited first
+		if ( !dirty[i] ) continue;
+		_joints[i]->update_lmat();
+		if ( p>=0 ) gmats[i].multaff ( gmats[p], lmats[i] ); else gmats[i]=lmats[i];
+	}
+	if ( size ) memset ( dirty, 0, size*sizeof(gscbool) );
+
 	_gmat_uptodate = true;
 	_skeleton_event ( EvGMatsUpdated );
 }
@@ -127,11 +155,24 @@ void KnSkeleton::compress ()
 	_channels->compress();
 	_postures.compress();
 	_joints.compress();
+	_lmats.compress();
+	_gmats.compress();
+	_jparents.compress();
+	_gdirty.compress();
+	_relink_matrices ();
 
 	for ( int i=0, s=_joints.size(); i<s; i++ )
 		_joints[i]->_children.compress();
 }
 
+void KnSkeleton::_relink_matrices ()
+{
+	for ( int i=0, s=_joints.size(); i<s; i++ )
+	{	_joints[i]->_lmat = &_lmats[i];
+		_joints[i]->_gmat = &_gmats[i];
+	}
+}
+
 void KnSkeleton::set_geo_local ()
  {
    int i;
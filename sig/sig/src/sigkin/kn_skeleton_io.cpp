@@ -645,7 +645,9 @@ bool KnSkeleton::load ( GsInput& in, const char* basedir )
 	// check scalings
 	if ( scale_offsets )
 		for ( i=0; i<_joints.size(); i++ )
-			_joints[i]->_offset *= scale;
+		{	_joints[i]->_offset *= scale;
+			_joints[i]->set_lmat_changed();
+		}
 
 	if ( scale_limits )
 	{	for ( i=0; i<_joints.size(); i++ )
@@ -8,6 +8,7 @@
 # include <stdlib.h>
 
 # include <sig/sn_model.h>
+# include <sig/gs_profiler.h>
 # include <sigkin/kn_skin.h>
 # include <sigkin/kn_skeleton.h>
 # include <sigkin/kn_joint.h>
@@ -19,6 +20,9 @@
 
 KnSkin::KnSkin ()
  {
+   skeleton=0;
+   _intn=false;
+   _gpu=false;
  }
 
 KnSkin::~KnSkin ()
@@ -28,10 +32,21 @@ KnSkin::~KnSkin ()
 
 void KnSkin::init ()
  {
-   while ( SV.size()>0 ) delete[] SV.pop().w;
+   SK.init();
+   BV.size(0); BN.size(0); IB.size(0); G.size(0);
+   if ( skinning() ) remove_skinning();
    model()->init();
    skeleton=0;
    _intn=false;
+   _gpu=false;
+ }
+
+// rotates v by the 3x3 linear part of m:
+static inline GsVec rotate ( const GsMat& m, const GsVec& v )
+ {
+   return GsVec ( m.e11*v.x + m.e12*v.y + m.e13*v.z,
+				  m.e21*v.x + m.e22*v.y + m.e23*v.z,
+				  m.e31*v.x + m.e32*v.y + m.e33*v.z );
  }
 
 bool KnSkin::init ( KnSkeleton* skel, const char* filename, const char* basedir )
@@ -70,13 +85,20 @@ bool KnSkin::init ( KnSkeleton* skel, const char* filename, const char* basedir
    else
 	{ gsout.warning("Unknown skinning weights file"); return false; }
 
-   GsQuat q;
-   GsMat ml, mi, mv;
+   // the initial posture of the skeleton is the bind pose:
    skel->init_values();
    skel->update_global_matrices();
    skeleton = skel;
+   const GsArray<KnJoint*>& joints = skel->joints();
+   IB.size ( joints.size() );
+   for ( int k=0; k<joints.size(); k++ ) joints[k]->gmat().inverse ( IB[k] );
+   BV = model()->V;
    _intn = model()->V.size()==model()->N.size();
+   if ( _intn ) BN = model()->N;
 
+   // influences keep the vertex in the frame of each joint, as in the bind pose:
+   int nsv=0, nv=BV.size();
+   SK.begin ();
    while (true)
 	{ in.get();
 	  if ( in.end() ) break;
@@ -84,76 +106,129 @@ bool KnSkin::init ( KnSkeleton* skel, const char* filename, const char* basedir
 	  if ( in.ltype()==GsInput::Number )
 	   { 
 		 int vid = atoi ( in.ltoken() );
-		 if ( vid!=SV.size() ) gsout<<"skin: skin vertex id mismatch\n";
+		 if ( vid!=nsv ) gsout<<"skin: skin vertex id mismatch\n";
 		 int n = in.geti();
-		 Weight* w = new Weight[n];
-		 SV.push();
-		 SV.top().n = n;
-		 SV.top().w = w;
 		 for ( int i=0; i<n; i++ )
 		  { in.get();
 			if ( in.ltype()==GsInput::Delimiter ) in.get(); // skip delimiter
 			if ( in.ltype()!=GsInput::String ) // missing weight
-			 { in.unget(); w[i].j=0; w[i].w=0; gsout<<"skin: missing weight\n"; break; }
-			w[i].j = skel->joint(in.ltoken());
-			if ( !w[i].j ) gsout<<"skin: unknown joint name: "<<in.ltoken()<<gsnl;
-			w[i].w = in.getf();
-			if ( w[i].j )
-			 { mv.translation ( model()->V[vid] );
-			   mi = w[i].j->gmat().inverse();
-			   ml.mult ( mv, mi );
-			   decompose ( ml, w[i].q, w[i].v );
-			   if ( _intn )
-				{ //mi.setrans ( GsVec::null );
-				  //w[i].n = model()->N[vid] * mi; // put normal in local coords
-				  //mv.translation ( model()->N[vid] );
-				  /*mat2quat ( w[i].j->gmat(), q );
-				  q = (w[i].q * q);
-				  w[i].nq = q.inverse();
-				  w[i].n = w[i].nq.apply ( model()->N[vid] );*/
-				} 
+			 { in.unget(); gsout<<"skin: missing weight\n"; break; }
+			KnJoint* j = skel->joint(in.ltoken());
+			if ( !j ) gsout<<"skin: unknown joint name: "<<in.ltoken()<<gsnl;
+			float w = in.getf();
+			if ( j )
+			 { const GsMat& ib = IB[j->index()];
+			   SK.add ( nsv, j->index(), w, ib*BV[nsv], _intn? rotate(ib,BN[nsv]):GsVec::null );
 			 }
 		  }
+		 nsv++;
 	   }
 	  else if ( in.ltype()==GsInput::String && in.ltoken()=="end"  )
 	   { break;
 	   }
-	  if ( SV.size()==model()->V.size() ) break;
+	  if ( nsv==nv ) break;
 	}
 
-   SV.compress();
-   if ( SV.size()!=model()->V.size() ) gsout.warning("Number of skin vertices differs from skinning weights");
+   SK.end ();
+   if ( nsv!=nv ) gsout.warning("Number of skin vertices differs from skinning weights");
    return true;
  }
 
+void KnSkin::_update_palette ( GsArray<GsMat>& pal )
+ {
+   const GsArray<KnJoint*>& joints = skeleton->joints();
+   pal.size ( IB.size() );
+   for ( int k=0, s=pal.size(); k<s; k++ )
+	{ pal[k].multaff ( joints[k]->gmat(), IB[k] );
+	  pal[k].setl4 ( 0, 0, 0, 1 ); // not set by multaff()
+	}
+ }
+
 void KnSkin::update ()
  {
    if ( !skeleton ) return;
    if ( !visible() ) return;
+   GsProfileScope scope ( "skin update" );
    skeleton->update_global_matrices();
-   GsModel* m = model(); // this will automatically call touch()
-   int i, k, size = m->V.size();
-   GsPnt vi, wv, ni, wn;
-   GsQuat q;
-
-   for ( i=0; i<size; i++ )
-	{ Weight* w = SV[i].w;
-	  int n = SV[i].n;
-	  wn = GsPnt::null;
-	  wv = GsPnt::null;
-	  for ( k=0; k<n; k++ )
-	   { if ( !w[k].j ) break;
-		 vi = w[k].v * w[k].j->gmat();
-		 wv += vi * w[k].w;
-		 if ( _intn )
-		  { //mat2quat ( w[k].j->gmat(), q );
-			//ni = q.apply(w[k].n);
-			//wn += ni * w[k].w;
-		  }
+
+   if ( _gpu ) // the renderer blends the vertices
+	{ Skinning* sk = skinning();
+	  _update_palette ( sk->palette );
+	  sk->palette_changed = true;
+	  _boxuptodate = 0; // the model is not changed but its box follows the palette
+	  return;
+	}
+
+   const GsArray<KnJoint*>& joints = skeleton->joints();
+   G.size ( joints.size() );
+   for ( int k=0, s=G.size(); k<s; k++ ) G[k] = joints[k]->gmat();
+
+   GsModel* m = model_changed ( _intn? VerticesChanged|NormalsChanged : VerticesChanged ); // faces are not changed
+   SK.apply ( G.pt(), m->V.pt(), _intn? m->N.pt():0 );
+ }
+
+void KnSkin::gpu_skinning ( bool b )
+ {
+   if ( b==_gpu ) return;
+   if ( !b )
+	{ remove_skinning ();
+	  _jbox.size(0);
+	  _gpu = false;
+	  update ();
+	  return;
+	}
+
+   if ( !skeleton || !_intn || IB.size()>256 ) return; // gpu skinning not supported
+
+   // keep the 4 largest weights of each vertex, preserving their total weight:
+   GsArray<int> counts, joints;
+   GsArray<float> weights;
+   SK.get_influences ( counts, joints, weights );
+   Skinning* sk = init_skinning ();
+   sk->influences.size ( BV.size() );
+   int i, k, t, c=0;
+   for ( i=0; i<BV.size(); i++ )
+	{ Skinning::Influence& f = sk->influences[i];
+	  for ( k=0; k<4; k++ ) { f.j[k]=0; f.w[k]=0; }
+	  if ( i>=counts.size() ) continue; // vertex with no influences
+	  float total=0;
+	  for ( k=0; k<counts[i]; k++, c++ )
+	   { float w = weights[c];
+		 total += w;
+		 for ( t=4; t>0 && w>f.w[t-1]; t-- ) if ( t<4 ) { f.j[t]=f.j[t-1]; f.w[t]=f.w[t-1]; }
+		 if ( t<4 ) { f.j[t]=(gsbyte)joints[c]; f.w[t]=w; }
 	   }
-	  m->V[i] = wv;
-	  //if ( _intn ) { wn.normalize(); m->N[i] = wn; }
+	  float sum = f.w[0]+f.w[1]+f.w[2]+f.w[3];
+	  if ( sum>0 && sum!=total ) for ( k=0; k<4; k++ ) f.w[k]*=total/sum;
 	}
+
+   // box of the bind pose vertices kept by each joint, the extra last box is for
+   // vertices without influences, which the renderer places at the origin:
+   _jbox.size ( IB.size()+1 );
+   for ( k=0; k<_jbox.size(); k++ ) _jbox[k].set_empty();
+   for ( i=0; i<BV.size(); i++ )
+	{ const Skinning::Influence& f = sk->influences[i];
+	  if ( f.w[0]<=0 ) { _jbox.top().extend(GsPnt::null); continue; }
+	  for ( k=0; k<4; k++ ) if ( f.w[k]>0 ) _jbox[f.j[k]].extend(BV[i]);
+	}
+
+   // the renderer receives the bind pose only once:
+   GsModel* m = model ();
+   m->V = BV;
+   m->N = BN;
+   _gpu = true;
+   update ();
+ }
+
+void KnSkin::get_bounding_box ( GsBox& b ) const
+ {
+   const Skinning* sk = _skinning;
+   if ( !_gpu || !sk || sk->palette.size()+1!=_jbox.size() ) { SnModel::get_bounding_box(b); return; }
+
+   b.set_empty();
+   const GsArray<GsMat>& pal = sk->palette;
+   for ( int k=0, s=pal.size(); k<s; k++ ) b.extend ( pal[k]*_jbox[k] );
+   b.extend ( _jbox.top() );
  }
 
 //============================= EOF ===================================
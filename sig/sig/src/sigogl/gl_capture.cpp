@@ -0,0 +1,346 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <stdio.h>
+# include <string.h>
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <signal.h>
+
+# include <sig/gs_array.h>
+# include <sig/gs_image.h>
+# include <sig/gs_string.h>
+# include <sig/gs_parallel.h>
+
+# include <sigogl/gl_core.h>
+# include <sigogl/gl_capture.h>
+
+//# define GS_USE_TRACE1 // capture
+//# define GS_USE_TRACE2 // encoding
+# include <sig/gs_trace.h>
+
+# ifdef GS_WINDOWS
+# define popen _popen
+# define pclose _pclose
+# endif
+
+//================================= Data ===============================
+
+struct GlCapture::Data
+{	struct Frame				// frame retrieved from a pixel buffer, with lines from bottom to top
+	{	int number, w, h;
+		GsArray<gsbyte> pixels;
+	};
+	struct Slot					// pixel pack buffer
+	{	GLuint pbo;
+		GLsync fence;			// fence after the read, null if the slot is free
+		int number, w, h;
+		gsuint size;			// allocated size of the buffer
+	};
+	GsArray<Slot> slots;
+	int next;					// next slot to be used, which is also the oldest one being read
+	int maxqueue, nthreads;
+
+	Format format;
+	GsString name, ext;			// file name and extension
+	FILE* pipe;					// pipe to the external encoder
+	# ifndef GS_WINDOWS
+	struct sigaction sigpipe;	// SIGPIPE action replaced while the pipe is open
+	# endif
+	int number;					// number of the next frame
+	bool opened;
+
+	std::thread* workers;
+	int nworkers;
+	std::mutex m;
+	std::condition_variable queued, freed; // signal a new frame in the queue, and a frame processed
+	GsArray<Frame*> queue;		// frames waiting to be encoded
+	GsArray<Frame*> available;	// frames available for reuse
+	int written;				// frames written, accessed with m locked
+	bool failed;				// accessed with m locked
+	bool quit;
+
+	Data ( int buffers, int queue, int threads );
+   ~Data ();
+	void start ( int nt );
+	void stop ();
+	void retrieve ( Slot& s, bool wait );
+	bool encode ( Frame* f );
+	void worker ();
+};
+
+GlCapture::Data::Data ( int buffers, int q, int threads )
+{
+	slots.size ( buffers>0? buffers:1 );
+	for ( int i=0; i<slots.size(); i++ ) { slots[i].pbo=0; slots[i].fence=0; slots[i].size=0; }
+	next = 0;
+	maxqueue = q>0? q:1;
+	nthreads = threads>0? threads : GS_MAX(gs_hardware_threads()-1,1);
+	format = Png;
+	pipe = 0;
+	number = 1;
+	opened = false;
+	workers = 0;
+	nworkers = 0;
+	written = 0;
+	failed = quit = false;
+}
+
+GlCapture::Data::~Data ()
+{
+	stop ();
+	for ( int i=0; i<slots.size(); i++ ) if ( slots[i].pbo ) glDeleteBuffers ( 1, &slots[i].pbo );
+	while ( available.size() ) delete available.pop();
+}
+
+void GlCapture::Data::start ( int nt )
+{
+	quit = failed = false;
+	written = 0;
+	nworkers = nt;
+	workers = new std::thread[nt];
+	for ( int t=0; t<nt; t++ ) workers[t] = std::thread ( &Data::worker, this );
+	opened = true;
+}
+
+void GlCapture::Data::stop ()
+{
+	if ( !opened ) return;
+
+	// retrieve the frames still being read, from the oldest one:
+	for ( int i=0; i<slots.size(); i++ )
+	{	Slot& s = slots[(next+i)%slots.size()];
+		if ( s.fence ) retrieve ( s, true );
+	}
+
+	// the workers process the whole queue before quitting:
+	{	std::lock_guard<std::mutex> lock(m);
+		quit = true;
+	}
+	queued.notify_all ();
+	for ( int t=0; t<nworkers; t++ ) workers[t].join();
+	delete[] workers;
+	workers = 0;
+	nworkers = 0;
+
+	if ( pipe )
+	{	pclose ( pipe );
+		pipe = 0;
+		# ifndef GS_WINDOWS
+		sigaction ( SIGPIPE, &sigpipe, 0 );
+		# endif
+	}
+	opened = false;
+}
+
+// maps the buffer of slot s, copies the frame and queues it:
+void GlCapture::Data::retrieve ( Slot& s, bool wait )
+{
+	GLenum r = glClientWaitSync ( s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+	while ( wait && r==GL_TIMEOUT_EXPIRED ) r = glClientWaitSync ( s.fence, 0, 1000000000 ); // 1 second
+	if ( r==GL_TIMEOUT_EXPIRED ) return;
+	glDeleteSync ( s.fence );
+	s.fence = 0;
+	if ( r==GL_WAIT_FAILED ) { std::lock_guard<std::mutex> lock(m); failed=true; return; }
+
+	Frame* f;
+	{	std::unique_lock<std::mutex> lock(m);
+		freed.wait ( lock, [&]{ return queue.size()<maxqueue; } );
+		f = available.size()? available.pop() : new Frame;
+	}
+	f->number = s.number;
+	f->w = s.w;
+	f->h = s.h;
+	f->pixels.size ( s.w*s.h*4 );
+
+	GS_TRACE1 ( "Retrieving frame "<<s.number<<"..." );
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, s.pbo );
+	const void* data = glMapBufferRange ( GL_PIXEL_PACK_BUFFER, 0, f->pixels.size(), GL_MAP_READ_BIT );
+	bool ok = data!=0;
+	if ( ok ) memcpy ( f->pixels.pt(), data, f->pixels.size() );
+	glUnmapBuffer ( GL_PIXEL_PACK_BUFFER );
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, 0 );
+
+	{	std::lock_guard<std::mutex> lock(m);
+		if ( ok ) queue.push()=f; else { available.push()=f; failed=true; }
+	}
+	queued.notify_one ();
+}
+
+// writes frame f with its lines in top to bottom order:
+bool GlCapture::Data::encode ( Frame* f )
+{
+	GS_TRACE2 ( "Encoding frame "<<f->number<<"..." );
+	int lsize = f->w*4;
+	if ( format==Pipe )
+	{	for ( int l=f->h-1; l>=0; l-- ) if ( fwrite(f->pixels.pt()+l*lsize,lsize,1,pipe)!=1 ) return false;
+		return true;
+	}
+
+	GsString file;
+	file.setf ( "%s%04d.%s", name.pt(), f->number, ext.pt() );
+	if ( format==Raw )
+	{	FILE* fp = fopen ( file, "wb" );
+		if ( !fp ) return false;
+		bool ok = true;
+		for ( int l=f->h-1; l>=0 && ok; l-- ) ok = fwrite(f->pixels.pt()+l*lsize,lsize,1,fp)==1;
+		if ( fclose(fp)!=0 ) ok=false;
+		return ok;
+	}
+
+	GsImage img ( f->w, f->h );
+	for ( int l=0; l<f->h; l++ ) memcpy ( (void*)img.ptpixel(l,0), f->pixels.pt()+(f->h-1-l)*lsize, lsize );
+	return img.save ( file );
+}
+
+void GlCapture::Data::worker ()
+{
+	for (;;)
+	{	Frame* f;
+		bool skip; // frames are discarded after an error
+		{	std::unique_lock<std::mutex> lock(m);
+			queued.wait ( lock, [&]{ return quit || queue.size()>0; } );
+			if ( queue.size()==0 ) return; // quit only with an empty queue
+			f = queue[0];
+			queue.remove ( 0 );
+			skip = failed;
+		}
+		freed.notify_one ();
+
+		bool ok = skip? false : encode(f);
+
+		{	std::lock_guard<std::mutex> lock(m);
+			if ( ok ) written++; else failed=true;
+			available.push() = f;
+		}
+	}
+}
+
+//================================= GlCapture ===============================
+
+GlCapture::GlCapture ( int buffers, int queue, int threads )
+{
+	_data = new Data ( buffers, queue, threads );
+}
+
+GlCapture::~GlCapture ()
+{
+	delete _data;
+}
+
+void GlCapture::open ( const char* file, int n )
+{
+	close ();
+	Data& d = *_data;
+	d.name = file;
+	if ( extract_extension(d.name,d.ext)>=0 ) // has extension
+	{	if ( d.ext!="bmp" && d.ext!="tga" && d.ext!="raw" ) d.ext="png"; }
+	else
+	{	if ( d.name.lchar()=='.' ) d.name.lchar(0);
+		d.ext = "png";
+	}
+	d.format = d.ext=="bmp"? Bmp : d.ext=="tga"? Tga : d.ext=="raw"? Raw : Png;
+	d.number = n>0? n:1;
+	d.start ( d.nthreads );
+}
+
+bool GlCapture::open_pipe ( const char* command )
+{
+	close ();
+	Data& d = *_data;
+	# ifdef GS_WINDOWS
+	d.pipe = popen ( command, "wb" );
+	# else
+	d.pipe = popen ( command, "w" );
+	# endif
+	if ( !d.pipe ) return false;
+	# ifndef GS_WINDOWS
+	// an encoder that exits early makes writes fail instead of terminating the application:
+	struct sigaction ignore;
+	memset ( &ignore, 0, sizeof(ignore) );
+	ignore.sa_handler = SIG_IGN;
+	sigemptyset ( &ignore.sa_mask );
+	sigaction ( SIGPIPE, &ignore, &d.sigpipe );
+	# endif
+	d.format = Pipe;
+	d.number = 1;
+	d.start ( 1 ); // frames have to be sent in order
+	return true;
+}
+
+void GlCapture::close ()
+{
+	_data->stop ();
+}
+
+bool GlCapture::opened () const
+{
+	return _data->opened;
+}
+
+GlCapture::Format GlCapture::format () const
+{
+	return _data->format;
+}
+
+void GlCapture::capture ( bool front )
+{
+	Data& d = *_data;
+	if ( !d.opened || error() ) return;
+
+	int vp[4];
+	glGetIntegerv ( GL_VIEWPORT, vp );
+	int x=vp[0], y=vp[1], w=vp[2]-x, h=vp[3]-y;
+	if ( x<0 || y<0 || w<=0 || h<=0 ) return; // ogl not initialized
+
+	// the slot to be used is the oldest one, which has to be retrieved if still in use:
+	Data::Slot& s = d.slots[d.next];
+	if ( s.fence ) d.retrieve ( s, true );
+
+	GS_TRACE1 ( "Reading frame "<<d.number<<"..." );
+	if ( !s.pbo ) glGenBuffers ( 1, &s.pbo );
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, s.pbo );
+	gsuint size = gsuint(w)*h*4;
+	if ( size!=s.size ) { glBufferData ( GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ ); s.size=size; }
+	glReadBuffer ( front? GL_FRONT:GL_BACK );
+	glPixelStorei ( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels ( x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0 ); // returns without waiting for the pixels
+	glBindBuffer ( GL_PIXEL_PACK_BUFFER, 0 );
+	s.fence = glFenceSync ( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	s.number = d.number++;
+	s.w = w;
+	s.h = h;
+	d.next = (d.next+1)%d.slots.size();
+
+	// retrieve the frames already read, in order and without waiting:
+	for ( int i=0; i<d.slots.size(); i++ )
+	{	Data::Slot& o = d.slots[(d.next+i)%d.slots.size()];
+		if ( !o.fence ) continue;
+		d.retrieve ( o, false );
+		if ( o.fence ) break; // not yet read
+	}
+}
+
+int GlCapture::frame_number () const
+{
+	return _data->number;
+}
+
+int GlCapture::frames_written () const
+{
+	std::lock_guard<std::mutex> lock(_data->m);
+	return _data->written;
+}
+
+bool GlCapture::error () const
+{
+	std::lock_guard<std::mutex> lock(_data->m);
+	return _data->failed;
+}
+
+//================================ End of File ========================================
@@ -5,6 +5,7 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <sig/gs_profiler.h>
 # include <sigogl/ui_style.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_core.h>
@@ -16,6 +17,9 @@
 //# define GS_USE_TRACE2 // 
 # include <sig/gs_trace.h>
 
+// stamps are unique among all contexts since programs may be shared:
+static gsuint Stamp=0;
+
 //=================================== GlContext ====================================
 
 GlContext::GlContext ()
@@ -37,6 +41,11 @@ GlContext::GlContext ()
 	_cullface = 0;		// default OpenGL value 
 	_depthtest = true;	// by default depth test will be on
 	_polygonmode = GL_FILL; // default OpenGL value 
+
+	// Uniform updates:
+	_projstamp = ++Stamp;
+	_lightstamp = ++Stamp;
+	_lastlight = light;
 }
 
 void GlContext::init ()
@@ -50,6 +59,12 @@ void GlContext::init ()
 	// Note: glLineWidth(w) with w>1 is deprecated
 }
 
+void GlContext::projection ( const GsMat* m )
+{
+	_projection = m;
+	_projstamp = ++Stamp;
+}
+
 void GlContext::viewport ( int w, int h )
 {
 	//gsout<<w<<"x"<<h<<gsnl;
@@ -158,6 +173,38 @@ void GlContext::use_program ( GLuint pid )
 	CHECK(_curprogram,pid);
 	GS_TRACE1 ( "Program id changed to: "<<pid );
 	glUseProgram ( pid );
+	GsProfiler::count ( GsProfiler::ProgramSwitches );
+}
+
+void GlContext::uniform_projection ( const GlProgram* p, int u )
+{
+	if ( p->projstamp==_projstamp ) return;
+	p->projstamp = _projstamp;
+	glUniformMatrix4fv ( p->uniloc[u], 1, GLTRANSPMAT, _projection->e );
+}
+
+void GlContext::uniform_light ( const GlProgram* p, int u )
+{
+	if ( light.ambient!=_lastlight.ambient || light.diffuse!=_lastlight.diffuse ||
+		 light.specular!=_lastlight.specular || light.position!=_lastlight.position )
+	{	_lastlight = light;
+		_lightstamp = ++Stamp;
+	}
+	if ( p->lightstamp==_lightstamp ) return;
+	p->lightstamp = _lightstamp;
+	float buf[9];
+	glUniform3fv ( p->uniloc[u], 1, light.position.e );
+	glUniform3fv ( p->uniloc[u+1], 3, light.encode_intensities(buf) );
+}
+
+void GlContext::uniform_material ( const GlProgram* p, const GsMaterial& m, int u )
+{
+	if ( p->materialsent && p->material==m ) return;
+	p->material = m;
+	p->materialsent = 1;
+	float buf[12];
+	glUniform3fv ( p->uniloc[u], 4, m.encode_colors(buf) );
+	glUniform1fv ( p->uniloc[u+1], 2, m.encode_params(buf) );
 }
 
 //================================ End of File ========================================
@@ -0,0 +1,102 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <sig/gs_array.h>
+# include <sig/gs_profiler.h>
+
+# include <sigogl/gl_core.h>
+# include <sigogl/gl_profiler.h>
+
+//# define GS_USE_TRACE1 // queries
+# include <sig/gs_trace.h>
+
+//================================= Data ===============================
+
+struct GlProfiler::Data
+{	struct Query
+	{	GLuint id;
+		int frame;				// frame of GsProfiler when the query started
+		const char* name;
+	};
+	GsArray<Query> queries;		// queries waiting for their results, from the oldest one
+	int first;					// index of the oldest query in queries
+	GsArray<GLuint> available;	// query objects available for reuse
+	Query current;
+	bool started;
+	Data () { first=0; started=false; }
+};
+
+// queries waiting for their results are limited, in case collect() is not called:
+static const int MaxPending = 65536;
+
+//================================= GlProfiler ===============================
+
+GlProfiler::GlProfiler ()
+{
+	_data = new Data;
+}
+
+GlProfiler::~GlProfiler ()
+{
+	Data& d = *_data;
+	if ( d.started ) glEndQuery ( GL_TIME_ELAPSED );
+	for ( int i=d.first; i<d.queries.size(); i++ ) glDeleteQueries ( 1, &d.queries[i].id );
+	if ( d.available.size() ) glDeleteQueries ( d.available.size(), d.available.pt() );
+	delete _data;
+}
+
+void GlProfiler::begin ( const char* name )
+{
+	Data& d = *_data;
+	if ( d.started || !GsProfiler::enabled() ) return;
+	if ( d.queries.size()-d.first>=MaxPending ) return;
+	Data::Query& q = d.current;
+	if ( d.available.size() ) q.id = d.available.pop();
+	else glGenQueries ( 1, &q.id );
+	q.frame = GsProfiler::frame_number();
+	q.name = name;
+	glBeginQuery ( GL_TIME_ELAPSED, q.id );
+	d.started = true;
+}
+
+void GlProfiler::end ()
+{
+	Data& d = *_data;
+	if ( !d.started ) return;
+	glEndQuery ( GL_TIME_ELAPSED );
+	d.queries.push() = d.current;
+	d.started = false;
+}
+
+void GlProfiler::collect ()
+{
+	Data& d = *_data;
+	GS_TRACE1 ( "Collecting "<<pending()<<" queries..." );
+
+	// queries complete in order, so the first unavailable result ends the search:
+	for ( ; d.first<d.queries.size(); d.first++ )
+	{	Data::Query& q = d.queries[d.first];
+		GLint ready=0;
+		glGetQueryObjectiv ( q.id, GL_QUERY_RESULT_AVAILABLE, &ready );
+		if ( !ready ) break;
+		GLuint64 ns=0;
+		glGetQueryObjectui64v ( q.id, GL_QUERY_RESULT, &ns );
+		GsProfiler::gpu_time ( q.frame, q.name, double(ns)/1000000.0 );
+		d.available.push() = q.id;
+	}
+
+	// the collected queries are removed when they are many or all of them:
+	if ( d.first==d.queries.size() ) { d.queries.size(0); d.first=0; }
+	else if ( d.first>=256 ) { d.queries.remove(0,d.first); d.first=0; }
+}
+
+int GlProfiler::pending () const
+{
+	return _data->queries.size()-_data->first+(_data->started?1:0);
+}
+
+//================================ End of File ========================================
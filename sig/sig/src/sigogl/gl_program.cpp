@@ -25,6 +25,8 @@ GlProgram::GlProgram ()
    id = 0;
    uniloc = 0;
    nu = 0;
+   projstamp = lightstamp = 0;
+   materialsent = 0;
    _linked = 0;
    _decl = 0;
 };
@@ -62,6 +64,8 @@ bool GlProgram::link ()
 	  _linked = 0;
 	  return false;
 	}
+   projstamp = lightstamp = 0; // uniforms are reset by linking
+   materialsent = 0;
    _linked = 1;
    return true;
  }
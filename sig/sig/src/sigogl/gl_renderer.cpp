@@ -6,12 +6,15 @@
   =======================================================================*/
 
 # include <sig/sn_node.h>
+# include <sig/sn_group.h>
 # include <sig/sn_material.h>
 # include <sig/sa_render_mode.h>
+# include <sig/gs_profiler.h>
 
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_renderer.h>
+# include <sigogl/gl_profiler.h>
 # include <sigogl/glr_base.h>
 
 //# define GS_USE_TRACE1 // constructor and destructor
@@ -28,11 +31,17 @@ GlRenderer::GlRenderer ( GlContext* c )
 	_context = c;
 	_context->ref();
 	_mode = DirectTraversal;
+	_frustumuptodate = 0;
+	_inside = 0;
+	_rendered = _culled = _instanced = 0;
+	_profiler = 0;
+	_profiling = 0;
 }
 
 GlRenderer::~GlRenderer ()
 {
 	GS_TRACE1 ( "Destructor" );
+	delete _profiler;
 	_context->unref();
 }
 
@@ -53,41 +62,196 @@ void GlRenderer::override_render_mode ( SnNode* n, gsRenderMode m )
 	program into a flat list and only update the list when needed, or to restrict the sorting
 	to only the static objets in the scene. However it is also true that many traditional
 	optimizations are no longer useful in modern GPU systems given their high performance
-	capabilities. Specific rendererers should be designed according to the application. */
+	capabilities. Specific rendererers should be designed according to the application.
+	CullingTraversal only adds frustum tests to the traversal, using cached boxes, so that
+	the cost of nodes outside the view is reduced to one box test per culled subtree.
+	SortedTraversal is a first step toward a flat render list: the queue is rebuilt at
+	every frame, what keeps it correct for any scene change. */
 void GlRenderer::apply ( SnNode* n )
 { 
 	GS_TRACE3 ( "Rendering Scene..." );
 
-	//if ( _mode==SceneTraversal ) // Render by just traversing scene
-	{	SaAction::apply(n);
+	_rendered = _culled = _instanced = 0;
+	_frustumuptodate = 0;
+	_inside = 0;
+	_profiling = GsProfiler::enabled();
+	if ( _profiling ) // results of previous frames are read without waiting
+	{	if ( !_profiler ) _profiler = new GlProfiler;
+		_profiler->collect ();
 	}
-	//else
-	//{ may implement other strategies here
-	//}
-	GS_TRACE3 ( "Rendering done." );
+	SaAction::apply(n);
+	if ( _mode==SortedTraversal ) _render_queue ();
+
+	GS_TRACE3 ( "Rendering done. Rendered: "<<_rendered<<" Culled: "<<_culled );
+}
+
+GsFrustum::Result GlRenderer::_cull ( const GsBox& b )
+{
+	if ( !_frustumuptodate ) // planes in the coordinates of the top matrix
+	{	GsMat m ( GsMat::NoInit );
+		m.mult ( _projection, _matstack.top() );
+		_frustum.set ( m );
+		_frustumuptodate = 1;
+	}
+	return _frustum.test ( b );
+}
+
+static gsuint32 material_hash ( const GsMaterial& m ) // FNV-1a
+{
+	const gsbyte* b = (const gsbyte*)&m;
+	gsuint32 h = 2166136261u;
+	for ( int i=0, s=sizeof(GsColor)*4+sizeof(float); i<s; i++ ) { h^=b[i]; h*=16777619u; }
+	return h;
+}
+
+// true if two materials only differ in their diffuse colors, which are sent per instance:
+static inline bool instance_material ( const GsMaterial& m1, const GsMaterial& m2 )
+{
+	return m1.ambient==m2.ambient && m1.specular==m2.specular && m1.emission==m2.emission &&
+		   m1.shininess==m2.shininess && m1.diffuse.a==m2.diffuse.a;
+}
+
+void GlRenderer::_enqueue ( SnShape* s )
+{
+	if ( !s->prep_render() ) return;
+	Packet& p = _queue.push();
+	p.shape = s;
+	p.material = _curmaterial;
+	if ( _curmaterial ) // apply this material, again at rendering time in case s appears more than once
+	{	s->material ( _curmaterial->material() );
+		_curmaterial = 0;
+	}
+	p.mat = _matstack.top();
+	bool transparent;
+	((GlrBase*)s->renderer())->sort_info ( s, p.program, transparent );
+	p.transparent = transparent;
+	p.instkey = transparent? 0 : ((GlrBase*)s->renderer())->instance_key ( s );
+	if ( p.instkey ) // diffuse colors are sent per instance and are not part of the state
+	{	GsMaterial m = s->material();
+		m.diffuse.r = m.diffuse.g = m.diffuse.b = 0;
+		p.mtlhash = material_hash ( m );
+	}
+	else p.mtlhash = material_hash ( s->material() );
+	const GsBox& b = s->cached_bounding_box();
+	p.depth = -( p.mat * ( b.empty()? GsPnt::null:b.center() ) ).z; // the camera looks at -z
+	p.order = _queue.size()-1;
+}
+
+int GlRenderer::_compare ( const Packet* p1, const Packet* p2 ) // static
+{
+	if ( p1->transparent!=p2->transparent ) return p1->transparent? 1:-1; // opaque shapes first
+	if ( p1->transparent ) // back to front
+	{	if ( p1->depth!=p2->depth ) return p1->depth>p2->depth? -1:1;
+	}
+	else // by state and then front to back
+	{	if ( p1->program!=p2->program ) return p1->program<p2->program? -1:1;
+		if ( p1->instkey!=p2->instkey ) return size_t(p1->instkey)<size_t(p2->instkey)? -1:1;
+		if ( p1->mtlhash!=p2->mtlhash ) return p1->mtlhash<p2->mtlhash? -1:1;
+		if ( p1->depth!=p2->depth ) return p1->depth<p2->depth? -1:1;
+	}
+	return p1->order-p2->order;
+}
+
+void GlRenderer::_render_queue ()
+{
+	GS_TRACE3 ( "Rendering queue with "<<_queue.size()<<" shapes..." );
+	_queue.sort ( _compare );
+	for ( int i=0, qs=_queue.size(), n; i<qs; i+=n )
+	{	Packet& p = _queue[i];
+		if ( p.material ) p.shape->material ( p.material->material() );
+		GlrBase* r = (GlrBase*)p.shape->renderer();
+		GsMaterial pm = p.shape->material();
+
+		// collect the following packets that can be drawn as instances of p:
+		for ( n=1; p.instkey && i+n<qs; n++ )
+		{	Packet& q = _queue[i+n];
+			if ( q.instkey!=p.instkey || q.program!=p.program ) break;
+			if ( q.material ) q.shape->material ( q.material->material() );
+			if ( !instance_material(q.shape->material(),pm) ) break;
+			if ( n==1 ) { _ishapes.size(0); _imats.size(0); _imtls.size(0); _ishapes.push()=p.shape; _imats.push()=p.mat; _imtls.push()=pm; }
+			_ishapes.push()=q.shape; _imats.push()=q.mat; _imtls.push()=q.shape->material();
+		}
+
+		if ( n==1 )
+		{	if ( p.material ) p.shape->material ( pm ); // in case the next packet has the same shape
+			_context->modelview ( &p.mat );
+			_render ( r, p.shape );
+		}
+		else
+		{	GS_TRACE3 ( "Drawing "<<n<<" instances..." );
+			if ( _profiling ) _profiler->begin ( p.shape->instance_name() );
+			r->render_instances ( _ishapes.pt(), _imats.pt(), _imtls.pt(), n, _context );
+			if ( _profiling ) _profiler->end ();
+			_instanced += n;
+		}
+		for ( int k=0; k<n; k++ ) _queue[i+k].shape->post_render ();
+	}
+	_rendered += _queue.size();
+	_queue.size ( 0 );
+	_context->modelview ( &_matstack.top() );
+}
+
+void GlRenderer::_render ( GlrBase* r, SnShape* s )
+{
+	if ( !_profiling ) { r->render(s,_context); return; }
+	_profiler->begin ( s->instance_name() );
+	r->render ( s, _context );
+	_profiler->end ();
 }
 
 //==================================== virtuals ====================================
 
+bool GlRenderer::group_apply ( SnGroup* g )
+{
+	if ( _mode==DirectTraversal || _inside || !g->can_cull() || !g->visible() ) return SaAction::group_apply(g);
+
+	g->update_node(); // the node is updated even if it is culled
+	GsFrustum::Result r = _cull ( g->culling_box() );
+	if ( r==GsFrustum::Outside ) { _culled++; return true; }
+	if ( r==GsFrustum::Intersecting ) return SaAction::group_apply(g);
+
+	_inside++;
+	bool b = SaAction::group_apply(g);
+	_inside--;
+	return b;
+}
+
 bool GlRenderer::shape_apply ( SnShape* s )
 {
 	GS_TRACE3 ( "Rendering Shape: "<<s->instance_name() );
 
 	// Render the node:
 	s->update_node();
-	if ( s->prep_render() )
+	if ( _mode!=DirectTraversal && !_inside && s->visible() )
+	{	if ( _cull(s->cached_bounding_box())==GsFrustum::Outside )
+		{	if ( _curmaterial ) { s->material(_curmaterial->material()); _curmaterial=0; } // material only applies to s
+			_culled++;
+			return true;
+		}
+	}
+	if ( _mode==SortedTraversal )
+	{	_enqueue ( s );
+	}
+	else if ( s->prep_render() )
 	{	if ( _curmaterial ) // apply this material
 		{	s->material ( _curmaterial->material() );
 			_curmaterial = 0;
 		}
-		((GlrBase*)s->renderer())->render(s,_context);
+		_render ( (GlrBase*)s->renderer(), s );
 		s->post_render ();
+		_rendered++;
 	}
 
 	// Continue to render:
 	return true;
 }
 
+void GlRenderer::mult_matrix ( const GsMat& mat )
+{
+	SaAction::mult_matrix ( mat );
+	_frustumuptodate = 0;
+}
+
 void GlRenderer::push_matrix ()
 {
 	_matstack.push_top();
@@ -98,6 +262,7 @@ void GlRenderer::pop_matrix ()
 {
 	_matstack.pop();
 	_context->modelview ( &_matstack.top() );
+	_frustumuptodate = 0;
 }
 
 //======================================= EOF ====================================
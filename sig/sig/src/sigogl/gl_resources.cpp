@@ -536,9 +536,13 @@ void GlResources::declare_default_shaders ()
 	const GlShader* vs3dsmooth  = r.declare_shader ( GL_VERTEX_SHADER, "vs3dsmooth", "3dsmooth.vert", pds_3dsmooth_vert );
 	const GlShader* vs3dsmoothsc= r.declare_shader ( GL_VERTEX_SHADER, "vs3dsmoothsc", "3dsmoothsc.vert", pds_3dsmoothsc_vert );
 	const GlShader* vs3dflat	= r.declare_shader ( GL_VERTEX_SHADER, "vs3dflat", "3dflat.vert", pds_3dflat_vert );
+	const GlShader* vs3dflati	= r.declare_shader ( GL_VERTEX_SHADER, "vs3dflati", "3dflati.vert", pds_3dflati_vert );
 	const GlShader* vs3dgouraud = r.declare_shader ( GL_VERTEX_SHADER, "vs3dgouraud", "3dgouraud.vert", pds_3dgouraud_vert );
+	const GlShader* vs3dgouraudi= r.declare_shader ( GL_VERTEX_SHADER, "vs3dgouraudi", "3dgouraudi.vert", pds_3dgouraudi_vert );
 	const GlShader* vs3dphong   = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphong", "3dphong.vert", pds_3dphong_vert );
+	const GlShader* vs3dphongi  = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphongi", "3dphongi.vert", pds_3dphongi_vert );
 	const GlShader* vs3dphongmc = r.declare_shader ( GL_VERTEX_SHADER, "vs3dphongmc", "3dphongmc.vert", pds_3dphongmc_vert );
+	const GlShader* vs3dskinned = r.declare_shader ( GL_VERTEX_SHADER, "vs3dskinned", "3dskinned.vert", pds_3dskinned_vert );
 	const GlShader* vs3dtextured= r.declare_shader ( GL_VERTEX_SHADER, "vsv3dtextured", "3dtextured.vert", pds_3dtextured_vert );
 	const GlShader* fs3dtextured= r.declare_shader ( GL_FRAGMENT_SHADER, "fs3dtextured", "3dtextured.frag", pds_3dtextured_frag );
 	const GlShader* fsflat		= r.declare_shader ( GL_FRAGMENT_SHADER, "fsflat", "flat.frag", pds_flat_frag );
@@ -590,6 +594,22 @@ void GlResources::declare_default_shaders ()
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
 
+	p = r.declare_program ( "3dflati", 3, vs3dflati, vshadefunc, fsflat );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+
+	p = r.declare_program ( "3dgouraudi", 3, vs3dgouraudi, vshadefunc, fsgouraud );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+
 	p = r.declare_program ( "3dtextured", 3, vs3dtextured, fs3dtextured, fshadefunc );
 	r.declare_uniform ( p, 0, "vProj" );
 	r.declare_uniform ( p, 1, "vView" );
@@ -617,6 +637,23 @@ void GlResources::declare_default_shaders ()
 	r.declare_uniform ( p, 4, "mColors" );
 	r.declare_uniform ( p, 5, "mParams" );
 
+	p = r.declare_program ( "3dphongi", 3, vs3dphongi, fsphongmc, fshadefunc );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+
+	p = r.declare_program ( "3dskinned", 3, vs3dskinned, vshadefunc, fsgouraud );
+	r.declare_uniform ( p, 0, "vProj" );
+	r.declare_uniform ( p, 1, "vView" );
+	r.declare_uniform ( p, 2, "lPos" );
+	r.declare_uniform ( p, 3, "lInt" );
+	r.declare_uniform ( p, 4, "mColors" );
+	r.declare_uniform ( p, 5, "mParams" );
+	r.declare_uniform ( p, 6, "Palette" );
+
 	p = r.declare_program ( "dftext", 2,
 		r.declare_shader ( GL_VERTEX_SHADER,   "vsdftext", "dftext.vert", pds_dftext_vert ),
 		r.declare_shader ( GL_FRAGMENT_SHADER, "fsdftext", "dftext.frag", pds_dftext_frag ) );
@@ -5,6 +5,7 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <sigogl/gl_context.h>
 # include <sigogl/glr_base.h>
 
 # include <sig/sn_model.h>
@@ -40,3 +41,23 @@ void GlrBase::init ()
 	SnPoints::renderer_instantiator = &GlrPointsInstantiator;
 	SnText::renderer_instantiator = &GlrTextInstantiator;
 }
+
+void GlrBase::sort_info ( SnShape* shape, GLuint& program, bool& transparent )
+{
+	program = 0;
+	transparent = shape->material().diffuse.a<255;
+}
+
+const void* GlrBase::instance_key ( SnShape* shape )
+{
+	return 0;
+}
+
+void GlrBase::render_instances ( SnShape** shapes, const GsMat* mats, const GsMaterial* mtls, int n, GlContext* c )
+{
+	for ( int i=0; i<n; i++ )
+	{	c->modelview ( mats+i );
+		if ( shapes[i]->material()!=mtls[i] ) shapes[i]->material ( mtls[i] );
+		((GlrBase*)shapes[i]->renderer())->render ( shapes[i], c );
+	}
+}
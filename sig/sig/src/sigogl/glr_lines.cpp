@@ -5,6 +5,8 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <sig/gs_profiler.h>
+
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
@@ -86,6 +88,8 @@ void GlrLines::render ( SnShape* s, GlContext* c )
 			}
 		}
 
+		GsProfiler::count ( GsProfiler::BytesUploaded, l.P.sizeofarray()+l.Pc.sizeofarray()+l.V.sizeofarray()+l.Vc.sizeofarray() );
+
 		if ( s->auto_clear_data() )
 		{	l.P.size(0);
 			l.Pc.size(0);
@@ -100,13 +104,13 @@ void GlrLines::render ( SnShape* s, GlContext* c )
 	if ( _colorspervertex )
 	{	GS_TRACE2 ( "Rendering w/ colors per vertex..." );
 		c->use_program ( pSmo->id ); // ctx tests if the program is being changed
-		glUniformMatrix4fv ( pSmo->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+		c->uniform_projection ( pSmo );
 		glUniformMatrix4fv ( pSmo->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 	}
 	else // single color per line:
 	{	GS_TRACE2 ( "Rendering w/ single color..." );
 		c->use_program ( pSsc->id ); // ctx tests if the program is being changed
-		glUniformMatrix4fv ( pSsc->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+		c->uniform_projection ( pSsc );
 		glUniformMatrix4fv ( pSsc->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 		glUniform4fv ( pSsc->uniloc[2], 1, s->SnShape::color().vec4() );
 	}
@@ -119,10 +123,17 @@ void GlrLines::render ( SnShape* s, GlContext* c )
 	{	glBindVertexArray ( _glo.va[1] );
 		glMultiDrawArrays ( GL_LINE_STRIP, (const GLint*)l.I.pt(), (const GLsizei *)l.Is.pt(), l.I.size() );
 	}
+	GsProfiler::count ( GsProfiler::DrawCalls, (_psize?1:0)+(_vsize?1:0) );
 
 	glBindVertexArray ( 0 ); // done
 }
 
+void GlrLines::sort_info ( SnShape* s, GLuint& program, bool& transparent )
+{
+	program = !pSmo? 0 : _colorspervertex? pSmo->id : pSsc->id; // known after the first render
+	transparent = s->SnShape::color().a<255;
+}
+
 // Alternative code not relying on Is and glMultiDrawArrays:
 // int s = l.I.size()-1;
 // for ( int i=0; i<s; i++ ) glDrawArrays ( GL_LINE_STRIP, l.I[i], l.I[i+1]-l.I[i] );
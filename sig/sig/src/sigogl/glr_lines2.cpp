@@ -5,6 +5,8 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <sig/gs_profiler.h>
+
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
@@ -88,6 +90,8 @@ void GlrLines2::render (  SnShape* s, GlContext* c )
 			}
 		}
 
+		GsProfiler::count ( GsProfiler::BytesUploaded, l.P.sizeofarray()+l.Pc.sizeofarray()+l.V.sizeofarray()+l.Vc.sizeofarray() );
+
 		if ( s->auto_clear_data() )
 		{	l.P.size(0);
 			l.Pc.size(0);
@@ -102,14 +106,14 @@ void GlrLines2::render (  SnShape* s, GlContext* c )
 	if ( _colormode==1 ) // colors per vertex
 	{	GS_TRACE2 ( "Rendering w/ colors per vertex..." );
 		c->use_program ( pMc->id ); // will test if the program is being changed
-		glUniformMatrix4fv ( pMc->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+		c->uniform_projection ( pMc );
 		glUniformMatrix4fv ( pMc->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 		glUniform1f ( pMc->uniloc[2], l.zcoordinate );
 	}
 	else if ( _colormode==2 ) // single color
 	{	GS_TRACE2 ( "Rendering w/ single color..." );
 		c->use_program ( pSc->id ); // ctx tests if the program is being changed
-		glUniformMatrix4fv ( pSc->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+		c->uniform_projection ( pSc );
 		glUniformMatrix4fv ( pSc->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 		glUniform1f  ( pSc->uniloc[2], l.zcoordinate );
 		glUniform4fv ( pSc->uniloc[3], 1, s->SnShape::color().vec4() );
@@ -123,6 +127,7 @@ void GlrLines2::render (  SnShape* s, GlContext* c )
 	{	glBindVertexArray ( _glo.va[1] );
 		glMultiDrawArrays ( GL_LINE_STRIP, (const GLint*)l.I.pt(), (const GLsizei *)l.Is.pt(), l.I.size() );
 	}
+	GsProfiler::count ( GsProfiler::DrawCalls, (_psize?1:0)+(_vsize?1:0) );
 
 	glBindVertexArray(0); // Break the existing vertex array object binding
 }
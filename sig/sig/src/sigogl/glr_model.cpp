@@ -5,10 +5,13 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <string.h>
 # include <sig/gs_dirs.h>
 # include <sig/gs_image.h>
+# include <sig/gs_profiler.h>
 
 # include <sigogl/gl_core.h>
+# include <sigogl/gl_objects.h>
 # include <sigogl/gl_texture.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
@@ -22,17 +25,80 @@
 //# define GS_USE_TRACE4 // Render type
 # include <sig/gs_trace.h>
 
+//======================================= Buffers ====================================
+
+struct GlrModel::Buffers
+{	GlContext* context;	// context owning the vertex array, which is never shared among contexts
+	GlObjects glo;		// vertex array and buffers
+	gsuint size[5];		// allocated sizes of the 3 attribute buffers, the element buffer, and the palette buffer
+	GsModel* model;		// model of shared buffers, referenced while the buffers exist, or null if not shared
+	int refs;			// number of renderers using the buffers
+	gsbyte key;			// layout identifying shared buffers
+	gsbyte layout;		// buffer layout of the last full update, a new full update is needed if it changes
+	gsuint stamp;		// GsModel::stamp() of the last update, see _attach()
+	gscbool dynamic;	// becomes true after the first partial update
+	gscbool normalspervertex;
+	gscbool instanced;	// true when the instance attributes are declared in the vertex array
+	GLuint paltex;		// texture buffer giving shader access to the palette buffer, 0 if not used
+	GLuint instbuf;		// buffer of the instance attributes, 0 if not used
+	Buffers ( GlContext* c )
+	{	context = c;
+		context->ref(); // the context is kept so that its address cannot be reused by another one
+		glo.gen_vertex_arrays ( 1 );
+		glo.gen_buffers ( 5 ); // 2 or 3 attribute buffers, one element buffer, and one palette buffer if skinned
+		size[0]=size[1]=size[2]=size[3]=size[4]=0;
+		model=0; refs=1; key=layout=0; stamp=0;
+		dynamic=normalspervertex=instanced=0;
+		paltex=instbuf=0;
+	}
+   ~Buffers ()
+	{	if ( paltex ) glDeleteTextures ( 1, &paltex );
+		if ( instbuf ) glDeleteBuffers ( 1, &instbuf );
+		context->unref();
+	}
+};
+
+// Shared buffers sorted by model, context and key:
+static GsArray<GlrModel::Buffers*> Shared;
+
+static inline int shared_compare ( const GlrModel::Buffers* sb, const GsModel* m, const GlContext* c, gsbyte key )
+{
+	if ( sb->model!=m ) return size_t(sb->model)<size_t(m)? -1:1;
+	if ( sb->context!=c ) return size_t(sb->context)<size_t(c)? -1:1;
+	return int(sb->key)-int(key);
+}
+
+static int shared_search ( const GsModel* m, const GlContext* c, gsbyte key, bool& found )
+{
+	int a=0, b=Shared.size();
+	while ( a<b )
+	{	int i = (a+b)/2;
+		if ( shared_compare(Shared[i],m,c,key)<0 ) a=i+1; else b=i;
+	}
+	found = a<Shared.size() && shared_compare(Shared[a],m,c,key)==0;
+	return a;
+}
+
+// Per-instance data of instanced drawing:
+struct Instance
+{	float mat[16];
+	GsColor diffuse;
+};
+
+static GsArray<Instance> Instances;
+
 //======================================= GlrModel ====================================
 
 GlrModel::GlrModel ()
 {
 	GS_TRACE1 ( "Constructor" );
-	_normalspervertex = false;
+	_buf = 0;
 }
 
 GlrModel::~GlrModel ()
 {
 	GS_TRACE1 ( "Destructor" );
+	_release ();
 }
 
 static const GlProgram* pFlat=0;
@@ -41,6 +107,10 @@ static const GlProgram* pPhong=0;
 static const GlProgram* pText=0;
 static const GlProgram* pPhongMC=0;
 static const GlProgram* pColored=0;
+static const GlProgram* pSkin=0;
+static const GlProgram* pFlatI=0;
+static const GlProgram* pGourI=0;
+static const GlProgram* pPhongI=0;
 
 void GlrModel::init ( SnShape* s )
 {
@@ -50,52 +120,84 @@ void GlrModel::init ( SnShape* s )
 		pGour = GlResources::get_program("3dgouraud");
 		pText = GlResources::get_program("3dtextured");
 		pPhong = GlResources::get_program("3dphong");
-		// pPhongMC and pColored are not as used and are later loaded only when/if needed 
+		// pPhongMC, pColored, pSkin and the instanced programs are not as used and are later loaded only when/if needed 
 	}
-	_glo.gen_vertex_arrays ( 1 );
-	_glo.gen_buffers ( 3 ); // it will need 2 or 3 buffers
+	// buffers are attached at the first render, when the layout is known
 }
 
-void GlrModel::render (  SnShape* s, GlContext* c )
+int GlrModel::shared_buffers ()
 {
-	GS_TRACE2 ( "GL4 Render "<<s->instance_name() );
-	const GsModel& m = *((const SnModel*)s)->cmodel();
-	if ( m.empty() ) return;
-
-	GS_TRACE2 ( "Start rendering "<<s->instance_name()<<" ["<<m.name<<"]" );
+	return Shared.size();
+}
 
-	GS_TRACE3 ( "Faces     : "<<m.F.size() );
-	GS_TRACE3 ( "Normals   : "<<m.N.size() );
-	GS_TRACE3 ( "Vertices  : "<<m.V.size() );
-	GS_TRACE3 ( "TexCoords : "<<m.T.size() );
-	GS_TRACE3 ( "Materials : "<<m.M.size() );
-	GS_TRACE3 ( "Groups    : "<<m.G.size() );
+bool GlrModel::_attach ( GsModel* m, GlContext* c, gsbyte layout, bool share )
+{
+	if ( _buf && _buf->context==c && ( share? _buf->model==m && _buf->key==layout : !_buf->model ) ) return false; // no change
+	_release ();
+	if ( !share ) { _buf = new Buffers(c); return false; }
 
-	const GlProgram* p=pGour;
+	bool found;
+	int i = shared_search ( m, c, layout, found );
+	if ( found )
+	{	GS_TRACE4 ( "Sharing buffers with layout "<<int(layout) );
+		_buf = Shared[i];
+		_buf->refs++;
+		return _buf->layout==layout && _buf->stamp==m->stamp(); // true if buffers already have the current data
+	}
+	_buf = new Buffers(c);
+	_buf->model = m;
+	_buf->key = layout;
+	m->ref();
+	Shared.insert(i) = _buf;
+	return false;
+}
 
-	c->cull_face ( m.culling? 1:0 ); // TodoNote: set rules for back-face culling context state change
+void GlrModel::_release ()
+{
+	if ( !_buf ) return;
+	if ( --_buf->refs==0 )
+	{	if ( _buf->model )
+		{	bool found;
+			Shared.remove ( shared_search(_buf->model,_buf->context,_buf->key,found) );
+			_buf->model->unref();
+		}
+		delete _buf;
+	}
+	_buf = 0;
+}
 
-	// 1. Set programs based on rendering mode
-	gsRenderMode rm = s->render_mode();
-	switch ( rm )
-	{	case gsRenderModeDefault: p=pGour; c->polygon_mode_fill(); GS_TRACE4("Prog: Gouraud"); break;
-		case gsRenderModePhong  : p=pPhong; c->polygon_mode_fill(); GS_TRACE4("Prog: Phong"); break;
-		case gsRenderModeGouraud: p=pGour; c->polygon_mode_fill(); GS_TRACE4("Prog: Gouraud"); break;
-		case gsRenderModeFlat	: p=pFlat; c->polygon_mode_fill(); GS_TRACE4("Prog: Flat"); break;
-		case gsRenderModeLines  : p=pGour; c->polygon_mode_line(); GS_TRACE4("Prog: Gouraud"); break;
-		case gsRenderModePoints : p=pFlat; c->polygon_mode_point(); GS_TRACE4("Prog: Flat"); break;
+// program used to render s, also giving the texture, material and skinning modes to be used:
+static const GlProgram* select_program ( SnShape* s, const GsModel& m, gscbool& textured, GsModel::MtlMode& mtlmode, SnModel::Skinning*& skin )
+{
+	const GlProgram* p=pGour;
+	switch ( s->render_mode() )
+	{	case gsRenderModeDefault: p=pGour; GS_TRACE4("Prog: Gouraud"); break;
+		case gsRenderModePhong  : p=pPhong; GS_TRACE4("Prog: Phong"); break;
+		case gsRenderModeGouraud: p=pGour; GS_TRACE4("Prog: Gouraud"); break;
+		case gsRenderModeFlat	: p=pFlat; GS_TRACE4("Prog: Flat"); break;
+		case gsRenderModeLines  : p=pGour; GS_TRACE4("Prog: Gouraud"); break;
+		case gsRenderModePoints : p=pFlat; GS_TRACE4("Prog: Flat"); break;
 	}
 
-	gscbool textured = m.textured;
-	GsModel::MtlMode mtlmode = m.mtlmode();
+	textured = m.textured;
+	mtlmode = m.mtlmode();
 	if ( s->material_is_overriden() ) { textured=0; mtlmode=GsModel::NoMtl; } // SgDev: color override not completed/tested
 
+	// Skinning is only performed for smooth models with at most one material per group:
+	skin = ((SnModel*)s)->skinning();
+	if ( skin && ( textured || mtlmode>GsModel::PerGroupMtl || m.geomode()!=GsModel::Smooth || skin->influences.size()!=m.V.size() ) ) skin=0;
+
 	// Textured objects have to be defined using the group structure
 	// SnColorSurf will use 2 possible modes: Smooth,PerVertexMtl or Faces,PerVertexColor
 	if ( textured )
 	{	GS_TRACE4 ( "Textured..." );
 		p=pText;
 	}
+	else if ( skin )
+	{	GS_TRACE4 ( "Skinned..." );
+		if ( !pSkin ) pSkin = GlResources::get_program("3dskinned");
+		p = pSkin;
+	}
 	else if ( mtlmode==GsModel::PerVertexMtl || mtlmode==GsModel::PerFaceMtl )
 	{	GS_TRACE4 ( "MtlMode: PerVertexMtl or PerFaceMtl..." );
 		if ( !pPhongMC ) pPhongMC = GlResources::get_program("3dphongmc");
@@ -106,68 +208,146 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 		if ( !pColored ) pColored = GlResources::get_program("3dsmooth");
 		p = pColored;
 	}
+	return p;
+}
+
+void GlrModel::sort_info ( SnShape* s, GLuint& program, bool& transparent )
+{
+	const GsModel& m = *((const SnModel*)s)->cmodel();
+	gscbool textured;
+	GsModel::MtlMode mtlmode;
+	SnModel::Skinning* skin;
+	program = select_program ( s, m, textured, mtlmode, skin )->id;
+	transparent = s->material().diffuse.a<255;
+	if ( mtlmode!=GsModel::NoMtl )
+	{	for ( int i=0, ms=m.M.size(); i<ms && !transparent; i++ ) if ( m.M[i].diffuse.a<255 ) transparent=true;
+	}
+}
+
+void GlrModel::_upload ( int b, GLenum target, gsuint size, const void* data )
+{
+	glBindBuffer ( target, _buf->glo.buf[b] );
+	if ( size==_buf->size[b] ) // same size: only replace the contents
+	{	glBufferSubData ( target, 0, size, data );
+	}
+	else
+	{	glBufferData ( target, size, data, _buf->dynamic? GL_DYNAMIC_DRAW:GL_STATIC_DRAW );
+		_buf->size[b] = size;
+	}
+	GsProfiler::count ( GsProfiler::BytesUploaded, size );
+}
+
+// Steps 1 and 2 of rendering, returning the program to be used:
+const GlProgram* GlrModel::_update ( SnShape* s, GlContext* c, gscbool& textured, GsModel::MtlMode& mtlmode, SnModel::Skinning*& skin )
+{
+	const GsModel& m = *((const SnModel*)s)->cmodel();
+
+	GS_TRACE3 ( "Faces     : "<<m.F.size() );
+	GS_TRACE3 ( "Normals   : "<<m.N.size() );
+	GS_TRACE3 ( "Vertices  : "<<m.V.size() );
+	GS_TRACE3 ( "TexCoords : "<<m.T.size() );
+	GS_TRACE3 ( "Materials : "<<m.M.size() );
+	GS_TRACE3 ( "Groups    : "<<m.G.size() );
+
+	c->cull_face ( m.culling? 1:0 ); // TodoNote: set rules for back-face culling context state change
+
+	// 1. Set programs based on rendering mode
+	const GlProgram* p = select_program ( s, m, textured, mtlmode, skin );
+	gsRenderMode rm = s->render_mode();
+	if ( rm==gsRenderModeLines ) c->polygon_mode_line();
+	else if ( rm==gsRenderModePoints ) c->polygon_mode_point();
+	else c->polygon_mode_fill();
+
+	// 2. Set buffer data if node has been changed (flags are: Unchanged, RenderModeChanged, MaterialChanged, Changed,
+	//    and the partial flags VerticesChanged, NormalsChanged, ColorsChanged, TexCoordsChanged)
+	gsbyte layout = p==pColored? 1 : m.geomode()==GsModel::Smooth&&p!=pFlat? 2 : p==pFlat? 3 : 4;
+	if ( textured ) layout |= 8;
+	if ( mtlmode>=GsModel::PerVertexMtl ) layout |= 16;
+	if ( skin ) layout |= 32;
 
-	// 2. Set buffer data if node has been changed (flags are: Unchanged, RenderModeChanged, MaterialChanged, Changed)
-	if ( s->changed()&SnShape::Changed )
-	{	glBindVertexArray ( _glo.va[0] );
+	gsbyte changed = s->changed();
+	if ( _attach ( (GsModel*)&m, c, layout, skin==0 ) ) changed &= ~SnShape::Changed; // shared buffers already have the data
+	bool full = (changed&SnShape::Changed) || layout!=_buf->layout;
+	if ( full ) changed = SnShape::DataChanged; // all data is sent
+	else if ( changed&SnShape::DataChanged ) _buf->dynamic = true; // partial updates are being used
+
+	if ( changed&SnShape::DataChanged )
+	{	glBindVertexArray ( _buf->glo.va[0] );
+		bool vchg = (changed&SnShape::VerticesChanged)!=0;
+		bool nchg = (changed&SnShape::NormalsChanged)!=0;
+		bool tchg = (changed&SnShape::TexCoordsChanged)!=0;
+		bool cchg = (changed&SnShape::ColorsChanged)!=0;
+
+		if ( full )
+		{	GS_TRACE4 ( "Full update with layout "<<int(layout) );
+			_buf->layout = layout;
+			glDisableVertexAttribArray ( 1 );
+			glDisableVertexAttribArray ( 2 );
+			glDisableVertexAttribArray ( 3 );
+		}
 
 		if ( p==pColored ) // colors per vertex, no illumination, only declare vertices
 		{	GS_TRACE4 ( "Defining V buffer..." );
-			_normalspervertex = false;
-			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
-			glBufferData ( GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
+			_buf->normalspervertex = false;
+			if ( vchg )
+			{	_upload ( 0, GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt() );
+				if ( full ) { glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,0); }
+			}
 		}
-		else if ( m.geomode()==GsModel::Smooth && p!=pFlat ) // normals per vertex, or no normals smooth mode
+		else if ( skin || ( m.geomode()==GsModel::Smooth && p!=pFlat ) ) // normals per vertex, or no normals smooth mode
 		{	GS_TRACE4 ( "Defining V,N per vertex buffers..." );
-			_normalspervertex = true;
+			_buf->normalspervertex = true;
 			// Vertices:
-			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
-			glBufferData ( GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
+			if ( vchg )
+			{	_upload ( 0, GL_ARRAY_BUFFER, m.V.sizeofarray(), m.V.pt() );
+				if ( full ) { glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,0); }
+			}
 			// Normals:
-			glEnableVertexAttribArray ( 1 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[1] );
-			glBufferData ( GL_ARRAY_BUFFER, m.N.sizeofarray(), m.N.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( 1, 3, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
+			if ( nchg )
+			{	_upload ( 1, GL_ARRAY_BUFFER, m.N.sizeofarray(), m.N.pt() );
+				if ( full ) { glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,0,0); } // false means no normalization
+			}
+			// Joint indices and weights, which only change with a full update:
+			if ( skin && full )
+			{	GS_TRACE4 ( "Defining skinning influences buffer..." );
+				const GLsizei st = sizeof(SnModel::Skinning::Influence);
+				_upload ( 2, GL_ARRAY_BUFFER, skin->influences.sizeofarray(), skin->influences.pt() );
+				glEnableVertexAttribArray(2); glVertexAttribIPointer(2,4,GL_UNSIGNED_BYTE,st,0);
+				glEnableVertexAttribArray(3); glVertexAttribPointer(3,4,GL_FLOAT,GL_FALSE,st,(const void*)(4*sizeof(gsbyte)));
+			}
 		}
 		else
 		{	GS_TRACE4 ( "Defining V,N per face buffers..." );
-			_normalspervertex = false;
+			_buf->normalspervertex = false;
 			GsArray<GsVec> va;
-			unsigned bufsize = m.F.size()*9*sizeof(float);
 			// Vertices:
-			m.get_vertices_per_face ( va );
-			glEnableVertexAttribArray ( 0 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[0] );
-			glBufferData ( GL_ARRAY_BUFFER, bufsize, va.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( 0, 3, GL_FLOAT, GL_FALSE, 0, 0 );
-			// Normals:
-			if ( p==pFlat )
-			{	GS_TRACE4 ( "Computing flat normals..." );
-				m.get_flat_normals_per_face(va,3);
+			if ( vchg )
+			{	m.get_vertices_per_face ( va );
+				_upload ( 0, GL_ARRAY_BUFFER, va.sizeofarray(), va.pt() );
+				if ( full ) { glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,0); }
 			}
-			else
-			{	GS_TRACE4 ( "Retrieving normals..." );
-				m.get_normals_per_face(va);
+			// Normals, which depend on the vertices when they are computed per face:
+			if ( nchg || ( vchg && ( p==pFlat || ( m.Fn.empty() && m.N.size()!=m.V.size() ) ) ) )
+			{	if ( p==pFlat )
+				{	GS_TRACE4 ( "Computing flat normals..." );
+					m.get_flat_normals_per_face(va,3);
+				}
+				else
+				{	GS_TRACE4 ( "Retrieving normals..." );
+					m.get_normals_per_face(va);
+				}
+				_upload ( 1, GL_ARRAY_BUFFER, va.sizeofarray(), va.pt() );
+				if ( full ) { glEnableVertexAttribArray(1); glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,0,0); } // false means no normalization
 			}
-			glEnableVertexAttribArray ( 1 );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[1] );
-			glBufferData ( GL_ARRAY_BUFFER, bufsize, va.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( 1, 3, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
-			if ( textured ) // Tx coordinates:
+			if ( textured && tchg ) // Tx coordinates:
 			{	GsArray<GsVec2> tca;
 				m.get_texcoords_per_face ( tca );
-				glEnableVertexAttribArray ( 2 );
-				glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[2] );
-				glBufferData ( GL_ARRAY_BUFFER, tca.sizeofarray(), tca.pt(), GL_STATIC_DRAW );
-				glVertexAttribPointer ( 2, 2, GL_FLOAT, GL_FALSE, 0, 0 ); // false means no normalization
+				_upload ( 2, GL_ARRAY_BUFFER, tca.sizeofarray(), tca.pt() );
+				if ( full ) { glEnableVertexAttribArray(2); glVertexAttribPointer(2,2,GL_FLOAT,GL_FALSE,0,0); } // false means no normalization
 			}
 		}
 
-		if ( mtlmode>=GsModel::PerVertexMtl ) // define color buffer
+		if ( mtlmode>=GsModel::PerVertexMtl && cchg ) // define color buffer
 		{	GsArray<GsColor> C;
 			if ( mtlmode==GsModel::PerFaceMtl )
 			{	GS_TRACE4 ( "Defining C per face buffer..." );
@@ -181,29 +361,66 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 			}
 			gsuint bufid = m.mtlmode()==GsModel::PerVertexColor? 1:2;
 			GS_TRACE4 ( "Defining bufferid "<<bufid );
-			glEnableVertexAttribArray ( bufid );
-			glBindBuffer ( GL_ARRAY_BUFFER, _glo.buf[bufid] );
-			glBufferData ( GL_ARRAY_BUFFER, C.sizeofarray(), C.pt(), GL_STATIC_DRAW );
-			glVertexAttribPointer ( bufid, 4, GL_UNSIGNED_BYTE, GL_FALSE, 0, 0 );
+			_upload ( bufid, GL_ARRAY_BUFFER, C.sizeofarray(), C.pt() );
+			if ( full ) { glEnableVertexAttribArray(bufid); glVertexAttribPointer(bufid,4,GL_UNSIGNED_BYTE,GL_FALSE,0,0); }
 		}
+
+		// Indices are kept in an element buffer which is part of the vertex array state:
+		if ( full && ( _buf->normalspervertex || p==pColored ) )
+		{	GS_TRACE4 ( "Defining element buffer..." );
+			_upload ( 3, GL_ELEMENT_ARRAY_BUFFER, m.F.sizeofarray(), m.F.pt() );
+		}
+		_buf->stamp = m.stamp();
 	}
 
+	// The palette is the only data sent per frame when skinning:
+	if ( skin && ( full || skin->palette_changed ) )
+	{	GS_TRACE4 ( "Updating skinning palette..." );
+		_upload ( 4, GL_TEXTURE_BUFFER, skin->palette.sizeofarray(), skin->palette.pt() );
+		if ( !_buf->paltex ) // the texture lives with the palette buffer it refers to
+		{	glGenTextures ( 1, &_buf->paltex );
+			glBindTexture ( GL_TEXTURE_BUFFER, _buf->paltex );
+			glTexBuffer ( GL_TEXTURE_BUFFER, GL_RGBA32F, _buf->glo.buf[4] ); // each matrix line is one texel
+		}
+		skin->palette_changed = false;
+	}
+
+	return p;
+}
+
+void GlrModel::render (  SnShape* s, GlContext* c )
+{
+	GS_TRACE2 ( "GL4 Render "<<s->instance_name() );
+	const GsModel& m = *((const SnModel*)s)->cmodel();
+	if ( m.empty() ) return;
+
+	GS_TRACE2 ( "Start rendering "<<s->instance_name()<<" ["<<m.name<<"]" );
+
+	gscbool textured;
+	GsModel::MtlMode mtlmode;
+	SnModel::Skinning* skin;
+	const GlProgram* p = _update ( s, c, textured, mtlmode, skin );
+	bool normalspervertex = _buf->normalspervertex!=0;
+
 	// 3. Enable/bind needed elements and draw:
 	c->use_program ( p->id );
-	glBindVertexArray ( _glo.va[0] );
+	glBindVertexArray ( _buf->glo.va[0] );
+
+	if ( skin )
+	{	glActiveTexture ( GL_TEXTURE0 + 0 );
+		glBindTexture ( GL_TEXTURE_BUFFER, _buf->paltex );
+		glUniform1i ( p->uniloc[6], 0 ); // palette is in texture unit 0
+	}
 
-	float buf[12];
-	glUniformMatrix4fv ( p->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+	c->uniform_projection ( p );
 	glUniformMatrix4fv ( p->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 
 	if ( mtlmode==GsModel::NoMtl )
-	{	glUniform3fv ( p->uniloc[2], 1, c->light.position.e );
-		glUniform3fv ( p->uniloc[3], 3, c->light.encode_intensities(buf) );
-		glUniform3fv ( p->uniloc[4], 4, s->material().encode_colors(buf) );
-		glUniform1fv ( p->uniloc[5], 2, s->material().encode_params(buf) );
-		if ( _normalspervertex )
+	{	c->uniform_light ( p, 2 );
+		c->uniform_material ( p, s->material(), 4 );
+		if ( normalspervertex )
 		{	GS_TRACE4 ( "Drawing per-vertex smooth, default material" );
-			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, 0 );
 		}
 		else 
 		{	GS_TRACE4 ( "Drawing per-face shading, default material" );
@@ -211,24 +428,20 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 		}
 	}
 	else if ( mtlmode==GsModel::PerGroupMtl )
-	{	glUniform3fv ( p->uniloc[2], 1, c->light.position.e );
-		glUniform3fv ( p->uniloc[3], 3, c->light.encode_intensities(buf) );
+	{	c->uniform_light ( p, 2 );
 		glUniform1i  ( p->uniloc[6], 0 ); // set mode to textured
 		const int gsize = m.G.size();
 
 		# define DRAW_GROUP_TRIANGLES(M,G) \
-			glUniform3fv ( p->uniloc[4], 4, M.encode_colors(buf) ); \
-			glUniform1fv ( p->uniloc[5], 2, M.encode_params(buf) ); \
+			c->uniform_material ( p, M, 4 ); \
 			glDrawArrays ( GL_TRIANGLES, G.fi*3, G.fn*3 )
 
-		if ( _normalspervertex )
+		if ( normalspervertex )
 		{	GS_TRACE4 ( "Drawing per-vertex smooth, grouped materials" );
 			for ( int g=0; g<gsize; g++ )
 			{	GsModel::Group& G=m.G[g];
-				GsMaterial& M=m.M[g];
-				glUniform3fv ( p->uniloc[4], 4, M.encode_colors(buf) );
-				glUniform1fv ( p->uniloc[5], 2, M.encode_params(buf) );
-				glDrawElements ( GL_TRIANGLES, G.fn*3, GL_UNSIGNED_INT, &m.F[G.fi].a );
+				c->uniform_material ( p, m.M[g], 4 );
+				glDrawElements ( GL_TRIANGLES, G.fn*3, GL_UNSIGNED_INT, (const void*)(G.fi*sizeof(GsModel::Face)) );
 			}
 		}
 		else if ( textured ) // per-group with textures
@@ -269,13 +482,11 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 		# undef DRAW_GROUP_TRIANGLES
 	}
 	else if ( m.mtlmode()==GsModel::PerVertexMtl || m.mtlmode()==GsModel::PerFaceMtl )
-	{	glUniform3fv ( p->uniloc[2], 1, c->light.position.e );
-		glUniform3fv ( p->uniloc[3], 3, c->light.encode_intensities(buf) );
-		glUniform3fv ( p->uniloc[4], 4, m.M[0].encode_colors(buf) );
-		glUniform1fv ( p->uniloc[5], 2, m.M[0].encode_params(buf) );
-		if ( _normalspervertex )
+	{	c->uniform_light ( p, 2 );
+		c->uniform_material ( p, m.M[0], 4 );
+		if ( normalspervertex )
 		{	GS_TRACE4 ( "Drawing per-vertex materials, per-vertex normals" );
-			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+			glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, 0 );
 		}
 		else 
 		{	GS_TRACE4 ( "Drawing per-vertex materials, per-face normals" );
@@ -284,15 +495,96 @@ void GlrModel::render (  SnShape* s, GlContext* c )
 	}
 	else // GsModel::PerVertexColor
 	{	GS_TRACE4 ( "Drawing without shading, only per-vertex colors" );
-		glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, m.F.pt() );
+		glDrawElements ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, 0 );
 	}
+	GsProfiler::count ( GsProfiler::DrawCalls, mtlmode==GsModel::PerGroupMtl? m.G.size():1 );
+	GsProfiler::count ( GsProfiler::Triangles, m.F.size() );
 
+	if ( skin ) glBindTexture ( GL_TEXTURE_BUFFER, 0 );
 	glBindVertexArray ( 0 );
 	c->polygon_mode_fill();
 
 	GS_TRACE2 ( "End rendering "<<s->instance_name()<<" ["<<m.name<<"]" );
 }
 
+const void* GlrModel::instance_key ( SnShape* s )
+{
+	const GsModel& m = *((const SnModel*)s)->cmodel();
+	gsRenderMode rm = s->render_mode();
+	if ( m.empty() || rm==gsRenderModeLines || rm==gsRenderModePoints ) return 0;
+	gscbool textured;
+	GsModel::MtlMode mtlmode;
+	SnModel::Skinning* skin;
+	const GlProgram* p = select_program ( s, m, textured, mtlmode, skin );
+	if ( mtlmode!=GsModel::NoMtl || ( p!=pGour && p!=pFlat && p!=pPhong ) ) return 0; // no materials, textures or skinning
+	return &m;
+}
+
+void GlrModel::render_instances ( SnShape** shapes, const GsMat* mats, const GsMaterial* mtls, int n, GlContext* c )
+{
+	GS_TRACE2 ( "Rendering "<<n<<" instances of "<<shapes[0]->instance_name() );
+	const GsModel& m = *((const SnModel*)shapes[0])->cmodel();
+
+	// update the buffers with the changes of all shapes, all renderers then use the same buffers:
+	gscbool textured;
+	GsModel::MtlMode mtlmode;
+	SnModel::Skinning* skin;
+	const GlProgram* p=0;
+	int i;
+	for ( i=0; i<n; i++ )
+	{	GlrModel* r = (GlrModel*)shapes[i]->renderer();
+		p = r->_update ( shapes[i], c, textured, mtlmode, skin );
+		if ( r->_buf!=_buf ) break;
+	}
+	if ( i<n ) { GlrBase::render_instances ( shapes, mats, mtls, n, c ); return; } // should not happen
+
+	if ( !pGourI )
+	{	pFlatI = GlResources::get_program("3dflati");
+		pGourI = GlResources::get_program("3dgouraudi");
+		pPhongI = GlResources::get_program("3dphongi");
+	}
+	p = p==pFlat? pFlatI : p==pPhong? pPhongI : pGourI;
+
+	// send the instance data:
+	Instances.size ( n );
+	for ( i=0; i<n; i++ )
+	{	memcpy ( Instances[i].mat, mats[i].e, sizeof(float)*16 );
+		Instances[i].diffuse = mtls[i].diffuse;
+	}
+	if ( !_buf->instbuf ) glGenBuffers ( 1, &_buf->instbuf );
+	glBindBuffer ( GL_ARRAY_BUFFER, _buf->instbuf );
+	glBufferData ( GL_ARRAY_BUFFER, Instances.sizeofarray(), Instances.pt(), GL_STREAM_DRAW );
+	GsProfiler::count ( GsProfiler::BytesUploaded, Instances.sizeofarray() );
+
+	c->use_program ( p->id );
+	glBindVertexArray ( _buf->glo.va[0] );
+	if ( !_buf->instanced ) // the instance attributes become part of the vertex array state
+	{	GS_TRACE4 ( "Declaring instance attributes..." );
+		const GLsizei st = sizeof(Instance);
+		for ( i=0; i<4; i++ ) // one attribute per matrix line
+		{	glEnableVertexAttribArray(4+i); glVertexAttribPointer(4+i,4,GL_FLOAT,GL_FALSE,st,(const void*)(i*4*sizeof(float)));
+			glVertexAttribDivisor ( 4+i, 1 );
+		}
+		glEnableVertexAttribArray(8); glVertexAttribPointer(8,4,GL_UNSIGNED_BYTE,GL_FALSE,st,(const void*)(16*sizeof(float)));
+		glVertexAttribDivisor ( 8, 1 );
+		_buf->instanced = 1;
+	}
+
+	c->uniform_projection ( p );
+	glUniformMatrix4fv ( p->uniloc[1], 1, GLTRANSPMAT, GsMat::id.e ); // transformations come from the instances
+	c->uniform_light ( p, 2 );
+	c->uniform_material ( p, mtls[0], 4 );
+	if ( _buf->normalspervertex )
+		glDrawElementsInstanced ( GL_TRIANGLES, m.F.size()*3, GL_UNSIGNED_INT, 0, n );
+	else
+		glDrawArraysInstanced ( GL_TRIANGLES, 0, m.F.size()*3, n );
+	GsProfiler::count ( GsProfiler::DrawCalls );
+	GsProfiler::count ( GsProfiler::Triangles, uint64_t(m.F.size())*n );
+
+	glBindVertexArray ( 0 );
+	c->polygon_mode_fill();
+}
+
 /*Notes:
   - MultiDrawArrays() requires indices and is not faster than DrawArrays() multiple times
   - glPolygonMode remains in version 4.5: opengl.org/sdk/docs/man4/html/glPolygonMode.xhtml
@@ -6,6 +6,7 @@
   =======================================================================*/
 
 # include <sig/sn_planar_objects.h>
+# include <sig/gs_profiler.h>
 
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_context.h>
@@ -64,6 +65,7 @@ void GlrPlanarObjects::render ( SnShape* s, GlContext* c )
 			glBufferData(GL_ARRAY_BUFFER, o.T.sizeofarray(), o.T.pt(), GL_STATIC_DRAW);
 			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
 		}
+		GsProfiler::count ( GsProfiler::BytesUploaded, o.P.sizeofarray()+o.C.sizeofarray()+o.T.sizeofarray() );
 	}
 
 	if (!_esize) return; // nothing to do
@@ -71,7 +73,7 @@ void GlrPlanarObjects::render ( SnShape* s, GlContext* c )
 	// 3. Enable/bind needed elements and draw:
 	c->use_program(Prog);
 	glActiveTexture(GL_TEXTURE0 + 0); // Only using texture unit 0
-	glUniformMatrix4fv(Prog->uniloc[0], 1, GLTRANSPMAT, c->projection()->e);
+	c->uniform_projection(Prog);
 	glUniformMatrix4fv(Prog->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e);
 	glUniform1f(Prog->uniloc[2], o.zcoordinate);
 	glBindVertexArray(_glo.va[0]);
@@ -96,6 +98,10 @@ void GlrPlanarObjects::render ( SnShape* s, GlContext* c )
 		}
 		G.pop();
 	}
+	// indices are sent from client memory at each draw:
+	GsProfiler::count ( GsProfiler::DrawCalls, gsize? gsize:1 );
+	GsProfiler::count ( GsProfiler::Triangles, _esize );
+	GsProfiler::count ( GsProfiler::BytesUploaded, o.I.sizeofarray() );
 	glBindVertexArray(0); // break the existing vertex array object binding.
 }
 
@@ -5,6 +5,8 @@
    at the base folder of the distribution. 
   =======================================================================*/
 
+# include <sig/gs_profiler.h>
+
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
@@ -64,6 +66,7 @@ void GlrPoints::render (  SnShape* s, GlContext* c )
 		 glBufferData ( GL_ARRAY_BUFFER, p.C.sizeofarray(), p.C.pt(), GL_STATIC_DRAW );
 		 glVertexAttribPointer ( 1, 4, GL_UNSIGNED_BYTE, GL_FALSE, 0, 0 );
 	   }
+	  GsProfiler::count ( GsProfiler::BytesUploaded, p.P.sizeofarray()+(_csize>0?p.C.sizeofarray():0) );
 	  if ( s->auto_clear_data() )
 	   { p.P.size(0);
 		 p.C.size(0);
@@ -81,19 +84,20 @@ void GlrPoints::render (  SnShape* s, GlContext* c )
    if ( _csize>0 )
 	{ GS_TRACE2 ( "Rendering w/ colors per point..." );
 	  c->use_program ( pSmo->id ); // ctx tests if the program is being changed
-	  glUniformMatrix4fv ( pSmo->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+	  c->uniform_projection ( pSmo );
 	  glUniformMatrix4fv ( pSmo->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 	}
    else // single color per line:
 	{ GS_TRACE2 ( "Rendering w/ single color..." );
 	  c->use_program ( pSsc->id ); // ctx tests if the program is being changed
-	  glUniformMatrix4fv ( pSsc->uniloc[0], 1, GLTRANSPMAT, c->projection()->e );
+	  c->uniform_projection ( pSsc );
 	  glUniformMatrix4fv ( pSsc->uniloc[1], 1, GLTRANSPMAT, c->modelview()->e );
 	  glUniform4fv ( pSsc->uniloc[2], 1, s->SnShape::color().vec4() );
 	}
 
    glBindVertexArray ( _glo.va[0] );
    glDrawArrays ( GL_POINTS, 0, _psize );
+   GsProfiler::count ( GsProfiler::DrawCalls );
    glBindVertexArray ( 0 ); // done
  }
 
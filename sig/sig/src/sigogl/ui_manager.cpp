@@ -5,6 +5,7 @@
    at the base folder of the distribution.
   =======================================================================*/
 
+# include <sig/gs_profiler.h>
 # include <sigogl/ws_run.h>
 # include <sigogl/ws_window.h>
 # include <sigogl/ui_button.h>
@@ -265,7 +266,8 @@ void UiManager::render ( GlRenderer* r )
 
 	GS_TRACE2("Changed: "<<_changed);
 	if (_changed)
-	{	if (_changed==2) { GS_TRACE2("Building..."); build(); }
+	{	GsProfileScope scope ( "ui build" );
+		if (_changed==2) { GS_TRACE2("Building..."); build(); }
 		for ( int i=0; i<panels(); i++ )
 		{	if ( get(i)->changed() )
 			{	GS_TRACE2("Drawing element " << i << "...");
@@ -278,6 +280,7 @@ void UiManager::render ( GlRenderer* r )
 	r->init(&_projmat, &GsMat::id);
 
 	GS_TRACE2("Rendering... ");
+	GsProfileScope scope ( "ui render" );
 	r->glcontext()->depth_test(false);
 	r->glcontext()->cull_face(false);
 	r->apply(group());
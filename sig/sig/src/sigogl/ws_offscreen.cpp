@@ -0,0 +1,311 @@
+/*=======================================================================
+   Copyright (c) 2018 Marcelo Kallmann.
+   This software is distributed under the Apache License, Version 2.0.
+   All copies must contain the full copyright notice licence.txt located
+   at the base folder of the distribution. 
+  =======================================================================*/
+
+# include <math.h>
+
+# include <sig/gs_box.h>
+# include <sig/gs_image.h>
+# include <sig/sn_group.h>
+# include <sig/sa_bbox.h>
+
+# include <sigogl/gl_core.h>
+# include <sigogl/gl_loader.h>
+# include <sigogl/gl_context.h>
+# include <sigogl/gl_renderer.h>
+# include <sigogl/ui_style.h>
+# include <sigogl/ws_offscreen.h>
+# include <sigogl/ws_osinterface.h>
+
+//# define GS_USE_TRACE1 // framebuffer
+# include <sig/gs_trace.h>
+
+//================================= Data ===============================
+
+struct WsOffscreen::Data
+{	void* ctx;				// system context, null if it could not be created
+	bool glinit;			// true after the context is initialized
+	int w, h, samples;
+	GLuint fbo, color, depth;	// framebuffer where the scene is rendered
+	GLuint rfbo, rcolor;		// single-sample framebuffer receiving the multisampled one
+	bool fbok;				// true if the framebuffers are complete for the current size
+
+	GlContext* context;
+	GlRenderer* renderer;
+	SnNode* root;
+	GsCamera camera;
+	GsMat matc, matp;
+	GsLight light;
+	GsColor bcolor;
+
+	Data () { ctx=0; glinit=false; fbo=color=depth=rfbo=rcolor=0; fbok=false; }
+	void init_gl ();
+	void delete_framebuffers ();
+	bool create_framebuffers ();
+};
+
+void WsOffscreen::Data::init_gl ()
+{
+	gl_load_and_initialize (); // only overall 1st call will actually load ogl
+	context->init ();
+
+	// same configuration as in WsViewer::init():
+	glEnable ( GL_DEPTH_TEST );
+	glDepthFunc ( GL_LEQUAL );
+	glCullFace ( GL_BACK );
+	glFrontFace ( GL_CCW );
+	glEnable ( GL_BLEND );
+	glBlendFunc ( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	glEnable ( GL_LINE_SMOOTH );
+	glHint ( GL_LINE_SMOOTH_HINT, GL_NICEST );
+	glPointSize ( 2.0 );
+	glinit = true;
+}
+
+void WsOffscreen::Data::delete_framebuffers ()
+{
+	if ( fbo ) { glDeleteFramebuffers ( 1, &fbo ); fbo=0; }
+	if ( rfbo ) { glDeleteFramebuffers ( 1, &rfbo ); rfbo=0; }
+	if ( color ) { glDeleteRenderbuffers ( 1, &color ); color=0; }
+	if ( depth ) { glDeleteRenderbuffers ( 1, &depth ); depth=0; }
+	if ( rcolor ) { glDeleteRenderbuffers ( 1, &rcolor ); rcolor=0; }
+	fbok = false;
+}
+
+bool WsOffscreen::Data::create_framebuffers ()
+{
+	GS_TRACE1 ( "Creating framebuffers "<<w<<"x"<<h<<" samples:"<<samples<<"..." );
+	delete_framebuffers ();
+
+	glGenRenderbuffers ( 1, &color );
+	glBindRenderbuffer ( GL_RENDERBUFFER, color );
+	if ( samples>1 ) glRenderbufferStorageMultisample ( GL_RENDERBUFFER, samples, GL_RGBA8, w, h );
+	else glRenderbufferStorage ( GL_RENDERBUFFER, GL_RGBA8, w, h );
+	glGenRenderbuffers ( 1, &depth );
+	glBindRenderbuffer ( GL_RENDERBUFFER, depth );
+	if ( samples>1 ) glRenderbufferStorageMultisample ( GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, w, h );
+	else glRenderbufferStorage ( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h );
+	glGenFramebuffers ( 1, &fbo );
+	glBindFramebuffer ( GL_FRAMEBUFFER, fbo );
+	glFramebufferRenderbuffer ( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color );
+	glFramebufferRenderbuffer ( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth );
+	fbok = glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+
+	// multisampled renderbuffers cannot be read and are resolved in a second framebuffer:
+	if ( fbok && samples>1 )
+	{	glGenRenderbuffers ( 1, &rcolor );
+		glBindRenderbuffer ( GL_RENDERBUFFER, rcolor );
+		glRenderbufferStorage ( GL_RENDERBUFFER, GL_RGBA8, w, h );
+		glGenFramebuffers ( 1, &rfbo );
+		glBindFramebuffer ( GL_FRAMEBUFFER, rfbo );
+		glFramebufferRenderbuffer ( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rcolor );
+		fbok = glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+	}
+	glBindRenderbuffer ( GL_RENDERBUFFER, 0 );
+	glBindFramebuffer ( GL_FRAMEBUFFER, 0 );
+
+	GS_TRACE1 ( (fbok?"Done.":"Error!") );
+	if ( !fbok ) delete_framebuffers ();
+	return fbok;
+}
+
+//================================= WsOffscreen ===============================
+
+WsOffscreen::WsOffscreen ( int w, int h, int samples, bool software )
+{
+	_data = new Data;
+	_data->w = w>0? w:1;
+	_data->h = h>0? h:1;
+	_data->samples = samples;
+	_data->ctx = wsi_new_offscreen ( software );
+
+	_data->context = new GlContext;
+	_data->context->ref();
+	_data->renderer = new GlRenderer ( _data->context );
+	_data->renderer->ref();
+
+	_data->root = new SnGroup;
+	_data->root->ref();
+	_data->light.init();
+	_data->bcolor = UiStyle::Current().color.background;
+	_data->camera.aspect = float(_data->w)/float(_data->h);
+}
+
+WsOffscreen::~WsOffscreen ()
+{
+	if ( _data->ctx ) // OpenGL objects of the scene are released with the context active
+	{	wsi_activate_offscreen ( _data->ctx );
+		_data->delete_framebuffers ();
+	}
+	_data->root->unref();
+	_data->renderer->unref();
+	_data->context->unref();
+	if ( _data->ctx ) wsi_del_offscreen ( _data->ctx );
+	delete _data;
+}
+
+bool WsOffscreen::valid () const
+{
+	return _data->ctx!=0;
+}
+
+void WsOffscreen::activate_ogl_context () const
+{
+	if ( _data->ctx ) wsi_activate_offscreen ( _data->ctx );
+}
+
+void WsOffscreen::size ( int w, int h )
+{
+	if ( w<1 ) w=1;
+	if ( h<1 ) h=1;
+	if ( w==_data->w && h==_data->h ) return;
+	_data->w = w;
+	_data->h = h;
+	_data->fbok = false; // framebuffers are recreated by the next render
+	_data->camera.aspect = float(w)/float(h);
+}
+
+int WsOffscreen::w () const
+{
+	return _data->w;
+}
+
+int WsOffscreen::h () const
+{
+	return _data->h;
+}
+
+SnNode* WsOffscreen::root () const
+{
+	return _data->root;
+}
+
+SnGroup* WsOffscreen::rootg () const
+{
+	return (SnGroup*)_data->root;
+}
+
+void WsOffscreen::root ( SnNode* r )
+{
+	if ( r==_data->root ) return;
+	if ( !r ) r = new SnGroup;
+	r->ref();
+	activate_ogl_context(); // the old scene may release OpenGL objects
+	_data->root->unref();
+	_data->root = r;
+}
+
+GlRenderer* WsOffscreen::scene_renderer () const
+{
+	return _data->renderer;
+}
+
+GsCamera& WsOffscreen::camera ()
+{
+	return _data->camera;
+}
+
+void WsOffscreen::camera ( const GsCamera& cam )
+{
+	_data->camera = cam;
+}
+
+GsLight& WsOffscreen::light ()
+{
+	return _data->light;
+}
+
+void WsOffscreen::light ( const GsLight& l )
+{
+	_data->light = l;
+}
+
+GsColor WsOffscreen::background () const
+{
+	return _data->bcolor;
+}
+
+void WsOffscreen::background ( GsColor c )
+{
+	_data->bcolor = c;
+}
+
+void WsOffscreen::view_all ()
+{
+	GsCamera& c = _data->camera;
+	c.init ();
+	c.aspect = float(_data->w)/float(_data->h);
+	c.eye.z = 2.0f;
+
+	SaBBox bboxaction;
+	bboxaction.apply ( _data->root );
+	GsBox box = bboxaction.get();
+	if ( box.empty() ) return;
+
+	c.fovy = GS_TORAD(65.0f);
+	float s = box.maxsize()/2.0f;
+	float d = s/tanf(c.fovy/2.0f);
+	c.center = box.center();
+	c.eye = c.center+GsVec(0,0,d+s);
+	c.up = GsVec::j;
+	c.znear = 0.01f;
+	c.zfar  = d+3.0f*s;
+}
+
+bool WsOffscreen::render ()
+{
+	Data& d = *_data;
+	if ( !d.ctx ) return false;
+	wsi_activate_offscreen ( d.ctx );
+	if ( !d.glinit ) d.init_gl ();
+	if ( !d.fbok && !d.create_framebuffers() ) return false;
+
+	//----- Clear Background --------------------------------------------
+	GlContext* glc = d.context;
+	glBindFramebuffer ( GL_FRAMEBUFFER, d.fbo );
+	glc->viewport ( d.w, d.h );
+	glc->clear_color ( d.bcolor );
+	glc->clear ();
+
+	//----- Set Transformations and Light -------------------------------
+	d.camera.getmat ( d.matp, d.matc );
+	d.renderer->init ( &d.matp, &d.matc );
+	glc->light = d.light;
+
+	//----- Render Scene ------------------------------------------------
+	d.renderer->apply ( d.root );
+
+	if ( d.rfbo ) // resolve the multisampled framebuffer
+	{	glBindFramebuffer ( GL_READ_FRAMEBUFFER, d.fbo );
+		glBindFramebuffer ( GL_DRAW_FRAMEBUFFER, d.rfbo );
+		glBlitFramebuffer ( 0, 0, d.w, d.h, 0, 0, d.w, d.h, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	}
+	glBindFramebuffer ( GL_FRAMEBUFFER, 0 );
+	return true;
+}
+
+void WsOffscreen::snapshot ( GsImage& img )
+{
+	Data& d = *_data;
+	if ( !d.fbok ) return;
+	wsi_activate_offscreen ( d.ctx );
+	img.init ( d.w, d.h );
+	glBindFramebuffer ( GL_READ_FRAMEBUFFER, d.rfbo? d.rfbo:d.fbo );
+	glReadBuffer ( GL_COLOR_ATTACHMENT0 );
+	glPixelStorei ( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels ( 0, 0, d.w, d.h, GL_RGBA, GL_UNSIGNED_BYTE, (void*)img.data() );
+	glBindFramebuffer ( GL_READ_FRAMEBUFFER, 0 );
+	img.vertical_mirror ();
+}
+
+bool WsOffscreen::render ( const char* file )
+{
+	GsImage img;
+	if ( !render(img) ) return false;
+	return img.save ( file );
+}
+
+//================================ End of File =================================================
@@ -16,6 +16,7 @@
 # include <sig/gs_plane.h>
 # include <sig/gs_event.h>
 # include <sig/gs_timer.h>
+# include <sig/gs_profiler.h>
 # include <sig/gs_string.h>
 # include <sig/gs_image.h>
 # include <sig/gs_light.h>
@@ -33,6 +34,7 @@
 
 # include <sigogl/gl_core.h>
 # include <sigogl/gl_tools.h>
+# include <sigogl/gl_capture.h>
 # include <sigogl/gl_context.h>
 # include <sigogl/gl_resources.h>
 # include <sigogl/gl_renderer.h>
@@ -76,6 +78,7 @@ class WsViewerData
 	gscbool iconized;		// to stop processing while the window is iconized
 	gscbool allowspinanim;	// allows spin animation or not
 	gscbool statistics;		// shows statistics or not
+	gscbool profiler;		// profiles frames and shows their summary or not
 
 	gscbool lightneedsupdate;
 	GsLight light;
@@ -92,22 +95,20 @@ class WsViewerData
 	GsCamera camera;		// The current camera and viewing parameters
 	GsMat matc, matp;		// Matrices used for camera and projection transformations
 
-	GsImage image;			// image memry is freed when not in use
-	GsString image_name;
-	GsString image_ext;
-	GsString image_filename;
-	int image_number;
+	GlCapture* capture;		// frame capture, only allocated when snapshots are used
 
 	UiPanel* rbpanel;		// right button activated menu
 
    private:
 	UiOutput* _output;		// to display text on the screen, not often used, created only when needed
 	UiOutput* _message;		// output element placed as a bottom bar
+	UiOutput* _profile;		// frame summary of the profiler, created only when needed
 
    public:
-	WsViewerData () { _output=0; _message=0; rbpanel=0; }
+	WsViewerData () { _output=0; _message=0; _profile=0; rbpanel=0; }
 	UiOutput* output ();
 	UiOutput* message ();
+	UiOutput* profile ();
 };
 
 //================================= gui ===================================================
@@ -145,6 +146,23 @@ UiOutput* WsViewerData::message ()
 	return _message;
 }
 
+UiOutput* WsViewerData::profile ()
+{
+	// Profiler summary =============================================================
+	if ( !_profile )
+	{	UiPanel* p = new UiPanel ( 0, UiPanel::Vertical, 10, 80 );
+		p->color().ln.a=0; // no frame
+		p->color().bg.a=0; // no background
+		_profile = new UiOutput(0,10,24);
+		_profile->color().bg.a=0; // no background
+		_profile->rect_clip ( false ); // use whole viewer
+		_profile->word_wrap ( false );
+		p->add ( _profile );
+		rbpanel->uimparent()->add(p); // insert finalized panel to ensure proper building
+	}
+	return _profile;
+}
+
 void WsViewer::build_ui ()
 {
 	UiPanel* p;  // current panel
@@ -181,6 +199,11 @@ void WsViewer::build_ui ()
 		p->add ( new UiCheckButton ( "statistics", VCmdStatistics ) );
 		p->add ( new UiCheckButton ( "spin anim", VCmdSpinAnim, 1 ) );
 	}
+	p->add ( new UiButton ( "profiler", sp=new UiPanel() ) );
+	{	UiPanel* p=sp;
+		p->add ( new UiCheckButton ( "profile frames", VCmdProfiler ) );
+		p->add ( new UiButton ( "save trace", VCmdSaveTrace ) );
+	}
 
 	//ImprNote: consider adding: number of lights, and ui style change
 }
@@ -225,9 +248,10 @@ WsViewer::WsViewer ( int x, int y, int w, int h, const char *label )
 	_data->spinning	= false;
 	_data->allowspinanim = true;
 	_data->statistics  = false;
+	_data->profiler = false;
 
 	_data->fcounter = 0; // frame counter not in use
-	_data->image_number = 0; // not saving images
+	_data->capture = 0; // not saving images
 
 	_data->light.init();
 	_data->lightneedsupdate = true;
@@ -272,6 +296,8 @@ WsViewer::~WsViewer ()
 	_data->vr->unref();
 	_data->vroot->unref();
 	delete _data->fcounter;
+	if ( _data->profiler ) GsProfiler::enable ( false );
+	if ( _data->capture ) { activate_ogl_context(); delete _data->capture; } // pending frames are written
 	delete _data;
 }
 
@@ -285,6 +311,11 @@ SnGroup* WsViewer::rootg () const
 	return (SnGroup*)_data->uroot;
 }
 
+GlRenderer* WsViewer::scene_renderer () const
+{
+	return _data->vr;
+}
+
 void WsViewer::root ( SnNode *r )
 { 
 	if ( r==_data->uroot ) return;
@@ -383,6 +414,18 @@ int WsViewer::cmd ( ViewerCmd c )
 			if ( !_data->allowspinanim ) _data->spinning=false;
 		} break;
 
+		case VCmdProfiler:
+		{	GS_SWAPB(_data->profiler); UPDATE(VCmdProfiler,_data->profiler);
+			GsProfiler::enable ( _data->profiler==1 );
+			if ( !_data->profiler ) _data->profile()->text().len(0);
+		} break;
+
+		case VCmdSaveTrace:
+		{	if ( !GsProfiler::frames() ) { ui_message("No profiled frames to save!"); return 1; }
+			const char* file = ui_input_file ( "Enter trace file name:", "trace.json", "*.json" );
+			if ( file && !GsProfiler::export_trace(file) ) ui_message("Could not save trace!");
+		} break;
+
 		// render mode radio buttons:
 		case VCmdAsIs:
 		{	_data->rendermode = ModeAsIs; SET(VCmdAsIs);
@@ -425,6 +468,7 @@ bool WsViewer::cmd_activated ( ViewerCmd c )
 		case VCmdBoundingBox: return SCENEBOX->visible()==1;
 		case VCmdStatistics: return _data->statistics==1;
 		case VCmdSpinAnim:	return _data->allowspinanim==1;
+		case VCmdProfiler:	return _data->profiler==1;
 
 		default : return false;
 	}
@@ -657,27 +701,21 @@ void WsViewer::export_all_models ( const char* prefix, const char* dir )
 
 void WsViewer::snapshots ( bool onoff, const char* file, int n )
 {
+	if ( !_data->capture && !onoff ) return;
+	activate_ogl_context (); // needed to finish pending reads
 	if ( onoff==false ) // turn off
-	{	_data->image_number=0; // an index<=0 disables snapshots
-		_data->image.init(0,0); // free image memory
-		_data->image_name.len(0);
-		_data->image_ext.len(0);
-		_data->image_filename.len(0);
+	{	delete _data->capture; // waits for pending frames to be written
+		_data->capture = 0;
 	}
 	else // turn on
-	{	if ( file )
-		{	_data->image_name = file; 
-			if ( extract_extension(_data->image_name,_data->image_ext)>=0 ) // has extension
-			{	if ( _data->image_ext!="bmp" && _data->image_ext!="tga" ) _data->image_ext="png"; }
-			else
-			{	if ( _data->image_name.lchar()=='.' ) _data->image_name.lchar(0); }
-			output(0); message(0); // clear any messages on screen
+	{	if ( !_data->capture ) _data->capture = new GlCapture;
+		if ( file && file[0]=='|' )
+		{	if ( !_data->capture->open_pipe(file+1) ) ui_message ( "Could not start encoder!" );
 		}
 		else
-		{	_data->image_name = "img"; // default values
-			_data->image_ext = "png";
+		{	_data->capture->open ( file? file:"img.png", n );
 		}
-		_data->image_number = n<=0? 1:n;
+		if ( file ) { output(0); message(0); } // clear any messages on screen
 	}
 }
 
@@ -711,6 +749,9 @@ void WsViewer::resize ( GlContext* c, int w, int h )
 
 void WsViewer::draw ( GlRenderer* wr ) 
 {
+	//----- Start Profiled Frame ----------------------------------------
+	GsProfiler::next_frame (); // the previous frame ends here, including the time between draws
+
 	//----- Clear Background --------------------------------------------
 	GlContext* glc = wr->glcontext();
 	glc->clear_color ( _data->bcolor );
@@ -731,11 +772,13 @@ void WsViewer::draw ( GlRenderer* wr )
 	//----- Render user scene -------------------------------------------
 	if ( _data->fcounter )
 	{	_data->fcounter->start();
+		GsProfileScope scope ( "scene traversal" );
 		_data->vr->apply ( _data->vroot );
 		_data->fcounter->stop();
 	}
 	else
-	{	_data->vr->apply ( _data->vroot );
+	{	GsProfileScope scope ( "scene traversal" );
+		_data->vr->apply ( _data->vroot );
 	}
 
 	//----- Update statistics -------------------------------------------
@@ -745,14 +788,19 @@ void WsViewer::draw ( GlRenderer* wr )
 						_data->fcounter->measurements(),
 						_data->fcounter->loopdt()*1000.0,
 						_data->fcounter->meandt()*1000.0 );
+		if ( _data->vr->traversal_mode()!=GlRenderer::DirectTraversal )
+			_data->message()->text() << " shapes:" << _data->vr->rendered() << " culled:" << _data->vr->culled();
+		if ( _data->vr->traversal_mode()==GlRenderer::SortedTraversal )
+			_data->message()->text() << " instanced:" << _data->vr->instanced();
 	}
 
+	//----- Update profiler summary -------------------------------------
+	if ( _data->profiler ) GsProfiler::summary ( GsProfiler::frames()-1, _data->profile()->text() );
+
 	//----- Snapshots -------------------------------------------
-	if ( _data->image_number>0 )
-	{	gl_snapshot ( _data->image );
-		_data->image_filename.setf ( "%s%04d.%s", _data->image_name.pt(), _data->image_number, _data->image_ext.pt() );
-		if ( !_data->image.save(_data->image_filename) ) { ui_message("Could not save snapshot!"); _data->image_number=-1; }
-		_data->image_number++;
+	if ( _data->capture && _data->capture->opened() )
+	{	_data->capture->capture (); // frames are saved by other threads
+		if ( _data->capture->error() ) { ui_message("Could not save snapshot!"); snapshots(false); }
 	}
 
 	//----- Let WsWindow draw UI ---------------------------------
@@ -979,14 +1027,16 @@ static void eps_export ( SnNode* n )
 
 static void snapshot_onoff ( WsViewerData* d, WsViewer* v )
 {
-	if ( d->image_number>0 ) // turn off
-	{	int n = d->image_number-1;
+	if ( d->capture && d->capture->opened() ) // turn off
+	{	v->activate_ogl_context ();
+		d->capture->close ();
+		int n = d->capture->frames_written();
 		v->snapshots ( false );
 		GsString s; s.setf ( "Snapshots turned off.\nImages saved: %d.", n );
 		ui_message ( s );
 	}
 	else // turn on
-	{	const char *file = ui_input_file ( "Enter file name (png,tga,bmp):", "./img.png" );
+	{	const char *file = ui_input_file ( "Enter file name (png,tga,bmp,raw):", "./img.png" );
 		if ( !file ) return;
 		v->snapshots ( true, file );
 	}
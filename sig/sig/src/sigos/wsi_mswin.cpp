@@ -44,6 +44,7 @@ static MSG			AppMsg;
 static char*		AppName="SIGAppClass";
 static gsint16		AppNumVisWindows=0;
 static gsint16		DialogRunning=0;
+static HGLRC		ShareCtx=0;		// context shared by all new contexts
 static int (*AppCallBack)( const GsEvent& ev, void* wdata )=0;
 
 //===== Declarations ==========================================================================
@@ -214,7 +215,7 @@ void* wsi_new_win ( int x, int y, int w, int h, const char* label, WsWindow* uwi
 	}
 
 	sw->glrendcontext = wglCreateContext ( sw->gldevcontext );
-	if ( AppWindows.size() ) wglShareLists ( AppWindows[0]->glrendcontext, sw->glrendcontext );
+	if ( ShareCtx ) wglShareLists ( ShareCtx, sw->glrendcontext ); else ShareCtx=sw->glrendcontext;
 
 	AppWindows.push ( sw );
 
@@ -367,6 +368,66 @@ void wsi_screen_resolution ( int& w, int& h )
 	h = GetSystemMetrics ( SM_CYSCREEN );
 }
 
+//==== Offscreen Contexts =====================================================================
+
+struct SwOffscreen
+{	HWND  window;			// hidden window, never shown
+	HDC	  gldevcontext;		// opengl device context
+	HGLRC glrendcontext;	// opengl rendering context
+};
+
+// software rendering depends on the installed opengl32.dll (as mesa's one using llvmpipe),
+// since the generic implementation of windows does not support shaders
+void* wsi_new_offscreen ( bool software )
+{
+	GS_TRACE1 ( "wsi_new_offscreen..." );
+	GlResources::load_configuration_file (); // only overall 1st call will actually load config file
+
+	SwOffscreen* so = new SwOffscreen;
+	so->window = CreateWindowEx ( 0, "STATIC", "", WS_POPUP, 0, 0, 16, 16, NULL, NULL, AppInstance, NULL );
+	if ( !so->window ) { delete so; return 0; }
+	so->gldevcontext = GetDC ( so->window );
+
+	PIXELFORMATDESCRIPTOR pfd;
+	memset ( &pfd, 0, sizeof(pfd) );
+	pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
+	pfd.nVersion = 1;
+	pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+	pfd.iPixelType = PFD_TYPE_RGBA;
+	pfd.cColorBits = 24;
+	pfd.cAlphaBits = 8;
+	pfd.cDepthBits = 32;
+	pfd.iLayerType = PFD_MAIN_PLANE;
+	int pixformat = ChoosePixelFormat ( so->gldevcontext, &pfd );
+	so->glrendcontext = pixformat && SetPixelFormat(so->gldevcontext,pixformat,&pfd)? wglCreateContext(so->gldevcontext) : NULL;
+	if ( !so->glrendcontext )
+	{	ReleaseDC ( so->window, so->gldevcontext );
+		DestroyWindow ( so->window );
+		delete so;
+		return 0;
+	}
+	if ( ShareCtx ) wglShareLists ( ShareCtx, so->glrendcontext ); else ShareCtx=so->glrendcontext;
+	return (void*)so;
+}
+
+void wsi_del_offscreen ( void* ctx )
+{
+	GS_TRACE1 ( "wsi_del_offscreen..." );
+	SwOffscreen* so = (SwOffscreen*)ctx;
+	wglMakeCurrent ( NULL, NULL );
+	if ( so->glrendcontext==ShareCtx ) { delete so; return; } // as for windows, only destroyed at exit
+	wglDeleteContext ( so->glrendcontext );
+	ReleaseDC ( so->window, so->gldevcontext );
+	DestroyWindow ( so->window );
+	delete so;
+}
+
+void wsi_activate_offscreen ( void* ctx )
+{
+	GS_TRACE2 ( "wsi_activate_offscreen..." );
+	wglMakeCurrent ( ((SwOffscreen*)ctx)->gldevcontext, ((SwOffscreen*)ctx)->glrendcontext );
+}
+
 //==== WndProc ==============================================================================
 
 static void setkeycode ( GsEvent& e, WPARAM wParam )
@@ -561,7 +622,7 @@ static LRESULT CALLBACK WndProc ( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 		case WM_DESTROY :
 			GS_TRACE5 ( "WM_DESTROY ["<<sw->label<<"]..." );
 			PostQuitMessage ( 0 );
-			if ( AppWindows.size()>1 ) // Do not delete last OpenGL Context because all shared resources would be lost
+			if ( sw->glrendcontext!=ShareCtx ) // the shared context is only deleted at exit, otherwise shared resources would be lost
 			{	wglDeleteContext ( sw->glrendcontext ); sw->glrendcontext=NULL; }
 			ReleaseDC ( hWnd, sw->gldevcontext ); sw->gldevcontext=NULL;
 			delete sw;
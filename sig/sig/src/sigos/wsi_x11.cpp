@@ -63,12 +63,18 @@
 
 # include <GLFW/glfw3.h>
 
+# define EGL_NO_X11 // egl is only used for surfaceless contexts
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+
 //===== Global Data ===========================================================================
 
 struct SwSysWin; // fwd decl
 static GsBuffer<SwSysWin*> AppWindows;
 static gsint16		AppNumVisWindows=0;
 static gsint16		DialogRunning=0;
+static GLFWwindow*	ShareWin=0;		// context shared by all new windows and offscreens, only destroyed at exit
+static bool			UsingEgl=false;	// true when OpenGL functions are loaded from an egl context
 
 //static int (*AppCallBack)( const GsEvent& ev, void* wdata )=0;
 
@@ -110,7 +116,8 @@ void wsi_del_win ( void *win ) // this function is called by the WsWindow destru
 	if ( sw->gwin ) // the user called this function
 	{	sw->swin=0; // if user deletes sw, this is being called before SwSysWin destructor, stop a 2nd delete
 		//PostMessage ( sw->gwin, WM_DESTROY, 0, 0 ); // sw will then be deleted from WndProc
-		glfwDestroyWindow ( sw->gwin );
+		if ( sw->gwin!=ShareWin ) glfwDestroyWindow ( sw->gwin );
+		else glfwSetWindowUserPointer ( sw->gwin, 0 ); // as for offscreens, the hidden window is kept for its context
 	}
 	else // this call came from SwSysWin desctructor triggered by a DESTROY event
 	{	// nothing more to do
@@ -127,12 +134,8 @@ static void error_callback(int error, const char* description)
     fprintf(stderr, "GLFW Error: %s\n", description);
 }
 
-void* wsi_new_win ( int x, int y, int w, int h, const char* label, WsWindow* swin, int mode )
+static void _init_glfw ()
 {
-printf("HERE 1!\n");
-
-	GS_TRACE1 ( "wsi_new_win ["<<label<<"]..." );
-
 	static bool notinit=true;
 	if ( notinit )
 	{	
@@ -142,6 +145,15 @@ printf("HERE 1!\n");
 		if ( !glfwInit() ) gsout.fatal("wsi_new_win: Could not init GLFW!");
 		notinit=false;
 	}
+}
+
+void* wsi_new_win ( int x, int y, int w, int h, const char* label, WsWindow* swin, int mode )
+{
+printf("HERE 1!\n");
+
+	GS_TRACE1 ( "wsi_new_win ["<<label<<"]..." );
+
+	_init_glfw ();
 
 printf("HERE 2!\n");
 	GlResources::load_configuration_file (); // only overall 1st call will actually load config file
@@ -176,8 +188,8 @@ printf("HERE 3!\n");
 	glfwWindowHint ( GLFW_DOUBLEBUFFER, 1 );
 	glfwWindowHint ( GLFW_RESIZABLE, 1 );
 	glfwWindowHint ( GLFW_FOCUSED, mode>0? 1:0 );
-	GLFWwindow* sharedwin = AppWindows.size()? AppWindows[0]->gwin:NULL;
-	sw->gwin = glfwCreateWindow ( w, h, label, NULL, sharedwin ); // GLFWmonitor* monitor, GLFWwindow* share);
+	sw->gwin = glfwCreateWindow ( w, h, label, NULL, ShareWin ); // GLFWmonitor* monitor, GLFWwindow* share);
+	if ( !ShareWin ) ShareWin = sw->gwin;
 	glfwSetWindowUserPointer ( sw->gwin, sw );
 
 	int scw, sch;
@@ -287,6 +299,7 @@ int wsi_num_windows ()
 void* wsi_get_ogl_procedure ( const char *name )
 {
 	GS_TRACE2 ( "wsi_get_ogl_procedure..." );
+	if ( UsingEgl ) return (void *)eglGetProcAddress(name);
 	return (void *)glfwGetProcAddress(name);
 	//return (void *)glXGetProcAddress((const GLubyte*)name);
 //here
@@ -305,6 +318,129 @@ void wsi_screen_resolution ( int& w, int& h )
     h = m->height;
 }
 
+//==== Offscreen Contexts =====================================================================
+
+struct SwOffscreen
+{	GLFWwindow* gwin;	// hidden window, or null if an egl context is used
+	EGLDisplay edpy;	// egl display and context
+	EGLContext ectx;
+};
+
+// selects mesa's llvmpipe, which mesa reads when the display connection is initialized:
+static void _use_software ()
+{
+	setenv ( "LIBGL_ALWAYS_SOFTWARE", "1", 1 );
+	setenv ( "GALLIUM_DRIVER", "llvmpipe", 0 ); // keep a driver chosen by the user
+}
+
+// the first egl context keeps the objects shared by all egl contexts:
+static EGLDisplay EglDpy=EGL_NO_DISPLAY;
+static EGLConfig  EglConfig;
+static EGLContext EglShareCtx=EGL_NO_CONTEXT;
+
+static EGLContext _egl_context ( EGLDisplay dpy, EGLConfig config, EGLContext share )
+{
+	// the shaders need version 3.3, and the compatibility profile is preferred as windows use it:
+	EGLint profiles[] = { EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT };
+	EGLContext ctx = EGL_NO_CONTEXT;
+	for ( int i=0; i<2 && ctx==EGL_NO_CONTEXT; i++ )
+	{	const EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+								   EGL_CONTEXT_OPENGL_PROFILE_MASK, profiles[i], EGL_NONE };
+		ctx = eglCreateContext ( dpy, config, share, attribs );
+	}
+	return ctx;
+}
+
+// creates a context without any surface, which does not need an X server:
+static bool _new_egl_context ( SwOffscreen* so )
+{
+	if ( EglShareCtx!=EGL_NO_CONTEXT )
+	{	so->edpy = EglDpy;
+		so->ectx = _egl_context ( EglDpy, EglConfig, EglShareCtx );
+		return so->ectx!=EGL_NO_CONTEXT;
+	}
+
+	EGLDisplay dpy = EGL_NO_DISPLAY;
+	const char* cext = eglQueryString ( EGL_NO_DISPLAY, EGL_EXTENSIONS ); // client extensions
+	if ( cext && strstr(cext,"EGL_MESA_platform_surfaceless") )
+	{	PFNEGLGETPLATFORMDISPLAYEXTPROC getdpy = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if ( getdpy ) dpy = getdpy ( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+	}
+	if ( dpy==EGL_NO_DISPLAY ) dpy = eglGetDisplay ( EGL_DEFAULT_DISPLAY );
+	if ( dpy==EGL_NO_DISPLAY || !eglInitialize(dpy,0,0) ) return false;
+
+	const char* dext = eglQueryString ( dpy, EGL_EXTENSIONS );
+	EGLConfig config;
+	EGLint n=0;
+	const EGLint cattribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	if ( !dext || !strstr(dext,"EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API) ||
+		 !eglChooseConfig(dpy,cattribs,&config,1,&n) || n<1 )
+	{	eglTerminate ( dpy ); return false; }
+
+	EGLContext ctx = _egl_context ( dpy, config, EGL_NO_CONTEXT );
+	if ( ctx==EGL_NO_CONTEXT ) { eglTerminate(dpy); return false; }
+
+	so->edpy = EglDpy = dpy;
+	so->ectx = EglShareCtx = ctx;
+	EglConfig = config;
+	return true;
+}
+
+void* wsi_new_offscreen ( bool software )
+{
+	GS_TRACE1 ( "wsi_new_offscreen..." );
+	GlResources::load_configuration_file (); // only overall 1st call will actually load config file
+
+	SwOffscreen* so = new SwOffscreen;
+	so->gwin = 0;
+	so->edpy = EGL_NO_DISPLAY;
+	so->ectx = EGL_NO_CONTEXT;
+
+	// without a display and windows to share with, a surfaceless egl context is used:
+	const char* display = getenv ( "DISPLAY" );
+	if ( UsingEgl || (!ShareWin && (!display || !display[0])) )
+	{	if ( software && !UsingEgl ) _use_software ();
+		bool ok = _new_egl_context ( so );
+		if ( !ok && !software ) { GS_TRACE1 ( "Trying llvmpipe..." ); _use_software(); ok=_new_egl_context(so); }
+		if ( !ok ) { delete so; return 0; }
+		UsingEgl = true;
+		return (void*)so;
+	}
+
+	// otherwise a hidden window sharing the context of the other windows is used:
+	if ( software && !ShareWin ) _use_software ();
+	_init_glfw ();
+	glfwWindowHint ( GLFW_VISIBLE, 0 );
+	so->gwin = glfwCreateWindow ( 16, 16, "", NULL, ShareWin );
+	glfwWindowHint ( GLFW_VISIBLE, 1 );
+	if ( !so->gwin ) { delete so; return 0; }
+	if ( !ShareWin ) ShareWin = so->gwin;
+	return (void*)so;
+}
+
+void wsi_del_offscreen ( void* ctx )
+{
+	GS_TRACE1 ( "wsi_del_offscreen..." );
+	SwOffscreen* so = (SwOffscreen*)ctx;
+	// as for windows, the context shared by the others is only destroyed at exit:
+	if ( so->gwin )
+	{	if ( so->gwin!=ShareWin ) glfwDestroyWindow ( so->gwin );
+	}
+	else
+	{	eglMakeCurrent ( so->edpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+		if ( so->ectx!=EglShareCtx ) eglDestroyContext ( so->edpy, so->ectx );
+	}
+	delete so;
+}
+
+void wsi_activate_offscreen ( void* ctx )
+{
+	GS_TRACE2 ( "wsi_activate_offscreen..." );
+	SwOffscreen* so = (SwOffscreen*)ctx;
+	if ( so->gwin ) glfwMakeContextCurrent ( so->gwin );
+	else eglMakeCurrent ( so->edpy, EGL_NO_SURFACE, EGL_NO_SURFACE, so->ectx );
+}
+
 //==== Callbacks ==============================================================================
 
 // The following are inline friend functions of WsWindow:
@@ -330,6 +466,7 @@ static void key_cb ( GLFWwindow* win, int key, int scancode, int action, int mod
 static void draw_cb ( GLFWwindow* gwin )
 {
 	SwSysWin* sw = (SwSysWin*)glfwGetWindowUserPointer(gwin);
+	if ( !sw ) return; // deleted window kept for its context
 	WsWindow* swin = sw->swin;
 
 	glfwMakeContextCurrent ( gwin );
@@ -350,6 +487,7 @@ static void draw_cb ( GLFWwindow* gwin )
 void resize_cb ( GLFWwindow* gwin, int w, int h )
 {
 	SwSysWin* sw = (SwSysWin*)glfwGetWindowUserPointer(gwin);
+	if ( !sw ) return; // deleted window kept for its context
 	WsWindow* swin = sw->swin;
 
 	glfwMakeContextCurrent ( gwin );
@@ -360,6 +498,7 @@ void resize_cb ( GLFWwindow* gwin, int w, int h )
 void mouse_cb ( GLFWwindow* gwin, int but, int action, int modifs )
 {
 	SwSysWin* sw = (SwSysWin*)glfwGetWindowUserPointer(gwin);
+	if ( !sw ) return; // deleted window kept for its context
 	WsWindow* swin = sw->swin;
 
 	GsEvent e;
@@ -384,6 +523,7 @@ gsout<<but;
 void mousepos_cb ( GLFWwindow* gwin, double x, double y )
 {
 	SwSysWin* sw = (SwSysWin*)glfwGetWindowUserPointer(gwin);
+	if ( !sw ) return; // deleted window kept for its context
 	WsWindow* swin = sw->swin;
 	GsEvent e;
 	e.type = GsEvent::Move;